@@ -11,6 +11,7 @@
 // Client_Globals
 Client_Globals::Client_Globals(TB8::EventQueue* pEventQueue)
 	: m_pRenderer(nullptr)
+	, m_pWorldRender(nullptr)
 	, m_isShutdown(false)
 	, m_pEventQueue(pEventQueue)
 	, m_currentFrameCount(0)
@@ -21,6 +22,7 @@ Client_Globals::Client_Globals(TB8::EventQueue* pEventQueue)
 Client_Globals::~Client_Globals()
 {
 	m_pRenderer = nullptr;
+	m_pWorldRender = nullptr;
 	m_pEventQueue = nullptr;
 }
 
@@ -35,10 +37,17 @@ void Client_Globals::Free()
 	TB8_DEL(this);
 }
 
-void Client_Globals::Initialize(TB8::RenderMain* pRenderer)
+void Client_Globals::Initialize(TB8::RenderMain* pRenderer, TB8::World_Render* pWorldRender)
 {
 	// set renderer.
 	m_pRenderer = pRenderer;
+	m_pWorldRender = pWorldRender;
+}
+
+void Client_Globals::UpdateFrameCount(s32 frameCount)
+{
+	m_currentFrameCount += static_cast<u32>(frameCount);
+	m_pEventQueue->AdvanceFrames(static_cast<u32>(frameCount));
 }
 
 void Client_Globals::QueueEvent(TB8::EventMessage** ppMessage)
@@ -1,13 +1,14 @@
 #pragma once
 #include <string>
-#include "common/basic_types.h"
-#include "common/memory.h"
+#include "Common/basic_types.h"
+#include "Common/memory.h"
 
 namespace TB8
 {
 	class EventQueue;
 	class EventMessage;
 	class RenderMain;
+	class World_Render;
 }
 
 class Client_Globals
@@ -17,14 +18,18 @@ public:
 	~Client_Globals();
 	static Client_Globals* Alloc(TB8::EventQueue* pEventQueue);
 	void Free();
-	void Initialize(TB8::RenderMain* pRenderer);
+	// <pRenderer> is nullptr when running headless, with a null <pWorldRender>.
+	void Initialize(TB8::RenderMain* pRenderer, TB8::World_Render* pWorldRender);
 
 	TB8::RenderMain* GetRenderer() { return m_pRenderer; }
 	const TB8::RenderMain* GetRenderer() const { return m_pRenderer; }
+	TB8::World_Render* GetWorldRender() { return m_pWorldRender; }
+	const TB8::World_Render* GetWorldRender() const { return m_pWorldRender; }
 	void QueueEvent(TB8::EventMessage** ppMessage);
 	TB8::EventQueue* GetEventQueue() { return m_pEventQueue; }
 	u32 GetCurrentFrameCount() const { return m_currentFrameCount; }
-	void UpdateFrameCount(s32 frameCount) { m_currentFrameCount += static_cast<u32>(frameCount); }
+	// steps the event queue's timers with it.
+	void UpdateFrameCount(s32 frameCount);
 	u32 GetNewID() { return ++m_idGen; }
 	void Shutdown();
 	void SetPathAssets(const std::string& pathAssets) { m_pathAssets = pathAssets; }
@@ -34,6 +39,7 @@ public:
 
 private:
 	TB8::RenderMain*								m_pRenderer;				// renderer.
+	TB8::World_Render*								m_pWorldRender;				// what the world renders with.
 
 	bool											m_isShutdown;				// true if we're shutting down.
 
@@ -61,6 +67,8 @@ protected:
 
 	TB8::RenderMain* __GetRenderer() { return m_pGlobals->GetRenderer(); }
 	const TB8::RenderMain* __GetRenderer() const { return m_pGlobals->GetRenderer(); }
+	TB8::World_Render* __GetWorldRender() { return m_pGlobals->GetWorldRender(); }
+	const TB8::World_Render* __GetWorldRender() const { return m_pGlobals->GetWorldRender(); }
 	Client_Globals* __GetGlobals() { return m_pGlobals; }
 	const Client_Globals* __GetGlobals() const { return m_pGlobals; }
 	u32 __GetCurrentFrameCount() const { return m_pGlobals->GetCurrentFrameCount(); }
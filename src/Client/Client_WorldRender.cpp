@@ -0,0 +1,264 @@
+/*
+	Copyright (C) 2019 8 Byte Technology Inc. - All Rights Reserved
+*/
+#include "pch.h"
+
+#include <map>
+
+#include "Render/RenderMain.h"
+#include "Render/RenderModel.h"
+#include "Render/RenderTexture.h"
+#include "Render/RenderImagine.h"
+#include "Render/RenderStatusBars.h"
+
+#include "Client_WorldRender.h"
+
+// Client_WorldRender_Model
+class Client_WorldRender_Model : public TB8::World_RenderModel
+{
+public:
+	Client_WorldRender_Model(TB8::RenderMain* pRenderer, TB8::RenderModel* pModel);
+
+	virtual const TB8::World_RenderModel_Bounds& GetBounds() const override { return m_bounds; }
+	virtual u32 GetAnimCount() const override { return m_pModel->GetAnimCount(); }
+	virtual const TB8::World_RenderModel_Bounds* GetAnimBounds(s32 animID) const override;
+	virtual void Render(const Matrix4& worldTransform, const TB8::World_RenderModel_Pose& pose) override;
+
+private:
+	virtual void __Free() override;
+	void __SetPose(const TB8::World_RenderModel_Pose& pose);
+	static void __CopyBounds(const TB8::RenderModel_Bounds& src, TB8::World_RenderModel_Bounds* pDst);
+
+	TB8::RenderMain*								m_pRenderer;
+	TB8::RenderModel*								m_pModel;
+	TB8::World_RenderModel_Bounds					m_bounds;
+	std::map<s32, TB8::World_RenderModel_Bounds>	m_animBounds;
+	bool											m_isPoseSet;
+	TB8::World_RenderModel_Pose						m_pose;						// pose the joints are in.
+};
+
+Client_WorldRender_Model::Client_WorldRender_Model(TB8::RenderMain* pRenderer, TB8::RenderModel* pModel)
+	: m_pRenderer(pRenderer)
+	, m_pModel(pModel)
+	, m_isPoseSet(false)
+{
+	__CopyBounds(pModel->GetMeshes().front().m_bounds, &m_bounds);
+
+	const std::vector<TB8::RenderModel_Anim>& anims = pModel->GetAnims();
+	for (std::vector<TB8::RenderModel_Anim>::const_iterator it = anims.begin(); it != anims.end(); ++it)
+	{
+		__CopyBounds(it->m_bounds, &m_animBounds[it->m_animID]);
+	}
+}
+
+void Client_WorldRender_Model::__Free()
+{
+	RELEASEI(m_pModel);
+	TB8_DEL(this);
+}
+
+const TB8::World_RenderModel_Bounds* Client_WorldRender_Model::GetAnimBounds(s32 animID) const
+{
+	std::map<s32, TB8::World_RenderModel_Bounds>::const_iterator it = m_animBounds.find(animID);
+	return (it != m_animBounds.end()) ? &(it->second) : nullptr;
+}
+
+void Client_WorldRender_Model::Render(const Matrix4& worldTransform, const TB8::World_RenderModel_Pose& pose)
+{
+	__SetPose(pose);
+	m_pModel->SetWorldTransform(worldTransform);
+	m_pModel->Render(m_pRenderer);
+}
+
+void Client_WorldRender_Model::__SetPose(const TB8::World_RenderModel_Pose& pose)
+{
+	// the model is shared, so its joints are posed for each object as it's drawn.  objects drawn one after another
+	//  are often in the same pose.
+	if (!m_pModel->GetJointCount())
+		return;
+	if (m_isPoseSet && (m_pose.m_animID0 == pose.m_animID0) && (m_pose.m_animID1 == pose.m_animID1) && (m_pose.m_t == pose.m_t))
+		return;
+	m_isPoseSet = true;
+	m_pose = pose;
+
+	for (u32 iJoint = 0; iJoint < m_pModel->GetJointCount(); ++iJoint)
+	{
+		const TB8::RenderModel_Anim_Joint* pJointAnimA = m_pModel->GetAnimJoint(pose.m_animID0, iJoint);
+		const TB8::RenderModel_Joint* pJoint = m_pModel->GetJoint(iJoint);
+		if (pose.m_animID0 == pose.m_animID1)
+		{
+			m_pModel->SetJointTransformMatrix(iJoint, pJointAnimA ? pJointAnimA->m_transform : pJoint->m_baseMatrix);
+			continue;
+		}
+
+		const TB8::RenderModel_Anim_Joint* pJointAnimB = m_pModel->GetAnimJoint(pose.m_animID1, iJoint);
+		if (!pJointAnimA && !pJointAnimB)
+		{
+			m_pModel->SetJointTransformMatrix(iJoint, pJoint->m_baseMatrix);
+		}
+		else
+		{
+			const Matrix4& matrixA = pJointAnimA ? pJointAnimA->m_transform : pJoint->m_baseMatrix;
+			const Matrix4& matrixB = pJointAnimB ? pJointAnimB->m_transform : pJoint->m_baseMatrix;
+
+			const Vector4 qA = Matrix4::ToQuaternion(matrixA);
+			const Vector4 qB = Matrix4::ToQuaternion(matrixB);
+
+			const Vector4 qR = Vector4::SLERP(qA, qB, pose.m_t);
+
+			Matrix4 matrixC = Matrix4::FromQuaternion(qR);
+
+			Vector3 posA;
+			Vector3 posB;
+			matrixA.GetTranslation(posA);
+			matrixB.GetTranslation(posB);
+
+			Vector3 posC = (posA + posB) / 2.f;
+			matrixC.AddTranslation(posC);
+
+			m_pModel->SetJointTransformMatrix(iJoint, matrixC);
+		}
+	}
+}
+
+void Client_WorldRender_Model::__CopyBounds(const TB8::RenderModel_Bounds& src, TB8::World_RenderModel_Bounds* pDst)
+{
+	pDst->m_min = src.m_min;
+	pDst->m_max = src.m_max;
+	pDst->m_center = src.m_center;
+	pDst->m_size = src.m_size;
+}
+
+// Client_WorldRender_Thought
+class Client_WorldRender_Thought : public TB8::World_RenderThought
+{
+public:
+	Client_WorldRender_Thought(TB8::RenderImagine* pImagine)
+		: m_pImagine(pImagine)
+	{
+	}
+
+	virtual void Render(const Vector2& screenPos) override
+	{
+		m_pImagine->SetPosition(screenPos);
+		m_pImagine->Render();
+	}
+
+private:
+	virtual void __Free() override
+	{
+		RELEASEI(m_pImagine);
+		TB8_DEL(this);
+	}
+
+	TB8::RenderImagine*								m_pImagine;
+};
+
+// Client_WorldRender_StatusBars
+class Client_WorldRender_StatusBars : public TB8::World_RenderStatusBars
+{
+public:
+	Client_WorldRender_StatusBars(TB8::RenderStatusBars* pStatusBars, TB8::RenderTexture* pTexture)
+		: m_pStatusBars(pStatusBars)
+		, m_pTexture(pTexture)
+	{
+	}
+
+	virtual u32 AddBar(const char* pszName, const Vector2& uv0, const Vector2& uv1, s32 value, s32 maxValue, s32 incrementSize) override
+	{
+		return m_pStatusBars->AddBar(pszName, m_pTexture, uv0, uv1, value, maxValue, incrementSize);
+	}
+	virtual void SetBarValue(u32 barID, s32 value) override { m_pStatusBars->SetBarValue(barID, value); }
+	virtual void Render2D() override { m_pStatusBars->Render2D(); }
+	virtual void Render3D() override { m_pStatusBars->Render3D(); }
+
+private:
+	virtual void __Free() override
+	{
+		RELEASEI(m_pStatusBars);
+		RELEASEI(m_pTexture);
+		TB8_DEL(this);
+	}
+
+	TB8::RenderStatusBars*							m_pStatusBars;
+	TB8::RenderTexture*								m_pTexture;
+};
+
+// Client_WorldRender
+Client_WorldRender::Client_WorldRender(TB8::RenderMain* pRenderer)
+	: m_pRenderer(pRenderer)
+{
+}
+
+Client_WorldRender::~Client_WorldRender()
+{
+	m_pRenderer = nullptr;
+}
+
+Client_WorldRender* Client_WorldRender::Alloc(TB8::RenderMain* pRenderer)
+{
+	Client_WorldRender* pObj = TB8_NEW(Client_WorldRender)(pRenderer);
+	return pObj;
+}
+
+void Client_WorldRender::Free()
+{
+	TB8_DEL(this);
+}
+
+TB8::World_RenderModel* Client_WorldRender::AllocModelFromDAE(const char* pszPath, const char* pszFile, const char* pszModelName)
+{
+	TB8::RenderModel* pModel = TB8::RenderModel::AllocFromDAE(m_pRenderer, pszPath, pszFile, pszModelName);
+	if (!pModel)
+		return nullptr;
+	if (pModel->GetMeshes().empty())
+	{
+		RELEASEI(pModel);
+		return nullptr;
+	}
+	return TB8_NEW(Client_WorldRender_Model)(m_pRenderer, pModel);
+}
+
+TB8::World_RenderModel* Client_WorldRender::AllocModelFromTexture(const char* pszTexturePath)
+{
+	TB8::RenderTexture* pTexture = TB8::RenderTexture::Alloc(m_pRenderer, pszTexturePath);
+	TB8::RenderModel* pModel = TB8::RenderModel::AllocSimpleRectangle(m_pRenderer, TB8::RenderMainViewType_World, Vector3(0.f, 0.f, 1.f), Vector3(1.f, 0.f, 0.f),
+		pTexture, Vector2(0.f, 0.f), Vector2(1.f, 1.f));
+	RELEASEI(pTexture);
+	return TB8_NEW(Client_WorldRender_Model)(m_pRenderer, pModel);
+}
+
+TB8::World_RenderThought* Client_WorldRender::AllocThought(TB8::World_RenderThought_Type type, const char* pszText)
+{
+	TB8::RenderImagine* pImagine = TB8::RenderImagine::Alloc(m_pRenderer);
+	pImagine->SetType((type == TB8::World_RenderThought_Type_Speech) ? TB8::RenderImagine_Type_Speech : TB8::RenderImagine_Type_Imagine);
+	pImagine->SetText(pszText);
+	return TB8_NEW(Client_WorldRender_Thought)(pImagine);
+}
+
+TB8::World_RenderStatusBars* Client_WorldRender::AllocStatusBars(const char* pszTexturePath)
+{
+	TB8::RenderTexture* pTexture = TB8::RenderTexture::Alloc(m_pRenderer, pszTexturePath);
+	TB8::RenderStatusBars* pStatusBars = TB8::RenderStatusBars::Alloc(m_pRenderer);
+	return TB8_NEW(Client_WorldRender_StatusBars)(pStatusBars, pTexture);
+}
+
+void Client_WorldRender::AlignWorldSize(Vector3& worldSize) const
+{
+	m_pRenderer->AlignWorldSize(worldSize);
+}
+
+void Client_WorldRender::AlignWorldPosition(Vector3& worldPos) const
+{
+	m_pRenderer->AlignWorldPosition(worldPos);
+}
+
+Vector2 Client_WorldRender::WorldToScreenCoords(const Vector3& worldPos) const
+{
+	return m_pRenderer->WorldToScreenCoords(worldPos);
+}
+
+Vector2 Client_WorldRender::GetScreenSizeWorld() const
+{
+	return m_pRenderer->GetRenderScreenSizeWorld();
+}
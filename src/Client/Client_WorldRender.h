@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Common/basic_types.h"
+
+#include "World/Render.h"
+
+namespace TB8
+{
+	class RenderMain;
+}
+
+// the world's renderer, drawing with RenderMain.
+class Client_WorldRender : public TB8::World_Render
+{
+public:
+	Client_WorldRender(TB8::RenderMain* pRenderer);
+	~Client_WorldRender();
+	static Client_WorldRender* Alloc(TB8::RenderMain* pRenderer);
+	void Free();
+
+	virtual TB8::World_RenderModel* AllocModelFromDAE(const char* pszPath, const char* pszFile, const char* pszModelName) override;
+	virtual TB8::World_RenderModel* AllocModelFromTexture(const char* pszTexturePath) override;
+	virtual TB8::World_RenderThought* AllocThought(TB8::World_RenderThought_Type type, const char* pszText) override;
+	virtual TB8::World_RenderStatusBars* AllocStatusBars(const char* pszTexturePath) override;
+
+	virtual void AlignWorldSize(Vector3& worldSize) const override;
+	virtual void AlignWorldPosition(Vector3& worldPos) const override;
+	virtual Vector2 WorldToScreenCoords(const Vector3& worldPos) const override;
+	virtual Vector2 GetScreenSizeWorld() const override;
+
+private:
+	TB8::RenderMain*								m_pRenderer;				// renderer.
+};
@@ -6,30 +6,34 @@
 #include <ShellScalingApi.h>
 #include <winuser.h>
 
-#include "common/file_io.h"
+#include "Common/file_io.h"
 
-#include "resource.h"
+#include "Resource.h"
 
-#include "render/RenderMain.h"
-#include "render/RenderModel.h"
-#include "render/RenderHelper.h"
+#include "Render/RenderMain.h"
+#include "Render/RenderModel.h"
+#include "Render/RenderHelper.h"
 
-#include "event/EventQueue.h"
-#include "event/EventQueueMessages.h"
+#include "Event/EventQueue.h"
+#include "Event/EventQueueMessages.h"
 
-#include "world/World.h"
+#include "World/World.h"
 
 #include "Client_Globals.h"
+#include "Client_WorldRender.h"
 #include "MainClass.h"
 
 const WCHAR* s_windowClassName = L"Racoon-Odyssey-Class";
 
+const s64 COMPUTE_FRAME_CATCHUP_MAX = 5;		// most simulation steps run for one render frame.
+
 // MainClass.
 MainClass::MainClass()
 	: m_eventQueue(nullptr)
 	, m_pClientGlobals(nullptr)
 	, m_pWorld(nullptr)
 	, m_pRenderer(nullptr)
+	, m_pWorldRender(nullptr)
 	, m_hInstance(NULL)
 	, m_hWnd(NULL)
 	, m_inSizeMove(false)
@@ -42,12 +46,12 @@ MainClass::MainClass()
 	QueryPerformanceFrequency(&val);
 	m_clockTickPerSecond = val.QuadPart;
 	m_clockTickPerMilliSecond = m_clockTickPerSecond / 1000LL;
-	m_clockTickPerRenderFrame = m_clockTickPerSecond / 60LL;
 	m_clockTickPerComputeFrame = m_clockTickPerSecond / 60LL;
 
 	QueryPerformanceCounter(&val);
 	m_clockTickLastRenderFrame = val.QuadPart;
 	m_clockTickLastComputeFrame = val.QuadPart;
+	m_clockTickComputeAccumulator = 0;
 }
 
 HRESULT MainClass::__CreateDesktopWindow()
@@ -145,13 +149,19 @@ void MainClass::Initialize()
 
 	// create renderer
 	m_pRenderer = TB8::RenderMain::Alloc(m_hWnd, m_pClientGlobals);
+	m_pWorldRender = Client_WorldRender::Alloc(m_pRenderer);
 
 	// initialize globals.
-	m_pClientGlobals->Initialize(m_pRenderer);
+	m_pClientGlobals->Initialize(m_pRenderer, m_pWorldRender);
 
 	// create world.
 	m_pWorld = TB8::World::Alloc(m_pClientGlobals);
-	m_pWorld->LoadMap("maps/wall-maze/wall-maze.xml");
+	if (!m_pWorld->LoadMap("maps/wall-maze/wall-maze.xml"))
+	{
+		// closing the window quits.
+		DestroyWindow(m_hWnd);
+		return;
+	}
 	m_pWorld->LoadCharacter("mooey/mooey.dae", "Mooey");
 }
 
@@ -192,32 +202,47 @@ void MainClass::__ProcessRenderFrame()
 	LARGE_INTEGER clockTickCurrent;
 	QueryPerformanceCounter(&clockTickCurrent);
 	s64 ticksSinceLastLiveFrame = clockTickCurrent.QuadPart - m_clockTickLastRenderFrame;
-	if (ticksSinceLastLiveFrame < m_clockTickPerRenderFrame)
-		return;
+	m_clockTickLastRenderFrame = clockTickCurrent.QuadPart;
+
+	// the simulation runs in fixed steps, a hitch longer than the catch-up budget is dropped.
+	m_clockTickComputeAccumulator += std::min<s64>(ticksSinceLastLiveFrame, m_clockTickPerComputeFrame * COMPUTE_FRAME_CATCHUP_MAX);
 
-	s32 frameCount = static_cast<s32>(ticksSinceLastLiveFrame / m_clockTickPerRenderFrame);
-	m_clockTickLastRenderFrame += (frameCount * m_clockTickPerRenderFrame);
+	s32 frameCount = 0;
+	while ((m_clockTickComputeAccumulator >= m_clockTickPerComputeFrame) && (frameCount < COMPUTE_FRAME_CATCHUP_MAX))
+	{
+		__ProcessComputeFrame();
+		m_clockTickComputeAccumulator -= m_clockTickPerComputeFrame;
+		++frameCount;
+	}
+	m_clockTickComputeAccumulator = std::min<s64>(m_clockTickComputeAccumulator, m_clockTickPerComputeFrame - 1);
 
-	__ProcessRenderFrame(frameCount);
+	// render between the last two simulation steps.
+	const f32 alpha = static_cast<f32>(m_clockTickComputeAccumulator) / static_cast<f32>(m_clockTickPerComputeFrame);
+	__ProcessRenderFrame(frameCount, alpha);
 }
 
-void MainClass::__ProcessRenderFrame(s32 frameCount)
+void MainClass::__ProcessComputeFrame()
 {
 	// update frame count on globals.
-	m_pClientGlobals->UpdateFrameCount(frameCount);
+	m_pClientGlobals->UpdateFrameCount(1);
 
 	__ProcessInternal();
 
+	m_pWorld->Update(1);
+}
+
+void MainClass::__ProcessRenderFrame(s32 frameCount, f32 alpha)
+{
 	m_pRenderer->UpdateRender(frameCount);
-	m_pWorld->Update(frameCount);
+	m_pWorld->UpdateRender(alpha);
 
 	m_pRenderer->BeginUpdate();
 
-	m_pWorld->Render3D(m_pRenderer);
+	m_pWorld->Render3D();
 
 	m_pRenderer->BeginDraw();
 
-	m_pWorld->Render2D(m_pRenderer);
+	m_pWorld->Render2D();
 
 	m_pRenderer->DrawCursor();
 
@@ -253,6 +278,7 @@ void MainClass::__Shutdown()
 	m_pClientGlobals->Shutdown();
 
 	OBJFREE(m_pWorld);
+	OBJFREE(m_pWorldRender);
 	OBJFREE(m_pRenderer);
 	OBJFREE(m_pClientGlobals);
 	OBJFREE(m_eventQueue);
@@ -299,6 +325,10 @@ LRESULT CALLBACK MainClass::__WindowProc(
 		break;
 
 	case WM_KEYDOWN:
+		// moves start on the first press, not on autorepeat.
+		if (lParam & (1 << 30))
+			break;
+
 		if ((wParam == 'W') || (wParam == VK_UP))
 		{
 			TB8::EventMessage* event = TB8::EventMessage_MoveStart::Alloc(+0, -1, +0);
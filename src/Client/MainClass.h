@@ -1,6 +1,6 @@
 #pragma once
 
-#include "common/basic_types.h"
+#include "Common/basic_types.h"
 
 namespace TB8
 {
@@ -10,6 +10,7 @@ namespace TB8
 }
 
 class Client_Globals;
+class Client_WorldRender;
 
 class MainClass
 {
@@ -29,7 +30,8 @@ private:
 	HRESULT __CreateDesktopWindow();
 
 	void __ProcessRenderFrame();
-	void __ProcessRenderFrame(s32 frameCount);
+	void __ProcessRenderFrame(s32 frameCount, f32 alpha);
+	void __ProcessComputeFrame();
 	void __DispatchEventQueue();
 	void __ProcessInternal();
 
@@ -58,11 +60,11 @@ private:
 
 	s64					m_clockTickPerSecond;			// counts / second.
 	s64					m_clockTickPerMilliSecond;		// counts / millisecond.
-	s64					m_clockTickPerRenderFrame;		// counts / live frame.
 	s64					m_clockTickPerComputeFrame;		// counts / master frame.
 
 	s64					m_clockTickLastRenderFrame;		// tick count last live frame.
 	s64					m_clockTickLastComputeFrame;	// tick count last master frame.
+	s64					m_clockTickComputeAccumulator;	// ticks not yet simulated.
 
 	Client_Globals*		m_pClientGlobals;
 
@@ -70,5 +72,7 @@ private:
 
 	TB8::RenderMain*	m_pRenderer;
 
+	Client_WorldRender*	m_pWorldRender;
+
 	TB8::EventQueue*	m_eventQueue;
 };
@@ -509,7 +509,7 @@ Matrix4::Matrix4()
 
 void Matrix4::Clear()
 {
-	ZeroMemory(m, sizeof(m));
+	memset(m, 0, sizeof(m));
 }
 
 bool Matrix4::operator ==(const Matrix4& rhs) const
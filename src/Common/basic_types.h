@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <math.h>
 
 typedef uint32_t u32;
 typedef int32_t s32;
@@ -58,6 +59,8 @@ struct guid : u128
 	explicit operator bool() const { return IsValid(); }
 } ;
 
+const f32 PI = 3.141592654f;
+
 inline bool is_approx_zero(f32 v) { return (-0.000001 < v) && (v < 0.00001); }
 inline bool is_negative(f32 v) { return (v < 0.f); }
 inline f32 get_sign(f32 v) { return (v < 0.f) ? -1.f : 1.f; }
@@ -2,11 +2,29 @@
 
 #include <stack>
 
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "string.h"
+#endif
+
 #include "file_io.h"
 
 namespace TB8
 {
 
+#if defined(_WIN32)
+const char* const FILE_PATH_SEPARATOR = "\\";
+#else
+const char* const FILE_PATH_SEPARATOR = "/";
+#endif
+
+#if defined(_WIN32)
+
 File::File()
 {
 	m_hFile = INVALID_HANDLE_VALUE;
@@ -97,26 +115,11 @@ u32 File::Write(const u8* pBuffer, u32 bytesToWrite)
 	return bytesWritten;
 }
 
-void File::WriteText(const char* fmt, ...)
-{
-	char buffer[4096];
-	va_list args;
-	va_start(args, fmt);
-	int used = vsprintf_s(buffer, fmt, args);
-	va_end(args);
-	Write(reinterpret_cast<u8*>(buffer), used);
-}
-
 void File::Flush()
 {
 	FlushFileBuffers(m_hFile);
 }
 
-void File::Free()
-{
-	delete this;
-}
-
 void File::CreateDir(const char* path)
 {
 	WCHAR wPath[MAX_PATH];
@@ -147,6 +150,185 @@ void File::CreateDir(const char* path)
 	}
 }
 
+bool File::GetModifiedTime(const char* path, u64* pTime)
+{
+	WCHAR wPath[MAX_PATH];
+	mbstowcs_s(nullptr, wPath, path, ARRAYSIZE(wPath));
+
+	WIN32_FILE_ATTRIBUTE_DATA attribs;
+	if (!GetFileAttributesExW(wPath, GetFileExInfoStandard, &attribs))
+		return false;
+
+	*pTime = (static_cast<u64>(attribs.ftLastWriteTime.dwHighDateTime) << 32) | attribs.ftLastWriteTime.dwLowDateTime;
+	return true;
+}
+
+bool File::Rename(const char* srcPath, const char* dstPath)
+{
+	WCHAR wSrcPath[MAX_PATH];
+	WCHAR wDstPath[MAX_PATH];
+	mbstowcs_s(nullptr, wSrcPath, srcPath, ARRAYSIZE(wSrcPath));
+	mbstowcs_s(nullptr, wDstPath, dstPath, ARRAYSIZE(wDstPath));
+	return MoveFileExW(wSrcPath, wDstPath, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+bool File::Delete(const char* path)
+{
+	WCHAR wPath[MAX_PATH];
+	mbstowcs_s(nullptr, wPath, path, ARRAYSIZE(wPath));
+	return DeleteFileW(wPath) != 0;
+}
+
+#else
+
+File::File()
+{
+	m_fd = -1;
+}
+
+File::~File()
+{
+	if (m_fd >= 0)
+	{
+		close(m_fd);
+		m_fd = -1;
+	}
+}
+
+File* File::AllocOpen(const char* path, bool readOnly)
+{
+	File* pObj = new File();
+	pObj->m_fd = open(path, readOnly ? O_RDONLY : O_RDWR);
+	if (pObj->m_fd < 0)
+	{
+		delete pObj;
+		return nullptr;
+	}
+	return pObj;
+}
+
+File* File::AllocCreate(const char* path)
+{
+	File* pObj = new File();
+	pObj->m_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (pObj->m_fd < 0)
+	{
+		delete pObj;
+		return nullptr;
+	}
+	return pObj;
+}
+
+u32 File::Read(u8* pBuffer, u32 bytesToRead)
+{
+	u32 bytesRead = 0;
+	while (bytesRead < bytesToRead)
+	{
+		const ssize_t r = read(m_fd, pBuffer + bytesRead, bytesToRead - bytesRead);
+		if (r <= 0)
+			break;
+		bytesRead += static_cast<u32>(r);
+	}
+	return bytesRead;
+}
+
+u32 File::Read(std::vector<u8>* dst)
+{
+	struct stat fileInfo;
+	if (fstat(m_fd, &fileInfo) != 0)
+	{
+		return 0;
+	}
+
+	assert(fileInfo.st_size < 0x100000000);
+	const u32 fileSize = static_cast<u32>(fileInfo.st_size);
+
+	dst->resize(fileSize);
+	const u32 bytesRead = Read(dst->data(), fileSize);
+	dst->resize(bytesRead);
+	return bytesRead;
+}
+
+u32 File::Write(const u8* pBuffer, u32 bytesToWrite)
+{
+	u32 bytesWritten = 0;
+	while (bytesWritten < bytesToWrite)
+	{
+		const ssize_t r = write(m_fd, pBuffer + bytesWritten, bytesToWrite - bytesWritten);
+		if (r <= 0)
+			break;
+		bytesWritten += static_cast<u32>(r);
+	}
+	return bytesWritten;
+}
+
+void File::Flush()
+{
+	fsync(m_fd);
+}
+
+void File::CreateDir(const char* path)
+{
+	if (mkdir(path, 0755) == 0)
+		return;
+	if (errno == EEXIST)
+		return;
+
+	std::stack<std::string> paths;
+	std::string tempPath = path;
+	while (!tempPath.empty() && tempPath.back() != '.')
+	{
+		std::string path1;
+		std::string file1;
+		paths.push(tempPath);
+		ParsePath(tempPath.c_str(), &path1, &file1);
+		tempPath = path1;
+	}
+
+	while (!paths.empty())
+	{
+		mkdir(paths.top().c_str(), 0755);
+		paths.pop();
+	}
+}
+
+bool File::GetModifiedTime(const char* path, u64* pTime)
+{
+	struct stat fileInfo;
+	if (stat(path, &fileInfo) != 0)
+		return false;
+
+	*pTime = (static_cast<u64>(fileInfo.st_mtim.tv_sec) * 1000000000) + static_cast<u64>(fileInfo.st_mtim.tv_nsec);
+	return true;
+}
+
+bool File::Rename(const char* srcPath, const char* dstPath)
+{
+	return rename(srcPath, dstPath) == 0;
+}
+
+bool File::Delete(const char* path)
+{
+	return unlink(path) == 0;
+}
+
+#endif
+
+void File::WriteText(const char* fmt, ...)
+{
+	char buffer[4096];
+	va_list args;
+	va_start(args, fmt);
+	int used = vsprintf_s(buffer, fmt, args);
+	va_end(args);
+	Write(reinterpret_cast<u8*>(buffer), used);
+}
+
+void File::Free()
+{
+	delete this;
+}
+
 void File::AppendToPath(std::string& path, const char* file)
 {
 	std::string tempPath = path;
@@ -184,9 +366,9 @@ void File::AppendToPath(std::string& path, const char* file)
 
 	path = tempPath;
 
-	if (!path.empty() && (path[path.length() - 1] != '\\'))
+	if (!path.empty() && (path[path.length() - 1] != FILE_PATH_SEPARATOR[0]))
 	{
-		path += "\\";
+		path += FILE_PATH_SEPARATOR;
 	}
 
 	path.append(file);
@@ -269,4 +451,128 @@ void File::ParsePath(const char* fullPathAndFile, std::string* path, std::string
 	*fileName = fullPathAndFile;
 }
 
+#if defined(_WIN32)
+
+FileMapping::FileMapping()
+	: m_hFile(INVALID_HANDLE_VALUE)
+	, m_hMapping(nullptr)
+	, m_pData(nullptr)
+	, m_size(0)
+{
+}
+
+FileMapping::~FileMapping()
+{
+	if (m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+		m_pData = nullptr;
+	}
+	if (m_hMapping)
+	{
+		CloseHandle(m_hMapping);
+		m_hMapping = nullptr;
+	}
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+FileMapping* FileMapping::AllocOpen(const char* path)
+{
+	FileMapping* pObj = new FileMapping();
+	WCHAR wPath[MAX_PATH];
+	mbstowcs_s(nullptr, wPath, path, ARRAYSIZE(wPath));
+
+	pObj->m_hFile = CreateFile(wPath,
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+	if (pObj->m_hFile == INVALID_HANDLE_VALUE)
+	{
+		delete pObj;
+		return nullptr;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(pObj->m_hFile, &fileSize) || (fileSize.QuadPart == 0) || (fileSize.QuadPart >= 0x100000000))
+	{
+		delete pObj;
+		return nullptr;
+	}
+	pObj->m_size = static_cast<u32>(fileSize.QuadPart);
+
+	pObj->m_hMapping = CreateFileMapping(pObj->m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!pObj->m_hMapping)
+	{
+		delete pObj;
+		return nullptr;
+	}
+
+	pObj->m_pData = static_cast<const u8*>(MapViewOfFile(pObj->m_hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!pObj->m_pData)
+	{
+		delete pObj;
+		return nullptr;
+	}
+	return pObj;
+}
+
+#else
+
+FileMapping::FileMapping()
+	: m_pData(nullptr)
+	, m_size(0)
+{
+}
+
+FileMapping::~FileMapping()
+{
+	if (m_pData)
+	{
+		munmap(const_cast<u8*>(m_pData), m_size);
+		m_pData = nullptr;
+	}
+}
+
+FileMapping* FileMapping::AllocOpen(const char* path)
+{
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+
+	// the mapping holds the file open, the descriptor isn't needed once it's made.
+	FileMapping* pObj = new FileMapping();
+	struct stat fileInfo;
+	if ((fstat(fd, &fileInfo) == 0) && (fileInfo.st_size > 0) && (fileInfo.st_size < 0x100000000))
+	{
+		void* pData = mmap(nullptr, static_cast<size_t>(fileInfo.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (pData != MAP_FAILED)
+		{
+			pObj->m_pData = static_cast<const u8*>(pData);
+			pObj->m_size = static_cast<u32>(fileInfo.st_size);
+		}
+	}
+	close(fd);
+
+	if (!pObj->m_pData)
+	{
+		delete pObj;
+		return nullptr;
+	}
+	return pObj;
+}
+
+#endif
+
+void FileMapping::Free()
+{
+	delete this;
+}
+
 }; // namespace TB8
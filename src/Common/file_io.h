@@ -21,6 +21,10 @@ public:
 	void Free();
 
 	static void CreateDir(const char* path);
+	static bool GetModifiedTime(const char* path, u64* pTime);
+	// replaces <dstPath> if it exists.
+	static bool Rename(const char* srcPath, const char* dstPath);
+	static bool Delete(const char* path);
 
 	static void AppendToPath(std::string& path, const char* pathOrFile);
 	static void SetExtension(std::string& path, const char* extension);
@@ -34,7 +38,33 @@ private:
 	File();
 	~File();
 
+#if defined(_WIN32)
 	HANDLE m_hFile;
+#else
+	int m_fd;
+#endif
+};
+
+// read-only view of a whole file, paged in as it's touched.
+class FileMapping
+{
+public:
+	static FileMapping* AllocOpen(const char* path);
+	void Free();
+
+	const u8* GetData() const { return m_pData; }
+	u32 GetSize() const { return m_size; }
+
+private:
+	FileMapping();
+	~FileMapping();
+
+#if defined(_WIN32)
+	HANDLE m_hFile;
+	HANDLE m_hMapping;
+#endif
+	const u8* m_pData;
+	u32 m_size;
 };
 	
 };
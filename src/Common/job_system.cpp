@@ -0,0 +1,146 @@
+#include "pch.h"
+
+#include "memory.h"
+#include "job_system.h"
+
+namespace TB8
+{
+
+JobSystem* JobSystem::Alloc(u32 threadCount)
+{
+	JobSystem* pObj = TB8_NEW(JobSystem)();
+	pObj->__Initialize(threadCount);
+	return pObj;
+}
+
+void JobSystem::Free()
+{
+	TB8_DEL(this);
+}
+
+JobSystem::JobSystem()
+	: m_pJob(nullptr)
+	, m_jobCount(0)
+	, m_jobNext(0)
+	, m_jobDoneCount(0)
+	, m_workerBusyCount(0)
+	, m_generation(0)
+	, m_isShutdown(false)
+{
+}
+
+JobSystem::~JobSystem()
+{
+	__Uninitialize();
+}
+
+u32 JobSystem::ResolveThreadCount(u32 threadCount)
+{
+	if (threadCount)
+		return threadCount;
+	return std::max<u32>(std::thread::hardware_concurrency(), 1);
+}
+
+void JobSystem::__Initialize(u32 threadCount)
+{
+	// the calling thread is one of the threads.
+	const u32 workerCount = ResolveThreadCount(threadCount) - 1;
+	m_threads.reserve(workerCount);
+	for (u32 i = 0; i < workerCount; ++i)
+	{
+		m_threads.push_back(std::thread(&JobSystem::__WorkerMain, this));
+	}
+}
+
+void JobSystem::__Uninitialize()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isShutdown = true;
+	}
+	m_wake.notify_all();
+
+	for (std::vector<std::thread>::iterator it = m_threads.begin(); it != m_threads.end(); ++it)
+	{
+		it->join();
+	}
+	m_threads.clear();
+}
+
+void JobSystem::ParallelFor(u32 jobCount, const std::function<void(u32 jobIndex)>& job)
+{
+	if (!jobCount)
+		return;
+
+	// not worth waking anyone.
+	if (m_threads.empty() || (jobCount == 1))
+	{
+		for (u32 i = 0; i < jobCount; ++i)
+		{
+			job(i);
+		}
+		return;
+	}
+
+	{
+		// a worker that woke late for the previous generation may still be looking at the old job.
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this] { return m_workerBusyCount == 0; });
+
+		m_pJob = &job;
+		m_jobCount = jobCount;
+		m_jobNext = 0;
+		m_jobDoneCount = 0;
+		++m_generation;
+	}
+	m_wake.notify_all();
+
+	const u32 doneCount = __RunJobs();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_jobDoneCount += doneCount;
+	m_done.wait(lock, [this] { return (m_jobDoneCount == m_jobCount) && (m_workerBusyCount == 0); });
+	m_pJob = nullptr;
+	m_jobCount = 0;
+}
+
+void JobSystem::__WorkerMain()
+{
+	u32 generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this, generation] { return m_isShutdown || (m_generation != generation); });
+			if (m_isShutdown)
+				return;
+			generation = m_generation;
+			++m_workerBusyCount;
+		}
+
+		const u32 doneCount = __RunJobs();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobDoneCount += doneCount;
+			--m_workerBusyCount;
+		}
+		m_done.notify_all();
+	}
+}
+
+u32 JobSystem::__RunJobs()
+{
+	u32 doneCount = 0;
+	for (;;)
+	{
+		const u32 jobIndex = m_jobNext.fetch_add(1);
+		if (jobIndex >= m_jobCount)
+			break;
+		(*m_pJob)(jobIndex);
+		++doneCount;
+	}
+	return doneCount;
+}
+
+}
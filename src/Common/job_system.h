@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "basic_types.h"
+
+namespace TB8
+{
+
+// fork / join worker pool.
+//  ParallelFor() hands out job indicies to the workers and the calling thread, and returns once they have all run.
+//  jobs must not depend on which thread, or in which order, they run.
+class JobSystem
+{
+public:
+	JobSystem();
+	~JobSystem();
+
+	static JobSystem* Alloc(u32 threadCount);
+	void Free();
+
+	// threads that run jobs, including the caller of ParallelFor().
+	u32 GetThreadCount() const { return static_cast<u32>(m_threads.size()) + 1; }
+
+	void ParallelFor(u32 jobCount, const std::function<void(u32 jobIndex)>& job);
+
+	// threadCount of 0 means one thread per core.
+	static u32 ResolveThreadCount(u32 threadCount);
+
+private:
+	void __Initialize(u32 threadCount);
+	void __Uninitialize();
+	void __WorkerMain();
+	u32 __RunJobs();
+
+	std::vector<std::thread>					m_threads;
+
+	std::mutex									m_mutex;
+	std::condition_variable						m_wake;					// workers wait for a new generation.
+	std::condition_variable						m_done;					// ParallelFor() waits for the workers.
+
+	const std::function<void(u32)>*				m_pJob;
+	u32											m_jobCount;
+	std::atomic<u32>							m_jobNext;
+	u32											m_jobDoneCount;
+	u32											m_workerBusyCount;
+	u32											m_generation;
+	bool										m_isShutdown;
+};
+
+}
@@ -4,7 +4,7 @@
 #include <vector>
 #include <string>
 
-#include "common/basic_types.h"
+#include "Common/basic_types.h"
 
 namespace TB8
 {
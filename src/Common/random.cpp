@@ -0,0 +1,111 @@
+#include "pch.h"
+
+#include "random.h"
+
+namespace TB8
+{
+
+const u32 PHILOX_M0 = 0xD2511F53;
+const u32 PHILOX_M1 = 0xCD9E8D57;
+const u32 PHILOX_W0 = 0x9E3779B9;			// golden ratio.
+const u32 PHILOX_W1 = 0xBB67AE85;			// sqrt(3) - 1.
+const u32 PHILOX_ROUNDS = 10;
+
+Random::Random()
+{
+	Seed(0, 0);
+}
+
+Random::Random(u64 seed, u64 stream)
+{
+	Seed(seed, stream);
+}
+
+void Random::Seed(u64 seed, u64 stream)
+{
+	m_key[0] = static_cast<u32>(seed);
+	m_key[1] = static_cast<u32>(seed >> 32);
+	m_stream[0] = static_cast<u32>(stream);
+	m_stream[1] = static_cast<u32>(stream >> 32);
+	SetPosition(0);
+}
+
+void Random::SetPosition(u64 position)
+{
+	m_position = position;
+
+	// the stream sits in the high half of the counter, the block in the low half.
+	const u64 block = position >> 2;
+	const u32 counter[4] = { static_cast<u32>(block), static_cast<u32>(block >> 32), m_stream[0], m_stream[1] };
+	Philox4x32(counter, m_key, m_block);
+}
+
+u32 Random::Next()
+{
+	const u32 value = m_block[m_position & 3];
+	++m_position;
+	if ((m_position & 3) == 0)
+	{
+		SetPosition(m_position);
+	}
+	return value;
+}
+
+u32 Random::Next(u32 range)
+{
+	// multiply and shift, redrawing the few values that would favour the low end of the range.
+	u64 m = static_cast<u64>(Next()) * range;
+	u32 low = static_cast<u32>(m);
+	if (low < range)
+	{
+		const u32 threshold = (0u - range) % range;
+		while (low < threshold)
+		{
+			m = static_cast<u64>(Next()) * range;
+			low = static_cast<u32>(m);
+		}
+	}
+	return static_cast<u32>(m >> 32);
+}
+
+s32 Random::Next(s32 min, s32 max)
+{
+	if (max <= min)
+		return min;
+	return min + static_cast<s32>(Next(static_cast<u32>(max - min)));
+}
+
+f32 Random::NextF32()
+{
+	// 24 bits, all a float holds.
+	return static_cast<f32>(Next() >> 8) * (1.f / 16777216.f);
+}
+
+void Random::Philox4x32(const u32 counter[4], const u32 key[2], u32 result[4])
+{
+	u32 c0 = counter[0];
+	u32 c1 = counter[1];
+	u32 c2 = counter[2];
+	u32 c3 = counter[3];
+	u32 k0 = key[0];
+	u32 k1 = key[1];
+
+	for (u32 round = 0; round < PHILOX_ROUNDS; ++round)
+	{
+		const u64 p0 = static_cast<u64>(PHILOX_M0) * c0;
+		const u64 p1 = static_cast<u64>(PHILOX_M1) * c2;
+		c0 = static_cast<u32>(p1 >> 32) ^ c1 ^ k0;
+		c1 = static_cast<u32>(p1);
+		c2 = static_cast<u32>(p0 >> 32) ^ c3 ^ k1;
+		c3 = static_cast<u32>(p0);
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+
+	result[0] = c0;
+	result[1] = c1;
+	result[2] = c2;
+	result[3] = c3;
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "basic_types.h"
+
+namespace TB8
+{
+
+// counter based random numbers, Philox4x32-10.
+//  each value is a hash of a 64 bit seed, a 64 bit stream and the value's position in the stream, so there's no state
+//  shared between streams.  give each entity its own stream and they can draw in any order, or on any thread, and
+//  still draw the same values.
+class Random
+{
+public:
+	Random();
+	Random(u64 seed, u64 stream);
+
+	void Seed(u64 seed, u64 stream);
+
+	u32 Next();
+	// uniform in [0, range), 0 for a range of 0.
+	u32 Next(u32 range);
+	// uniform in [min, max).
+	s32 Next(s32 min, s32 max);
+	// uniform in [0, 1).
+	f32 NextF32();
+	bool NextBool() { return (Next() & 1) != 0; }
+
+	// values drawn since it was seeded, to save and restore a stream for replay.
+	u64 GetPosition() const { return m_position; }
+	void SetPosition(u64 position);
+
+	// one block of the generator, 4 values for a 128 bit counter and 64 bit key.
+	static void Philox4x32(const u32 counter[4], const u32 key[2], u32 result[4]);
+
+private:
+	u32							m_key[2];
+	u32							m_stream[2];
+	u64							m_position;
+	u32							m_block[4];			// the block m_position is in.
+};
+
+}
@@ -2,7 +2,7 @@
 
 #include <atomic>
 
-#include "common/basic_types.h"
+#include "Common/basic_types.h"
 
 namespace TB8
 {
@@ -0,0 +1,123 @@
+/*
+	Copyright (C) 2019 8 Byte Technology Inc. - All Rights Reserved
+*/
+#include "pch.h"
+
+#include "EventMessagePool.h"
+
+namespace TB8
+{
+
+const u32 EVENTMESSAGEPOOL_INDEX_HEAP = UINT_MAX;
+const size_t EVENTMESSAGEPOOL_HEADER_SIZE = 16;		// keeps the message 16 byte aligned.
+
+EventMessagePool::EventMessagePool(size_t size)
+	: m_blockStride(EVENTMESSAGEPOOL_HEADER_SIZE + ((size + 15) & ~static_cast<size_t>(15)))
+	, m_freeHead(0)
+	, m_slabCount(0)
+{
+	for (u32 i = 0; i < EVENTMESSAGEPOOL_SLAB_MAX; ++i)
+	{
+		m_slabs[i].store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+EventMessagePool::~EventMessagePool()
+{
+	for (u32 i = 0; i < m_slabCount.load(); ++i)
+	{
+		TB8_FREE(m_slabs[i].load());
+	}
+}
+
+void* EventMessagePool::Alloc()
+{
+	EventMessagePool_Block* pBlock = __Pop();
+	if (!pBlock)
+	{
+		pBlock = __Grow();
+	}
+	return reinterpret_cast<u8*>(pBlock) + EVENTMESSAGEPOOL_HEADER_SIZE;
+}
+
+void EventMessagePool::Free(void* p)
+{
+	EventMessagePool_Block* pBlock = reinterpret_cast<EventMessagePool_Block*>(static_cast<u8*>(p) - EVENTMESSAGEPOOL_HEADER_SIZE);
+	if (pBlock->m_index == EVENTMESSAGEPOOL_INDEX_HEAP)
+	{
+		pBlock->~EventMessagePool_Block();
+		TB8_FREE(pBlock);
+		return;
+	}
+	__Push(pBlock);
+}
+
+EventMessagePool_Block* EventMessagePool::__GetBlock(u32 index) const
+{
+	u8* pSlab = m_slabs[index / EVENTMESSAGEPOOL_SLAB_BLOCKS].load(std::memory_order_acquire);
+	return reinterpret_cast<EventMessagePool_Block*>(pSlab + ((index % EVENTMESSAGEPOOL_SLAB_BLOCKS) * m_blockStride));
+}
+
+void EventMessagePool::__Push(EventMessagePool_Block* pBlock)
+{
+	u64 head = m_freeHead.load(std::memory_order_relaxed);
+	u64 headNew;
+	do
+	{
+		pBlock->m_next.store(static_cast<u32>(head), std::memory_order_relaxed);
+		headNew = (((head >> 32) + 1) << 32) | (pBlock->m_index + 1);
+	} while (!m_freeHead.compare_exchange_weak(head, headNew, std::memory_order_release, std::memory_order_relaxed));
+}
+
+EventMessagePool_Block* EventMessagePool::__Pop()
+{
+	u64 head = m_freeHead.load(std::memory_order_acquire);
+	for (;;)
+	{
+		const u32 index = static_cast<u32>(head);
+		if (!index)
+			return nullptr;
+
+		// the link may be stale if another thread pops this block first, but then the tag has moved on and the swap fails.
+		EventMessagePool_Block* pBlock = __GetBlock(index - 1);
+		const u64 headNew = (((head >> 32) + 1) << 32) | pBlock->m_next.load(std::memory_order_relaxed);
+		if (m_freeHead.compare_exchange_weak(head, headNew, std::memory_order_acquire, std::memory_order_acquire))
+			return pBlock;
+	}
+}
+
+EventMessagePool_Block* EventMessagePool::__Grow()
+{
+	std::lock_guard<std::mutex> lock(m_growMutex);
+
+	// another thread may have grown it while this one waited.
+	EventMessagePool_Block* pBlock = __Pop();
+	if (pBlock)
+		return pBlock;
+
+	const u32 slabIndex = m_slabCount.load(std::memory_order_relaxed);
+	if (slabIndex >= EVENTMESSAGEPOOL_SLAB_MAX)
+	{
+		pBlock = new(TB8_MALLOC(m_blockStride)) EventMessagePool_Block();
+		pBlock->m_index = EVENTMESSAGEPOOL_INDEX_HEAP;
+		return pBlock;
+	}
+
+	u8* pSlab = static_cast<u8*>(TB8_MALLOC(m_blockStride * EVENTMESSAGEPOOL_SLAB_BLOCKS));
+	for (u32 i = 0; i < EVENTMESSAGEPOOL_SLAB_BLOCKS; ++i)
+	{
+		EventMessagePool_Block* pSlabBlock = new(pSlab + (i * m_blockStride)) EventMessagePool_Block();
+		pSlabBlock->m_index = (slabIndex * EVENTMESSAGEPOOL_SLAB_BLOCKS) + i;
+	}
+	m_slabs[slabIndex].store(pSlab, std::memory_order_release);
+	m_slabCount.store(slabIndex + 1, std::memory_order_release);
+
+	// keep the first, free the rest.
+	for (u32 i = 1; i < EVENTMESSAGEPOOL_SLAB_BLOCKS; ++i)
+	{
+		__Push(reinterpret_cast<EventMessagePool_Block*>(pSlab + (i * m_blockStride)));
+	}
+	return reinterpret_cast<EventMessagePool_Block*>(pSlab);
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <limits.h>
+
+#include <new>
+#include <utility>
+#include <atomic>
+#include <mutex>
+
+#include "Common/basic_types.h"
+
+namespace TB8
+{
+
+const u32 EVENTMESSAGEPOOL_SLAB_BLOCKS = 64;
+const u32 EVENTMESSAGEPOOL_SLAB_MAX = 1024;			// slabs, so past 64k blocks in use, blocks come from the heap.
+
+struct EventMessagePool_Block
+{
+	std::atomic<u32>	m_next;			// free list link, a block index + 1.
+	u32					m_index;		// EVENTMESSAGEPOOL_INDEX_HEAP for a block from the heap.
+};
+
+// fixed size blocks for one message type, recycled on a lock free free list, so steady traffic doesn't touch the heap.
+//  any thread can alloc and free.  slabs are only released with the pool.
+class EventMessagePool
+{
+public:
+	EventMessagePool(size_t size);
+	~EventMessagePool();
+
+	void* Alloc();
+	void Free(void* p);
+
+	u32 GetBlockCount() const { return m_slabCount.load(std::memory_order_relaxed) * EVENTMESSAGEPOOL_SLAB_BLOCKS; }
+
+	// a pool per message type, for its Alloc() and __Free().
+	template <class T> static EventMessagePool& Get()
+	{
+		static EventMessagePool s_pool(sizeof(T));
+		return s_pool;
+	}
+	template <class T, class... TArgs> static T* New(TArgs&&... args)
+	{
+		return new(Get<T>().Alloc()) T(std::forward<TArgs>(args)...);
+	}
+	template <class T> static void Delete(T* p)
+	{
+		p->~T();
+		Get<T>().Free(p);
+	}
+
+private:
+	EventMessagePool_Block* __GetBlock(u32 index) const;
+	void __Push(EventMessagePool_Block* pBlock);
+	EventMessagePool_Block* __Pop();
+	EventMessagePool_Block* __Grow();
+
+	size_t								m_blockStride;
+	std::atomic<u64>					m_freeHead;				// (tag << 32) | (block index + 1), the tag stops ABA.
+	std::atomic<u8*>					m_slabs[EVENTMESSAGEPOOL_SLAB_MAX];
+	std::atomic<u32>					m_slabCount;
+	std::mutex							m_growMutex;
+};
+
+}
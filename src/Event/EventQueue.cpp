@@ -3,6 +3,9 @@
 */
 #include "pch.h"
 
+#include <algorithm>
+#include <chrono>
+
 #include "EventQueueModules.h"
 #include "EventQueueMessage.h"
 #include "EventQueueMessages.h"
@@ -12,6 +15,71 @@
 namespace TB8
 {
 
+const u32 EVENTQUEUE_TARGET_BUCKETS_MIN = 64;
+// a registree's slots are compacted once this many are tombstones, and they're at least half of them.
+const u32 EVENTQUEUE_REGISTREE_TOMBSTONES_MIN = 16;
+
+// about a quarter of a 60hz frame.
+const u32 EVENTQUEUE_FRAME_BUDGET_DEFAULT_US = 4000;
+
+static u64 EventQueue_GetRegistreeKey(EventModuleID moduleID, u32 subModuleID)
+{
+	return (static_cast<u64>(moduleID) << 32) | subModuleID;
+}
+
+struct EventQueueCoalesceDefault
+{
+	EventMessageID		m_messageID;
+	EventQueueCoalesce	m_coalesce;
+};
+
+static const EventQueueCoalesceDefault s_coalesceDefaults[] =
+{
+	{ EventMessageID_MouseCursorMove, EventQueueCoalesce_KeepLatest },
+	{ EventMessageID_MouseLBDownHold, EventQueueCoalesce_KeepLatest },
+	{ EventMessageID_MouseMoveWheel, EventQueueCoalesce_SumDeltas },
+};
+
+struct EventQueuePriorityDefault
+{
+	EventMessageID		m_messageID;
+	EventQueuePriority	m_priority;
+};
+
+// anything not here is simulation.
+static const EventQueuePriorityDefault s_priorityDefaults[] =
+{
+	{ EventMessageID_MoveStart, EventQueuePriority_Input },
+	{ EventMessageID_MoveEnd, EventQueuePriority_Input },
+	{ EventMessageID_ResizeWindow, EventQueuePriority_Input },
+	{ EventMessageID_WindowDPIChanged, EventQueuePriority_Input },
+	{ EventMessageID_RenderAreaResize, EventQueuePriority_Input },
+	{ EventMessageID_Activate, EventQueuePriority_Input },
+	{ EventMessageID_Rotate, EventQueuePriority_Input },
+	{ EventMessageID_Close, EventQueuePriority_Input },
+	{ EventMessageID_MouseCursorMove, EventQueuePriority_Input },
+	{ EventMessageID_MouseLBDown, EventQueuePriority_Input },
+	{ EventMessageID_MouseLBDownHold, EventQueuePriority_Input },
+	{ EventMessageID_MouseLBUp, EventQueuePriority_Input },
+	{ EventMessageID_MouseLeave, EventQueuePriority_Input },
+	{ EventMessageID_MouseHover, EventQueuePriority_Input },
+	{ EventMessageID_MouseLBDoubleClick, EventQueuePriority_Input },
+	{ EventMessageID_MouseMoveWheel, EventQueuePriority_Input },
+	{ EventMessageID_UnitThought, EventQueuePriority_Cosmetic },
+};
+
+void EventQueueRegistration::Call(EventMessage* message) const
+{
+	if (m_pThunk)
+	{
+		m_pThunk(m_pObject, m_method, message);
+	}
+	else
+	{
+		m_pCallback(message);
+	}
+}
+
 bool EventQueueRegistration::operator <(const EventQueueRegistration& rhs) const
 {
 	if (m_moduleID != rhs.m_moduleID)
@@ -19,11 +87,140 @@ bool EventQueueRegistration::operator <(const EventQueueRegistration& rhs) const
 	return m_subModuleID < rhs.m_subModuleID;
 }
 
-bool EventQueueMessageTarget::operator <(const EventQueueMessageTarget& rhs) const
+bool EventQueueBatchRegistration::operator <(const EventQueueBatchRegistration& rhs) const
+{
+	if (m_moduleID != rhs.m_moduleID)
+		return m_moduleID < rhs.m_moduleID;
+	return m_subModuleID < rhs.m_subModuleID;
+}
+
+EventQueueTargetTable::EventQueueTargetTable()
+	: m_count(0)
 {
-	if (m_objectID != rhs.m_objectID)
-		return m_objectID < rhs.m_objectID;
-	return m_messageID < rhs.m_messageID;
+}
+
+u32 EventQueueTargetTable::__GetHomeBucket(u32 objectID, EventMessageID messageID) const
+{
+	// fibonacci hash of the pair, the top bits are the best mixed.
+	const u64 key = (static_cast<u64>(objectID) << 32) | static_cast<u64>(messageID);
+	const u64 hash = key * 0x9E3779B97F4A7C15ull;
+	return static_cast<u32>(hash >> 32) & static_cast<u32>(m_buckets.size() - 1);
+}
+
+u32 EventQueueTargetTable::__FindBucket(u32 objectID, EventMessageID messageID) const
+{
+	if (m_buckets.empty())
+		return EVENTQUEUE_TARGET_NONE;
+
+	const u32 mask = static_cast<u32>(m_buckets.size() - 1);
+	for (u32 i = __GetHomeBucket(objectID, messageID); ; i = (i + 1) & mask)
+	{
+		const EventQueueTargetBucket& bucket = m_buckets[i];
+		if (bucket.m_targetIndex == EVENTQUEUE_TARGET_NONE)
+			return EVENTQUEUE_TARGET_NONE;
+		if ((bucket.m_objectID == objectID) && (bucket.m_messageID == messageID))
+			return i;
+	}
+}
+
+u32 EventQueueTargetTable::Find(u32 objectID, EventMessageID messageID) const
+{
+	const u32 iBucket = __FindBucket(objectID, messageID);
+	return (iBucket != EVENTQUEUE_TARGET_NONE) ? m_buckets[iBucket].m_targetIndex : EVENTQUEUE_TARGET_NONE;
+}
+
+u32 EventQueueTargetTable::FindOrAdd(u32 objectID, EventMessageID messageID)
+{
+	assert(objectID != 0);
+
+	const u32 targetIndex = Find(objectID, messageID);
+	if (targetIndex != EVENTQUEUE_TARGET_NONE)
+		return targetIndex;
+
+	// keep the load under a half, so probes stay short.
+	if (((m_count + 1) * 2) > m_buckets.size())
+	{
+		__Grow();
+	}
+
+	u32 newTargetIndex;
+	if (!m_freeTargets.empty())
+	{
+		newTargetIndex = m_freeTargets.back();
+		m_freeTargets.pop_back();
+	}
+	else
+	{
+		newTargetIndex = static_cast<u32>(m_targets.size());
+		m_targets.push_back(EventQueueTarget());
+	}
+	EventQueueTarget& target = m_targets[newTargetIndex];
+	target.m_objectID = objectID;
+	target.m_messageID = messageID;
+	target.m_registrations.clear();
+
+	const u32 mask = static_cast<u32>(m_buckets.size() - 1);
+	u32 i = __GetHomeBucket(objectID, messageID);
+	while (m_buckets[i].m_targetIndex != EVENTQUEUE_TARGET_NONE)
+	{
+		i = (i + 1) & mask;
+	}
+	m_buckets[i].m_objectID = objectID;
+	m_buckets[i].m_messageID = messageID;
+	m_buckets[i].m_targetIndex = newTargetIndex;
+	++m_count;
+
+	return newTargetIndex;
+}
+
+void EventQueueTargetTable::Remove(u32 targetIndex)
+{
+	EventQueueTarget& target = m_targets[targetIndex];
+	u32 i = __FindBucket(target.m_objectID, target.m_messageID);
+	assert(i != EVENTQUEUE_TARGET_NONE);
+
+	// shift back the buckets after it that would otherwise be cut off from their home bucket, no tombstones.
+	const u32 mask = static_cast<u32>(m_buckets.size() - 1);
+	for (u32 j = (i + 1) & mask; m_buckets[j].m_targetIndex != EVENTQUEUE_TARGET_NONE; j = (j + 1) & mask)
+	{
+		const u32 home = __GetHomeBucket(m_buckets[j].m_objectID, m_buckets[j].m_messageID);
+		const bool isBetween = (i <= j) ? ((i < home) && (home <= j)) : ((i < home) || (home <= j));
+		if (isBetween)
+			continue;
+		m_buckets[i] = m_buckets[j];
+		i = j;
+	}
+	m_buckets[i].m_targetIndex = EVENTQUEUE_TARGET_NONE;
+	--m_count;
+
+	target.m_objectID = 0;
+	target.m_registrations.clear();
+	m_freeTargets.push_back(targetIndex);
+}
+
+void EventQueueTargetTable::__Grow()
+{
+	std::vector<EventQueueTargetBucket> buckets;
+	buckets.swap(m_buckets);
+
+	EventQueueTargetBucket empty;
+	empty.m_objectID = 0;
+	empty.m_messageID = EventMessageID_Invalid;
+	empty.m_targetIndex = EVENTQUEUE_TARGET_NONE;
+	m_buckets.resize(std::max<size_t>(buckets.size() * 2, EVENTQUEUE_TARGET_BUCKETS_MIN), empty);
+
+	const u32 mask = static_cast<u32>(m_buckets.size() - 1);
+	for (std::vector<EventQueueTargetBucket>::const_iterator it = buckets.begin(); it != buckets.end(); ++it)
+	{
+		if (it->m_targetIndex == EVENTQUEUE_TARGET_NONE)
+			continue;
+		u32 i = __GetHomeBucket(it->m_objectID, it->m_messageID);
+		while (m_buckets[i].m_targetIndex != EVENTQUEUE_TARGET_NONE)
+		{
+			i = (i + 1) & mask;
+		}
+		m_buckets[i] = *it;
+	}
 }
 
 EventQueuePending::~EventQueuePending()
@@ -32,13 +229,33 @@ EventQueuePending::~EventQueuePending()
 	{
 		EventMessage* message = m_messages.front();
 		m_messages.pop_front();
-		message->Release();
+		RELEASEI(message);
+	}
+	for (u32 priority = 0; priority < EventQueuePriority_Count; ++priority)
+	{
+		while (!m_queues[priority].empty())
+		{
+			EventMessage* message = m_queues[priority].front().m_message;
+			m_queues[priority].pop_front();
+			RELEASEI(message);
+		}
 	}
 }
 
 EventQueue::EventQueue()
-	: m_index(0)
+	: m_frameBudgetNS(static_cast<u64>(EVENTQUEUE_FRAME_BUDGET_DEFAULT_US) * 1000)
+	, m_processIndex(0)
+	, m_batchRegistrationCount(0)
+	, m_isDispatching(false)
 {
+	for (u32 i = 0; i < ARRAYSIZE(s_coalesceDefaults); ++i)
+	{
+		SetCoalesce(s_coalesceDefaults[i].m_messageID, s_coalesceDefaults[i].m_coalesce);
+	}
+	for (u32 i = 0; i < ARRAYSIZE(s_priorityDefaults); ++i)
+	{
+		SetPriority(s_priorityDefaults[i].m_messageID, s_priorityDefaults[i].m_priority);
+	}
 }
 
 EventQueue::~EventQueue()
@@ -58,32 +275,72 @@ void EventQueue::Free()
 
 void EventQueue::QueueMessage(EventMessage** message)
 {
+#if defined(TB8_EVENTQUEUE_STATS)
+	m_stats.OnQueued(*message);
+#endif
 	// steals ownership of the reference to the message.
-	m_pending[m_index].m_messages.push_back(*message);
+	m_inbox.Push(*message);
 	*message = nullptr;
 }
 
 void EventQueue::ProcessPending()
 {
-	// swap the queue.
-	EventQueuePending& pending = m_pending[m_index];
-	m_index = __GetNextIndex();
+	// take what's been queued so far, anything queued from here on is for next time.
+	EventQueuePending& pending = m_pending;
+	m_inbox.Pop(m_inbox.GetTicketCount(), &pending.m_messages);
+	__CoalescePending();
 
-	// process pending messages.
-	while (!pending.m_messages.empty())
+	// hand each batch handler its messages.
+	if (m_batchRegistrationCount)
 	{
-		// get the first message.
-		EventMessage* message = pending.m_messages.front();
-		pending.m_messages.pop_front();
+		m_isDispatching = true;
+		__DispatchBatches();
+		m_isDispatching = false;
+		__ProcessDeferredRegistrations();
+	}
 
-		// dispatch to those that specifically asked for this object id.
-		__DispatchMessageObject(message);
+	// queue them by priority, after those rolled over from earlier frames.
+	++m_processIndex;
+	for (std::deque<EventMessage*>::const_iterator it = pending.m_messages.begin(); it != pending.m_messages.end(); ++it)
+	{
+		if (!*it)
+			continue;
+		EventQueuePendingEntry entry;
+		entry.m_message = *it;
+		entry.m_processIndex = m_processIndex;
+		pending.m_queues[__GetPriority(entry.m_message->GetID())].push_back(entry);
+	}
+	pending.m_messages.clear();
+#if defined(TB8_EVENTQUEUE_STATS)
+	u64 depth = 0;
+	for (u32 priority = 0; priority < EventQueuePriority_Count; ++priority)
+	{
+		depth += pending.m_queues[priority].size();
+	}
+	m_stats.OnPendingDepth(depth);
+#endif
 
-		// dispatch to those that wanted this message, and didn't specify an object id.
-		__DispatchMessageGeneric(message);
+	// process pending messages.  input doesn't wait, the rest roll over once the budget's spent, until they're
+	//  overdue.  the queues are in the order the messages were first up, so only the front can be overdue.
+	const std::chrono::steady_clock::time_point timeStart = std::chrono::steady_clock::now();
+	for (u32 priority = 0; priority < EventQueuePriority_Count; ++priority)
+	{
+		std::deque<EventQueuePendingEntry>& queue = pending.m_queues[priority];
+		while (!queue.empty())
+		{
+			const EventQueuePendingEntry& entry = queue.front();
+			const bool isOverdue = (m_processIndex - entry.m_processIndex) >= EVENTQUEUE_ROLLOVER_MAX;
+			if ((priority != EventQueuePriority_Input) && !isOverdue && m_frameBudgetNS)
+			{
+				const u64 elapsedNS = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - timeStart).count();
+				if (elapsedNS >= m_frameBudgetNS)
+					break;
+			}
 
-		// we're done with this message, release it.
-		message->Release();
+			EventMessage* message = entry.m_message;
+			queue.pop_front();
+			__DispatchMessage(message);
+		}
 	}
 
 	// process targets & registrees that unregistered.
@@ -91,96 +348,407 @@ void EventQueue::ProcessPending()
 	__ProcessDeferredUnregistrations();
 }
 
+EventQueueTimerID EventQueue::QueueMessageAt(EventMessage** message, u64 frame)
+{
+	if (frame <= m_timers.GetFrame())
+	{
+		QueueMessage(message);
+		return EVENTQUEUE_TIMER_NONE;
+	}
+
+	// steals ownership of the reference to the message.
+	const EventQueueTimerID timerID = m_timers.Add(*message, frame);
+	*message = nullptr;
+	return timerID;
+}
+
+EventQueueTimerID EventQueue::QueueMessageAfter(EventMessage** message, u32 frameCount)
+{
+	return QueueMessageAt(message, m_timers.GetFrame() + frameCount);
+}
+
+bool EventQueue::CancelMessage(EventQueueTimerID timerID)
+{
+	return m_timers.Cancel(timerID);
+}
+
+void EventQueue::AdvanceFrames(u32 frameCount)
+{
+	m_timers.Advance(m_timers.GetFrame() + frameCount, &m_timersDue);
+	for (std::vector<EventMessage*>::iterator it = m_timersDue.begin(); it != m_timersDue.end(); ++it)
+	{
+		QueueMessage(&(*it));
+	}
+	m_timersDue.clear();
+
+#if defined(TB8_EVENTQUEUE_STATS)
+	m_stats.AdvanceFrames(frameCount);
+#endif
+}
+
+void EventQueue::SetProfiler(EventQueueProfiler* pProfiler)
+{
+#if defined(TB8_EVENTQUEUE_STATS)
+	m_stats.SetProfiler(pProfiler);
+#else
+	(void)pProfiler;
+#endif
+}
+
+void EventQueue::SetStatsDumpFrames(u32 frameCount)
+{
+#if defined(TB8_EVENTQUEUE_STATS)
+	m_stats.SetDumpFrames(frameCount);
+#else
+	(void)frameCount;
+#endif
+}
+
+void EventQueue::DumpStats()
+{
+#if defined(TB8_EVENTQUEUE_STATS)
+	m_stats.Dump();
+#endif
+}
+
+void EventQueue::SetPriority(EventMessageID messageID, EventQueuePriority priority)
+{
+	if (messageID >= m_priorities.size())
+	{
+		m_priorities.resize(messageID + 1, EventQueuePriority_Simulation);
+	}
+	m_priorities[messageID] = priority;
+}
+
+EventQueuePriority EventQueue::__GetPriority(EventMessageID messageID) const
+{
+	return (messageID < m_priorities.size()) ? m_priorities[messageID] : EventQueuePriority_Simulation;
+}
+
+void EventQueue::SetCoalesce(EventMessageID messageID, EventQueueCoalesce coalesce)
+{
+	if (messageID >= m_coalesce.size())
+	{
+		m_coalesce.resize(messageID + 1, EventQueueCoalesce_None);
+	}
+	m_coalesce[messageID] = coalesce;
+}
+
+EventQueueCoalesce EventQueue::__GetCoalesce(EventMessageID messageID) const
+{
+	return (messageID < m_coalesce.size()) ? m_coalesce[messageID] : EventQueueCoalesce_None;
+}
+
+void EventQueue::__CoalescePending()
+{
+	// few ids coalesce, and fewer objects send them, so the entries are searched in order.  dropped messages leave a
+	//  nullptr behind.
+	std::deque<EventMessage*>& messages = m_pending.m_messages;
+	m_coalesceEntries.clear();
+	for (size_t i = 0; i < messages.size(); ++i)
+	{
+		EventMessage* message = messages[i];
+		const EventQueueCoalesce coalesce = __GetCoalesce(message->GetID());
+		if (coalesce == EventQueueCoalesce_None)
+			continue;
+
+		std::vector<EventQueueCoalesceEntry>::iterator itEntry = m_coalesceEntries.begin();
+		while ((itEntry != m_coalesceEntries.end()) && ((itEntry->m_messageID != message->GetID()) || (itEntry->m_objectID != message->GetObjectID())))
+		{
+			++itEntry;
+		}
+		if (itEntry == m_coalesceEntries.end())
+		{
+			EventQueueCoalesceEntry entry;
+			entry.m_messageID = message->GetID();
+			entry.m_objectID = message->GetObjectID();
+			entry.m_pendingIndex = i;
+			m_coalesceEntries.push_back(entry);
+			continue;
+		}
+
+		EventMessage*& earlier = messages[itEntry->m_pendingIndex];
+		switch (coalesce)
+		{
+		case EventQueueCoalesce_SumDeltas:
+			message->Accumulate(earlier);
+			RELEASEI(earlier);
+			break;
+
+		case EventQueueCoalesce_KeepLatest:
+			RELEASEI(earlier);
+			break;
+
+		default:
+			break;
+		}
+		itEntry->m_pendingIndex = i;
+	}
+}
+
 void EventQueue::__CleanupDestroyedTargets()
 {
 	while (!m_destroyedTargets.empty())
 	{
-		EventQueueMessageTarget target;
-		target.m_objectID = m_destroyedTargets.front();
-		target.m_messageID = EventMessageID_Invalid;
-
-		std::map<EventQueueMessageTarget, std::set<EventQueueRegistration>>::iterator itTarget = m_targets.lower_bound(target);
-		while ((itTarget != m_targets.end()) && (itTarget->first.m_objectID == target.m_objectID))
+		const u32 objectID = m_destroyedTargets.front();
+		std::unordered_map<u32, std::vector<EventMessageID>>::iterator itObject = m_objectTargets.find(objectID);
+		if (itObject != m_objectTargets.end())
 		{
-			std::map<EventQueueMessageTarget, std::set<EventQueueRegistration>>::iterator itDel = itTarget;
-			++itTarget;
-			m_targets.erase(itDel);
+			for (std::vector<EventMessageID>::const_iterator itMessage = itObject->second.begin(); itMessage != itObject->second.end(); ++itMessage)
+			{
+				const u32 targetIndex = m_targets.Find(objectID, *itMessage);
+				const std::vector<EventQueueRegistration>& registrations = m_targets.GetTarget(targetIndex).m_registrations;
+				for (std::vector<EventQueueRegistration>::const_iterator itReg = registrations.begin(); itReg != registrations.end(); ++itReg)
+				{
+					__RemoveRegistreeSlot(itReg->m_moduleID, itReg->m_subModuleID, itReg->m_registreeSlot);
+				}
+				m_targets.Remove(targetIndex);
+			}
+			m_objectTargets.erase(itObject);
 		}
 
 		m_destroyedTargets.pop_front();
 	}
 }
 
+void EventQueue::__ProcessDeferredRegistrations()
+{
+	for (std::vector<EventQueueDeferredRegistration>::const_iterator it = m_deferredRegistrations.begin(); it != m_deferredRegistrations.end(); ++it)
+	{
+		__AddRegistration(it->m_objectID, it->m_messageID, it->m_registration);
+	}
+	m_deferredRegistrations.clear();
+
+	for (std::vector<EventQueueDeferredBatchRegistration>::const_iterator it = m_deferredBatchRegistrations.begin(); it != m_deferredBatchRegistrations.end(); ++it)
+	{
+		__AddBatchRegistration(it->m_messageID, it->m_registration);
+	}
+	m_deferredBatchRegistrations.clear();
+}
+
 void EventQueue::__ProcessDeferredUnregistrations()
 {
 	while (!m_deferredUnregistrations.empty())
 	{
 		const EventQueueDeferredUnregistration& unreg = m_deferredUnregistrations.front();
-
-		EventQueueMessageTarget target;
-		target.m_objectID = unreg.m_objectID;
-		target.m_messageID = unreg.m_messageID;
-
-		std::map<EventQueueMessageTarget, std::set<EventQueueRegistration>>::iterator itTarget = m_targets.find(target);
-		if (itTarget != m_targets.end())
+		if (unreg.m_isBatch)
 		{
-			std::set<EventQueueRegistration>& registrations = itTarget->second;
+			std::vector<EventQueueBatchRegistration>& registrations = m_batchRegistrations[unreg.m_messageID];
+			EventQueueBatchRegistration* pReg = __FindBatchRegistration(unreg.m_moduleID, unreg.m_subModuleID, unreg.m_messageID);
+			if (pReg && pReg->m_isUnregistered)
+			{
+				__RemoveRegistreeSlot(unreg.m_moduleID, unreg.m_subModuleID, pReg->m_registreeSlot);
+				registrations.erase(registrations.begin() + (pReg - registrations.data()));
+				--m_batchRegistrationCount;
+			}
+			m_deferredUnregistrations.pop_front();
+			continue;
+		}
 
-			EventQueueRegistration reg;
-			reg.m_moduleID = unreg.m_moduleID;
-			reg.m_subModuleID = unreg.m_subModuleID;
+		std::vector<EventQueueRegistration>* pRegistrations = __FindRegistrations(unreg.m_objectID, unreg.m_messageID);
+		if (pRegistrations)
+		{
+			EventQueueRegistration* pReg = __FindRegistration(*pRegistrations, unreg.m_moduleID, unreg.m_subModuleID);
+			if (pReg && !pReg->IsSet())
+			{
+				__RemoveRegistreeSlot(unreg.m_moduleID, unreg.m_subModuleID, pReg->m_registreeSlot);
+				pRegistrations->erase(pRegistrations->begin() + (pReg - pRegistrations->data()));
+			}
 
-			registrations.erase(reg);
+			// drop object targets with no one left listening.
+			if (pRegistrations->empty() && (unreg.m_objectID != 0))
+			{
+				m_targets.Remove(m_targets.Find(unreg.m_objectID, unreg.m_messageID));
+				__RemoveObjectTarget(unreg.m_objectID, unreg.m_messageID);
+			}
 		}
 
 		m_deferredUnregistrations.pop_front();
 	}
 }
 
+void EventQueue::__DispatchBatches()
+{
+	// a stable counting sort by id of the messages with batch handlers, so each id's messages are contiguous and in
+	//  the order they were queued.
+	const u32 idCount = static_cast<u32>(m_batchRegistrations.size());
+	m_batchOffsets.assign(idCount + 1, 0);
+	for (std::deque<EventMessage*>::const_iterator it = m_pending.m_messages.begin(); it != m_pending.m_messages.end(); ++it)
+	{
+		const EventMessage* message = *it;
+		if (message && (message->GetID() < idCount) && !m_batchRegistrations[message->GetID()].empty())
+		{
+			++m_batchOffsets[message->GetID() + 1];
+		}
+	}
+	for (u32 id = 0; id < idCount; ++id)
+	{
+		m_batchOffsets[id + 1] += m_batchOffsets[id];
+	}
+	if (!m_batchOffsets[idCount])
+		return;
+
+	m_batchMessages.resize(m_batchOffsets[idCount]);
+	for (std::deque<EventMessage*>::const_iterator it = m_pending.m_messages.begin(); it != m_pending.m_messages.end(); ++it)
+	{
+		EventMessage* message = *it;
+		if (message && (message->GetID() < idCount) && !m_batchRegistrations[message->GetID()].empty())
+		{
+			m_batchMessages[m_batchOffsets[message->GetID()]++] = message;
+		}
+	}
+
+	// the offsets are now where each id's messages end.
+	u32 start = 0;
+	for (u32 id = 0; id < idCount; ++id)
+	{
+		const u32 end = m_batchOffsets[id];
+		if (end == start)
+			continue;
+
+		const std::vector<EventQueueBatchRegistration>& registrations = m_batchRegistrations[id];
+		for (std::vector<EventQueueBatchRegistration>::const_iterator itReg = registrations.begin(); itReg != registrations.end(); ++itReg)
+		{
+			if (!itReg->m_isUnregistered)
+			{
+#if defined(TB8_EVENTQUEUE_STATS)
+				const u64 timeStart = m_stats.BeginHandler(itReg->m_moduleID, itReg->m_subModuleID, static_cast<EventMessageID>(id), true);
+#endif
+				itReg->m_pCallback(m_batchMessages.data() + start, end - start);
+#if defined(TB8_EVENTQUEUE_STATS)
+				m_stats.EndHandler(itReg->m_moduleID, itReg->m_subModuleID, static_cast<EventMessageID>(id), true, timeStart);
+#endif
+			}
+		}
+		start = end;
+	}
+	m_batchMessages.clear();
+}
+
+void EventQueue::__DispatchMessage(EventMessage* message)
+{
+#if defined(TB8_EVENTQUEUE_STATS)
+	m_stats.OnDispatched(message);
+#endif
+	m_isDispatching = true;
+
+	// dispatch to those that specifically asked for this object id.
+	__DispatchMessageObject(message);
+
+	// dispatch to those that wanted this message, and didn't specify an object id.
+	__DispatchMessageGeneric(message);
+
+	m_isDispatching = false;
+	__ProcessDeferredRegistrations();
+
+	// we're done with this message, release it.
+	message->Release();
+}
+
+void EventQueue::__CallHandler(const EventQueueRegistration& reg, EventMessage* message)
+{
+#if defined(TB8_EVENTQUEUE_STATS)
+	const u64 timeStart = m_stats.BeginHandler(reg.m_moduleID, reg.m_subModuleID, message->GetID(), false);
+	reg.Call(message);
+	m_stats.EndHandler(reg.m_moduleID, reg.m_subModuleID, message->GetID(), false, timeStart);
+#else
+	reg.Call(message);
+#endif
+}
+
 void EventQueue::__DispatchMessageObject(EventMessage* message)
 {
 	if (message->GetObjectID() == 0)
 		return;
 
-	EventQueueMessageTarget target;
-	target.m_objectID = message->GetObjectID();
-	target.m_messageID = message->GetID();
-
 	// are there registrations for this message?
-	std::map<EventQueueMessageTarget, std::set<EventQueueRegistration>>::iterator itTarget = m_targets.find(target);
-	if (itTarget == m_targets.end())
+	const u32 targetIndex = m_targets.Find(message->GetObjectID(), message->GetID());
+	if (targetIndex == EVENTQUEUE_TARGET_NONE)
 		return;
 
 	// go thru all the registrations, call everyone.
-	__DispatchMessage(message, itTarget->second);
+	const std::vector<EventQueueRegistration>& registrations = m_targets.GetTarget(targetIndex).m_registrations;
+	for (std::vector<EventQueueRegistration>::const_iterator itReg = registrations.begin(); itReg != registrations.end(); ++itReg)
+	{
+		if (itReg->IsSet())
+		{
+			__CallHandler(*itReg, message);
+		}
+	}
 }
 
 void EventQueue::__DispatchMessageGeneric(EventMessage* message)
 {
-	EventQueueMessageTarget target;
-	target.m_objectID = 0;
-	target.m_messageID = message->GetID();
-
 	// are there registrations for this message?
-	std::map<EventQueueMessageTarget, std::set<EventQueueRegistration>>::iterator itTarget = m_targets.find(target);
-	if (itTarget == m_targets.end())
+	if (message->GetID() >= m_messageRegistrations.size())
 		return;
 
 	// go thru all the registrations, call everyone.
-	__DispatchMessage(message, itTarget->second);
+	const std::vector<EventQueueRegistration>& registrations = m_messageRegistrations[message->GetID()];
+	for (std::vector<EventQueueRegistration>::const_iterator itReg = registrations.begin(); itReg != registrations.end(); ++itReg)
+	{
+		if (itReg->IsSet())
+		{
+			__CallHandler(*itReg, message);
+		}
+	}
 }
 
-void EventQueue::__DispatchMessage(EventMessage* message, std::set<EventQueueRegistration>& registrations)
+std::vector<EventQueueRegistration>* EventQueue::__FindRegistrations(u32 objectID, EventMessageID messageID)
 {
-	// go thru all the registrations, call everyone.
-	for (std::set<EventQueueRegistration>::iterator itReg = registrations.begin(); itReg != registrations.end(); ++itReg)
+	if (objectID == 0)
+		return (messageID < m_messageRegistrations.size()) ? &m_messageRegistrations[messageID] : nullptr;
+
+	const u32 targetIndex = m_targets.Find(objectID, messageID);
+	return (targetIndex != EVENTQUEUE_TARGET_NONE) ? &m_targets.GetTarget(targetIndex).m_registrations : nullptr;
+}
+
+EventQueueRegistration* EventQueue::__FindRegistration(std::vector<EventQueueRegistration>& registrations, EventModuleID moduleID, u32 subModuleID)
+{
+	EventQueueRegistration regFind;
+	regFind.m_moduleID = moduleID;
+	regFind.m_subModuleID = subModuleID;
+
+	std::vector<EventQueueRegistration>::iterator itReg = std::lower_bound(registrations.begin(), registrations.end(), regFind);
+	if ((itReg == registrations.end()) || (regFind < *itReg))
+		return nullptr;
+	return &(*itReg);
+}
+
+void EventQueue::__AddRegistration(u32 objectID, EventMessageID messageID, const EventQueueRegistration& reg)
+{
+	std::vector<EventQueueRegistration>* pRegistrations;
+	if (objectID == 0)
 	{
-		const EventQueueRegistration& reg = *itReg;
-		if (reg.m_pCallback)
+		if (messageID >= m_messageRegistrations.size())
 		{
-			reg.m_pCallback(message);
+			m_messageRegistrations.resize(messageID + 1);
 		}
+		pRegistrations = &m_messageRegistrations[messageID];
 	}
+	else
+	{
+		u32 targetIndex = m_targets.Find(objectID, messageID);
+		if (targetIndex == EVENTQUEUE_TARGET_NONE)
+		{
+			targetIndex = m_targets.FindOrAdd(objectID, messageID);
+			m_objectTargets[objectID].push_back(messageID);
+		}
+		pRegistrations = &m_targets.GetTarget(targetIndex).m_registrations;
+	}
+
+	// add the registration, in module order.
+	std::vector<EventQueueRegistration>::iterator itReg = std::lower_bound(pRegistrations->begin(), pRegistrations->end(), reg);
+	if ((itReg != pRegistrations->end()) && !(reg < *itReg))
+	{
+		// registering again replaces the handler, as for batches.
+		const u32 registreeSlot = itReg->m_registreeSlot;
+		*itReg = reg;
+		itReg->m_registreeSlot = registreeSlot;
+		return;
+	}
+	itReg = pRegistrations->insert(itReg, reg);
+	itReg->m_registreeSlot = __AddRegistreeSlot(reg.m_moduleID, reg.m_subModuleID, objectID, messageID, false);
 }
 
 void EventQueue::RegisterForMessage(EventModuleID moduleID, EventMessageID messageID, EventQueueCallback cb)
@@ -190,58 +758,246 @@ void EventQueue::RegisterForMessage(EventModuleID moduleID, EventMessageID messa
 
 void EventQueue::RegisterForMessage(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID, u32 objectID, EventQueueCallback cb)
 {
-	EventQueueMessageTarget target;
-	target.m_objectID = objectID;
-	target.m_messageID = messageID;
+	EventQueueRegistration reg;
+	reg.m_moduleID = moduleID;
+	reg.m_subModuleID = subModuleID;
+	reg.m_pThunk = nullptr;
+	reg.m_pObject = nullptr;
+	reg.m_pCallback = cb;
+	reg.m_isUnregistered = false;
+	__Register(objectID, messageID, reg);
+}
 
+void EventQueue::__RegisterMethod(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID, u32 objectID, EventQueueThunk pThunk, void* pObject, const void* pMethod, size_t methodSize)
+{
 	EventQueueRegistration reg;
 	reg.m_moduleID = moduleID;
 	reg.m_subModuleID = subModuleID;
+	reg.m_pThunk = pThunk;
+	reg.m_pObject = pObject;
+	memcpy(reg.m_method, pMethod, methodSize);
+	reg.m_isUnregistered = false;
+	__Register(objectID, messageID, reg);
+}
+
+void EventQueue::__Register(u32 objectID, EventMessageID messageID, const EventQueueRegistration& reg)
+{
+	if (m_isDispatching)
+	{
+		EventQueueDeferredRegistration deferred;
+		deferred.m_objectID = objectID;
+		deferred.m_messageID = messageID;
+		deferred.m_registration = reg;
+		m_deferredRegistrations.push_back(deferred);
+		return;
+	}
+
+	__AddRegistration(objectID, messageID, reg);
+}
+
+void EventQueue::RegisterForMessageBatch(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID, EventQueueBatchCallback cb)
+{
+	EventQueueBatchRegistration reg;
+	reg.m_moduleID = moduleID;
+	reg.m_subModuleID = subModuleID;
 	reg.m_pCallback = cb;
+	reg.m_isUnregistered = false;
 
-	// look up the event.
-	std::map<EventQueueMessageTarget, std::set<EventQueueRegistration>>::iterator itTarget = m_targets.find(target);
-	if (itTarget == m_targets.end())
+	if (m_isDispatching)
 	{
-		itTarget = m_targets.insert(std::make_pair(target, std::set<EventQueueRegistration>())).first;
+		EventQueueDeferredBatchRegistration deferred;
+		deferred.m_messageID = messageID;
+		deferred.m_registration = reg;
+		m_deferredBatchRegistrations.push_back(deferred);
+		return;
 	}
-	std::set<EventQueueRegistration>& registrations = itTarget->second;
 
-	// add the registration
-	std::pair<std::set<EventQueueRegistration>::iterator, bool> p = registrations.insert(reg);
-	assert(p.second); // fixme: deal with re-registering.
+	__AddBatchRegistration(messageID, reg);
 }
 
-void EventQueue::UnregisterForMessage(EventModuleID moduleID, u32 subModuleID, EventMessageID targetMessageID, u32 targetObjectID)
+void EventQueue::__AddBatchRegistration(EventMessageID messageID, const EventQueueBatchRegistration& reg)
 {
-	EventQueueMessageTarget target;
-	target.m_objectID = targetObjectID;
-	target.m_messageID = targetMessageID;
+	if (messageID >= m_batchRegistrations.size())
+	{
+		m_batchRegistrations.resize(messageID + 1);
+	}
+	std::vector<EventQueueBatchRegistration>& registrations = m_batchRegistrations[messageID];
 
-	EventQueueRegistration regFind;
+	// add the registration, in module order.
+	std::vector<EventQueueBatchRegistration>::iterator itReg = std::lower_bound(registrations.begin(), registrations.end(), reg);
+	if ((itReg != registrations.end()) && !(reg < *itReg))
+	{
+		// registering again replaces the handler, whether it's live or waiting on a deferred unregistration.  adds
+		//  are deferred while dispatching, so the old one isn't running.
+		itReg->m_pCallback = reg.m_pCallback;
+		itReg->m_isUnregistered = false;
+		return;
+	}
+	itReg = registrations.insert(itReg, reg);
+	itReg->m_registreeSlot = __AddRegistreeSlot(reg.m_moduleID, reg.m_subModuleID, 0, messageID, true);
+	++m_batchRegistrationCount;
+}
+
+u32 EventQueue::__AddRegistreeSlot(EventModuleID moduleID, u32 subModuleID, u32 objectID, EventMessageID messageID, bool isBatch)
+{
+	std::unordered_map<u64, EventQueueRegistree>::iterator it = m_registrees.find(EventQueue_GetRegistreeKey(moduleID, subModuleID));
+	if (it == m_registrees.end())
+	{
+		EventQueueRegistree registree;
+		registree.m_tombstoneCount = 0;
+		it = m_registrees.insert(std::make_pair(EventQueue_GetRegistreeKey(moduleID, subModuleID), registree)).first;
+	}
+
+	EventQueueRegistreeSlot slot;
+	slot.m_objectID = objectID;
+	slot.m_messageID = messageID;
+	slot.m_isBatch = isBatch;
+	it->second.m_slots.push_back(slot);
+	return static_cast<u32>(it->second.m_slots.size() - 1);
+}
+
+void EventQueue::__RemoveRegistreeSlot(EventModuleID moduleID, u32 subModuleID, u32 slot)
+{
+	std::unordered_map<u64, EventQueueRegistree>::iterator it = m_registrees.find(EventQueue_GetRegistreeKey(moduleID, subModuleID));
+	EventQueueRegistree& registree = it->second;
+	assert(registree.m_slots[slot].m_messageID != EventMessageID_Invalid);
+
+	registree.m_slots[slot].m_messageID = EventMessageID_Invalid;
+	++registree.m_tombstoneCount;
+	if (registree.m_tombstoneCount == registree.m_slots.size())
+	{
+		m_registrees.erase(it);
+	}
+	else if ((registree.m_tombstoneCount >= EVENTQUEUE_REGISTREE_TOMBSTONES_MIN) && (registree.m_tombstoneCount * 2 >= registree.m_slots.size()))
+	{
+		__CompactRegistree(moduleID, subModuleID, registree);
+	}
+}
+
+void EventQueue::__CompactRegistree(EventModuleID moduleID, u32 subModuleID, EventQueueRegistree& registree)
+{
+	// the registrations in the slots that move are told where they've moved to.
+	u32 slotCount = 0;
+	for (u32 i = 0; i < registree.m_slots.size(); ++i)
+	{
+		const EventQueueRegistreeSlot& slot = registree.m_slots[i];
+		if (slot.m_messageID == EventMessageID_Invalid)
+			continue;
+
+		if (slotCount != i)
+		{
+			if (slot.m_isBatch)
+			{
+				__FindBatchRegistration(moduleID, subModuleID, slot.m_messageID)->m_registreeSlot = slotCount;
+			}
+			else
+			{
+				__FindRegistration(*__FindRegistrations(slot.m_objectID, slot.m_messageID), moduleID, subModuleID)->m_registreeSlot = slotCount;
+			}
+			registree.m_slots[slotCount] = slot;
+		}
+		++slotCount;
+	}
+	registree.m_slots.resize(slotCount);
+	registree.m_tombstoneCount = 0;
+}
+
+void EventQueue::__RemoveObjectTarget(u32 objectID, EventMessageID messageID)
+{
+	std::unordered_map<u32, std::vector<EventMessageID>>::iterator it = m_objectTargets.find(objectID);
+	std::vector<EventMessageID>& messageIDs = it->second;
+	std::vector<EventMessageID>::iterator itMessage = std::find(messageIDs.begin(), messageIDs.end(), messageID);
+	*itMessage = messageIDs.back();
+	messageIDs.pop_back();
+	if (messageIDs.empty())
+	{
+		m_objectTargets.erase(it);
+	}
+}
+
+EventQueueBatchRegistration* EventQueue::__FindBatchRegistration(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID)
+{
+	if (messageID >= m_batchRegistrations.size())
+		return nullptr;
+	std::vector<EventQueueBatchRegistration>& registrations = m_batchRegistrations[messageID];
+
+	EventQueueBatchRegistration regFind;
 	regFind.m_moduleID = moduleID;
 	regFind.m_subModuleID = subModuleID;
-	regFind.m_pCallback = nullptr;
+
+	std::vector<EventQueueBatchRegistration>::iterator itReg = std::lower_bound(registrations.begin(), registrations.end(), regFind);
+	if ((itReg == registrations.end()) || (regFind < *itReg))
+		return nullptr;
+	return &(*itReg);
+}
+
+void EventQueue::UnregisterForMessageBatch(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID)
+{
+	for (std::vector<EventQueueDeferredBatchRegistration>::iterator it = m_deferredBatchRegistrations.begin(); it != m_deferredBatchRegistrations.end(); )
+	{
+		if ((it->m_messageID == messageID) && (it->m_registration.m_moduleID == moduleID) && (it->m_registration.m_subModuleID == subModuleID))
+		{
+			it = m_deferredBatchRegistrations.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	EventQueueBatchRegistration* pReg = __FindBatchRegistration(moduleID, subModuleID, messageID);
+	if (!pReg || pReg->m_isUnregistered)
+		return;
+
+	pReg->m_isUnregistered = true;
+
+	EventQueueDeferredUnregistration unreg;
+	unreg.m_objectID = 0;
+	unreg.m_messageID = messageID;
+	unreg.m_moduleID = moduleID;
+	unreg.m_subModuleID = subModuleID;
+	unreg.m_isBatch = true;
+	m_deferredUnregistrations.push_back(unreg);
+}
+
+void EventQueue::__UnregisterDeferredRegistration(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID, u32 objectID, bool isAnyTarget)
+{
+	for (std::vector<EventQueueDeferredRegistration>::iterator it = m_deferredRegistrations.begin(); it != m_deferredRegistrations.end(); )
+	{
+		const bool isTarget = isAnyTarget || ((it->m_objectID == objectID) && (it->m_messageID == messageID));
+		if (isTarget && (it->m_registration.m_moduleID == moduleID) && (it->m_registration.m_subModuleID == subModuleID))
+		{
+			it = m_deferredRegistrations.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void EventQueue::UnregisterForMessage(EventModuleID moduleID, u32 subModuleID, EventMessageID targetMessageID, u32 targetObjectID)
+{
+	__UnregisterDeferredRegistration(moduleID, subModuleID, targetMessageID, targetObjectID, false);
 
 	// look up the event.
-	std::map<EventQueueMessageTarget, std::set<EventQueueRegistration>>::iterator itTarget = m_targets.find(target);
-	if (itTarget == m_targets.end())
+	std::vector<EventQueueRegistration>* pRegistrations = __FindRegistrations(targetObjectID, targetMessageID);
+	if (!pRegistrations)
 		return;
-	std::set<EventQueueRegistration>& registrations = itTarget->second;
 
 	// look up the registration.
-	std::set<EventQueueRegistration>::iterator itReg = registrations.find(regFind);
-	if (itReg == registrations.end())
+	EventQueueRegistration* pReg = __FindRegistration(*pRegistrations, moduleID, subModuleID);
+	if (!pReg || !pReg->IsSet())
 		return;
 
-	EventQueueRegistration& reg = const_cast<EventQueueRegistration&>(*itReg);
-	reg.m_pCallback = nullptr;
+	pReg->m_isUnregistered = true;
 
 	EventQueueDeferredUnregistration unreg;
 	unreg.m_objectID = targetObjectID;
 	unreg.m_messageID = targetMessageID;
 	unreg.m_moduleID = moduleID;
 	unreg.m_subModuleID = subModuleID;
+	unreg.m_isBatch = false;
 	m_deferredUnregistrations.push_back(unreg);
 }
 
@@ -252,34 +1008,67 @@ void EventQueue::UnregisterForMessagesByRegistree(EventModuleID moduleID)
 
 void EventQueue::UnregisterForMessagesByRegistree(EventModuleID moduleID, u32 subModuleID)
 {
-	EventQueueRegistration regFind;
-	regFind.m_moduleID = moduleID;
-	regFind.m_subModuleID = subModuleID;
-	regFind.m_pCallback = nullptr;
+	__UnregisterDeferredRegistration(moduleID, subModuleID, EventMessageID_Invalid, 0, true);
+	for (std::vector<EventQueueDeferredBatchRegistration>::iterator it = m_deferredBatchRegistrations.begin(); it != m_deferredBatchRegistrations.end(); )
+	{
+		if ((it->m_registration.m_moduleID == moduleID) && (it->m_registration.m_subModuleID == subModuleID))
+		{
+			it = m_deferredBatchRegistrations.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
 
-	for (std::map<EventQueueMessageTarget, std::set<EventQueueRegistration>>::iterator itTarget = m_targets.begin();
-		itTarget != m_targets.end(); ++itTarget)
+	// the unregistrations are deferred, so the slots don't change while they're walked.
+	std::unordered_map<u64, EventQueueRegistree>::const_iterator itRegistree = m_registrees.find(EventQueue_GetRegistreeKey(moduleID, subModuleID));
+	if (itRegistree == m_registrees.end())
+		return;
+	const std::vector<EventQueueRegistreeSlot>& slots = itRegistree->second.m_slots;
+	for (std::vector<EventQueueRegistreeSlot>::const_iterator it = slots.begin(); it != slots.end(); ++it)
 	{
-		const EventQueueMessageTarget& target = itTarget->first;
-		std::set<EventQueueRegistration>& registrations = itTarget->second;
-		std::set<EventQueueRegistration>::iterator itReg = registrations.find(regFind);
-		if (itReg != registrations.end())
+		if (it->m_messageID == EventMessageID_Invalid)
+			continue;
+
+		if (it->m_isBatch)
 		{
-			EventQueueRegistration& reg = const_cast<EventQueueRegistration&>(*itReg);
-			reg.m_pCallback = nullptr;
-
-			EventQueueDeferredUnregistration unreg;
-			unreg.m_objectID = target.m_objectID;
-			unreg.m_messageID = target.m_messageID;
-			unreg.m_moduleID = moduleID;
-			unreg.m_subModuleID = subModuleID;
-			m_deferredUnregistrations.push_back(unreg);
+			UnregisterForMessageBatch(moduleID, subModuleID, it->m_messageID);
+		}
+		else
+		{
+			UnregisterForMessage(moduleID, subModuleID, it->m_messageID, it->m_objectID);
 		}
 	}
 }
 
 void EventQueue::UnregisterForMessagesByTargetObjectID(u32 objectID)
 {
+	for (std::vector<EventQueueDeferredRegistration>::iterator it = m_deferredRegistrations.begin(); it != m_deferredRegistrations.end(); )
+	{
+		if (it->m_objectID == objectID)
+		{
+			it = m_deferredRegistrations.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	// the object's handlers stop now, and are removed after dispatch.
+	std::unordered_map<u32, std::vector<EventMessageID>>::const_iterator itObject = m_objectTargets.find(objectID);
+	if (itObject != m_objectTargets.end())
+	{
+		for (std::vector<EventMessageID>::const_iterator itMessage = itObject->second.begin(); itMessage != itObject->second.end(); ++itMessage)
+		{
+			std::vector<EventQueueRegistration>& registrations = m_targets.GetTarget(m_targets.Find(objectID, *itMessage)).m_registrations;
+			for (std::vector<EventQueueRegistration>::iterator itReg = registrations.begin(); itReg != registrations.end(); ++itReg)
+			{
+				itReg->m_isUnregistered = true;
+			}
+		}
+	}
 	m_destroyedTargets.push_back(objectID);
 }
 
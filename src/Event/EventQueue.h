@@ -1,52 +1,184 @@
 #pragma once
 
-#include <map>
-#include <set>
+#include <limits.h>
+#include <string.h>
+
+#include <vector>
 #include <deque>
 #include <functional>
+#include <unordered_map>
 
-#include "common/basic_types.h"
+#include "Common/basic_types.h"
 
 #include "EventQueueModules.h"
 #include "EventQueueMessage.h"
+#include "EventQueueInbox.h"
+#include "EventQueueTimers.h"
+#include "EventQueueStats.h"
 
 namespace TB8
 {
 
+const u32 EVENTQUEUE_TARGET_NONE = UINT_MAX;
+// the biggest member function pointer, msvc's for a class it doesn't know the inheritance of.
+const u32 EVENTQUEUE_METHOD_SIZE_MAX = 24;
+// calls to ProcessPending() a message can be rolled over for before it's dispatched regardless of the budget.
+const u32 EVENTQUEUE_ROLLOVER_MAX = 4;
+
 typedef std::function<void(EventMessage*)> EventQueueCallback;
+// calls a method, copied into pMethod, on pObject.  see EventQueue::Register().
+typedef void (*EventQueueThunk)(void* pObject, const u8* pMethod, EventMessage* message);
+// all of a frame's pending messages with one id, in the order they were queued.
+typedef std::function<void(EventMessage* const* ppMessages, u32 messageCount)> EventQueueBatchCallback;
 
-struct EventQueueMessageTarget
+// what to do with a pending message when another with the same id and object id is queued after it.
+enum EventQueueCoalesce : u32
 {
-	u32					m_objectID;
-	EventMessageID		m_messageID;
+	EventQueueCoalesce_None = 0,
+	EventQueueCoalesce_KeepLatest,				// drop the earlier one.
+	EventQueueCoalesce_SumDeltas,				// drop the earlier one, after the later one Accumulate()s it.
+};
 
-	bool operator <(const EventQueueMessageTarget& rhs) const;
+// the order messages are dispatched in.  input is always dispatched the frame it's queued, the others while the
+//  frame's budget lasts.
+enum EventQueuePriority : u32
+{
+	EventQueuePriority_Input = 0,
+	EventQueuePriority_Simulation,
+	EventQueuePriority_Cosmetic,
+
+	EventQueuePriority_Count,
 };
 
+struct EventQueueCoalesceEntry
+{
+	EventMessageID		m_messageID;
+	u32					m_objectID;
+	size_t				m_pendingIndex;			// latest pending message with this id and object id.
+};
+
+// a registration's handler is a method called through a thunk, or a callback.
 struct EventQueueRegistration
 {
 	EventModuleID		m_moduleID;
 	u32					m_subModuleID;
+	EventQueueThunk		m_pThunk;
+	void*				m_pObject;
+	u8					m_method[EVENTQUEUE_METHOD_SIZE_MAX];
 	EventQueueCallback	m_pCallback;
+	u32					m_registreeSlot;			// in its registree's EventQueueRegistree.
+	bool				m_isUnregistered;			// as for batches.
 
+	bool IsSet() const { return !m_isUnregistered; }
+	void Call(EventMessage* message) const;
 	bool operator <(const EventQueueRegistration& rhs) const;
 };
 
+struct EventQueueBatchRegistration
+{
+	EventModuleID			m_moduleID;
+	u32						m_subModuleID;
+	EventQueueBatchCallback	m_pCallback;
+	u32						m_registreeSlot;
+	bool					m_isUnregistered;		// waiting on its deferred unregistration.  the callback's kept until
+													//  then, as it may be the one that's running.
+
+	bool operator <(const EventQueueBatchRegistration& rhs) const;
+};
+
+// registrations for one message to one object.  a free target has an object id of 0.
+struct EventQueueTarget
+{
+	u32									m_objectID;
+	EventMessageID						m_messageID;
+	std::vector<EventQueueRegistration>	m_registrations;		// sorted by module, sub module.
+};
+
+struct EventQueueTargetBucket
+{
+	u32					m_objectID;
+	EventMessageID		m_messageID;
+	u32					m_targetIndex;
+};
+
+// object targeted registrations, found by (object id, message id) in an open addressed hash with linear probing.
+//  the buckets hold the key, so a lookup touches just one target.  target indicies are stable until removed.
+class EventQueueTargetTable
+{
+public:
+	EventQueueTargetTable();
+
+	u32 Find(u32 objectID, EventMessageID messageID) const;
+	u32 FindOrAdd(u32 objectID, EventMessageID messageID);
+	void Remove(u32 targetIndex);
+
+	EventQueueTarget& GetTarget(u32 targetIndex) { return m_targets[targetIndex]; }
+
+private:
+	u32 __FindBucket(u32 objectID, EventMessageID messageID) const;
+	u32 __GetHomeBucket(u32 objectID, EventMessageID messageID) const;
+	void __Grow();
+
+	std::vector<EventQueueTargetBucket>	m_buckets;				// power of 2, a target index of EVENTQUEUE_TARGET_NONE when empty.
+	std::vector<EventQueueTarget>		m_targets;
+	std::vector<u32>					m_freeTargets;
+	u32									m_count;
+};
+
+// where one of a registree's registrations is.  a removed registration leaves a tombstone, a message id of
+//  EventMessageID_Invalid, until the slots are compacted.
+struct EventQueueRegistreeSlot
+{
+	u32					m_objectID;
+	EventMessageID		m_messageID;
+	bool				m_isBatch;
+};
+
+// the registrations made by one (module id, sub module id), so unregistering them doesn't search the others.
+struct EventQueueRegistree
+{
+	std::vector<EventQueueRegistreeSlot>	m_slots;
+	u32										m_tombstoneCount;
+};
+
 struct EventQueueDeferredUnregistration
 {
 	u32					m_objectID;
 	EventMessageID		m_messageID;
 	EventModuleID		m_moduleID;
 	u32					m_subModuleID;
+	bool				m_isBatch;
+};
+
+struct EventQueueDeferredRegistration
+{
+	u32						m_objectID;
+	EventMessageID			m_messageID;
+	EventQueueRegistration	m_registration;
+};
+
+struct EventQueueDeferredBatchRegistration
+{
+	EventMessageID				m_messageID;
+	EventQueueBatchRegistration	m_registration;
+};
+
+struct EventQueuePendingEntry
+{
+	EventMessage*		m_message;
+	u64					m_processIndex;			// the ProcessPending() it was first up for.
 };
 
 struct EventQueuePending
 {
 	std::deque<EventMessage*>				m_messages;
+	// by priority, including messages rolled over from earlier frames.
+	std::deque<EventQueuePendingEntry>		m_queues[EventQueuePriority_Count];
 
 	~EventQueuePending();
 };
 
+// messages can be queued from any thread.  they're processed, and registrations made, on the main thread.
 class EventQueue
 {
 public:
@@ -56,9 +188,24 @@ public:
 	static EventQueue* Alloc();
 	void Free();
 
+	// any thread.
 	void QueueMessage(EventMessage** message);
+	// dispatches the messages queued before it was called.  those queued while it runs wait for the next call.
+	//  once the frame budget's spent, messages below input priority wait for the next call too, unless they've
+	//  waited EVENTQUEUE_ROLLOVER_MAX calls already.
 	void ProcessPending();
 
+	// main thread.  the message is queued when the frame reaches <frame>, and dispatched by the ProcessPending() after.
+	//  a frame that's already been reached queues it now, and returns EVENTQUEUE_TIMER_NONE.
+	EventQueueTimerID QueueMessageAt(EventMessage** message, u64 frame);
+	EventQueueTimerID QueueMessageAfter(EventMessage** message, u32 frameCount);
+	// releases the message if it's still waiting, false if it's already been queued.
+	bool CancelMessage(EventQueueTimerID timerID);
+	// the simulation's frame, see Client_Globals::UpdateFrameCount().
+	void AdvanceFrames(u32 frameCount);
+	u64 GetFrame() const { return m_timers.GetFrame(); }
+
+	// registering a module and sub module for a message and object again replaces its handler.
 	void RegisterForMessage(EventModuleID moduleID, EventMessageID messageID, EventQueueCallback cb);
 	void RegisterForMessage(EventModuleID moduleID, u32 subModuleID, EventMessageID targetMessageID, u32 targetObjectID, EventQueueCallback cb);
 
@@ -69,24 +216,123 @@ public:
 
 	void UnregisterForMessagesByTargetObjectID(u32 objectID);
 
+	// registers a method that takes the message's type, for <T>::MESSAGE_ID.  it's called without a cast or a
+	//  std::function, eg. Register<EventMessage_MoveStart>(EventModuleID_World, this, &World::__OnMoveStart).
+	template <class T, class O, class C>
+	void Register(EventModuleID moduleID, O* pObject, void (C::*method)(T*))
+	{
+		Register<T>(moduleID, 0, 0, pObject, method);
+	}
+	template <class T, class O, class C>
+	void Register(EventModuleID moduleID, u32 subModuleID, u32 targetObjectID, O* pObject, void (C::*method)(T*))
+	{
+		static_assert(sizeof(method) <= EVENTQUEUE_METHOD_SIZE_MAX, "member function pointer is too big.");
+		C* pHandler = pObject;
+		__RegisterMethod(moduleID, subModuleID, T::MESSAGE_ID, targetObjectID, &EventQueue::__CallMethod<T, C>, pHandler, &method, sizeof(method));
+	}
+	template <class T>
+	void Unregister(EventModuleID moduleID, u32 subModuleID, u32 targetObjectID)
+	{
+		UnregisterForMessage(moduleID, subModuleID, T::MESSAGE_ID, targetObjectID);
+	}
+
+	// batch handlers get all of a frame's messages with the id in one call, to process them in a tight loop.  batches
+	//  are dispatched before the messages are dispatched one by one, and aren't object targeted.  registering again
+	//  replaces the handler.
+	void RegisterForMessageBatch(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID, EventQueueBatchCallback cb);
+	void UnregisterForMessageBatch(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID);
+
+	// applied to the messages queued between calls to ProcessPending(), so high frequency input is handled once per
+	//  frame with its latest state.
+	void SetCoalesce(EventMessageID messageID, EventQueueCoalesce coalesce);
+
+	void SetPriority(EventMessageID messageID, EventQueuePriority priority);
+	// time ProcessPending() can spend on messages below input priority, 0 for no limit.
+	void SetFrameBudget(u32 microseconds) { m_frameBudgetNS = static_cast<u64>(microseconds) * 1000; }
+
+	// instrumentation, does nothing without TB8_EVENTQUEUE_STATS defined.  stats are dumped every <frameCount>
+	//  frames, to the profiler if there is one, and start over.
+	void SetProfiler(EventQueueProfiler* pProfiler);
+	void SetStatsDumpFrames(u32 frameCount);
+	void DumpStats();
+
 private:
+	template <class T, class C>
+	static void __CallMethod(void* pObject, const u8* pMethod, EventMessage* message)
+	{
+		// registered for T::MESSAGE_ID, so it's a T.
+		void (C::*method)(T*);
+		memcpy(&method, pMethod, sizeof(method));
+		(static_cast<C*>(pObject)->*method)(static_cast<T*>(message));
+	}
+	void __RegisterMethod(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID, u32 objectID, EventQueueThunk pThunk, void* pObject, const void* pMethod, size_t methodSize);
+	void __Register(u32 objectID, EventMessageID messageID, const EventQueueRegistration& reg);
+
+	void __CoalescePending();
+	EventQueueCoalesce __GetCoalesce(EventMessageID messageID) const;
+	EventQueuePriority __GetPriority(EventMessageID messageID) const;
+
+	void __DispatchBatches();
+	void __DispatchMessage(EventMessage* message);
+	void __CallHandler(const EventQueueRegistration& reg, EventMessage* message);
 	void __DispatchMessageObject(EventMessage* message);
 	void __DispatchMessageGeneric(EventMessage* message);
-	void __DispatchMessage(EventMessage* message, std::set<EventQueueRegistration>& registrations);
 
-	void __CleanupTargetObjectIDs();
+	void __AddRegistration(u32 objectID, EventMessageID messageID, const EventQueueRegistration& reg);
+	std::vector<EventQueueRegistration>* __FindRegistrations(u32 objectID, EventMessageID messageID);
+	EventQueueRegistration* __FindRegistration(std::vector<EventQueueRegistration>& registrations, EventModuleID moduleID, u32 subModuleID);
+	void __UnregisterDeferredRegistration(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID, u32 objectID, bool isAnyTarget);
+	void __AddBatchRegistration(EventMessageID messageID, const EventQueueBatchRegistration& reg);
+	EventQueueBatchRegistration* __FindBatchRegistration(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID);
+
+	u32 __AddRegistreeSlot(EventModuleID moduleID, u32 subModuleID, u32 objectID, EventMessageID messageID, bool isBatch);
+	void __RemoveRegistreeSlot(EventModuleID moduleID, u32 subModuleID, u32 slot);
+	void __CompactRegistree(EventModuleID moduleID, u32 subModuleID, EventQueueRegistree& registree);
+	void __RemoveObjectTarget(u32 objectID, EventMessageID messageID);
+
 	void __CleanupDestroyedTargets();
+	void __ProcessDeferredRegistrations();
 	void __ProcessDeferredUnregistrations();
 
-	u32 __GetNextIndex() const { return m_index ? 1 : 0; }
+	EventQueueInbox										m_inbox;
+	EventQueuePending									m_pending;
+
+	EventQueueTimerWheel								m_timers;
+	std::vector<EventMessage*>							m_timersDue;
+
+	std::vector<EventQueueCoalesce>						m_coalesce;				// by message id.
+	std::vector<EventQueueCoalesceEntry>				m_coalesceEntries;
+
+	std::vector<EventQueuePriority>						m_priorities;			// by message id.
+	u64													m_frameBudgetNS;
+	u64													m_processIndex;			// calls to ProcessPending().
+
+#if defined(TB8_EVENTQUEUE_STATS)
+	EventQueueStats										m_stats;
+#endif
+
+	// generic registrations are indexed by message id, object targeted ones hashed.
+	std::vector<std::vector<EventQueueRegistration>>	m_messageRegistrations;
+	EventQueueTargetTable								m_targets;
+
+	// batch registrations by message id, and the pending messages they're for, grouped by id.
+	std::vector<std::vector<EventQueueBatchRegistration>>	m_batchRegistrations;
+	u32													m_batchRegistrationCount;
+	std::vector<EventMessage*>							m_batchMessages;
+	std::vector<u32>									m_batchOffsets;			// by message id.
 
-	u32								m_index;
-	EventQueuePending				m_pending[2];
+	// reverse indices, from a registree to its registrations and from an object to the message ids it's targeted
+	//  by, so unregistering and cleaning up destroyed objects touch only their own registrations.
+	std::unordered_map<u64, EventQueueRegistree>		m_registrees;			// by (module id << 32) | sub module id.
+	std::unordered_map<u32, std::vector<EventMessageID>>	m_objectTargets;
 
-	std::map<EventQueueMessageTarget, std::set<EventQueueRegistration>> m_targets;
+	// registrations made by a handler are held until its message is dispatched, so the lists being walked don't move.
+	bool												m_isDispatching;
+	std::vector<EventQueueDeferredRegistration>			m_deferredRegistrations;
+	std::vector<EventQueueDeferredBatchRegistration>	m_deferredBatchRegistrations;
 
-	std::deque<u32>									m_destroyedTargets;
-	std::deque<EventQueueDeferredUnregistration>	m_deferredUnregistrations;
+	std::deque<u32>										m_destroyedTargets;
+	std::deque<EventQueueDeferredUnregistration>		m_deferredUnregistrations;
 };
 
 }
@@ -0,0 +1,123 @@
+/*
+	Copyright (C) 2019 8 Byte Technology Inc. - All Rights Reserved
+*/
+#include "pch.h"
+
+#include <algorithm>
+
+#include "EventQueueMessage.h"
+
+#include "EventQueueInbox.h"
+
+namespace TB8
+{
+
+const u64 EVENTQUEUE_INBOX_MASK = EVENTQUEUE_INBOX_CAPACITY - 1;
+
+EventQueueInbox::EventQueueInbox()
+	: m_ticketNext(0)
+	, m_overflowHead(nullptr)
+	, m_ticketPop(0)
+{
+	for (u32 i = 0; i < EVENTQUEUE_INBOX_CAPACITY; ++i)
+	{
+		m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+		m_cells[i].m_message = nullptr;
+	}
+}
+
+EventQueueInbox::~EventQueueInbox()
+{
+	// the producers are done, release whatever wasn't popped.
+	std::deque<EventMessage*> messages;
+	Pop(m_ticketNext.load(), &messages);
+	while (!messages.empty())
+	{
+		messages.front()->Release();
+		messages.pop_front();
+	}
+
+	__CollectOverflow();
+	for (std::vector<EventQueueInboxNode*>::iterator it = m_overflow.begin(); it != m_overflow.end(); ++it)
+	{
+		(*it)->m_message->Release();
+		TB8_DEL(*it);
+	}
+}
+
+void EventQueueInbox::Push(EventMessage* message)
+{
+	const u64 ticket = m_ticketNext.fetch_add(1, std::memory_order_acq_rel);
+
+	// the cell is free once the consumer has popped the ticket a lap before this one.
+	EventQueueInboxCell& cell = m_cells[ticket & EVENTQUEUE_INBOX_MASK];
+	if (cell.m_sequence.load(std::memory_order_acquire) == ticket)
+	{
+		cell.m_message = message;
+		cell.m_sequence.store(ticket + 1, std::memory_order_release);
+		return;
+	}
+
+	// the ring is a lap behind, chain it.
+	EventQueueInboxNode* pNode = TB8_NEW(EventQueueInboxNode)();
+	pNode->m_message = message;
+	pNode->m_ticket = ticket;
+	pNode->m_next = m_overflowHead.load(std::memory_order_relaxed);
+	while (!m_overflowHead.compare_exchange_weak(pNode->m_next, pNode, std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+}
+
+void EventQueueInbox::Pop(u64 ticketEnd, std::deque<EventMessage*>* pMessages)
+{
+	while (m_ticketPop < ticketEnd)
+	{
+		// a ticket's message is in its cell, or on the overflow chain.
+		EventQueueInboxCell& cell = m_cells[m_ticketPop & EVENTQUEUE_INBOX_MASK];
+		EventMessage* message = nullptr;
+		if (cell.m_sequence.load(std::memory_order_acquire) == (m_ticketPop + 1))
+		{
+			message = cell.m_message;
+			cell.m_message = nullptr;
+		}
+		else
+		{
+			if (m_overflow.empty() || (m_overflow.back()->m_ticket != m_ticketPop))
+			{
+				__CollectOverflow();
+			}
+			if (!m_overflow.empty() && (m_overflow.back()->m_ticket == m_ticketPop))
+			{
+				EventQueueInboxNode* pNode = m_overflow.back();
+				m_overflow.pop_back();
+				message = pNode->m_message;
+				TB8_DEL(pNode);
+			}
+		}
+
+		// not pushed yet, it'll be popped next time.
+		if (!message)
+			break;
+
+		// free the cell for the ticket a lap on, whichever way this one came.
+		cell.m_sequence.store(m_ticketPop + EVENTQUEUE_INBOX_CAPACITY, std::memory_order_release);
+		++m_ticketPop;
+
+		pMessages->push_back(message);
+	}
+}
+
+void EventQueueInbox::__CollectOverflow()
+{
+	EventQueueInboxNode* pNode = m_overflowHead.exchange(nullptr, std::memory_order_acquire);
+	if (!pNode)
+		return;
+
+	for (; pNode; pNode = pNode->m_next)
+	{
+		m_overflow.push_back(pNode);
+	}
+	std::sort(m_overflow.begin(), m_overflow.end(), [](const EventQueueInboxNode* pA, const EventQueueInboxNode* pB) { return pA->m_ticket > pB->m_ticket; });
+}
+
+}
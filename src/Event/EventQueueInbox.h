@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <deque>
+
+#include "Common/basic_types.h"
+
+namespace TB8
+{
+
+class EventMessage;
+
+const u32 EVENTQUEUE_INBOX_CAPACITY = 1024;		// power of 2.
+
+struct EventQueueInboxCell
+{
+	std::atomic<u64>		m_sequence;			// the ticket it's free for, or that ticket + 1 once it holds the message.
+	EventMessage*			m_message;
+};
+
+struct EventQueueInboxNode
+{
+	EventMessage*			m_message;
+	u64						m_ticket;
+	EventQueueInboxNode*	m_next;
+};
+
+// lock free multi producer, single consumer message queue.
+//  each push takes a ticket, and goes in the ring cell for it if that's free, otherwise on an overflow chain.  the
+//  consumer pops in ticket order from whichever it's in, so messages come out in the order they were pushed, and
+//  a producer is never blocked by the consumer or the other producers.
+class EventQueueInbox
+{
+public:
+	EventQueueInbox();
+	~EventQueueInbox();
+
+	// any thread.  steals the reference to the message.
+	void Push(EventMessage* message);
+	// tickets taken so far, pushed or still being pushed.
+	u64 GetTicketCount() const { return m_ticketNext.load(std::memory_order_acquire); }
+
+	// consumer thread.  pops the messages with tickets before <ticketEnd>, stopping early at one still being pushed.
+	void Pop(u64 ticketEnd, std::deque<EventMessage*>* pMessages);
+
+private:
+	void __CollectOverflow();
+
+	// producers.
+	std::atomic<u64>					m_ticketNext;
+	std::atomic<EventQueueInboxNode*>	m_overflowHead;
+
+	EventQueueInboxCell					m_cells[EVENTQUEUE_INBOX_CAPACITY];
+
+	// consumer.
+	u64									m_ticketPop;
+	std::vector<EventQueueInboxNode*>	m_overflow;			// collected from m_overflowHead, latest ticket first.
+};
+
+}
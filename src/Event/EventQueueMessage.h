@@ -1,7 +1,10 @@
 #pragma once
 
-#include "common/basic_types.h"
-#include "common/ref_count.h"
+#include "Common/basic_types.h"
+#include "Common/ref_count.h"
+
+// define TB8_EVENTQUEUE_STATS for the whole build to instrument the event queue, see EventQueueStats.  it changes
+//  EventMessage's layout.
 
 namespace TB8
 {
@@ -28,11 +31,19 @@ public:
 	EventMessageID GetID() const { return m_messageID; }
 	u32 GetObjectID() const { return m_objectID; }
 
+	// for coalescing pending messages with the same id and object id, see EventQueueCoalesce_SumDeltas.
+	virtual void Accumulate(const EventMessage* /*pEarlier*/) {}
+
 private:
 	virtual void __Free() override = 0;
 
 	EventMessageID		m_messageID;
 	u32					m_objectID;
+#if defined(TB8_EVENTQUEUE_STATS)
+	friend class EventQueueStats;
+	u64					m_queuedFrame;
+	u64					m_queuedNS;
+#endif
 };
 
 }
@@ -3,6 +3,7 @@
 */
 #include "pch.h"
 
+#include "EventMessagePool.h"
 #include "EventQueueMessages.h"
 
 namespace TB8
@@ -10,7 +11,7 @@ namespace TB8
 
 // EventMessage_MoveStart
 EventMessage_MoveStart::EventMessage_MoveStart(s32 dx, s32 dy, s32 dz)
-	: EventMessage(EventMessageID_MoveStart)
+	: EventMessage(MESSAGE_ID)
 	, m_dx(dx)
 	, m_dy(dy)
 	, m_dz(dz)
@@ -19,18 +20,18 @@ EventMessage_MoveStart::EventMessage_MoveStart(s32 dx, s32 dy, s32 dz)
 
 EventMessage_MoveStart* EventMessage_MoveStart::Alloc(s32 dx, s32 dy, s32 dz)
 {
-	EventMessage_MoveStart* obj = TB8_NEW(EventMessage_MoveStart)(dx, dy, dz);
+	EventMessage_MoveStart* obj = EventMessagePool::New<EventMessage_MoveStart>(dx, dy, dz);
 	return obj;
 }
 
 void EventMessage_MoveStart::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessage_EndMove
 EventMessage_MoveEnd::EventMessage_MoveEnd(s32 dx, s32 dy, s32 dz)
-	: EventMessage(EventMessageID_MoveEnd)
+	: EventMessage(MESSAGE_ID)
 	, m_dx(dx)
 	, m_dy(dy)
 	, m_dz(dz)
@@ -39,18 +40,18 @@ EventMessage_MoveEnd::EventMessage_MoveEnd(s32 dx, s32 dy, s32 dz)
 
 EventMessage_MoveEnd* EventMessage_MoveEnd::Alloc(s32 dx, s32 dy, s32 dz)
 {
-	EventMessage_MoveEnd* obj = TB8_NEW(EventMessage_MoveEnd)(dx, dy, dz);
+	EventMessage_MoveEnd* obj = EventMessagePool::New<EventMessage_MoveEnd>(dx, dy, dz);
 	return obj;
 }
 
 void EventMessage_MoveEnd::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessage_ResizeWindow
 EventMessage_ResizeWindow::EventMessage_ResizeWindow(s32 sizeX, s32 sizeY, bool final)
-	: EventMessage(EventMessageID_ResizeWindow)
+	: EventMessage(MESSAGE_ID)
 	, m_sizeX(sizeX)
 	, m_sizeY(sizeY)
 	, m_final(final)
@@ -59,18 +60,18 @@ EventMessage_ResizeWindow::EventMessage_ResizeWindow(s32 sizeX, s32 sizeY, bool
 
 EventMessage_ResizeWindow* EventMessage_ResizeWindow::Alloc(s32 sizeX, s32 sizeY, bool final)
 {
-	EventMessage_ResizeWindow* obj = TB8_NEW(EventMessage_ResizeWindow)(sizeX, sizeY, final);
+	EventMessage_ResizeWindow* obj = EventMessagePool::New<EventMessage_ResizeWindow>(sizeX, sizeY, final);
 	return obj;
 }
 
 void EventMessage_ResizeWindow::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessageID_WindowDPIChanged
 EventMessage_WindowDPIChanged::EventMessage_WindowDPIChanged(const IVector2& dpi, const IVector2& size)
-	: EventMessage(EventMessageID_WindowDPIChanged)
+	: EventMessage(MESSAGE_ID)
 	, m_dpi(dpi)
 	, m_size(size)
 {
@@ -78,18 +79,18 @@ EventMessage_WindowDPIChanged::EventMessage_WindowDPIChanged(const IVector2& dpi
 
 EventMessage_WindowDPIChanged* EventMessage_WindowDPIChanged::Alloc(const IVector2& dpi, const IVector2& size)
 {
-	EventMessage_WindowDPIChanged* obj = TB8_NEW(EventMessage_WindowDPIChanged)(dpi, size);
+	EventMessage_WindowDPIChanged* obj = EventMessagePool::New<EventMessage_WindowDPIChanged>(dpi, size);
 	return obj;
 }
 
 void EventMessage_WindowDPIChanged::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessageID_RenderAreaResize
 EventMessage_RenderAreaResize::EventMessage_RenderAreaResize(s32 dpi, RenderScaleSize scale, const IVector2& size)
-	: EventMessage(EventMessageID_RenderAreaResize)
+	: EventMessage(MESSAGE_ID)
 	, m_dpi(dpi)
 	, m_scale(scale)
 	, m_size(size)
@@ -98,69 +99,69 @@ EventMessage_RenderAreaResize::EventMessage_RenderAreaResize(s32 dpi, RenderScal
 
 EventMessage_RenderAreaResize* EventMessage_RenderAreaResize::Alloc(s32 dpi, RenderScaleSize scale, const IVector2& size)
 {
-	EventMessage_RenderAreaResize* obj = TB8_NEW(EventMessage_RenderAreaResize)(dpi, scale, size);
+	EventMessage_RenderAreaResize* obj = EventMessagePool::New<EventMessage_RenderAreaResize>(dpi, scale, size);
 	return obj;
 }
 
 void EventMessage_RenderAreaResize::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessageID_Activate
 EventMessage_Activate::EventMessage_Activate()
-	: EventMessage(EventMessageID_Activate)
+	: EventMessage(MESSAGE_ID)
 {
 }
 
 EventMessage_Activate* EventMessage_Activate::Alloc()
 {
-	EventMessage_Activate* obj = TB8_NEW(EventMessage_Activate)();
+	EventMessage_Activate* obj = EventMessagePool::New<EventMessage_Activate>();
 	return obj;
 }
 
 void EventMessage_Activate::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessageID_Rotate
 EventMessage_Rotate::EventMessage_Rotate()
-	: EventMessage(EventMessageID_Rotate)
+	: EventMessage(MESSAGE_ID)
 {
 }
 
 EventMessage_Rotate* EventMessage_Rotate::Alloc()
 {
-	EventMessage_Rotate* obj = TB8_NEW(EventMessage_Rotate)();
+	EventMessage_Rotate* obj = EventMessagePool::New<EventMessage_Rotate>();
 	return obj;
 }
 
 void EventMessage_Rotate::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessageID_Close
 EventMessage_Close::EventMessage_Close()
-	: EventMessage(EventMessageID_Close)
+	: EventMessage(MESSAGE_ID)
 {
 }
 
 EventMessage_Close* EventMessage_Close::Alloc()
 {
-	EventMessage_Close* obj = TB8_NEW(EventMessage_Close)();
+	EventMessage_Close* obj = EventMessagePool::New<EventMessage_Close>();
 	return obj;
 }
 
 void EventMessage_Close::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessage_MouseCursorMove
 EventMessage_MouseCursorMove::EventMessage_MouseCursorMove(s32 mouseX, s32 mouseY)
-	: EventMessage(EventMessageID_MouseCursorMove)
+	: EventMessage(MESSAGE_ID)
 	, m_mouseX(mouseX)
 	, m_mouseY(mouseY)
 {
@@ -168,18 +169,18 @@ EventMessage_MouseCursorMove::EventMessage_MouseCursorMove(s32 mouseX, s32 mouse
 
 EventMessage_MouseCursorMove* EventMessage_MouseCursorMove::Alloc(s32 mouseX, s32 mouseY)
 {
-	EventMessage_MouseCursorMove* obj = TB8_NEW(EventMessage_MouseCursorMove)(mouseX, mouseY);
+	EventMessage_MouseCursorMove* obj = EventMessagePool::New<EventMessage_MouseCursorMove>(mouseX, mouseY);
 	return obj;
 }
 
 void EventMessage_MouseCursorMove::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessage_MouseLBDown
 EventMessage_MouseLBDown::EventMessage_MouseLBDown(s32 mouseX, s32 mouseY)
-	: EventMessage(EventMessageID_MouseLBDown)
+	: EventMessage(MESSAGE_ID)
 	, m_mouseX(mouseX)
 	, m_mouseY(mouseY)
 {
@@ -187,18 +188,18 @@ EventMessage_MouseLBDown::EventMessage_MouseLBDown(s32 mouseX, s32 mouseY)
 
 EventMessage_MouseLBDown* EventMessage_MouseLBDown::Alloc(s32 mouseX, s32 mouseY)
 {
-	EventMessage_MouseLBDown* obj = TB8_NEW(EventMessage_MouseLBDown)(mouseX, mouseY);
+	EventMessage_MouseLBDown* obj = EventMessagePool::New<EventMessage_MouseLBDown>(mouseX, mouseY);
 	return obj;
 }
 
 void EventMessage_MouseLBDown::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessageID_MouseLBDownHold
 EventMessage_MouseLBDownHold::EventMessage_MouseLBDownHold(u32 frameCount, const IVector2& mousePos)
-	: EventMessage(EventMessageID_MouseLBDownHold)
+	: EventMessage(MESSAGE_ID)
 	, m_frameCount(frameCount)
 	, m_mousePos(mousePos)
 {
@@ -206,36 +207,36 @@ EventMessage_MouseLBDownHold::EventMessage_MouseLBDownHold(u32 frameCount, const
 
 EventMessage_MouseLBDownHold* EventMessage_MouseLBDownHold::Alloc(u32 frameCount, const IVector2& mousePos)
 {
-	EventMessage_MouseLBDownHold* obj = TB8_NEW(EventMessage_MouseLBDownHold)(frameCount, mousePos);
+	EventMessage_MouseLBDownHold* obj = EventMessagePool::New<EventMessage_MouseLBDownHold>(frameCount, mousePos);
 	return obj;
 }
 
 void EventMessage_MouseLBDownHold::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessageID_MouseLBDoubleClick
 EventMessage_MouseLBDoubleClick::EventMessage_MouseLBDoubleClick(const IVector2& mousePos)
-	: EventMessage(EventMessageID_MouseLBDoubleClick)
+	: EventMessage(MESSAGE_ID)
 	, m_mousePos(mousePos)
 {
 }
 
 EventMessage_MouseLBDoubleClick* EventMessage_MouseLBDoubleClick::Alloc(const IVector2& mousePos)
 {
-	EventMessage_MouseLBDoubleClick* obj = TB8_NEW(EventMessage_MouseLBDoubleClick)(mousePos);
+	EventMessage_MouseLBDoubleClick* obj = EventMessagePool::New<EventMessage_MouseLBDoubleClick>(mousePos);
 	return obj;
 }
 
 void EventMessage_MouseLBDoubleClick::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessage_MouseLBUp
 EventMessage_MouseLBUp::EventMessage_MouseLBUp(s32 mouseX, s32 mouseY)
-	: EventMessage(EventMessageID_MouseLBUp)
+	: EventMessage(MESSAGE_ID)
 	, m_mouseX(mouseX)
 	, m_mouseY(mouseY)
 {
@@ -243,54 +244,54 @@ EventMessage_MouseLBUp::EventMessage_MouseLBUp(s32 mouseX, s32 mouseY)
 
 EventMessage_MouseLBUp* EventMessage_MouseLBUp::Alloc(s32 mouseX, s32 mouseY)
 {
-	EventMessage_MouseLBUp* obj = TB8_NEW(EventMessage_MouseLBUp)(mouseX, mouseY);
+	EventMessage_MouseLBUp* obj = EventMessagePool::New<EventMessage_MouseLBUp>(mouseX, mouseY);
 	return obj;
 }
 
 void EventMessage_MouseLBUp::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessageID_MouseLeave
 EventMessage_MouseLeave::EventMessage_MouseLeave(const IVector2& mousePos)
-	: EventMessage(EventMessageID_MouseLeave)
+	: EventMessage(MESSAGE_ID)
 	, m_mousePos(mousePos)
 {
 }
 
 EventMessage_MouseLeave* EventMessage_MouseLeave::Alloc(const IVector2& mousePos)
 {
-	EventMessage_MouseLeave* obj = TB8_NEW(EventMessage_MouseLeave)(mousePos);
+	EventMessage_MouseLeave* obj = EventMessagePool::New<EventMessage_MouseLeave>(mousePos);
 	return obj;
 }
 
 void EventMessage_MouseLeave::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessageID_MouseHover
 EventMessage_MouseHover::EventMessage_MouseHover(const IVector2& mousePos)
-	: EventMessage(EventMessageID_MouseHover)
+	: EventMessage(MESSAGE_ID)
 	, m_mousePos(mousePos)
 {
 }
 
 EventMessage_MouseHover* EventMessage_MouseHover::Alloc(const IVector2& mousePos)
 {
-	EventMessage_MouseHover* obj = TB8_NEW(EventMessage_MouseHover)(mousePos);
+	EventMessage_MouseHover* obj = EventMessagePool::New<EventMessage_MouseHover>(mousePos);
 	return obj;
 }
 
 void EventMessage_MouseHover::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
 }
 
 // EventMessageID_MouseMoveWheel
 EventMessage_MouseMoveWheel::EventMessage_MouseMoveWheel(const IVector2& mousePos, s32 delta, s32 threshold)
-	: EventMessage(EventMessageID_MouseMoveWheel)
+	: EventMessage(MESSAGE_ID)
 	, m_mousePos(mousePos)
 	, m_delta(delta)
 	, m_threshold(threshold)
@@ -299,13 +300,52 @@ EventMessage_MouseMoveWheel::EventMessage_MouseMoveWheel(const IVector2& mousePo
 
 EventMessage_MouseMoveWheel* EventMessage_MouseMoveWheel::Alloc(const IVector2& mousePos, s32 delta, s32 threshold)
 {
-	EventMessage_MouseMoveWheel* obj = TB8_NEW(EventMessage_MouseMoveWheel)(mousePos, delta, threshold);
+	EventMessage_MouseMoveWheel* obj = EventMessagePool::New<EventMessage_MouseMoveWheel>(mousePos, delta, threshold);
 	return obj;
 }
 
 void EventMessage_MouseMoveWheel::__Free()
 {
-	TB8_DEL(this);
+	EventMessagePool::Delete(this);
+}
+
+void EventMessage_MouseMoveWheel::Accumulate(const EventMessage* pEarlier)
+{
+	m_delta += static_cast<const EventMessage_MouseMoveWheel*>(pEarlier)->m_delta;
+}
+
+// EventMessageID_UnitThought
+EventMessage_UnitThought::EventMessage_UnitThought(u32 objectID)
+	: EventMessage(MESSAGE_ID, objectID)
+{
+}
+
+EventMessage_UnitThought* EventMessage_UnitThought::Alloc(u32 objectID)
+{
+	EventMessage_UnitThought* obj = EventMessagePool::New<EventMessage_UnitThought>(objectID);
+	return obj;
+}
+
+void EventMessage_UnitThought::__Free()
+{
+	EventMessagePool::Delete(this);
+}
+
+// EventMessageID_AvatarRest
+EventMessage_AvatarRest::EventMessage_AvatarRest(u32 objectID)
+	: EventMessage(MESSAGE_ID, objectID)
+{
+}
+
+EventMessage_AvatarRest* EventMessage_AvatarRest::Alloc(u32 objectID)
+{
+	EventMessage_AvatarRest* obj = EventMessagePool::New<EventMessage_AvatarRest>(objectID);
+	return obj;
+}
+
+void EventMessage_AvatarRest::__Free()
+{
+	EventMessagePool::Delete(this);
 }
 
 }
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "common/basic_types.h"
+#include "Common/basic_types.h"
 
 #include "EventQueueMessage.h"
 
@@ -32,12 +32,17 @@ enum EventMessageID : u32
 	EventMessageID_MouseHover,
 	EventMessageID_MouseLBDoubleClick,
 	EventMessageID_MouseMoveWheel,
+
+	EventMessageID_UnitThought,
+	EventMessageID_AvatarRest,
 };
 
 // EventMessage_StartMove
 class EventMessage_MoveStart : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_MoveStart;
+
 	EventMessage_MoveStart(s32 dx, s32 dy, s32 dz);
 
 	static EventMessage_MoveStart* Alloc(s32 dx, s32 dy, s32 dz);
@@ -52,6 +57,8 @@ public:
 class EventMessage_MoveEnd : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_MoveEnd;
+
 	EventMessage_MoveEnd(s32 dx, s32 dy, s32 dz);
 
 	static EventMessage_MoveEnd* Alloc(s32 dx, s32 dy, s32 dz);
@@ -66,6 +73,8 @@ public:
 class EventMessage_ResizeWindow : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_ResizeWindow;
+
 	EventMessage_ResizeWindow(s32 sizeX, s32 sizeY, bool final);
 
 	static EventMessage_ResizeWindow* Alloc(s32 sizeX, s32 sizeY, bool final);
@@ -80,6 +89,8 @@ public:
 class EventMessage_RenderAreaResize : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_RenderAreaResize;
+
 	EventMessage_RenderAreaResize(s32 dpi, RenderScaleSize scale, const IVector2& size);
 
 	static EventMessage_RenderAreaResize* Alloc(s32 dpi, RenderScaleSize scale, const IVector2& size);
@@ -94,6 +105,8 @@ public:
 class EventMessage_WindowDPIChanged : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_WindowDPIChanged;
+
 	EventMessage_WindowDPIChanged(const IVector2& dpi, const IVector2& size);
 
 	static EventMessage_WindowDPIChanged* Alloc(const IVector2& dpi, const IVector2& size);
@@ -107,6 +120,8 @@ public:
 class EventMessage_Activate : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_Activate;
+
 	EventMessage_Activate();
 
 	static EventMessage_Activate* Alloc();
@@ -117,6 +132,8 @@ public:
 class EventMessage_Rotate : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_Rotate;
+
 	EventMessage_Rotate();
 
 	static EventMessage_Rotate* Alloc();
@@ -127,6 +144,8 @@ public:
 class EventMessage_Close : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_Close;
+
 	EventMessage_Close();
 
 	static EventMessage_Close* Alloc();
@@ -137,6 +156,8 @@ public:
 class EventMessage_MouseCursorMove : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_MouseCursorMove;
+
 	EventMessage_MouseCursorMove(s32 mouseX, s32 mouseY);
 
 	static EventMessage_MouseCursorMove* Alloc(s32 mouseX, s32 mouseY);
@@ -150,6 +171,8 @@ public:
 class EventMessage_MouseLBDown : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_MouseLBDown;
+
 	EventMessage_MouseLBDown(s32 mouseX, s32 mouseY);
 
 	static EventMessage_MouseLBDown* Alloc(s32 mouseX, s32 mouseY);
@@ -163,6 +186,8 @@ public:
 class EventMessage_MouseLBDownHold : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_MouseLBDownHold;
+
 	EventMessage_MouseLBDownHold(u32 frameCount, const IVector2& mousePos);
 
 	static EventMessage_MouseLBDownHold* Alloc(u32 frameCount, const IVector2& mousePos);
@@ -176,6 +201,8 @@ public:
 class EventMessage_MouseLBDoubleClick : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_MouseLBDoubleClick;
+
 	EventMessage_MouseLBDoubleClick(const IVector2& mousePos);
 
 	static EventMessage_MouseLBDoubleClick* Alloc(const IVector2& mousePos);
@@ -188,6 +215,8 @@ public:
 class EventMessage_MouseLBUp : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_MouseLBUp;
+
 	EventMessage_MouseLBUp(s32 mouseX, s32 mouseY);
 
 	static EventMessage_MouseLBUp* Alloc(s32 mouseX, s32 mouseY);
@@ -201,6 +230,8 @@ public:
 class EventMessage_MouseLeave : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_MouseLeave;
+
 	EventMessage_MouseLeave(const IVector2& mousePos);
 
 	static EventMessage_MouseLeave* Alloc(const IVector2& mousePos);
@@ -213,6 +244,8 @@ public:
 class EventMessage_MouseHover : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_MouseHover;
+
 	EventMessage_MouseHover(const IVector2& mousePos);
 
 	static EventMessage_MouseHover* Alloc(const IVector2& mousePos);
@@ -225,14 +258,41 @@ public:
 class EventMessage_MouseMoveWheel : public EventMessage
 {
 public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_MouseMoveWheel;
+
 	EventMessage_MouseMoveWheel(const IVector2& mousePos, s32 delta, s32 threshold);
 
 	static EventMessage_MouseMoveWheel* Alloc(const IVector2& mousePos, s32 delta, s32 threshold);
 	virtual void __Free() override;
+	virtual void Accumulate(const EventMessage* pEarlier) override;
 
 	IVector2 m_mousePos;
 	s32 m_delta;
 	s32 m_threshold;
 };
 
+// EventMessageID_UnitThought
+class EventMessage_UnitThought : public EventMessage
+{
+public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_UnitThought;
+
+	EventMessage_UnitThought(u32 objectID);
+
+	static EventMessage_UnitThought* Alloc(u32 objectID);
+	virtual void __Free() override;
+};
+
+// EventMessageID_AvatarRest
+class EventMessage_AvatarRest : public EventMessage
+{
+public:
+	static const EventMessageID MESSAGE_ID = EventMessageID_AvatarRest;
+
+	EventMessage_AvatarRest(u32 objectID);
+
+	static EventMessage_AvatarRest* Alloc(u32 objectID);
+	virtual void __Free() override;
+};
+
 }
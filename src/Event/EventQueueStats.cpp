@@ -0,0 +1,210 @@
+/*
+	Copyright (C) 2019 8 Byte Technology Inc. - All Rights Reserved
+*/
+#include "pch.h"
+
+#include "EventQueueStats.h"
+
+#if defined(TB8_EVENTQUEUE_STATS)
+
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include "Common/string.h"
+
+namespace TB8
+{
+
+const u32 EVENTQUEUE_STATS_DUMP_FRAMES_DEFAULT = 600;			// 10 seconds at 60hz.
+const u32 EVENTQUEUE_STATS_DUMP_HANDLERS_MAX = 16;				// the slowest, by total time.
+const u32 EVENTQUEUE_STATS_HISTOGRAM_SHIFT = 10;				// the first bucket is under 1024ns.
+
+bool EventQueueStatsHandlerKey::operator <(const EventQueueStatsHandlerKey& rhs) const
+{
+	if (m_messageID != rhs.m_messageID)
+		return m_messageID < rhs.m_messageID;
+	if (m_moduleID != rhs.m_moduleID)
+		return m_moduleID < rhs.m_moduleID;
+	if (m_subModuleID != rhs.m_subModuleID)
+		return m_subModuleID < rhs.m_subModuleID;
+	return m_isBatch < rhs.m_isBatch;
+}
+
+EventQueueStats::EventQueueStats()
+	: m_frame(0)
+	, m_frameDump(0)
+	, m_dumpFrames(EVENTQUEUE_STATS_DUMP_FRAMES_DEFAULT)
+	, m_pProfiler(nullptr)
+	, m_pendingDepthMax(0)
+{
+}
+
+/* static */ u64 EventQueueStats::GetTimeNS()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void EventQueueStats::OnQueued(EventMessage* message) const
+{
+	message->m_queuedFrame = m_frame.load(std::memory_order_relaxed);
+	message->m_queuedNS = GetTimeNS();
+}
+
+void EventQueueStats::OnDispatched(const EventMessage* message)
+{
+	if (message->GetID() >= m_messages.size())
+	{
+		EventQueueStatsMessage empty = {};
+		m_messages.resize(message->GetID() + 1, empty);
+	}
+	EventQueueStatsMessage& stats = m_messages[message->GetID()];
+
+	const u64 latencyFrames = m_frame.load(std::memory_order_relaxed) - message->m_queuedFrame;
+	const u64 latencyNS = GetTimeNS() - message->m_queuedNS;
+	++stats.m_count;
+	stats.m_latencyFramesTotal += latencyFrames;
+	stats.m_latencyFramesMax = std::max(stats.m_latencyFramesMax, latencyFrames);
+	stats.m_latencyNSTotal += latencyNS;
+	stats.m_latencyNSMax = std::max(stats.m_latencyNSMax, latencyNS);
+}
+
+void EventQueueStats::OnPendingDepth(u64 depth)
+{
+	m_pendingDepthMax = std::max(m_pendingDepthMax, depth);
+}
+
+u64 EventQueueStats::BeginHandler(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID, bool /*isBatch*/)
+{
+	if (m_pProfiler)
+	{
+		m_pProfiler->BeginHandler(moduleID, subModuleID, messageID);
+	}
+	return GetTimeNS();
+}
+
+void EventQueueStats::EndHandler(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID, bool isBatch, u64 timeStart)
+{
+	const u64 elapsedNS = GetTimeNS() - timeStart;
+	if (m_pProfiler)
+	{
+		m_pProfiler->EndHandler(moduleID, subModuleID, messageID, elapsedNS);
+	}
+
+	EventQueueStatsHandlerKey key;
+	key.m_moduleID = moduleID;
+	key.m_subModuleID = subModuleID;
+	key.m_messageID = messageID;
+	key.m_isBatch = isBatch;
+	std::map<EventQueueStatsHandlerKey, EventQueueStatsHandler>::iterator it = m_handlers.find(key);
+	if (it == m_handlers.end())
+	{
+		EventQueueStatsHandler empty = {};
+		it = m_handlers.insert(std::make_pair(key, empty)).first;
+	}
+	EventQueueStatsHandler& stats = it->second;
+
+	++stats.m_count;
+	stats.m_timeNSTotal += elapsedNS;
+	stats.m_timeNSMax = std::max(stats.m_timeNSMax, elapsedNS);
+
+	u32 bucket = 0;
+	for (u64 ns = elapsedNS >> EVENTQUEUE_STATS_HISTOGRAM_SHIFT; ns && (bucket < EVENTQUEUE_STATS_HISTOGRAM_BUCKETS - 1); ns >>= 1)
+	{
+		++bucket;
+	}
+	++stats.m_histogram[bucket];
+}
+
+void EventQueueStats::AdvanceFrames(u32 frameCount)
+{
+	const u64 frame = m_frame.load(std::memory_order_relaxed) + frameCount;
+	m_frame.store(frame, std::memory_order_relaxed);
+	if (m_dumpFrames && ((frame - m_frameDump) >= m_dumpFrames))
+	{
+		Dump();
+	}
+}
+
+void EventQueueStats::Dump()
+{
+	const u64 frame = m_frame.load(std::memory_order_relaxed);
+	std::string text;
+	char line[512];
+
+	sprintf_s(line, sizeof(line), "event queue, frames %llu to %llu, pending depth max %llu\n",
+		static_cast<unsigned long long>(m_frameDump), static_cast<unsigned long long>(frame), static_cast<unsigned long long>(m_pendingDepthMax));
+	text += line;
+
+	text += "  message id: count, latency frames avg / max, latency us avg / max\n";
+	for (u32 messageID = 0; messageID < m_messages.size(); ++messageID)
+	{
+		const EventQueueStatsMessage& stats = m_messages[messageID];
+		if (!stats.m_count)
+			continue;
+		sprintf_s(line, sizeof(line), "  %3u: %8llu, %6.2f / %4llu, %9.1f / %9.1f\n", messageID, static_cast<unsigned long long>(stats.m_count),
+			static_cast<f64>(stats.m_latencyFramesTotal) / stats.m_count, static_cast<unsigned long long>(stats.m_latencyFramesMax),
+			static_cast<f64>(stats.m_latencyNSTotal) / stats.m_count / 1000.0, static_cast<f64>(stats.m_latencyNSMax) / 1000.0);
+		text += line;
+	}
+
+	// the handlers that took the longest, with how many calls took 1us, 2us, 4us, ... 16ms+.
+	std::vector<std::map<EventQueueStatsHandlerKey, EventQueueStatsHandler>::const_iterator> handlers;
+	for (std::map<EventQueueStatsHandlerKey, EventQueueStatsHandler>::const_iterator it = m_handlers.begin(); it != m_handlers.end(); ++it)
+	{
+		handlers.push_back(it);
+	}
+	std::sort(handlers.begin(), handlers.end(),
+		[](std::map<EventQueueStatsHandlerKey, EventQueueStatsHandler>::const_iterator lhs, std::map<EventQueueStatsHandlerKey, EventQueueStatsHandler>::const_iterator rhs)
+		{
+			return lhs->second.m_timeNSTotal > rhs->second.m_timeNSTotal;
+		});
+	if (handlers.size() > EVENTQUEUE_STATS_DUMP_HANDLERS_MAX)
+	{
+		handlers.resize(EVENTQUEUE_STATS_DUMP_HANDLERS_MAX);
+	}
+
+	text += "  handler message id / module / sub module: calls, total us, avg / max us, histogram\n";
+	for (size_t i = 0; i < handlers.size(); ++i)
+	{
+		const EventQueueStatsHandlerKey& key = handlers[i]->first;
+		const EventQueueStatsHandler& stats = handlers[i]->second;
+		sprintf_s(line, sizeof(line), "  %3u / %u / %u%s: %8llu, %10.1f, %8.2f / %9.1f,", key.m_messageID, key.m_moduleID, key.m_subModuleID,
+			key.m_isBatch ? " batch" : "", static_cast<unsigned long long>(stats.m_count), static_cast<f64>(stats.m_timeNSTotal) / 1000.0,
+			static_cast<f64>(stats.m_timeNSTotal) / stats.m_count / 1000.0, static_cast<f64>(stats.m_timeNSMax) / 1000.0);
+		text += line;
+		for (u32 bucket = 0; bucket < EVENTQUEUE_STATS_HISTOGRAM_BUCKETS; ++bucket)
+		{
+			sprintf_s(line, sizeof(line), " %u", stats.m_histogram[bucket]);
+			text += line;
+		}
+		text += "\n";
+	}
+
+	if (m_pProfiler)
+	{
+		m_pProfiler->Dump(text.c_str());
+	}
+	else
+	{
+#if defined(_WIN32)
+		OutputDebugStringA(text.c_str());
+#else
+		fputs(text.c_str(), stderr);
+#endif
+	}
+
+	__Reset();
+}
+
+void EventQueueStats::__Reset()
+{
+	m_frameDump = m_frame.load(std::memory_order_relaxed);
+	m_messages.clear();
+	m_handlers.clear();
+	m_pendingDepthMax = 0;
+}
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <map>
+
+#include "Common/basic_types.h"
+
+#include "EventQueueModules.h"
+#include "EventQueueMessage.h"
+
+namespace TB8
+{
+
+// hooks for a frame profiler, see EventQueue::SetProfiler().  only called with TB8_EVENTQUEUE_STATS defined.
+class EventQueueProfiler
+{
+public:
+	virtual ~EventQueueProfiler() {}
+
+	// around each handler call, batch handlers included.
+	virtual void BeginHandler(EventModuleID /*moduleID*/, u32 /*subModuleID*/, EventMessageID /*messageID*/) {}
+	virtual void EndHandler(EventModuleID /*moduleID*/, u32 /*subModuleID*/, EventMessageID /*messageID*/, u64 /*elapsedNS*/) {}
+	// the periodic dump.  without a profiler it goes to the debugger, or stderr.
+	virtual void Dump(const char* /*pszText*/) {}
+};
+
+#if defined(TB8_EVENTQUEUE_STATS)
+
+// handler times go in power of 2 buckets from 1us, the last holding everything over 16ms.
+const u32 EVENTQUEUE_STATS_HISTOGRAM_BUCKETS = 16;
+
+struct EventQueueStatsMessage
+{
+	u64					m_count;
+	u64					m_latencyFramesTotal;		// queued to dispatched.
+	u64					m_latencyFramesMax;
+	u64					m_latencyNSTotal;
+	u64					m_latencyNSMax;
+};
+
+struct EventQueueStatsHandlerKey
+{
+	EventModuleID		m_moduleID;
+	u32					m_subModuleID;
+	EventMessageID		m_messageID;
+	bool				m_isBatch;
+
+	bool operator <(const EventQueueStatsHandlerKey& rhs) const;
+};
+
+struct EventQueueStatsHandler
+{
+	u64					m_count;
+	u64					m_timeNSTotal;
+	u64					m_timeNSMax;
+	u32					m_histogram[EVENTQUEUE_STATS_HISTOGRAM_BUCKETS];
+};
+
+// event traffic since the last dump.  the queue stamps messages as they're queued, on any thread, and everything
+//  else is on the main thread.
+class EventQueueStats
+{
+public:
+	EventQueueStats();
+
+	static u64 GetTimeNS();
+
+	void OnQueued(EventMessage* message) const;
+	void OnDispatched(const EventMessage* message);
+	void OnPendingDepth(u64 depth);
+	// returns the handler's start time, for EndHandler().
+	u64 BeginHandler(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID, bool isBatch);
+	void EndHandler(EventModuleID moduleID, u32 subModuleID, EventMessageID messageID, bool isBatch, u64 timeStart);
+
+	// dumps every <dumpFrames> frames, 0 to only dump on Dump().
+	void AdvanceFrames(u32 frameCount);
+	void SetDumpFrames(u32 dumpFrames) { m_dumpFrames = dumpFrames; }
+	void SetProfiler(EventQueueProfiler* pProfiler) { m_pProfiler = pProfiler; }
+	// and starts over.
+	void Dump();
+
+private:
+	void __Reset();
+
+	std::atomic<u64>									m_frame;
+	u64													m_frameDump;				// the frame of the last dump.
+	u32													m_dumpFrames;
+	EventQueueProfiler*									m_pProfiler;
+
+	std::vector<EventQueueStatsMessage>					m_messages;					// by message id.
+	std::map<EventQueueStatsHandlerKey, EventQueueStatsHandler>	m_handlers;
+	u64													m_pendingDepthMax;
+};
+
+#endif
+
+}
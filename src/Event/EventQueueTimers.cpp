@@ -0,0 +1,194 @@
+/*
+	Copyright (C) 2019 8 Byte Technology Inc. - All Rights Reserved
+*/
+#include "pch.h"
+
+#include <algorithm>
+
+#include "EventQueueMessage.h"
+
+#include "EventQueueTimers.h"
+
+namespace TB8
+{
+
+const u64 EVENTQUEUE_TIMER_SLOT_MASK = EVENTQUEUE_TIMER_SLOTS - 1;
+
+EventQueueTimerWheel::EventQueueTimerWheel()
+	: m_frame(0)
+	, m_timerCount(0)
+{
+	for (u32 i = 0; i < ARRAYSIZE(m_slots); ++i)
+	{
+		m_slots[i].m_head = EVENTQUEUE_TIMER_INDEX_NONE;
+		m_slots[i].m_tail = EVENTQUEUE_TIMER_INDEX_NONE;
+	}
+}
+
+EventQueueTimerWheel::~EventQueueTimerWheel()
+{
+	for (std::vector<EventQueueTimer>::iterator it = m_timers.begin(); it != m_timers.end(); ++it)
+	{
+		if (it->m_slot != EVENTQUEUE_TIMER_INDEX_NONE)
+		{
+			RELEASEI(it->m_message);
+		}
+	}
+}
+
+EventQueueTimerID EventQueueTimerWheel::Add(EventMessage* message, u64 frame)
+{
+	assert(frame > m_frame);
+
+	u32 timerIndex;
+	if (!m_freeTimers.empty())
+	{
+		timerIndex = m_freeTimers.back();
+		m_freeTimers.pop_back();
+	}
+	else
+	{
+		timerIndex = static_cast<u32>(m_timers.size());
+		EventQueueTimer timer;
+		timer.m_generation = 1;
+		m_timers.push_back(timer);
+	}
+
+	EventQueueTimer& timer = m_timers[timerIndex];
+	timer.m_message = message;
+	timer.m_frame = frame;
+	__Link(timerIndex);
+	++m_timerCount;
+
+	return (static_cast<u64>(timer.m_generation) << 32) | timerIndex;
+}
+
+bool EventQueueTimerWheel::Cancel(EventQueueTimerID timerID)
+{
+	const u32 timerIndex = static_cast<u32>(timerID);
+	const u32 generation = static_cast<u32>(timerID >> 32);
+	if (timerIndex >= m_timers.size())
+		return false;
+
+	EventQueueTimer& timer = m_timers[timerIndex];
+	if ((timer.m_generation != generation) || (timer.m_slot == EVENTQUEUE_TIMER_INDEX_NONE))
+		return false;
+
+	__Unlink(timerIndex);
+	RELEASEI(timer.m_message);
+	__FreeTimer(timerIndex);
+	return true;
+}
+
+void EventQueueTimerWheel::Advance(u64 frame, std::vector<EventMessage*>* pDue)
+{
+	while (m_frame < frame)
+	{
+		++m_frame;
+
+		// entering a new span of a level drops the timers in that span's slot down a level, top level first.
+		if ((m_frame & ((1ull << (EVENTQUEUE_TIMER_SLOT_BITS * EVENTQUEUE_TIMER_LEVELS)) - 1)) == 0)
+		{
+			__Cascade(EVENTQUEUE_TIMER_SLOT_FAR);
+		}
+		for (u32 level = EVENTQUEUE_TIMER_LEVELS - 1; level > 0; --level)
+		{
+			const u32 shift = EVENTQUEUE_TIMER_SLOT_BITS * level;
+			if ((m_frame & ((1ull << shift) - 1)) == 0)
+			{
+				__Cascade((level * EVENTQUEUE_TIMER_SLOTS) + static_cast<u32>((m_frame >> shift) & EVENTQUEUE_TIMER_SLOT_MASK));
+			}
+		}
+
+		// everything in this frame's level 0 slot is due.
+		EventQueueTimerSlot& slot = m_slots[m_frame & EVENTQUEUE_TIMER_SLOT_MASK];
+		while (slot.m_head != EVENTQUEUE_TIMER_INDEX_NONE)
+		{
+			const u32 timerIndex = slot.m_head;
+			EventQueueTimer& timer = m_timers[timerIndex];
+			assert(timer.m_frame == m_frame);
+			__Unlink(timerIndex);
+			pDue->push_back(timer.m_message);
+			timer.m_message = nullptr;
+			__FreeTimer(timerIndex);
+		}
+	}
+}
+
+u32 EventQueueTimerWheel::__GetSlot(u64 frame) const
+{
+	// the lowest level where the frame is in the same span as now.
+	for (u32 level = 0; level < EVENTQUEUE_TIMER_LEVELS; ++level)
+	{
+		const u32 shift = EVENTQUEUE_TIMER_SLOT_BITS * (level + 1);
+		if ((frame >> shift) == (m_frame >> shift))
+			return (level * EVENTQUEUE_TIMER_SLOTS) + static_cast<u32>((frame >> (EVENTQUEUE_TIMER_SLOT_BITS * level)) & EVENTQUEUE_TIMER_SLOT_MASK);
+	}
+	return EVENTQUEUE_TIMER_SLOT_FAR;
+}
+
+void EventQueueTimerWheel::__Link(u32 timerIndex)
+{
+	EventQueueTimer& timer = m_timers[timerIndex];
+	timer.m_slot = __GetSlot(timer.m_frame);
+
+	EventQueueTimerSlot& slot = m_slots[timer.m_slot];
+	timer.m_prev = slot.m_tail;
+	timer.m_next = EVENTQUEUE_TIMER_INDEX_NONE;
+	if (slot.m_tail != EVENTQUEUE_TIMER_INDEX_NONE)
+	{
+		m_timers[slot.m_tail].m_next = timerIndex;
+	}
+	else
+	{
+		slot.m_head = timerIndex;
+	}
+	slot.m_tail = timerIndex;
+}
+
+void EventQueueTimerWheel::__Unlink(u32 timerIndex)
+{
+	EventQueueTimer& timer = m_timers[timerIndex];
+	EventQueueTimerSlot& slot = m_slots[timer.m_slot];
+	if (timer.m_prev != EVENTQUEUE_TIMER_INDEX_NONE)
+	{
+		m_timers[timer.m_prev].m_next = timer.m_next;
+	}
+	else
+	{
+		slot.m_head = timer.m_next;
+	}
+	if (timer.m_next != EVENTQUEUE_TIMER_INDEX_NONE)
+	{
+		m_timers[timer.m_next].m_prev = timer.m_prev;
+	}
+	else
+	{
+		slot.m_tail = timer.m_prev;
+	}
+	timer.m_slot = EVENTQUEUE_TIMER_INDEX_NONE;
+}
+
+void EventQueueTimerWheel::__FreeTimer(u32 timerIndex)
+{
+	EventQueueTimer& timer = m_timers[timerIndex];
+	timer.m_generation = std::max<u32>(timer.m_generation + 1, 1);
+	m_freeTimers.push_back(timerIndex);
+	--m_timerCount;
+}
+
+void EventQueueTimerWheel::__Cascade(u32 slotIndex)
+{
+	// relink in order, so timers due on the same frame stay in the order they were added.
+	u32 timerIndex = m_slots[slotIndex].m_head;
+	m_slots[slotIndex].m_head = EVENTQUEUE_TIMER_INDEX_NONE;
+	m_slots[slotIndex].m_tail = EVENTQUEUE_TIMER_INDEX_NONE;
+	while (timerIndex != EVENTQUEUE_TIMER_INDEX_NONE)
+	{
+		const u32 timerIndexNext = m_timers[timerIndex].m_next;
+		__Link(timerIndex);
+		timerIndex = timerIndexNext;
+	}
+}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <limits.h>
+
+#include <vector>
+
+#include "Common/basic_types.h"
+
+namespace TB8
+{
+
+class EventMessage;
+
+typedef u64 EventQueueTimerID;
+const EventQueueTimerID EVENTQUEUE_TIMER_NONE = 0;
+
+const u32 EVENTQUEUE_TIMER_LEVELS = 4;
+const u32 EVENTQUEUE_TIMER_SLOT_BITS = 6;
+const u32 EVENTQUEUE_TIMER_SLOTS = 1 << EVENTQUEUE_TIMER_SLOT_BITS;		// per level.
+const u32 EVENTQUEUE_TIMER_SLOT_FAR = EVENTQUEUE_TIMER_LEVELS * EVENTQUEUE_TIMER_SLOTS;	// past the top level.
+const u32 EVENTQUEUE_TIMER_INDEX_NONE = UINT_MAX;
+
+struct EventQueueTimer
+{
+	EventMessage*		m_message;
+	u64					m_frame;			// frame it's due.
+	u32					m_slot;				// EVENTQUEUE_TIMER_INDEX_NONE when free.
+	u32					m_prev;
+	u32					m_next;
+	u32					m_generation;		// bumped when freed, so a stale id can't cancel the next timer in its place.
+};
+
+struct EventQueueTimerSlot
+{
+	u32					m_head;
+	u32					m_tail;
+};
+
+// messages waiting on a frame, in a hierarchical timing wheel.
+//  level 0 has a slot per frame for the next 64 frames, each level up a slot per 64 frames of the one below.  a timer
+//  goes in the lowest level whose span holds its frame, and drops a level each time the wheel reaches its slot, so
+//  adding and cancelling are O(1), and advancing is O(1) a frame plus the timers that come due.  timers due on the
+//  same frame come due in the order they were added.
+class EventQueueTimerWheel
+{
+public:
+	EventQueueTimerWheel();
+	~EventQueueTimerWheel();
+
+	u64 GetFrame() const { return m_frame; }
+
+	// steals the reference to the message.  <frame> must be after GetFrame().
+	EventQueueTimerID Add(EventMessage* message, u64 frame);
+	// releases the message, false if the timer already came due or was cancelled.
+	bool Cancel(EventQueueTimerID timerID);
+
+	// steps to <frame>, appending the messages that come due to <pDue>, in order.
+	void Advance(u64 frame, std::vector<EventMessage*>* pDue);
+
+	u32 GetTimerCount() const { return m_timerCount; }
+
+private:
+	u32 __GetSlot(u64 frame) const;
+	void __Link(u32 timerIndex);
+	void __Unlink(u32 timerIndex);
+	void __FreeTimer(u32 timerIndex);
+	void __Cascade(u32 slot);
+
+	u64									m_frame;
+	EventQueueTimerSlot					m_slots[EVENTQUEUE_TIMER_SLOT_FAR + 1];
+	std::vector<EventQueueTimer>		m_timers;
+	std::vector<u32>					m_freeTimers;
+	u32									m_timerCount;
+};
+
+}
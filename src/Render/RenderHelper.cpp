@@ -1,6 +1,6 @@
 #include "pch.h"
 
-#include "common/file_io.h"
+#include "Common/file_io.h"
 
 #include "RenderHelper.h"
 
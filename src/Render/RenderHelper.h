@@ -5,7 +5,7 @@
 
 #include <vector>
 
-#include "common/basic_types.h"
+#include "Common/basic_types.h"
 
 namespace TB8
 {
@@ -5,8 +5,8 @@
 #include <vector>
 #include <map>
 
-#include "common/basic_types.h"
-#include "common/ref_count.h"
+#include "Common/basic_types.h"
+#include "Common/ref_count.h"
 
 namespace TB8
 {
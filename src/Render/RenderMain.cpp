@@ -283,7 +283,7 @@ void RenderMain::__Initialize()
 	assert(hr == S_OK);
 
 	// register for events.
-	__GetEventQueue()->RegisterForMessage(EventModuleID_Renderer, EventMessageID_ResizeWindow, std::bind(&RenderMain::__EventHandler, this, std::placeholders::_1));
+	__GetEventQueue()->Register<EventMessage_ResizeWindow>(EventModuleID_Renderer, this, &RenderMain::__EventResizeWindow);
 
 	RELEASEI(dxgiAdapter);
 
@@ -897,16 +897,6 @@ void RenderMain::EndUpdate()
 	m_pDXGISwapChain->Present(1, 0);
 }
 
-void RenderMain::__EventHandler(EventMessage* message)
-{
-	switch (message->GetID())
-	{
-	case EventMessageID_ResizeWindow:
-		__EventResizeWindow(static_cast<EventMessage_ResizeWindow*>(message));
-		break;
-	}
-}
-
 void RenderMain::__EventResizeWindow(EventMessage_ResizeWindow* event)
 {
 	const IVector2 screenSize(event->m_sizeX, event->m_sizeY);
@@ -2,7 +2,7 @@
 
 #include <vector>
 
-#include "client/client_globals.h"
+#include "Client/Client_Globals.h"
 
 namespace TB8
 {
@@ -155,7 +155,6 @@ private:
 	void __ConfigureView_World();
 	void __ConfigureView_UI();
 
-	void __EventHandler(EventMessage* message);
 	void __EventResizeWindow(class EventMessage_ResizeWindow* event);
 
 	HWND						m_hWnd;
@@ -5,10 +5,10 @@
 #include <vector>
 #include <map>
 
-#include "common/basic_types.h"
-#include "common/ref_count.h"
-#include "common/file_io.h"
-#include "common/parse_xml.h"
+#include "Common/basic_types.h"
+#include "Common/ref_count.h"
+#include "Common/file_io.h"
+#include "Common/parse_xml.h"
 
 namespace TB8
 {
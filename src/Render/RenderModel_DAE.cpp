@@ -5,8 +5,8 @@
 #include <map>
 #include <algorithm>
 
-#include "common/file_io.h"
-#include "common/parse_xml.h"
+#include "Common/file_io.h"
+#include "Common/parse_xml.h"
 
 #include "RenderHelper.h"
 #include "RenderModel.h"
@@ -2,7 +2,7 @@
 
 #include <DirectXMath.h>
 
-#include "common/file_io.h"
+#include "Common/file_io.h"
 
 #include "RenderTexture.h"
 #include "RenderHelper.h"
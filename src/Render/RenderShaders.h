@@ -4,8 +4,8 @@
 #include <wrl/client.h>
 #include <vector>
 
-#include "common/basic_types.h"
-#include "common/ref_count.h"
+#include "Common/basic_types.h"
+#include "Common/ref_count.h"
 
 namespace TB8
 {
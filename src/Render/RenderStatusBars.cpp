@@ -5,7 +5,7 @@
 #include <map>
 #include <algorithm>
 
-#include "common/memory.h"
+#include "Common/memory.h"
 
 #include "RenderHelper.h"
 #include "RenderScale.h"
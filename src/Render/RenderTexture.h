@@ -3,8 +3,8 @@
 #include <d3d11.h>
 #include <wrl/client.h>
 
-#include "common/basic_types.h"
-#include "common/ref_count.h"
+#include "Common/basic_types.h"
+#include "Common/ref_count.h"
 
 namespace TB8
 {
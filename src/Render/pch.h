@@ -26,6 +26,6 @@
 #include <map>
 #include <algorithm>
 
-#include "common/basic_types.h"
-#include "common/memory.h"
+#include "Common/basic_types.h"
+#include "Common/memory.h"
 
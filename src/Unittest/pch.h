@@ -3,6 +3,7 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 
+#if defined(_WIN32)
 #define WIN32_LEAN_AND_MEAN
 
 #include <windows.h>
@@ -17,14 +18,22 @@
 #include "Wincodec.h"
 #include <wrl/client.h>
 
-#include <stdlib.h>
 #include <malloc.h>
-#include <memory>
 #include <tchar.h>
+#else
+#include <unistd.h>
+#include <string.h>
+
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+inline void Sleep(unsigned int ms) { usleep(ms * 1000); }
+#endif
+
+#include <stdlib.h>
+#include <memory>
 #include <string>
 
 #include <algorithm>
 #include <stdlib.h>
 
-#include "common/basic_types.h"
-#include "common/memory.h"
+#include "Common/basic_types.h"
+#include "Common/memory.h"
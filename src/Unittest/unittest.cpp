@@ -2,9 +2,11 @@
 
 #include <iostream>
 
-#include "common/string.h"
+#include "Common/string.h"
 
 #include "unittest_common.h"
+#include "unittest_event.h"
+#include "unittest_world.h"
 
 #include "unittest.h"
 
@@ -13,6 +15,7 @@ u32 g_testNum = 0;
 u32 g_testCount;
 u32 g_testPartCount;
 u32 g_errorCount;
+u32 g_failedTestCount = 0;
 u32 g_errorPartCount;
 u32 g_lineCount;
 bool g_isFreshLine;
@@ -48,6 +51,8 @@ int main(int argc, char* argv[])
 	if (g_testNum == 0)
 	{
 		unittest_common();
+		unittest_event();
+		unittest_world();
 	}
 	else
 	{
@@ -56,10 +61,18 @@ int main(int argc, char* argv[])
 		case 1:
 			unittest_common();
 			break;
+		case 2:
+			unittest_event();
+			break;
+		case 3:
+			unittest_world();
+			break;
 		default:
 			break;
 		}
 	}
+
+	return (g_failedTestCount == 0) ? 0 : 1;
 }
 
 void EnsureFreshLine()
@@ -136,6 +149,7 @@ void TESTEND()
 	if (g_errorCount > 0)
 	{
 		printf("\x1b[41mFailed\x1b[0m\n");
+		++g_failedTestCount;
 	}
 	else
 	{
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "common/basic_types.h"
+#include "Common/basic_types.h"
 
 enum unittest_output
 {
@@ -1,6 +1,8 @@
 #include "pch.h"
 
-#include "common/parse_xml.h"
+#include "Common/parse_xml.h"
+#include "Common/job_system.h"
+#include "Common/random.h"
 
 #include "unittest_common.h"
 #include "unittest.h"
@@ -340,12 +342,155 @@ Exit:
 
 }
 
+void unittest_common_job_system()
+{
+	TESTBEGIN("Job system parallel for");
+
+	for (u32 threadCount = 1; threadCount <= 8; ++threadCount)
+	{
+		JobSystem* pJobSystem = JobSystem::Alloc(threadCount);
+		if (pJobSystem->GetThreadCount() != threadCount)
+		{
+			TESTOUT(unittest_output_error, "Thread count %d, expected %d.", pJobSystem->GetThreadCount(), threadCount);
+		}
+
+		// every job runs exactly once, for repeated calls of varying size.
+		for (u32 jobCount = 0; jobCount < 64; ++jobCount)
+		{
+			std::vector<u32> results(jobCount, 0);
+			pJobSystem->ParallelFor(jobCount, [&results](u32 jobIndex) { results[jobIndex] += jobIndex + 1; });
+
+			for (u32 i = 0; i < jobCount; ++i)
+			{
+				if (results[i] != i + 1)
+				{
+					TESTOUT(unittest_output_error, "Job %d of %d with %d threads, result %d.", i, jobCount, threadCount, results[i]);
+					break;
+				}
+			}
+		}
+
+		pJobSystem->Free();
+	}
+
+	TESTEND();
+}
+
+void unittest_common_random()
+{
+	TESTBEGIN("Random streams");
+
+	// known answers, from the Philox reference implementation.
+	struct KnownAnswer
+	{
+		u32 m_counter[4];
+		u32 m_key[2];
+		u32 m_result[4];
+	};
+	static const KnownAnswer s_knownAnswers[] =
+	{
+		{ { 0x00000000, 0x00000000, 0x00000000, 0x00000000 }, { 0x00000000, 0x00000000 }, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+		{ { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }, { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+		{ { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }, { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } },
+	};
+	for (u32 i = 0; i < ARRAYSIZE(s_knownAnswers); ++i)
+	{
+		u32 result[4];
+		Random::Philox4x32(s_knownAnswers[i].m_counter, s_knownAnswers[i].m_key, result);
+		if (memcmp(result, s_knownAnswers[i].m_result, sizeof(result)) != 0)
+		{
+			TESTOUT(unittest_output_error, "Known answer %d, got %08x %08x %08x %08x.", i, result[0], result[1], result[2], result[3]);
+		}
+	}
+
+	// a stream draws the same values however it's interleaved with others.
+	const u32 valueCount = 37;
+	std::vector<u32> alone[3];
+	for (u32 stream = 0; stream < 3; ++stream)
+	{
+		Random random(1234, stream);
+		for (u32 i = 0; i < valueCount; ++i)
+		{
+			alone[stream].push_back(random.Next());
+		}
+	}
+	Random interleaved[3] = { Random(1234, 0), Random(1234, 1), Random(1234, 2) };
+	for (u32 i = 0; i < valueCount; ++i)
+	{
+		for (u32 stream = 3; stream-- > 0; )
+		{
+			if (interleaved[stream].Next() != alone[stream][i])
+			{
+				TESTOUT(unittest_output_error, "Stream %d value %d changed when interleaved.", stream, i);
+			}
+		}
+	}
+	if ((alone[0] == alone[1]) || (alone[1] == alone[2]))
+	{
+		TESTOUT(unittest_output_error, "Streams are the same.");
+	}
+
+	// restoring a position replays the stream from there.
+	for (u32 position = 0; position < valueCount; ++position)
+	{
+		Random random(1234, 1);
+		random.SetPosition(position);
+		for (u32 i = position; i < valueCount; ++i)
+		{
+			if (random.Next() != alone[1][i])
+			{
+				TESTOUT(unittest_output_error, "Replay from %d differs at %d.", position, i);
+				break;
+			}
+		}
+	}
+
+	// ranges.
+	Random random(99, 7);
+	u32 counts[6] = { 0 };
+	for (u32 i = 0; i < 60000; ++i)
+	{
+		const u32 value = random.Next(6);
+		if (value >= 6)
+		{
+			TESTOUT(unittest_output_error, "Next(6) returned %d.", value);
+			break;
+		}
+		++counts[value];
+
+		const s32 ranged = random.Next(-3, 4);
+		if ((ranged < -3) || (ranged >= 4))
+		{
+			TESTOUT(unittest_output_error, "Next(-3, 4) returned %d.", ranged);
+			break;
+		}
+
+		const f32 unit = random.NextF32();
+		if ((unit < 0.f) || (unit >= 1.f))
+		{
+			TESTOUT(unittest_output_error, "NextF32() returned %f.", unit);
+			break;
+		}
+	}
+	for (u32 i = 0; i < ARRAYSIZE(counts); ++i)
+	{
+		if ((counts[i] < 9500) || (counts[i] > 10500))
+		{
+			TESTOUT(unittest_output_error, "Next(6) drew %d %d times in 60000.", i, counts[i]);
+		}
+	}
+
+	TESTEND();
+}
+
 void unittest_common()
 {
 	SUITEBEGIN("Starting common tests ...");
 
 	unittest_common_parse_xml();
 	unittest_common_parse_xml_buffer_overrun();
+	unittest_common_job_system();
+	unittest_common_random();
 
 	SUITEEND();
 }
\ No newline at end of file
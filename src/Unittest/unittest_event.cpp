@@ -0,0 +1,715 @@
+#include "pch.h"
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#include "Event/EventQueue.h"
+#include "Event/EventQueueMessages.h"
+#include "Event/EventQueueStats.h"
+#include "Common/string.h"
+
+#include "unittest_event.h"
+#include "unittest.h"
+
+using namespace TB8;
+
+const u32 UNITTEST_EVENT_PRODUCER_COUNT = 6;
+const u32 UNITTEST_EVENT_PRODUCER_MESSAGES = 20000;		// each, well past the inbox ring, so the overflow chain is used.
+
+void unittest_event_inbox_producers()
+{
+	TESTBEGIN("Event inbox, %d producer threads", UNITTEST_EVENT_PRODUCER_COUNT);
+
+	EventQueue* pQueue = EventQueue::Alloc();
+	pQueue->SetCoalesce(EventMessageID_MouseCursorMove, EventQueueCoalesce_None);
+	pQueue->SetFrameBudget(0);
+
+	// the producer is in x and its sequence number in y, each producer's messages must arrive in order.
+	std::vector<s32> nextSequence(UNITTEST_EVENT_PRODUCER_COUNT, 0);
+	u32 receivedCount = 0;
+	u32 orderErrorCount = 0;
+	pQueue->RegisterForMessage(EventModuleID_World, EventMessageID_MouseCursorMove, [&](EventMessage* message)
+	{
+		const EventMessage_MouseCursorMove* pMove = static_cast<const EventMessage_MouseCursorMove*>(message);
+		const u32 producer = static_cast<u32>(pMove->m_mouseX);
+		if ((producer >= UNITTEST_EVENT_PRODUCER_COUNT) || (pMove->m_mouseY != nextSequence[producer]))
+		{
+			if (!orderErrorCount)
+			{
+				TESTOUT(unittest_output_error, "Producer %d message %d out of order.", pMove->m_mouseX, pMove->m_mouseY);
+			}
+			++orderErrorCount;
+			return;
+		}
+		++nextSequence[producer];
+		++receivedCount;
+	});
+
+	std::atomic<u32> doneCount(0);
+	std::vector<std::thread> producers;
+	for (u32 producer = 0; producer < UNITTEST_EVENT_PRODUCER_COUNT; ++producer)
+	{
+		producers.push_back(std::thread([pQueue, producer, &doneCount]()
+		{
+			for (u32 i = 0; i < UNITTEST_EVENT_PRODUCER_MESSAGES; ++i)
+			{
+				EventMessage* message = EventMessage_MouseCursorMove::Alloc(static_cast<s32>(producer), static_cast<s32>(i));
+				pQueue->QueueMessage(&message);
+			}
+			++doneCount;
+		}));
+	}
+
+	// dispatch while the producers run, as the main thread would each frame.
+	while (doneCount < UNITTEST_EVENT_PRODUCER_COUNT)
+	{
+		pQueue->ProcessPending();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	for (std::vector<std::thread>::iterator it = producers.begin(); it != producers.end(); ++it)
+	{
+		it->join();
+	}
+	pQueue->ProcessPending();
+
+	if (receivedCount != UNITTEST_EVENT_PRODUCER_COUNT * UNITTEST_EVENT_PRODUCER_MESSAGES)
+	{
+		TESTOUT(unittest_output_error, "Received %d messages, expected %d.", receivedCount, UNITTEST_EVENT_PRODUCER_COUNT * UNITTEST_EVENT_PRODUCER_MESSAGES);
+	}
+
+	pQueue->Free();
+
+	TESTEND();
+}
+
+void unittest_event_coalesce()
+{
+	TESTBEGIN("Event coalescing");
+
+	// the defaults: cursor moves keep the latest, wheel moves sum their deltas, and move starts aren't coalesced.
+	EventQueue* pQueue = EventQueue::Alloc();
+	pQueue->SetFrameBudget(0);
+
+	const s32 queuedCount = 5;
+	const s32 moveStartCount = 3;
+	u32 moveCount = 0;
+	s32 lastMoveX = -1;
+	u32 wheelCount = 0;
+	s32 wheelDelta = 0;
+	u32 moveStartReceivedCount = 0;
+	pQueue->RegisterForMessage(EventModuleID_World, EventMessageID_MouseCursorMove, [&](EventMessage* message)
+	{
+		++moveCount;
+		lastMoveX = static_cast<const EventMessage_MouseCursorMove*>(message)->m_mouseX;
+	});
+	pQueue->RegisterForMessage(EventModuleID_World, EventMessageID_MouseMoveWheel, [&](EventMessage* message)
+	{
+		++wheelCount;
+		wheelDelta = static_cast<const EventMessage_MouseMoveWheel*>(message)->m_delta;
+	});
+	pQueue->RegisterForMessage(EventModuleID_World, EventMessageID_MoveStart, [&](EventMessage*)
+	{
+		++moveStartReceivedCount;
+	});
+
+	for (s32 i = 0; i < queuedCount; ++i)
+	{
+		EventMessage* message = EventMessage_MouseCursorMove::Alloc(i, 0);
+		pQueue->QueueMessage(&message);
+		message = EventMessage_MouseMoveWheel::Alloc(IVector2(0, 0), i + 1, 120);
+		pQueue->QueueMessage(&message);
+	}
+	for (s32 i = 0; i < moveStartCount; ++i)
+	{
+		EventMessage* message = EventMessage_MoveStart::Alloc(1, 0, 0);
+		pQueue->QueueMessage(&message);
+	}
+	pQueue->ProcessPending();
+
+	if ((moveCount != 1) || (lastMoveX != queuedCount - 1))
+	{
+		TESTOUT(unittest_output_error, "Dispatched %d cursor moves ending at %d, expected 1 at %d.", moveCount, lastMoveX, queuedCount - 1);
+	}
+	const s32 expectedDelta = queuedCount * (queuedCount + 1) / 2;
+	if ((wheelCount != 1) || (wheelDelta != expectedDelta))
+	{
+		TESTOUT(unittest_output_error, "Dispatched %d wheel moves with delta %d, expected 1 with %d.", wheelCount, wheelDelta, expectedDelta);
+	}
+	if (moveStartReceivedCount != static_cast<u32>(moveStartCount))
+	{
+		TESTOUT(unittest_output_error, "Dispatched %d move starts, expected %d.", moveStartReceivedCount, moveStartCount);
+	}
+
+	pQueue->Free();
+
+	TESTEND();
+}
+
+void unittest_event_timers()
+{
+	TESTBEGIN("Event timers");
+
+	EventQueue* pQueue = EventQueue::Alloc();
+	pQueue->SetFrameBudget(0);
+	pQueue->SetStatsDumpFrames(0);
+
+	// each delay lands in a different level of the wheel, the last past the top level.  the message's dx is its index
+	//  in the order it should arrive.
+	const u32 delays[] = { 1, 37, 37, 300, 5000, 70000, 20000000 };
+	const u32 delayCount = sizeof(delays) / sizeof(delays[0]);
+	const u32 stepFrames = 400;				// stepped a frame at a time, the rest in one jump.
+
+	std::vector<s32> received;
+	std::vector<u64> receivedFrames;
+	pQueue->RegisterForMessage(EventModuleID_World, EventMessageID_MoveStart, [&](EventMessage* message)
+	{
+		received.push_back(static_cast<const EventMessage_MoveStart*>(message)->m_dx);
+		receivedFrames.push_back(pQueue->GetFrame());
+	});
+
+	std::vector<EventQueueTimerID> timerIDs;
+	for (u32 i = 0; i < delayCount; ++i)
+	{
+		EventMessage* message = EventMessage_MoveStart::Alloc(static_cast<s32>(i), 0, 0);
+		timerIDs.push_back(pQueue->QueueMessageAfter(&message, delays[i]));
+		if ((timerIDs.back() == EVENTQUEUE_TIMER_NONE) || message)
+		{
+			TESTOUT(unittest_output_error, "Timer %d wasn't added.", i);
+		}
+	}
+
+	// cancelled once only.
+	EventMessage* message = EventMessage_MoveStart::Alloc(-1, 0, 0);
+	const EventQueueTimerID cancelID = pQueue->QueueMessageAfter(&message, 100);
+	const bool isCancelled = pQueue->CancelMessage(cancelID);
+	const bool isCancelledAgain = pQueue->CancelMessage(cancelID);
+	if (!isCancelled || isCancelledAgain)
+	{
+		TESTOUT(unittest_output_error, "Cancel returned %d then %d, expected 1 then 0.", isCancelled, isCancelledAgain);
+	}
+
+	// a frame that's been reached is queued now.
+	message = EventMessage_MoveStart::Alloc(-2, 0, 0);
+	if (pQueue->QueueMessageAt(&message, pQueue->GetFrame()) != EVENTQUEUE_TIMER_NONE)
+	{
+		TESTOUT(unittest_output_error, "A timer for the current frame was added.");
+	}
+	pQueue->ProcessPending();
+	if ((received.size() != 1) || (received[0] != -2))
+	{
+		TESTOUT(unittest_output_error, "The message for the current frame wasn't dispatched.");
+	}
+	received.clear();
+	receivedFrames.clear();
+
+	for (u32 frame = 0; frame < stepFrames; ++frame)
+	{
+		pQueue->AdvanceFrames(1);
+		pQueue->ProcessPending();
+	}
+	if (pQueue->CancelMessage(timerIDs[0]))
+	{
+		TESTOUT(unittest_output_error, "Cancelled a timer that had come due.");
+	}
+	pQueue->AdvanceFrames(delays[delayCount - 1]);
+	pQueue->ProcessPending();
+
+	// stepped timers arrive on their frame, and the ones in the jump after them, all in order.
+	bool isOrderError = received.size() != delayCount;
+	for (u32 i = 0; !isOrderError && (i < delayCount); ++i)
+	{
+		isOrderError = (received[i] != static_cast<s32>(i)) || ((delays[i] <= stepFrames) && (receivedFrames[i] != delays[i]));
+	}
+	if (isOrderError)
+	{
+		TESTOUT(unittest_output_error, "Received %d of %d timers, out of order or on the wrong frame.", static_cast<u32>(received.size()), delayCount);
+		for (u32 i = 0; i < received.size(); ++i)
+		{
+			TESTOUT(unittest_output_debug, "  %d at frame %llu", received[i], static_cast<unsigned long long>(receivedFrames[i]));
+		}
+	}
+
+	pQueue->Free();
+
+	TESTEND();
+}
+
+void unittest_event_batch()
+{
+	TESTBEGIN("Event batch dispatch");
+
+	EventQueue* pQueue = EventQueue::Alloc();
+	pQueue->SetFrameBudget(0);
+
+	// a frame's move starts, in the order they were queued, among messages that aren't batched.
+	const s32 batchCount = 10;
+	u32 firstCallCount = 0;
+	std::vector<s32> batch;
+	pQueue->RegisterForMessageBatch(EventModuleID_World, 1, EventMessageID_MoveStart, [&](EventMessage* const* ppMessages, u32 messageCount)
+	{
+		++firstCallCount;
+		for (u32 i = 0; i < messageCount; ++i)
+		{
+			batch.push_back(static_cast<const EventMessage_MoveStart*>(ppMessages[i])->m_dx);
+		}
+	});
+	for (s32 i = 0; i < batchCount; ++i)
+	{
+		EventMessage* message = EventMessage_MoveStart::Alloc(i, 0, 0);
+		pQueue->QueueMessage(&message);
+		message = EventMessage_MoveEnd::Alloc(i, 0, 0);
+		pQueue->QueueMessage(&message);
+	}
+	pQueue->ProcessPending();
+
+	bool isOrderError = (firstCallCount != 1) || (batch.size() != static_cast<size_t>(batchCount));
+	for (s32 i = 0; !isOrderError && (i < batchCount); ++i)
+	{
+		isOrderError = batch[i] != i;
+	}
+	if (isOrderError)
+	{
+		TESTOUT(unittest_output_error, "%d batches held %d messages, expected 1 with %d in order.", firstCallCount, static_cast<u32>(batch.size()), batchCount);
+	}
+
+	// registering again replaces the handler.  a handler that unregisters itself finishes its call, and those after it
+	//  are still called that frame.  its captures are copied so they're stored with it.
+	u32 secondCallCount = 0;
+	pQueue->RegisterForMessageBatch(EventModuleID_World, 1, EventMessageID_MoveStart, [&](EventMessage* const*, u32)
+	{
+		++secondCallCount;
+	});
+	u32 selfCallCount = 0;
+	u32* pSelfCallCount = &selfCallCount;
+	const std::vector<u32> selfCapture(16, 1);
+	pQueue->RegisterForMessageBatch(EventModuleID_World, 2, EventMessageID_MoveStart, [pQueue, pSelfCallCount, selfCapture](EventMessage* const*, u32)
+	{
+		pQueue->UnregisterForMessageBatch(EventModuleID_World, 2, EventMessageID_MoveStart);
+		*pSelfCallCount += selfCapture[selfCapture.size() - 1];
+	});
+	u32 lastCallCount = 0;
+	pQueue->RegisterForMessageBatch(EventModuleID_World, 3, EventMessageID_MoveStart, [&](EventMessage* const*, u32)
+	{
+		++lastCallCount;
+	});
+
+	for (u32 frame = 0; frame < 2; ++frame)
+	{
+		EventMessage* message = EventMessage_MoveStart::Alloc(0, 0, 0);
+		pQueue->QueueMessage(&message);
+		pQueue->ProcessPending();
+	}
+	if ((firstCallCount != 1) || (secondCallCount != 2))
+	{
+		TESTOUT(unittest_output_error, "Registering again called the first handler %d times and the second %d, expected 1 and 2.", firstCallCount, secondCallCount);
+	}
+	if ((selfCallCount != 1) || (lastCallCount != 2))
+	{
+		TESTOUT(unittest_output_error, "The handler that unregistered itself was called %d times and the one after it %d, expected 1 and 2.", selfCallCount, lastCallCount);
+	}
+
+	pQueue->Free();
+
+	TESTEND();
+}
+
+const u32 UNITTEST_EVENT_TARGET_COUNT = 4000;
+
+void unittest_event_targets()
+{
+	TESTBEGIN("Event targets, %d objects", UNITTEST_EVENT_TARGET_COUNT);
+
+	EventQueue* pQueue = EventQueue::Alloc();
+	pQueue->SetFrameBudget(0);
+
+	// each object's thoughts go to a world sub module of its own and to the renderer.  object ids start at 1.
+	const u32 objectCountMax = UNITTEST_EVENT_TARGET_COUNT * 2;
+	std::vector<u32> worldCalls(objectCountMax + 1, 0);
+	std::vector<u32> rendererCalls(objectCountMax + 1, 0);
+	std::vector<u32> expectedWorldCalls(objectCountMax + 1, 0);
+	std::vector<u32> expectedRendererCalls(objectCountMax + 1, 0);
+	bool isUnregistering = false;
+	auto registerObject = [&](u32 objectID)
+	{
+		pQueue->RegisterForMessage(EventModuleID_World, objectID, EventMessageID_UnitThought, objectID, [&worldCalls, objectID](EventMessage*)
+		{
+			++worldCalls[objectID];
+		});
+		pQueue->RegisterForMessage(EventModuleID_Renderer, 0, EventMessageID_UnitThought, objectID, [&, objectID](EventMessage*)
+		{
+			++rendererCalls[objectID];
+			if (!isUnregistering)
+				return;
+
+			// the first object's thought unregisters the even objects' world handlers, and every handler of every
+			//  third object, while the rest of the thoughts wait to be dispatched.
+			isUnregistering = false;
+			for (u32 id = 2; id <= UNITTEST_EVENT_TARGET_COUNT; id += 2)
+			{
+				pQueue->UnregisterForMessagesByRegistree(EventModuleID_World, id);
+			}
+			for (u32 id = 3; id <= UNITTEST_EVENT_TARGET_COUNT; id += 3)
+			{
+				pQueue->UnregisterForMessagesByTargetObjectID(id);
+			}
+		});
+	};
+	auto queueThoughts = [&](u32 objectCount)
+	{
+		for (u32 objectID = 1; objectID <= objectCount; ++objectID)
+		{
+			EventMessage* message = EventMessage_UnitThought::Alloc(objectID);
+			pQueue->QueueMessage(&message);
+		}
+		pQueue->ProcessPending();
+	};
+	auto checkCalls = [&](const char* pszStep)
+	{
+		u32 errorCount = 0;
+		for (u32 objectID = 1; objectID <= objectCountMax; ++objectID)
+		{
+			if ((worldCalls[objectID] != expectedWorldCalls[objectID]) || (rendererCalls[objectID] != expectedRendererCalls[objectID]))
+			{
+				if (!errorCount)
+				{
+					TESTOUT(unittest_output_error, "%s, object %d called %d / %d times, expected %d / %d.", pszStep, objectID, worldCalls[objectID], rendererCalls[objectID], expectedWorldCalls[objectID], expectedRendererCalls[objectID]);
+				}
+				++errorCount;
+			}
+		}
+		if (errorCount > 1)
+		{
+			TESTOUT(unittest_output_error, "%s, %d objects called the wrong number of times.", pszStep, errorCount);
+		}
+	};
+
+	for (u32 objectID = 1; objectID <= UNITTEST_EVENT_TARGET_COUNT; ++objectID)
+	{
+		registerObject(objectID);
+		++expectedWorldCalls[objectID];
+		++expectedRendererCalls[objectID];
+	}
+	queueThoughts(UNITTEST_EVENT_TARGET_COUNT);
+	checkCalls("Registered");
+
+	// no stale handler is called, neither later in the dispatch that unregistered it, nor after.
+	for (u32 pass = 0; pass < 2; ++pass)
+	{
+		isUnregistering = (pass == 0);
+		for (u32 objectID = 1; objectID <= UNITTEST_EVENT_TARGET_COUNT; ++objectID)
+		{
+			const bool isTargetRemoved = (objectID != 1) && ((objectID % 3) == 0);
+			const bool isWorldRemoved = (objectID != 1) && ((objectID % 2) == 0);
+			expectedWorldCalls[objectID] += (isTargetRemoved || isWorldRemoved) ? 0 : 1;
+			expectedRendererCalls[objectID] += isTargetRemoved ? 0 : 1;
+		}
+		queueThoughts(UNITTEST_EVENT_TARGET_COUNT);
+		checkCalls(pass ? "After unregistering" : "Unregistering");
+	}
+
+	// the removed objects register again, and as many new ones, so the table grows again.
+	for (u32 objectID = 1; objectID <= objectCountMax; ++objectID)
+	{
+		if ((objectID > UNITTEST_EVENT_TARGET_COUNT) || ((objectID % 3) == 0))
+		{
+			registerObject(objectID);
+		}
+		else if ((objectID % 2) == 0)
+		{
+			pQueue->RegisterForMessage(EventModuleID_World, objectID, EventMessageID_UnitThought, objectID, [&worldCalls, objectID](EventMessage*)
+			{
+				++worldCalls[objectID];
+			});
+		}
+		++expectedWorldCalls[objectID];
+		++expectedRendererCalls[objectID];
+	}
+	queueThoughts(objectCountMax);
+	checkCalls("Registered again");
+
+	pQueue->Free();
+
+	TESTEND();
+}
+
+// a handler behind another base, so its this pointer is adjusted, with a virtual that's overridden.
+class unittest_event_typed_base
+{
+public:
+	unittest_event_typed_base() : m_padding(0) {}
+	virtual ~unittest_event_typed_base() {}
+
+	u32					m_padding;
+};
+
+class unittest_event_typed_handler
+{
+public:
+	unittest_event_typed_handler() : m_thoughtObjectID(0) {}
+	virtual ~unittest_event_typed_handler() {}
+
+	virtual void OnThought(EventMessage_UnitThought* pEvent) { m_thoughtObjectID = pEvent->GetObjectID(); }
+
+	u32					m_thoughtObjectID;
+};
+
+class unittest_event_typed_derived : public unittest_event_typed_base, public unittest_event_typed_handler
+{
+public:
+	unittest_event_typed_derived() : m_moveDX(0), m_overrideCount(0) {}
+
+	void OnMoveStart(EventMessage_MoveStart* pEvent) { m_moveDX = pEvent->m_dx; }
+	virtual void OnThought(EventMessage_UnitThought* pEvent) override
+	{
+		unittest_event_typed_handler::OnThought(pEvent);
+		++m_overrideCount;
+	}
+
+	s32					m_moveDX;
+	u32					m_overrideCount;
+};
+
+void unittest_event_typed()
+{
+	TESTBEGIN("Event typed handlers");
+
+	EventQueue* pQueue = EventQueue::Alloc();
+	pQueue->SetFrameBudget(0);
+
+	// a derived class's method, and a base's virtual, called on the derived object for one object id.
+	const u32 objectID = 7;
+	unittest_event_typed_derived handler;
+	pQueue->Register<EventMessage_MoveStart>(EventModuleID_World, &handler, &unittest_event_typed_derived::OnMoveStart);
+	pQueue->Register<EventMessage_UnitThought>(EventModuleID_World, 1, objectID, &handler, &unittest_event_typed_handler::OnThought);
+
+	auto queueMessages = [pQueue](s32 dx)
+	{
+		EventMessage* message = EventMessage_MoveStart::Alloc(dx, 0, 0);
+		pQueue->QueueMessage(&message);
+		message = EventMessage_UnitThought::Alloc(objectID);
+		pQueue->QueueMessage(&message);
+		message = EventMessage_UnitThought::Alloc(objectID + 1);
+		pQueue->QueueMessage(&message);
+		pQueue->ProcessPending();
+	};
+	queueMessages(42);
+	if ((handler.m_moveDX != 42) || (handler.m_thoughtObjectID != objectID) || (handler.m_overrideCount != 1))
+	{
+		TESTOUT(unittest_output_error, "Received dx %d and thought for %d %d times, expected 42 and %d once.", handler.m_moveDX, handler.m_thoughtObjectID, handler.m_overrideCount, objectID);
+	}
+
+	pQueue->Unregister<EventMessage_MoveStart>(EventModuleID_World, 0, 0);
+	pQueue->Unregister<EventMessage_UnitThought>(EventModuleID_World, 1, objectID);
+	queueMessages(43);
+	if ((handler.m_moveDX != 42) || (handler.m_overrideCount != 1))
+	{
+		TESTOUT(unittest_output_error, "Received dx %d and %d thoughts after unregistering.", handler.m_moveDX, handler.m_overrideCount);
+	}
+
+	pQueue->Free();
+
+	TESTEND();
+}
+
+void unittest_event_frame_budget()
+{
+	TESTBEGIN("Event frame budget");
+
+	// thoughts are cosmetic, each takes longer than the budget.  move starts are input.
+	EventQueue* pQueue = EventQueue::Alloc();
+	pQueue->SetFrameBudget(500);
+
+	const u32 thoughtCount = 12;
+	std::vector<u32> thoughts;
+	u32 moveStartCount = 0;
+	pQueue->RegisterForMessage(EventModuleID_World, EventMessageID_UnitThought, [&](EventMessage* message)
+	{
+		thoughts.push_back(message->GetObjectID());
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	});
+	pQueue->RegisterForMessage(EventModuleID_World, EventMessageID_MoveStart, [&](EventMessage*)
+	{
+		++moveStartCount;
+	});
+
+	for (u32 objectID = 1; objectID <= thoughtCount; ++objectID)
+	{
+		EventMessage* message = EventMessage_UnitThought::Alloc(objectID);
+		pQueue->QueueMessage(&message);
+	}
+
+	// input is dispatched by every call, the thoughts roll over until they're overdue.
+	u32 callCount = 0;
+	u32 inputErrorCount = 0;
+	while ((thoughts.size() < thoughtCount) && (callCount <= EVENTQUEUE_ROLLOVER_MAX + 1))
+	{
+		EventMessage* message = EventMessage_MoveStart::Alloc(0, 0, 0);
+		pQueue->QueueMessage(&message);
+		pQueue->ProcessPending();
+		++callCount;
+		inputErrorCount += (moveStartCount != callCount) ? 1 : 0;
+	}
+
+	if (inputErrorCount)
+	{
+		TESTOUT(unittest_output_error, "Input wasn't dispatched by %d of %d calls.", inputErrorCount, callCount);
+	}
+	if ((thoughts.size() != thoughtCount) || (callCount > EVENTQUEUE_ROLLOVER_MAX + 1))
+	{
+		TESTOUT(unittest_output_error, "Dispatched %d of %d thoughts in %d calls, expected all in %d.", static_cast<u32>(thoughts.size()), thoughtCount, callCount, EVENTQUEUE_ROLLOVER_MAX + 1);
+	}
+	if (callCount < 2)
+	{
+		TESTOUT(unittest_output_error, "The thoughts weren't deferred.");
+	}
+	for (u32 i = 0; i < thoughts.size(); ++i)
+	{
+		if (thoughts[i] != i + 1)
+		{
+			TESTOUT(unittest_output_error, "Thought %d dispatched as %d, out of order.", i + 1, thoughts[i]);
+			break;
+		}
+	}
+
+	pQueue->Free();
+
+	TESTEND();
+}
+
+#if defined(TB8_EVENTQUEUE_STATS)
+
+class unittest_event_stats_profiler : public EventQueueProfiler
+{
+public:
+	unittest_event_stats_profiler()
+		: m_handlerDepth(0)
+		, m_isNestingError(false)
+		, m_dumpCount(0)
+	{
+	}
+
+	virtual void BeginHandler(EventModuleID /*moduleID*/, u32 /*subModuleID*/, EventMessageID messageID) override
+	{
+		if (m_beginCounts.size() <= messageID)
+		{
+			m_beginCounts.resize(messageID + 1, 0);
+		}
+		++m_beginCounts[messageID];
+		++m_handlerDepth;
+	}
+	virtual void EndHandler(EventModuleID /*moduleID*/, u32 /*subModuleID*/, EventMessageID /*messageID*/, u64 /*elapsedNS*/) override
+	{
+		m_isNestingError |= (m_handlerDepth == 0);
+		--m_handlerDepth;
+	}
+	virtual void Dump(const char* pszText) override
+	{
+		++m_dumpCount;
+		m_dump = pszText;
+	}
+
+	u32 GetBeginCount(EventMessageID messageID) const { return (messageID < m_beginCounts.size()) ? m_beginCounts[messageID] : 0; }
+
+	std::vector<u32>	m_beginCounts;
+	s32					m_handlerDepth;
+	bool				m_isNestingError;
+	u32					m_dumpCount;
+	std::string			m_dump;
+};
+
+void unittest_event_stats()
+{
+	TESTBEGIN("Event queue stats");
+
+	EventQueue* pQueue = EventQueue::Alloc();
+	pQueue->SetCoalesce(EventMessageID_MouseCursorMove, EventQueueCoalesce_None);
+	pQueue->SetCoalesce(EventMessageID_MouseMoveWheel, EventQueueCoalesce_None);
+	pQueue->SetStatsDumpFrames(0);
+
+	unittest_event_stats_profiler profiler;
+	pQueue->SetProfiler(&profiler);
+
+	// cursor moves go to a handler each, wheel moves to one batch.
+	const u32 moveCount = 10;
+	const u32 wheelCount = 4;
+	pQueue->RegisterForMessage(EventModuleID_World, EventMessageID_MouseCursorMove, [](EventMessage*) {});
+	pQueue->RegisterForMessageBatch(EventModuleID_World, 0, EventMessageID_MouseMoveWheel, [](EventMessage* const*, u32) {});
+	for (u32 i = 0; i < moveCount; ++i)
+	{
+		EventMessage* message = EventMessage_MouseCursorMove::Alloc(static_cast<s32>(i), 0);
+		pQueue->QueueMessage(&message);
+	}
+	for (u32 i = 0; i < wheelCount; ++i)
+	{
+		EventMessage* message = EventMessage_MouseMoveWheel::Alloc(IVector2(0, 0), 120, 120);
+		pQueue->QueueMessage(&message);
+	}
+	pQueue->ProcessPending();
+
+	if (profiler.GetBeginCount(EventMessageID_MouseCursorMove) != moveCount)
+	{
+		TESTOUT(unittest_output_error, "Profiled %d cursor move handlers, expected %d.", profiler.GetBeginCount(EventMessageID_MouseCursorMove), moveCount);
+	}
+	if (profiler.GetBeginCount(EventMessageID_MouseMoveWheel) != 1)
+	{
+		TESTOUT(unittest_output_error, "Profiled %d wheel batches, expected 1.", profiler.GetBeginCount(EventMessageID_MouseMoveWheel));
+	}
+	if (profiler.m_isNestingError || (profiler.m_handlerDepth != 0))
+	{
+		TESTOUT(unittest_output_error, "Handler begin and end calls don't pair up.");
+	}
+
+	// the dump counts every message dispatched, batched or not.
+	pQueue->DumpStats();
+	char line[128];
+	sprintf_s(line, sizeof(line), "  %3u: %8llu,", static_cast<u32>(EventMessageID_MouseCursorMove), static_cast<unsigned long long>(moveCount));
+	const bool isMoveCounted = profiler.m_dump.find(line) != std::string::npos;
+	sprintf_s(line, sizeof(line), "  %3u: %8llu,", static_cast<u32>(EventMessageID_MouseMoveWheel), static_cast<unsigned long long>(wheelCount));
+	const bool isWheelCounted = profiler.m_dump.find(line) != std::string::npos;
+	if ((profiler.m_dumpCount != 1) || !isMoveCounted || !isWheelCounted || (profiler.m_dump.find(" batch:") == std::string::npos))
+	{
+		TESTOUT(unittest_output_error, "Dump %d doesn't hold the counts:\n%s", profiler.m_dumpCount, profiler.m_dump.c_str());
+	}
+
+	// dumps every few frames, each starting over.
+	pQueue->SetStatsDumpFrames(3);
+	pQueue->AdvanceFrames(1);
+	pQueue->AdvanceFrames(1);
+	if (profiler.m_dumpCount != 1)
+	{
+		TESTOUT(unittest_output_error, "Dumped after 2 of 3 frames.");
+	}
+	pQueue->AdvanceFrames(1);
+	sprintf_s(line, sizeof(line), "  %3u: ", static_cast<u32>(EventMessageID_MouseCursorMove));
+	if ((profiler.m_dumpCount != 2) || (profiler.m_dump.find(line) != std::string::npos))
+	{
+		TESTOUT(unittest_output_error, "Dump %d after 3 frames isn't empty:\n%s", profiler.m_dumpCount, profiler.m_dump.c_str());
+	}
+
+	pQueue->Free();
+
+	TESTEND();
+}
+
+#endif
+
+void unittest_event()
+{
+	SUITEBEGIN("Starting event tests ...");
+
+	unittest_event_inbox_producers();
+	unittest_event_coalesce();
+	unittest_event_timers();
+	unittest_event_batch();
+	unittest_event_targets();
+	unittest_event_typed();
+	unittest_event_frame_budget();
+#if defined(TB8_EVENTQUEUE_STATS)
+	unittest_event_stats();
+#endif
+
+	SUITEEND();
+}
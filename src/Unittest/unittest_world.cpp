@@ -0,0 +1,690 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "Event/EventQueue.h"
+#include "Client/Client_Globals.h"
+#include "Common/random.h"
+#include "World/World.h"
+#include "World/RenderNull.h"
+#include "World/WallGrid.h"
+#include "World/Pathfinder.h"
+#include "World/PathHierarchy.h"
+#include "World/FlowField.h"
+#include "World/Unit.h"
+#include "World/Integrator.h"
+
+#include "unittest_world.h"
+#include "unittest.h"
+
+using namespace TB8;
+
+const s32 UNITTEST_WORLD_MAZE_SIZE = 1024;
+const s32 UNITTEST_WORLD_MAZE_ROOM = 12;			// cells across a room, with a door in each wall.
+const u32 UNITTEST_WORLD_INTEGRATOR_UNITS = 37;		// not a multiple of the lane count, so the padding is used.
+const u32 UNITTEST_WORLD_INTEGRATOR_TICKS = 200;
+const s32 UNITTEST_WORLD_QUERY_MAP_SIZE = 64;
+const u32 UNITTEST_WORLD_QUERY_UNITS = 600;
+const u32 UNITTEST_WORLD_QUERY_COUNT = 400;
+
+// rooms in a grid, each with a door in its left and top wall.
+static void unittest_world_build_maze(World_WallGrid& wallGrid, World_Pathfinder& pathfinder, s32 mazeSize)
+{
+	const IVector2 size(mazeSize, mazeSize);
+	wallGrid.Resize(size);
+	pathfinder.Resize(size);
+
+	IVector2 cell;
+	for (cell.y = 0; cell.y < size.y; ++cell.y)
+	{
+		for (cell.x = 0; cell.x < size.x; ++cell.x)
+		{
+			const s32 roomX = cell.x % UNITTEST_WORLD_MAZE_ROOM;
+			const s32 roomY = cell.y % UNITTEST_WORLD_MAZE_ROOM;
+			if ((roomX == 0) && (roomY != 5) && (roomY != 6))
+			{
+				wallGrid.SetWall(cell, World_WallGrid_Edge_Left, true);
+			}
+			if ((roomY == 0) && (roomX != 3))
+			{
+				wallGrid.SetWall(cell, World_WallGrid_Edge_Top, true);
+			}
+		}
+	}
+}
+
+// the cost of <path>, or a negative value if it isn't a connected path from <start> to <goal>.
+static f32 unittest_world_get_path_cost(const World_Pathfinder& pathfinder, const std::vector<IVector2>& path, const IVector2& start, const IVector2& goal)
+{
+	if (path.empty() || (path.front() != start) || (path.back() != goal))
+		return -1.f;
+
+	f32 cost = 0.f;
+	for (size_t i = 1; i < path.size(); ++i)
+	{
+		const IVector2 dir(path[i].x - path[i - 1].x, path[i].y - path[i - 1].y);
+		if ((std::abs(dir.x) > 1) || (std::abs(dir.y) > 1) || !pathfinder.CanStep(path[i - 1], dir))
+			return -1.f;
+		cost += pathfinder.GetStepCost(path[i - 1], dir);
+	}
+	return cost;
+}
+
+static f64 unittest_world_get_elapsed_ms(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void unittest_world_path_hierarchy()
+{
+	TESTBEGIN("Hierarchical pathfinding on a %dx%d maze", UNITTEST_WORLD_MAZE_SIZE, UNITTEST_WORLD_MAZE_SIZE);
+
+	World_WallGrid wallGrid;
+	World_Pathfinder pathfinder(wallGrid);
+	unittest_world_build_maze(wallGrid, pathfinder, UNITTEST_WORLD_MAZE_SIZE);
+
+	std::chrono::steady_clock::time_point timeStart = std::chrono::steady_clock::now();
+	World_PathHierarchy hierarchy(pathfinder);
+	hierarchy.Resize();
+	hierarchy.Update();
+	TESTOUT(unittest_output_debug, "Built %d nodes in %.1f ms.", hierarchy.GetNodeCount(), unittest_world_get_elapsed_ms(timeStart));
+
+	// corner to corner, and across.
+	const s32 far = UNITTEST_WORLD_MAZE_SIZE - 2;
+	const IVector2 queries[][2] =
+	{
+		{ IVector2(1, 1), IVector2(far, far) },
+		{ IVector2(far, 1), IVector2(1, far) },
+		{ IVector2(5, UNITTEST_WORLD_MAZE_SIZE / 2), IVector2(far, 40) },
+	};
+	for (u32 i = 0; i < ARRAYSIZE(queries); ++i)
+	{
+		const IVector2& start = queries[i][0];
+		const IVector2& goal = queries[i][1];
+		std::vector<IVector2> path;
+
+		timeStart = std::chrono::steady_clock::now();
+		const World_Path_Status statusWaypoints = hierarchy.FindPath(start, goal, &path, false);
+		const f64 waypointsMS = unittest_world_get_elapsed_ms(timeStart);
+		if ((statusWaypoints != World_Path_Status_Found) || (path.size() < 2) || (path.front() != start) || (path.back() != goal))
+		{
+			TESTOUT(unittest_output_error, "Query %d, no waypoints.", i);
+		}
+
+		timeStart = std::chrono::steady_clock::now();
+		const World_Path_Status statusRefined = hierarchy.FindPath(start, goal, &path, true);
+		const f64 refinedMS = unittest_world_get_elapsed_ms(timeStart);
+		const f32 costRefined = unittest_world_get_path_cost(pathfinder, path, start, goal);
+		if ((statusRefined != World_Path_Status_Found) || (costRefined < 0.f))
+		{
+			TESTOUT(unittest_output_error, "Query %d, the refined path isn't connected.", i);
+			continue;
+		}
+
+		timeStart = std::chrono::steady_clock::now();
+		const World_Path_Status statusFlat = pathfinder.FindPath(start, goal, &path, World_Path_Mode_AStar);
+		const f64 flatMS = unittest_world_get_elapsed_ms(timeStart);
+		const f32 costFlat = unittest_world_get_path_cost(pathfinder, path, start, goal);
+		if ((statusFlat != World_Path_Status_Found) || (costFlat < 0.f))
+		{
+			TESTOUT(unittest_output_error, "Query %d, no flat path.", i);
+			continue;
+		}
+
+		// the abstract search is weighted, so the path can be a little longer, never shorter.
+		if ((costRefined < costFlat - 0.01f) || (costRefined > costFlat * 1.25f))
+		{
+			TESTOUT(unittest_output_error, "Query %d, cost %.1f against %.1f flat.", i, costRefined, costFlat);
+		}
+
+		TESTOUT(unittest_output_debug, "Query %d, waypoints %.2f ms, refined %.2f ms, flat a* %.1f ms, cost %.1f against %.1f.",
+			i, waypointsMS, refinedMS, flatMS, costRefined, costFlat);
+	}
+
+	TESTEND();
+}
+
+void unittest_world_path_jps()
+{
+	TESTBEGIN("Jump point search on a %dx%d maze", UNITTEST_WORLD_MAZE_SIZE, UNITTEST_WORLD_MAZE_SIZE);
+
+	World_WallGrid wallGrid;
+	World_Pathfinder pathfinder(wallGrid);
+	unittest_world_build_maze(wallGrid, pathfinder, UNITTEST_WORLD_MAZE_SIZE);
+
+	// paths are cached whatever the mode, so a* and the requests each get a pathfinder of their own.
+	World_WallGrid wallGridAStar;
+	World_Pathfinder pathfinderAStar(wallGridAStar);
+	unittest_world_build_maze(wallGridAStar, pathfinderAStar, UNITTEST_WORLD_MAZE_SIZE);
+	World_WallGrid wallGridSliced;
+	World_Pathfinder pathfinderSliced(wallGridSliced);
+	unittest_world_build_maze(wallGridSliced, pathfinderSliced, UNITTEST_WORLD_MAZE_SIZE);
+
+	const s32 far = UNITTEST_WORLD_MAZE_SIZE - 2;
+	const IVector2 queries[][2] =
+	{
+		{ IVector2(1, 1), IVector2(far, far) },
+		{ IVector2(far, 1), IVector2(1, far) },
+		{ IVector2(5, UNITTEST_WORLD_MAZE_SIZE / 2), IVector2(far, 40) },
+	};
+	const u32 nodeBudget = 64;
+	for (u32 i = 0; i < ARRAYSIZE(queries); ++i)
+	{
+		const IVector2& start = queries[i][0];
+		const IVector2& goal = queries[i][1];
+
+		std::vector<IVector2> pathAStar;
+		pathfinderAStar.FindPath(start, goal, &pathAStar, World_Path_Mode_AStar);
+		const f32 costAStar = unittest_world_get_path_cost(pathfinderAStar, pathAStar, start, goal);
+
+		std::chrono::steady_clock::time_point timeStart = std::chrono::steady_clock::now();
+		std::vector<IVector2> pathJPS;
+		pathfinder.FindPath(start, goal, &pathJPS, World_Path_Mode_JPS);
+		const f64 jpsMS = unittest_world_get_elapsed_ms(timeStart);
+		const f32 costJPS = unittest_world_get_path_cost(pathfinder, pathJPS, start, goal);
+		if ((costAStar < 0.f) || (costJPS < 0.f) || (std::abs(costJPS - costAStar) > 0.01f))
+		{
+			TESTOUT(unittest_output_error, "Query %d, jps cost %.1f against %.1f a*.", i, costJPS, costAStar);
+			continue;
+		}
+
+		// the same search, a few nodes and jump cells an update.
+		const u32 requestID = pathfinderSliced.RequestPath(start, goal, World_Path_Mode_JPS);
+		u32 updateCount = 0;
+		u32 overBudgetCount = 0;
+		while ((pathfinderSliced.GetRequestStatus(requestID) == World_Path_Status_Pending) && (updateCount < 1000000))
+		{
+			const u32 nodeCount = pathfinderSliced.GetMetrics().m_nodeCount;
+			pathfinderSliced.Update(nodeBudget);
+			overBudgetCount += ((pathfinderSliced.GetMetrics().m_nodeCount - nodeCount) > nodeBudget) ? 1 : 0;
+			++updateCount;
+		}
+		std::vector<IVector2> pathSliced;
+		if (!pathfinderSliced.GetRequestPath(requestID, &pathSliced) || (pathSliced != pathJPS))
+		{
+			TESTOUT(unittest_output_error, "Query %d, the time-sliced request didn't find the same path.", i);
+		}
+		if (overBudgetCount)
+		{
+			TESTOUT(unittest_output_error, "Query %d, %d of %d updates went over their budget of %d.", i, overBudgetCount, updateCount, nodeBudget);
+		}
+		pathfinderSliced.ReleaseRequest(requestID);
+
+		TESTOUT(unittest_output_debug, "Query %d, jps %.2f ms, cost %.1f, time-sliced in %d updates.", i, jpsMS, costJPS, updateCount);
+	}
+
+	TESTEND();
+}
+
+void unittest_world_flow_field()
+{
+	TESTBEGIN("Flow fields on a %dx%d maze", UNITTEST_WORLD_MAZE_SIZE, UNITTEST_WORLD_MAZE_SIZE);
+
+	World_WallGrid wallGrid;
+	World_Pathfinder pathfinder(wallGrid);
+	unittest_world_build_maze(wallGrid, pathfinder, UNITTEST_WORLD_MAZE_SIZE);
+
+	World_FlowFieldCache flowFields(pathfinder);
+	flowFields.Resize();
+
+	const IVector2 goal(UNITTEST_WORLD_MAZE_SIZE / 2, UNITTEST_WORLD_MAZE_SIZE / 2);
+	std::chrono::steady_clock::time_point timeStart = std::chrono::steady_clock::now();
+	const World_FlowField* pField = flowFields.GetField(goal);
+	TESTOUT(unittest_output_debug, "Built a field in %.1f ms.", unittest_world_get_elapsed_ms(timeStart));
+
+	// following the directions from a corner walks the shortest path to the goal.
+	const s32 far = UNITTEST_WORLD_MAZE_SIZE - 2;
+	const IVector2 starts[] = { IVector2(1, 1), IVector2(far, 1), IVector2(1, far), IVector2(far, far) };
+	for (u32 i = 0; i < ARRAYSIZE(starts); ++i)
+	{
+		std::vector<IVector2> path;
+		const f32 costFlat = (pathfinder.FindPath(starts[i], goal, &path, World_Path_Mode_AStar) == World_Path_Status_Found)
+			? unittest_world_get_path_cost(pathfinder, path, starts[i], goal) : -1.f;
+		if (!pField->IsReachable(starts[i]) || (std::fabs(pField->GetCost(starts[i]) - costFlat) > 0.5f))
+		{
+			TESTOUT(unittest_output_error, "Start %d, field cost %.1f against %.1f flat.", i, pField->GetCost(starts[i]), costFlat);
+			continue;
+		}
+
+		IVector2 cell = starts[i];
+		Vector2 dir;
+		u32 stepCount = 0;
+		while (pField->GetDirection(cell, &dir) && (stepCount < static_cast<u32>(UNITTEST_WORLD_MAZE_SIZE * UNITTEST_WORLD_MAZE_SIZE)))
+		{
+			const IVector2 step((dir.x > 0.1f) ? 1 : ((dir.x < -0.1f) ? -1 : 0), (dir.y > 0.1f) ? 1 : ((dir.y < -0.1f) ? -1 : 0));
+			const IVector2 next = cell + step;
+			if (!pathfinder.CanStep(cell, step)
+				|| (std::fabs(pField->GetCost(cell) - (pField->GetCost(next) + pathfinder.GetStepCost(cell, step))) > 0.01f))
+			{
+				TESTOUT(unittest_output_error, "Start %d, bad step from %d,%d.", i, cell.x, cell.y);
+				break;
+			}
+			cell = next;
+			++stepCount;
+		}
+		if (cell != goal)
+		{
+			TESTOUT(unittest_output_error, "Start %d, stopped at %d,%d.", i, cell.x, cell.y);
+		}
+	}
+
+	TESTEND();
+}
+
+void unittest_world_flow_field_cache()
+{
+	TESTBEGIN("Flow field cache with more goals than fields");
+
+	World_WallGrid wallGrid;
+	World_Pathfinder pathfinder(wallGrid);
+	unittest_world_build_maze(wallGrid, pathfinder, UNITTEST_WORLD_MAZE_ROOM * 8);
+
+	World_FlowFieldCache flowFields(pathfinder);
+	flowFields.Resize();
+
+	// looking up more goals than fit evicts each before it's used again.
+	const u32 goalCount = FLOWFIELD_CACHE_SIZE_DEFAULT + 4;
+	for (u32 isReserved = 0; isReserved < 2; ++isReserved)
+	{
+		if (isReserved)
+		{
+			flowFields.Reserve(goalCount);
+			if (flowFields.GetCapacity() != goalCount)
+			{
+				TESTOUT(unittest_output_error, "Capacity %d after reserving %d.", flowFields.GetCapacity(), goalCount);
+			}
+		}
+
+		const u32 buildCount = flowFields.GetMetrics().m_buildCount;
+		for (u32 pass = 0; pass < 2; ++pass)
+		{
+			for (u32 i = 0; i < goalCount; ++i)
+			{
+				flowFields.GetField(IVector2(static_cast<s32>(i * 7) + 1, static_cast<s32>(i * 3) + 1));
+			}
+		}
+
+		// with room for them all, only the goals evicted by the first loop are built again.
+		const u32 buildCountExpected = isReserved ? (goalCount - FLOWFIELD_CACHE_SIZE_DEFAULT) : (goalCount * 2);
+		if (flowFields.GetMetrics().m_buildCount - buildCount != buildCountExpected)
+		{
+			TESTOUT(unittest_output_error, "Built %d fields for %d goals, expected %d.", flowFields.GetMetrics().m_buildCount - buildCount, goalCount, buildCountExpected);
+		}
+	}
+
+	TESTEND();
+}
+
+void unittest_world_integrator()
+{
+	TESTBEGIN("Integrator, scalar against avx, %d units", UNITTEST_WORLD_INTEGRATOR_UNITS);
+
+	EventQueue* pQueue = EventQueue::Alloc();
+	Client_Globals* pGlobals = Client_Globals::Alloc(pQueue);
+
+	// the same units three times, stepped by the scalar path, the avx path, and World_Unit::ComputeNextPosition().
+	const u32 unitCount = UNITTEST_WORLD_INTEGRATOR_UNITS;
+	std::vector<World_Unit*> units[3];
+	std::vector<s32> frameCounts(unitCount);
+	for (u32 copy = 0; copy < 3; ++copy)
+	{
+		for (u32 i = 0; i < unitCount; ++i)
+		{
+			World_Unit* pUnit = World_Unit::Alloc(pGlobals);
+			const f32 f = static_cast<f32>(i);
+			pUnit->m_pos = Vector3(f * 1.5f, 100.f - f, (i % 3) ? 0.f : (f * 0.1f));
+			pUnit->m_velocity = Vector3((i % 4) ? (f * 0.25f - 4.f) : 0.f, (i % 5) ? (3.f - f * 0.125f) : 0.f, 0.f);
+			pUnit->m_mass = 1.f + (f * 0.5f);
+			pUnit->m_maxVelocity = 2.f + (f * 0.25f);
+			units[copy].push_back(pUnit);
+			frameCounts[i] = 1 + static_cast<s32>(i % 4);
+		}
+	}
+
+	World_Integrator integratorScalar;
+	integratorScalar.SetAVX(false);
+	World_Integrator integratorAVX;
+	if (!integratorAVX.IsAVX())
+	{
+		TESTOUT(unittest_output_debug, "The avx path isn't built or the cpu doesn't have it, only the scalar path is checked.");
+	}
+
+	std::vector<World_UnitMove> moves[3];
+	for (u32 copy = 0; copy < 3; ++copy)
+	{
+		moves[copy].resize(unitCount);
+	}
+	u32 mismatchCount = 0;
+	for (u32 tick = 0; tick < UNITTEST_WORLD_INTEGRATOR_TICKS; ++tick)
+	{
+		// forces that start and stop, some too small to count, and the odd jump.
+		for (u32 i = 0; i < unitCount; ++i)
+		{
+			const u32 phase = (tick + i) % 40;
+			const f32 forceX = (phase < 15) ? (static_cast<f32>(i % 7) * 0.15f - 0.45f) : ((phase < 20) ? 1e-7f : 0.f);
+			const f32 forceY = (phase < 25) ? (static_cast<f32>(i % 5) * 0.25f - 0.5f) : 0.f;
+			const f32 forceZ = ((tick % 50) == (i % 50)) ? 1.f : 0.f;
+			for (u32 copy = 0; copy < 3; ++copy)
+			{
+				units[copy][i]->SetForce(Vector3(forceX, forceY, forceZ));
+			}
+		}
+
+		integratorScalar.Integrate(frameCounts.data(), units[0].data(), unitCount, moves[0].data());
+		integratorAVX.Integrate(frameCounts.data(), units[1].data(), unitCount, moves[1].data());
+		for (u32 i = 0; i < unitCount; ++i)
+		{
+			units[2][i]->ComputeNextPosition(frameCounts[i], moves[2][i].m_pos, moves[2][i].m_vel);
+		}
+
+		for (u32 i = 0; i < unitCount; ++i)
+		{
+			for (u32 copy = 1; copy < 3; ++copy)
+			{
+				const World_Unit* pUnit = units[copy][i];
+				if ((memcmp(&moves[copy][i], &moves[0][i], sizeof(World_UnitMove)) != 0)
+					|| (memcmp(&pUnit->m_velocity, &units[0][i]->m_velocity, sizeof(Vector3)) != 0)
+					|| (memcmp(&pUnit->GetForce(), &units[0][i]->GetForce(), sizeof(Vector3)) != 0))
+				{
+					if (!mismatchCount)
+					{
+						TESTOUT(unittest_output_error, "Tick %d, unit %d, %s doesn't match the scalar path, pos %f,%f,%f against %f,%f,%f.",
+							tick, i, (copy == 1) ? "avx" : "ComputeNextPosition",
+							moves[copy][i].m_pos.x, moves[copy][i].m_pos.y, moves[copy][i].m_pos.z,
+							moves[0][i].m_pos.x, moves[0][i].m_pos.y, moves[0][i].m_pos.z);
+					}
+					++mismatchCount;
+				}
+			}
+		}
+
+		// each copy carries on from its own moves.
+		for (u32 copy = 0; copy < 3; ++copy)
+		{
+			for (u32 i = 0; i < unitCount; ++i)
+			{
+				units[copy][i]->m_pos = moves[copy][i].m_pos;
+				units[copy][i]->m_velocity = moves[copy][i].m_vel;
+			}
+		}
+	}
+	if (mismatchCount)
+	{
+		TESTOUT(unittest_output_error, "%d mismatches in all.", mismatchCount);
+	}
+
+	for (u32 copy = 0; copy < 3; ++copy)
+	{
+		for (u32 i = 0; i < unitCount; ++i)
+		{
+			units[copy][i]->Free();
+		}
+	}
+	pGlobals->Free();
+	pQueue->Free();
+
+	TESTEND();
+}
+
+// first root of |from + delta t - pos| = radius, as World_UnitGrid::Raycast() finds it.
+static bool unittest_world_ray_unit(const Vector2& from, const Vector2& delta, const Vector2& pos, f32 radius, f32* pT)
+{
+	const Vector2 offset = from - pos;
+	const f32 deltaMagSq = delta.MagSq();
+	const f32 c = offset.MagSq() - (radius * radius);
+	*pT = 0.f;
+	if (c <= 0.f)
+		return true;
+	if (deltaMagSq <= 0.f)
+		return false;
+	const f32 b = Vector2::Dot(offset, delta);
+	const f32 discriminant = (b * b) - (deltaMagSq * c);
+	if ((b >= 0.f) || (discriminant < 0.f))
+		return false;
+	*pT = (-b - std::sqrt(discriminant)) / deltaMagSq;
+	return *pT <= 1.f;
+}
+
+// a world with units and walls but no map file, and the world's queries done again by scanning every unit.
+class unittest_world_QueryWorld : public World
+{
+public:
+	unittest_world_QueryWorld(Client_Globals* pGlobalState, World_RenderModel* pModel)
+		: World(pGlobalState)
+	{
+		__Initialize();
+
+		m_mapSize = IVector2(UNITTEST_WORLD_QUERY_MAP_SIZE, UNITTEST_WORLD_QUERY_MAP_SIZE);
+		m_wallGrid.Resize(m_mapSize);
+		m_pathfinder.Resize(m_mapSize);
+		m_pathHierarchy.Resize();
+		m_flowFields.Resize();
+		m_mapModels.insert(std::make_pair(1, pModel));
+
+		Random random(1, 0);
+		for (u32 i = 0; i < UNITTEST_WORLD_QUERY_MAP_SIZE * 4; ++i)
+		{
+			const IVector2 cell(random.Next(1, UNITTEST_WORLD_QUERY_MAP_SIZE - 1), random.Next(1, UNITTEST_WORLD_QUERY_MAP_SIZE - 1));
+			SetWall(cell, random.NextBool() ? World_WallGrid_Edge_Left : World_WallGrid_Edge_Top, true);
+		}
+
+		// some scaled up, so the grid looks past a cell for them.
+		for (u32 i = 0; i < UNITTEST_WORLD_QUERY_UNITS; ++i)
+		{
+			World_Unit* pUnit = World_Unit::Alloc(__GetGlobals());
+			pUnit->m_type = World_Object_Type_Unit;
+			pUnit->m_pModel = pModel;
+			pUnit->m_pos = Vector3(random.NextF32() * UNITTEST_WORLD_QUERY_MAP_SIZE, random.NextF32() * UNITTEST_WORLD_QUERY_MAP_SIZE, 0.f);
+			pUnit->m_scale = ((i % 50) == 0) ? 3.f : 0.5f;
+			pUnit->m_mass = 2.f;
+			pUnit->m_maxVelocity = 2.5f;
+			pUnit->m_bounds.m_type = World_Object_Bounds_Type_Sphere;
+			pUnit->Init();
+			pUnit->SeedRandom(m_seed, m_units.size());
+			pUnit->SetForce(Vector3((random.NextF32() * 2.f) - 1.f, (random.NextF32() * 2.f) - 1.f, 0.f));
+			m_units.push_back(pUnit);
+		}
+	}
+
+	u32 ScanRadius(const Vector2& center, f32 radius, std::vector<World_Unit*>& units) const
+	{
+		units.clear();
+		for (std::vector<World_Unit*>::const_iterator it = m_units.begin(); it != m_units.end(); ++it)
+		{
+			const f32 dist = radius + __GetUnitRadius(**it);
+			if ((Vector2((*it)->m_pos.x, (*it)->m_pos.y) - center).MagSq() <= (dist * dist))
+			{
+				units.push_back(*it);
+			}
+		}
+		return static_cast<u32>(units.size());
+	}
+
+	u32 ScanAABB(const Vector2& min, const Vector2& max, std::vector<World_Unit*>& units) const
+	{
+		units.clear();
+		for (std::vector<World_Unit*>::const_iterator it = m_units.begin(); it != m_units.end(); ++it)
+		{
+			const Vector2 pos((*it)->m_pos.x, (*it)->m_pos.y);
+			const Vector2 nearest(std::min(std::max(pos.x, min.x), max.x), std::min(std::max(pos.y, min.y), max.y));
+			const f32 radius = __GetUnitRadius(**it);
+			if ((nearest - pos).MagSq() <= (radius * radius))
+			{
+				units.push_back(*it);
+			}
+		}
+		return static_cast<u32>(units.size());
+	}
+
+	// true if <pHit> is a first hit of the ray.  units hit at the same point are all first.
+	bool IsRaycastHit(const Vector2& from, const Vector2& to, bool isHit, const World_RaycastHit& hit) const
+	{
+		Vector2 end = to;
+		f32 fraction = 1.f;
+		const bool isWall = m_wallGrid.Raycast(from, to, &end);
+		if (isWall)
+		{
+			const Vector2 delta = to - from;
+			const f32 deltaMagSq = delta.MagSq();
+			fraction = (deltaMagSq > 0.f) ? (Vector2::Dot(end - from, delta) / deltaMagSq) : 0.f;
+		}
+
+		f32 tHit = FLT_MAX;
+		for (std::vector<World_Unit*>::const_iterator it = m_units.begin(); it != m_units.end(); ++it)
+		{
+			f32 t = 0.f;
+			if (unittest_world_ray_unit(from, end - from, Vector2((*it)->m_pos.x, (*it)->m_pos.y), __GetUnitRadius(**it), &t))
+			{
+				tHit = std::min(tHit, t);
+			}
+		}
+
+		if (tHit != FLT_MAX)
+		{
+			f32 t = 0.f;
+			return isHit && hit.m_pUnit
+				&& unittest_world_ray_unit(from, end - from, Vector2(hit.m_pUnit->m_pos.x, hit.m_pUnit->m_pos.y), __GetUnitRadius(*hit.m_pUnit), &t) && (t == tHit)
+				&& (hit.m_fraction == tHit * fraction) && (hit.m_pos == from + ((end - from) * tHit));
+		}
+		if (isWall)
+			return isHit && !hit.m_pUnit && (hit.m_fraction == fraction) && (hit.m_pos == end);
+		return !isHit;
+	}
+};
+
+static bool unittest_world_is_same_units(World_Unit* const* ppUnits, u32 count, std::vector<World_Unit*> expected)
+{
+	if (count != expected.size())
+		return false;
+	std::vector<World_Unit*> units(ppUnits, ppUnits + count);
+	std::sort(units.begin(), units.end());
+	std::sort(expected.begin(), expected.end());
+	return units == expected;
+}
+
+void unittest_world_queries()
+{
+	TESTBEGIN("Spatial queries against a scan of %d units", UNITTEST_WORLD_QUERY_UNITS);
+
+	EventQueue* pQueue = EventQueue::Alloc();
+	Client_Globals* pGlobals = Client_Globals::Alloc(pQueue);
+	World_RenderNull* pRender = World_RenderNull::Alloc();
+	pGlobals->Initialize(nullptr, pRender);
+	unittest_world_QueryWorld* pWorld = TB8_NEW(unittest_world_QueryWorld)(pGlobals, pRender->AllocModelFromTexture(""));
+
+	// queries over the map and past its edges, against the units where some updates have moved them.
+	const u32 queryCount = UNITTEST_WORLD_QUERY_COUNT;
+	const f32 queryRange = static_cast<f32>(UNITTEST_WORLD_QUERY_MAP_SIZE) + 8.f;
+	Random random(2, 0);
+	std::vector<Vector2> centers(queryCount);
+	std::vector<f32> radii(queryCount);
+	std::vector<Vector2> mins(queryCount);
+	std::vector<Vector2> maxs(queryCount);
+	std::vector<Vector2> froms(queryCount);
+	std::vector<Vector2> tos(queryCount);
+	for (u32 i = 0; i < queryCount; ++i)
+	{
+		centers[i] = Vector2((random.NextF32() * queryRange) - 4.f, (random.NextF32() * queryRange) - 4.f);
+		radii[i] = random.NextF32() * ((i % 10) ? 3.f : 12.f);
+		mins[i] = Vector2((random.NextF32() * queryRange) - 4.f, (random.NextF32() * queryRange) - 4.f);
+		maxs[i] = mins[i] + Vector2(random.NextF32() * 10.f, random.NextF32() * 10.f);
+		froms[i] = Vector2(random.NextF32() * UNITTEST_WORLD_QUERY_MAP_SIZE, random.NextF32() * UNITTEST_WORLD_QUERY_MAP_SIZE);
+		tos[i] = ((i % 20) == 0) ? froms[i] : Vector2(random.NextF32() * UNITTEST_WORLD_QUERY_MAP_SIZE, random.NextF32() * UNITTEST_WORLD_QUERY_MAP_SIZE);
+	}
+
+	const u32 capacity = UNITTEST_WORLD_QUERY_UNITS;
+	std::vector<World_Unit*> units(capacity);
+	std::vector<World_Unit*> expected;
+	std::vector<World_Unit*> batchUnits(queryCount * capacity);
+	std::vector<u32> batchCounts(queryCount);
+	std::vector<World_RaycastHit> batchHits(queryCount);
+	std::vector<u8> batchIsHit(queryCount);
+	u32 errorCount = 0;
+	for (u32 pass = 0; pass < 3; ++pass)
+	{
+		for (u32 update = 0; update < 60; ++update)
+		{
+			pWorld->Update(1);
+		}
+
+		pWorld->QueryRadiusBatch(centers.data(), radii.data(), queryCount, batchUnits.data(), capacity, batchCounts.data());
+		for (u32 i = 0; i < queryCount; ++i)
+		{
+			pWorld->ScanRadius(centers[i], radii[i], expected);
+			const u32 count = pWorld->QueryRadius(centers[i], radii[i], units.data(), capacity);
+			if (!unittest_world_is_same_units(units.data(), count, expected)
+				|| !unittest_world_is_same_units(batchUnits.data() + (i * capacity), batchCounts[i], expected))
+			{
+				TESTOUT(unittest_output_error, "Pass %d, radius query %d found %d, %d batched, against %d.", pass, i, count, batchCounts[i], static_cast<u32>(expected.size()));
+				++errorCount;
+			}
+
+			// too small a buffer still counts them all, and fills it with some of them.
+			World_Unit* few[2];
+			const u32 fewCount = pWorld->QueryRadius(centers[i], radii[i], few, ARRAYSIZE(few));
+			if ((fewCount != expected.size())
+				|| !std::all_of(few, few + std::min<u32>(fewCount, ARRAYSIZE(few)), [&expected](World_Unit* pUnit) { return std::find(expected.begin(), expected.end(), pUnit) != expected.end(); }))
+			{
+				TESTOUT(unittest_output_error, "Pass %d, radius query %d with room for %d.", pass, i, static_cast<u32>(ARRAYSIZE(few)));
+				++errorCount;
+			}
+		}
+
+		pWorld->QueryAABBBatch(mins.data(), maxs.data(), queryCount, batchUnits.data(), capacity, batchCounts.data());
+		for (u32 i = 0; i < queryCount; ++i)
+		{
+			pWorld->ScanAABB(mins[i], maxs[i], expected);
+			const u32 count = pWorld->QueryAABB(mins[i], maxs[i], units.data(), capacity);
+			if (!unittest_world_is_same_units(units.data(), count, expected)
+				|| !unittest_world_is_same_units(batchUnits.data() + (i * capacity), batchCounts[i], expected))
+			{
+				TESTOUT(unittest_output_error, "Pass %d, box query %d found %d, %d batched, against %d.", pass, i, count, batchCounts[i], static_cast<u32>(expected.size()));
+				++errorCount;
+			}
+		}
+
+		pWorld->RaycastBatch(froms.data(), tos.data(), queryCount, batchHits.data(), batchIsHit.data());
+		u32 unitHitCount = 0;
+		for (u32 i = 0; i < queryCount; ++i)
+		{
+			World_RaycastHit hit;
+			const bool isHit = pWorld->Raycast(froms[i], tos[i], nullptr, &hit);
+			if (!pWorld->IsRaycastHit(froms[i], tos[i], isHit, hit)
+				|| !pWorld->IsRaycastHit(froms[i], tos[i], batchIsHit[i] != 0, batchHits[i]))
+			{
+				TESTOUT(unittest_output_error, "Pass %d, ray %d from %.2f,%.2f to %.2f,%.2f.", pass, i, froms[i].x, froms[i].y, tos[i].x, tos[i].y);
+				++errorCount;
+			}
+			unitHitCount += (isHit && hit.m_pUnit) ? 1 : 0;
+		}
+		TESTOUT(unittest_output_debug, "Pass %d, %d of %d rays hit a unit, %d moves to another cell.", pass, unitHitCount, queryCount, pWorld->GetUnitGridMetrics().m_cellChangeCount);
+
+		if (errorCount > 10)
+			break;
+	}
+
+	TB8_DEL(pWorld);
+	pGlobals->Free();
+	pRender->Free();
+	pQueue->Free();
+
+	TESTEND();
+}
+
+void unittest_world()
+{
+	SUITEBEGIN("Starting world tests ...");
+
+	unittest_world_path_hierarchy();
+	unittest_world_path_jps();
+	unittest_world_flow_field();
+	unittest_world_flow_field_cache();
+	unittest_world_integrator();
+	unittest_world_queries();
+
+	SUITEEND();
+}
@@ -1,9 +1,9 @@
 #include "pch.h"
 
-#include "render/RenderMain.h"
-#include "render/RenderModel.h"
-#include "render/RenderTexture.h"
-#include "render/RenderStatusBars.h"
+#include "Common/file_io.h"
+
+#include "Event/EventQueue.h"
+#include "Event/EventQueueMessages.h"
 
 #include "Avatar.h"
 
@@ -11,6 +11,7 @@ namespace TB8
 {
 
 const f32 MAX_VELOCITY = 5.f;
+const u32 REST_FRAMES = 120;
 
 World_Avatar* World_Avatar::Alloc(Client_Globals* pGlobalState, const char* pszCharacterModelPath)
 {
@@ -27,8 +28,7 @@ void World_Avatar::Free()
 World_Avatar::World_Avatar(Client_Globals* pGlobalState)
 	: World_Unit(pGlobalState)
 	, m_pStatusBars(nullptr)
-	, m_restingFrameCount(0)
-	, m_digestingFrameCount(0)
+	, m_restTimerID(EVENTQUEUE_TIMER_NONE)
 	, m_distanceTravelledLast(0.f)
 {
 }
@@ -48,71 +48,85 @@ void World_Avatar::__Initialize(const char* pszCharacterModelPath)
 	File::AppendToPath(textureFile, "status_bar.png");
 	std::string texturePath = __GetPathAssets();
 	File::AppendToPath(texturePath, textureFile.c_str());
-	RenderTexture* pTexture = RenderTexture::Alloc(__GetRenderer(), texturePath.c_str());
-
-	m_pStatusBars = RenderStatusBars::Alloc(__GetRenderer());
-	m_barID_Chill = m_pStatusBars->AddBar("Chillaxness", pTexture, Vector2(0.f, 0.f), Vector2(1.f, 0.25f), 5, 20, 2);
-	m_barID_Spunk = m_pStatusBars->AddBar("Spunkiness", pTexture, Vector2(0.f, 0.25f), Vector2(1.f, 0.50f), 20, 40, 4);
-	m_barID_Full = m_pStatusBars->AddBar("Fullness", pTexture, Vector2(0.f, 0.50f), Vector2(1.f, 0.75f), 26, 30, 3);
-	m_barID_Gas = m_pStatusBars->AddBar("Gassiness", pTexture, Vector2(0.f, 0.75f), Vector2(1.f, 1.f), 2, 10, 1);
-
-	RELEASEI(pTexture);
+	m_pStatusBars = __GetWorldRender()->AllocStatusBars(texturePath.c_str());
+	__AddStat(m_chill, "Chillaxness", Vector2(0.f, 0.f), Vector2(1.f, 0.25f), 5, 20, 2);
+	__AddStat(m_spunk, "Spunkiness", Vector2(0.f, 0.25f), Vector2(1.f, 0.50f), 20, 40, 4);
+	__AddStat(m_full, "Fullness", Vector2(0.f, 0.50f), Vector2(1.f, 0.75f), 26, 30, 3);
+	__AddStat(m_gas, "Gassiness", Vector2(0.f, 0.75f), Vector2(1.f, 1.f), 2, 10, 1);
 
 	m_maxVelocity = MAX_VELOCITY;
+
+	__GetEventQueue()->Register<EventMessage_AvatarRest>(EventModuleID_World, m_eventID, m_eventID, this, &World_Avatar::__OnRest);
+	__ScheduleRest();
 }
 
 void World_Avatar::__Uninitialize()
 {
+	__GetEventQueue()->CancelMessage(m_restTimerID);
+	__GetEventQueue()->Unregister<EventMessage_AvatarRest>(EventModuleID_World, m_eventID, m_eventID);
 	RELEASEI(m_pStatusBars);
 }
 
-void World_Avatar::Update(s32 frameCount)
+void World_Avatar::UpdateStats()
 {
-	World_Unit::Update(frameCount);
-
-	if (IsSitting())
-	{
-		// if resting a while, increase spunk.
-		m_restingFrameCount += frameCount;
-		if (m_restingFrameCount > 120)
-		{
-			m_pStatusBars->SetBarValueDelta(m_barID_Spunk, +1);
-			m_restingFrameCount = 0;
-			__UpdateVelocity();
-		}
-
-		// if resting a while, digest some food.
-		m_digestingFrameCount += frameCount;
-		if (m_digestingFrameCount > 120)
-		{
-			m_pStatusBars->SetBarValueDelta(m_barID_Full, -1);
-			m_pStatusBars->SetBarValueDelta(m_barID_Gas, +1);
-			m_digestingFrameCount = 0;
-		}
-	}
-	else
+	if (!IsSitting())
 	{
 		// if moving, reduce spunk.
 		while ((m_distanceTravelled - m_distanceTravelledLast) > 0.25f)
 		{
-			m_pStatusBars->SetBarValueDelta(m_barID_Spunk, -1);
+			__SetStatDelta(m_spunk, -1);
 			m_distanceTravelledLast += 0.25f;
 			__UpdateVelocity();
 		}
 	}
 }
 
+void World_Avatar::__OnSitDown()
+{
+	World_Unit::__OnSitDown();
+	__ScheduleRest();
+}
+
+void World_Avatar::__OnStandUp()
+{
+	World_Unit::__OnStandUp();
+	__GetEventQueue()->CancelMessage(m_restTimerID);
+	m_restTimerID = EVENTQUEUE_TIMER_NONE;
+}
+
+void World_Avatar::__ScheduleRest()
+{
+	__GetEventQueue()->CancelMessage(m_restTimerID);
+
+	EventMessage* pEvent = EventMessage_AvatarRest::Alloc(m_eventID);
+	m_restTimerID = __GetEventQueue()->QueueMessageAfter(&pEvent, REST_FRAMES);
+}
+
+void World_Avatar::__OnRest(EventMessage_AvatarRest* /*pEvent*/)
+{
+	m_restTimerID = EVENTQUEUE_TIMER_NONE;
+	if (!IsSitting())
+		return;
+
+	// rested a while, increase spunk and digest some food.
+	__SetStatDelta(m_spunk, +1);
+	__UpdateVelocity();
+	__SetStatDelta(m_full, -1);
+	__SetStatDelta(m_gas, +1);
+	__ScheduleRest();
+}
+
 void World_Avatar::__UpdateVelocity()
 {
-	if (m_pStatusBars->GetBarValue(m_barID_Spunk) >= 8)
+	if (m_spunk.m_value >= 8)
 	{
 		m_maxVelocity = MAX_VELOCITY;
 	}
-	else if (m_pStatusBars->GetBarValue(m_barID_Spunk) > 4)
+	else if (m_spunk.m_value > 4)
 	{
 		m_maxVelocity = MAX_VELOCITY * 0.2f;
 	}
-	else if (m_pStatusBars->GetBarValue(m_barID_Spunk) > 0)
+	else if (m_spunk.m_value > 0)
 	{
 		m_maxVelocity = MAX_VELOCITY * 0.1f;
 	}
@@ -122,6 +136,19 @@ void World_Avatar::__UpdateVelocity()
 	}
 }
 
+void World_Avatar::__AddStat(World_Avatar_Stat& stat, const char* pszName, const Vector2& uv0, const Vector2& uv1, s32 value, s32 maxValue, s32 incrementSize)
+{
+	stat.m_barID = m_pStatusBars->AddBar(pszName, uv0, uv1, value, maxValue, incrementSize);
+	stat.m_value = value;
+	stat.m_maxValue = maxValue;
+}
+
+void World_Avatar::__SetStatDelta(World_Avatar_Stat& stat, s32 delta)
+{
+	stat.m_value = std::min<s32>(std::max<s32>(stat.m_value + delta, 0), stat.m_maxValue);
+	m_pStatusBars->SetBarValue(stat.m_barID, stat.m_value);
+}
+
 void World_Avatar::Render2D(const Vector3& screenWorldPos)
 {
 	World_Unit::Render2D(screenWorldPos);
@@ -1,13 +1,21 @@
 #pragma once
 
-#include "common/basic_types.h"
+#include "Common/basic_types.h"
 
 #include "Unit.h"
 
 namespace TB8
 {
 
-class RenderStatusBars;
+class EventMessage_AvatarRest;
+
+// a status shown on the avatar's bars.
+struct World_Avatar_Stat
+{
+	u32					m_barID;
+	s32					m_value;
+	s32					m_maxValue;
+};
 
 struct World_Avatar : public World_Unit
 {
@@ -17,23 +25,29 @@ struct World_Avatar : public World_Unit
 	static World_Avatar* Alloc(Client_Globals* pGlobalState, const char* pszCharacterModelPath);
 	virtual void Free() override;
 
-	virtual void Update(s32 frameCount) override;
+	// spends spunk on the distance travelled since the last call.
+	void UpdateStats();
 	virtual void Render2D(const Vector3& screenWorldPos) override;
 	virtual void Render3D(const Vector3& screenWorldPos) override;
 
 	void __Initialize(const char* pszCharacterModelPath);
 	void __Uninitialize();
+	virtual void __OnSitDown() override;
+	virtual void __OnStandUp() override;
+	void __OnRest(EventMessage_AvatarRest* pEvent);
+	void __ScheduleRest();
 	void __UpdateVelocity();
+	void __AddStat(World_Avatar_Stat& stat, const char* pszName, const Vector2& uv0, const Vector2& uv1, s32 value, s32 maxValue, s32 incrementSize);
+	void __SetStatDelta(World_Avatar_Stat& stat, s32 delta);
 
-	RenderStatusBars*	m_pStatusBars;
+	World_RenderStatusBars*	m_pStatusBars;
 
-	u32					m_barID_Chill;
-	u32					m_barID_Spunk;
-	u32					m_barID_Full;
-	u32					m_barID_Gas;
+	World_Avatar_Stat	m_chill;
+	World_Avatar_Stat	m_spunk;
+	World_Avatar_Stat	m_full;
+	World_Avatar_Stat	m_gas;
 
-	u32					m_restingFrameCount;
-	u32					m_digestingFrameCount;
+	EventQueueTimerID	m_restTimerID;			// resting a while ups spunk, and digests some food.
 	f32					m_distanceTravelledLast;
 };
 
@@ -0,0 +1,336 @@
+#include "pch.h"
+
+#include "Avoidance.h"
+
+#include "Common/job_system.h"
+
+namespace TB8
+{
+
+const f32 AVOIDANCE_NEIGHBOR_DIST = 4.f;		// meters, centre to centre.
+const u32 AVOIDANCE_NEIGHBOR_MAX = 10;
+const f32 AVOIDANCE_TIME_HORIZON = 1.5f;		// seconds ahead that velocities are kept collision free.
+const u32 AVOIDANCE_BATCH_SIZE = 64;
+const f32 AVOIDANCE_EPSILON = 0.00001f;
+
+// 2d cross product.
+static f32 __Det(const Vector2& a, const Vector2& b)
+{
+	return (a.x * b.y) - (a.y * b.x);
+}
+
+void World_Avoidance_Metrics::Clear()
+{
+	m_agentCount = 0;
+	m_neighborCount = 0;
+	m_fallbackCount = 0;
+}
+
+World_Avoidance::World_Avoidance()
+{
+	m_broadphase.SetCellSize(AVOIDANCE_NEIGHBOR_DIST);
+}
+
+void World_Avoidance::Compute(const World_Avoidance_Agent* pAgents, u32 count, f32 timeStep, JobSystem* pJobSystem, Vector2* pVelocities)
+{
+	m_metrics.Clear();
+	m_metrics.m_agentCount = count;
+	if (!count)
+		return;
+
+	__ComputeNeighbors(pAgents, count);
+
+	const u32 batchCount = (count + AVOIDANCE_BATCH_SIZE - 1) / AVOIDANCE_BATCH_SIZE;
+	m_batchNeighborCounts.assign(batchCount, 0);
+	m_batchFallbackCounts.assign(batchCount, 0);
+	if (pJobSystem)
+	{
+		pJobSystem->ParallelFor(batchCount, [this, pAgents, count, timeStep, pVelocities](u32 batch) { __ComputeBatch(batch, pAgents, count, timeStep, pVelocities); });
+	}
+	else
+	{
+		for (u32 batch = 0; batch < batchCount; ++batch)
+		{
+			__ComputeBatch(batch, pAgents, count, timeStep, pVelocities);
+		}
+	}
+
+	for (u32 batch = 0; batch < batchCount; ++batch)
+	{
+		m_metrics.m_neighborCount += m_batchNeighborCounts[batch];
+		m_metrics.m_fallbackCount += m_batchFallbackCounts[batch];
+	}
+}
+
+void World_Avoidance::__ComputeNeighbors(const World_Avoidance_Agent* pAgents, u32 count)
+{
+	// boxes half the neighbour distance out from each centre overlap for every agent in range, and a few more.
+	const f32 extent = AVOIDANCE_NEIGHBOR_DIST * 0.5f;
+	m_boundsMin.resize(count);
+	m_boundsMax.resize(count);
+	for (u32 i = 0; i < count; ++i)
+	{
+		m_boundsMin[i] = Vector2(pAgents[i].m_pos.x - extent, pAgents[i].m_pos.y - extent);
+		m_boundsMax[i] = Vector2(pAgents[i].m_pos.x + extent, pAgents[i].m_pos.y + extent);
+	}
+	m_broadphase.Build(m_boundsMin.data(), m_boundsMax.data(), count);
+	m_broadphase.ComputePairs();
+
+	// each pair goes in both agents' lists.
+	const std::vector<World_Broadphase_Pair>& pairs = m_broadphase.GetPairs();
+	m_neighborStarts.assign(count + 1, 0);
+	for (size_t p = 0; p < pairs.size(); ++p)
+	{
+		++m_neighborStarts[pairs[p].m_indexA + 1];
+		++m_neighborStarts[pairs[p].m_indexB + 1];
+	}
+	for (u32 i = 0; i < count; ++i)
+	{
+		m_neighborStarts[i + 1] += m_neighborStarts[i];
+	}
+
+	m_neighborCursors.assign(m_neighborStarts.begin(), m_neighborStarts.end() - 1);
+	m_neighbors.resize(m_neighborStarts[count]);
+	for (size_t p = 0; p < pairs.size(); ++p)
+	{
+		m_neighbors[m_neighborCursors[pairs[p].m_indexA]++] = pairs[p].m_indexB;
+		m_neighbors[m_neighborCursors[pairs[p].m_indexB]++] = pairs[p].m_indexA;
+	}
+}
+
+void World_Avoidance::__ComputeBatch(u32 batch, const World_Avoidance_Agent* pAgents, u32 count, f32 timeStep, Vector2* pVelocities)
+{
+	const f32 invTimeHorizon = 1.f / AVOIDANCE_TIME_HORIZON;
+	const f32 invTimeStep = 1.f / timeStep;
+	const f32 neighborDistSq = AVOIDANCE_NEIGHBOR_DIST * AVOIDANCE_NEIGHBOR_DIST;
+
+	const u32 begin = batch * AVOIDANCE_BATCH_SIZE;
+	const u32 end = std::min(begin + AVOIDANCE_BATCH_SIZE, count);
+	for (u32 i = begin; i < end; ++i)
+	{
+		const World_Avoidance_Agent& agent = pAgents[i];
+		if (!agent.m_isAvoiding)
+		{
+			pVelocities[i] = agent.m_velPref;
+			continue;
+		}
+
+		// keep the closest neighbours, sorted by distance.
+		u32 neighbors[AVOIDANCE_NEIGHBOR_MAX];
+		f32 neighborDistSqs[AVOIDANCE_NEIGHBOR_MAX];
+		u32 neighborCount = 0;
+		for (u32 n = m_neighborStarts[i]; n < m_neighborStarts[i + 1]; ++n)
+		{
+			const u32 other = m_neighbors[n];
+			const f32 distSq = (pAgents[other].m_pos - agent.m_pos).MagSq();
+			if (distSq >= neighborDistSq)
+				continue;
+			if ((neighborCount == AVOIDANCE_NEIGHBOR_MAX) && (distSq >= neighborDistSqs[neighborCount - 1]))
+				continue;
+
+			u32 slot = (neighborCount < AVOIDANCE_NEIGHBOR_MAX) ? neighborCount++ : (neighborCount - 1);
+			while ((slot > 0) && (neighborDistSqs[slot - 1] > distSq))
+			{
+				neighbors[slot] = neighbors[slot - 1];
+				neighborDistSqs[slot] = neighborDistSqs[slot - 1];
+				--slot;
+			}
+			neighbors[slot] = other;
+			neighborDistSqs[slot] = distSq;
+		}
+		m_batchNeighborCounts[batch] += neighborCount;
+
+		// one half plane of permitted velocities per neighbour.
+		Line lines[AVOIDANCE_NEIGHBOR_MAX];
+		for (u32 n = 0; n < neighborCount; ++n)
+		{
+			const World_Avoidance_Agent& other = pAgents[neighbors[n]];
+			const Vector2 relPos = other.m_pos - agent.m_pos;
+			const Vector2 relVel = agent.m_vel - other.m_vel;
+			const f32 distSq = relPos.MagSq();
+			const f32 radius = agent.m_radius + other.m_radius;
+			const f32 radiusSq = radius * radius;
+
+			Line& line = lines[n];
+			Vector2 u;
+			if (distSq > radiusSq)
+			{
+				// no collision yet.  w is from the centre of the cutoff circle to the relative velocity.
+				const Vector2 w = relVel - (relPos * invTimeHorizon);
+				const f32 wLengthSq = w.MagSq();
+				const f32 dot = Vector2::Dot(w, relPos);
+				if ((dot < 0.f) && ((dot * dot) > (radiusSq * wLengthSq)))
+				{
+					// project on the cutoff circle.
+					const f32 wLength = std::sqrt(wLengthSq);
+					const Vector2 unitW = w / wLength;
+					line.m_dir = Vector2(unitW.y, -unitW.x);
+					u = unitW * ((radius * invTimeHorizon) - wLength);
+				}
+				else
+				{
+					// project on the nearer leg of the cone.
+					const f32 leg = std::sqrt(distSq - radiusSq);
+					if (__Det(relPos, w) > 0.f)
+					{
+						line.m_dir = Vector2((relPos.x * leg) - (relPos.y * radius), (relPos.x * radius) + (relPos.y * leg)) / distSq;
+					}
+					else
+					{
+						line.m_dir = Vector2(-(relPos.x * leg) - (relPos.y * radius), (relPos.x * radius) - (relPos.y * leg)) / distSq;
+					}
+					u = (line.m_dir * Vector2::Dot(relVel, line.m_dir)) - relVel;
+				}
+			}
+			else
+			{
+				// already overlapping, push apart within this step.
+				const Vector2 w = relVel - (relPos * invTimeStep);
+				const f32 wLength = w.Mag();
+				const Vector2 unitW = (wLength > AVOIDANCE_EPSILON) ? (w / wLength) : Vector2(0.f, 0.f);
+				line.m_dir = Vector2(unitW.y, -unitW.x);
+				u = unitW * ((radius * invTimeStep) - wLength);
+			}
+
+			const f32 responsibility = other.m_isAvoiding ? 0.5f : 1.f;
+			line.m_point = agent.m_vel + (u * responsibility);
+		}
+
+		Vector2 vel;
+		const u32 failLine = __LinearProgram2(lines, neighborCount, agent.m_maxSpeed, agent.m_velPref, false, vel);
+		if (failLine < neighborCount)
+		{
+			__LinearProgram3(lines, neighborCount, failLine, agent.m_maxSpeed, vel);
+			++m_batchFallbackCounts[batch];
+		}
+		pVelocities[i] = vel;
+	}
+}
+
+bool World_Avoidance::__LinearProgram1(const Line* pLines, u32 lineIndex, f32 radius, const Vector2& velOpt, bool isDirOpt, Vector2& result)
+{
+	// the part of the line inside the speed circle.
+	const Line& line = pLines[lineIndex];
+	const f32 dot = Vector2::Dot(line.m_point, line.m_dir);
+	const f32 discriminant = (dot * dot) + (radius * radius) - line.m_point.MagSq();
+	if (discriminant < 0.f)
+		return false;
+
+	const f32 discriminantSqrt = std::sqrt(discriminant);
+	f32 tLeft = -dot - discriminantSqrt;
+	f32 tRight = -dot + discriminantSqrt;
+
+	// clip it by the earlier lines.
+	for (u32 i = 0; i < lineIndex; ++i)
+	{
+		const f32 denominator = __Det(line.m_dir, pLines[i].m_dir);
+		const f32 numerator = __Det(pLines[i].m_dir, line.m_point - pLines[i].m_point);
+		if (std::fabs(denominator) <= AVOIDANCE_EPSILON)
+		{
+			// parallel, either all or none of the line is permitted.
+			if (numerator < 0.f)
+				return false;
+			continue;
+		}
+
+		const f32 t = numerator / denominator;
+		if (denominator >= 0.f)
+		{
+			tRight = std::min(tRight, t);
+		}
+		else
+		{
+			tLeft = std::max(tLeft, t);
+		}
+
+		if (tLeft > tRight)
+			return false;
+	}
+
+	if (isDirOpt)
+	{
+		result = line.m_point + (line.m_dir * ((Vector2::Dot(velOpt, line.m_dir) > 0.f) ? tRight : tLeft));
+	}
+	else
+	{
+		const f32 t = Vector2::Dot(line.m_dir, velOpt - line.m_point);
+		result = line.m_point + (line.m_dir * std::min(std::max(t, tLeft), tRight));
+	}
+	return true;
+}
+
+u32 World_Avoidance::__LinearProgram2(const Line* pLines, u32 lineCount, f32 radius, const Vector2& velOpt, bool isDirOpt, Vector2& result)
+{
+	if (isDirOpt)
+	{
+		// <velOpt> is a unit direction, take the furthest velocity that way.
+		result = velOpt * radius;
+	}
+	else if (velOpt.MagSq() > (radius * radius))
+	{
+		result = velOpt * (radius / velOpt.Mag());
+	}
+	else
+	{
+		result = velOpt;
+	}
+
+	// each line the result is outside of moves it onto that line, the index of the first that can't is returned.
+	for (u32 i = 0; i < lineCount; ++i)
+	{
+		if (__Det(pLines[i].m_dir, pLines[i].m_point - result) > 0.f)
+		{
+			const Vector2 resultPrev = result;
+			if (!__LinearProgram1(pLines, i, radius, velOpt, isDirOpt, result))
+			{
+				result = resultPrev;
+				return i;
+			}
+		}
+	}
+	return lineCount;
+}
+
+void World_Avoidance::__LinearProgram3(const Line* pLines, u32 lineCount, u32 lineBegin, f32 radius, Vector2& result)
+{
+	// no velocity satisfies every line, so minimise the furthest any line is violated.
+	f32 distance = 0.f;
+	for (u32 i = lineBegin; i < lineCount; ++i)
+	{
+		if (__Det(pLines[i].m_dir, pLines[i].m_point - result) <= distance)
+			continue;
+
+		// the earlier lines, projected onto this one.
+		Line projLines[AVOIDANCE_NEIGHBOR_MAX];
+		u32 projLineCount = 0;
+		for (u32 j = 0; j < i; ++j)
+		{
+			Line& projLine = projLines[projLineCount];
+			const f32 determinant = __Det(pLines[i].m_dir, pLines[j].m_dir);
+			if (std::fabs(determinant) <= AVOIDANCE_EPSILON)
+			{
+				// parallel lines pointing the same way don't constrain the projection.
+				if (Vector2::Dot(pLines[i].m_dir, pLines[j].m_dir) > 0.f)
+					continue;
+				projLine.m_point = (pLines[i].m_point + pLines[j].m_point) * 0.5f;
+			}
+			else
+			{
+				projLine.m_point = pLines[i].m_point + (pLines[i].m_dir * (__Det(pLines[j].m_dir, pLines[i].m_point - pLines[j].m_point) / determinant));
+			}
+			projLine.m_dir = pLines[j].m_dir - pLines[i].m_dir;
+			projLine.m_dir.Normalize();
+			++projLineCount;
+		}
+
+		const Vector2 resultPrev = result;
+		if (__LinearProgram2(projLines, projLineCount, radius, Vector2(-pLines[i].m_dir.y, pLines[i].m_dir.x), true, result) < projLineCount)
+		{
+			// can only fail from rounding, the result is already optimal.
+			result = resultPrev;
+		}
+		distance = __Det(pLines[i].m_dir, pLines[i].m_point - result);
+	}
+}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+
+#include "Common/basic_types.h"
+
+#include "Broadphase.h"
+
+namespace TB8
+{
+
+class JobSystem;
+
+struct World_Avoidance_Agent
+{
+	Vector2							m_pos;
+	Vector2							m_vel;
+	Vector2							m_velPref;			// where the agent wants to go.
+	f32								m_radius;
+	f32								m_maxSpeed;
+	u8								m_isAvoiding;		// agents that don't avoid are obstacles with a fixed velocity.
+};
+
+struct World_Avoidance_Metrics
+{
+	World_Avoidance_Metrics() { Clear(); }
+	void Clear();
+
+	u32						m_agentCount;
+	u32						m_neighborCount;		// neighbours used, over every agent.
+	u32						m_fallbackCount;		// agents with no velocity outside every obstacle.
+};
+
+// local avoidance with optimal reciprocal collision avoidance (orca).
+//  each agent takes half the responsibility for avoiding each avoiding neighbour, and all of it for the rest.  the
+//  velocities that keep it clear of a neighbour for the time horizon form a half plane, and the new velocity is the one
+//  closest to the preferred one within all of them and the max speed.  neighbours come from a grid broadphase, and
+//  agents are solved in batches that only read the inputs, so the batches run in parallel.
+class World_Avoidance
+{
+public:
+	World_Avoidance();
+
+	void Compute(const World_Avoidance_Agent* pAgents, u32 count, f32 timeStep, JobSystem* pJobSystem, Vector2* pVelocities);
+
+	const World_Avoidance_Metrics& GetMetrics() const { return m_metrics; }
+
+private:
+	struct Line
+	{
+		Vector2						m_point;
+		Vector2						m_dir;
+	};
+
+	void __ComputeNeighbors(const World_Avoidance_Agent* pAgents, u32 count);
+	void __ComputeBatch(u32 batch, const World_Avoidance_Agent* pAgents, u32 count, f32 timeStep, Vector2* pVelocities);
+
+	static bool __LinearProgram1(const Line* pLines, u32 lineIndex, f32 radius, const Vector2& velOpt, bool isDirOpt, Vector2& result);
+	static u32 __LinearProgram2(const Line* pLines, u32 lineCount, f32 radius, const Vector2& velOpt, bool isDirOpt, Vector2& result);
+	static void __LinearProgram3(const Line* pLines, u32 lineCount, u32 lineBegin, f32 radius, Vector2& result);
+
+	World_Broadphase				m_broadphase;
+	std::vector<Vector2>			m_boundsMin;
+	std::vector<Vector2>			m_boundsMax;
+	std::vector<u32>				m_neighborStarts;	// per agent, into m_neighbors.  one extra at the end.
+	std::vector<u32>				m_neighbors;
+	std::vector<u32>				m_neighborCursors;
+	std::vector<u32>				m_batchNeighborCounts;
+	std::vector<u32>				m_batchFallbackCounts;
+
+	World_Avoidance_Metrics			m_metrics;
+};
+
+}
@@ -2,8 +2,6 @@
 
 #include <cmath>
 
-#include "render/RenderModel.h"
-
 #include "Bounds.h"
 #include "Object.h"
 
@@ -27,14 +25,11 @@ void World_Object_Bounds::ComputeBounds(World_Object& object)
 
 void World_Object_Bounds::__ComputeBoundsBox(World_Object& object)
 {
-	const std::vector<RenderModel_Mesh>& meshes = object.m_pModel->GetMeshes();
-	assert(!meshes.empty());
-	const RenderModel_Mesh& mesh = meshes.front();
-	const RenderModel_Bounds& meshBounds = mesh.m_bounds;
+	const World_RenderModel_Bounds& meshBounds = object.m_pModel->GetBounds();
 
 	// rotate it.
 	Matrix4 matrixRotate;
-	matrixRotate.SetRotate(Vector3(0.f, 0.f, DirectX::XM_PI * (object.m_rotation) / 180.f));
+	matrixRotate.SetRotate(Vector3(0.f, 0.f, PI * (object.m_rotation) / 180.f));
 
 	// position it.
 	Matrix4 matrixPosition;
@@ -65,10 +60,7 @@ void World_Object_Bounds::__ComputeBoundsBox(World_Object& object)
 
 void World_Object_Bounds::__ComputeBoundsSphere(World_Object& object)
 {
-	const std::vector<RenderModel_Mesh>& meshes = object.m_pModel->GetMeshes();
-	assert(!meshes.empty());
-	const RenderModel_Mesh& mesh = meshes.front();
-	const RenderModel_Bounds& meshBounds = mesh.m_bounds;
+	const World_RenderModel_Bounds& meshBounds = object.m_pModel->GetBounds();
 
 	const Vector3& vCenter = meshBounds.m_center;
 	const f32 radius = std::max<f32>(std::max<f32>(meshBounds.m_size.x, meshBounds.m_size.y), meshBounds.m_size.z) / 2.f;
@@ -78,6 +70,30 @@ void World_Object_Bounds::__ComputeBoundsSphere(World_Object& object)
 	m_radius = radius * object.m_scale;
 }
 
+void World_Object_Bounds::ComputeAABB(Vector3& min, Vector3& max) const
+{
+	switch (m_type)
+	{
+	case World_Object_Bounds_Type_Box:
+		min = m_coords[0];
+		max = m_coords[0];
+		for (u32 i = 1; i < ARRAYSIZE(m_coords); ++i)
+		{
+			min = Vector3(std::min<f32>(min.x, m_coords[i].x), std::min<f32>(min.y, m_coords[i].y), std::min<f32>(min.z, m_coords[i].z));
+			max = Vector3(std::max<f32>(max.x, m_coords[i].x), std::max<f32>(max.y, m_coords[i].y), std::max<f32>(max.z, m_coords[i].z));
+		}
+		break;
+	case World_Object_Bounds_Type_Sphere:
+		min = Vector3(m_center.x - m_radius, m_center.y - m_radius, m_center.z - m_radius);
+		max = Vector3(m_center.x + m_radius, m_center.y + m_radius, m_center.z + m_radius);
+		break;
+	default:
+		min = m_center;
+		max = m_center;
+		break;
+	}
+}
+
 bool World_Object_Bounds::IsCollision(const World_Object_Bounds& boundsA, const World_Object_Bounds& boundsB)
 {
 	if ((boundsA.m_type == World_Object_Bounds_Type_None)
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "common/basic_types.h"
+#include "Common/basic_types.h"
 
 namespace TB8
 {
@@ -26,6 +26,8 @@ struct World_Object_Bounds
 	void __ComputeBoundsBox(World_Object& object);
 	void __ComputeBoundsSphere(World_Object& object);
 
+	void ComputeAABB(Vector3& min, Vector3& max) const;
+
 	static bool IsCollision(const World_Object_Bounds& boundsA, const World_Object_Bounds& boundsB);
 	static bool IsCollisionAlongNormal(const Vector3& projection, const World_Object_Bounds& boundsA, const World_Object_Bounds& boundsB);
 
@@ -0,0 +1,142 @@
+#include "pch.h"
+
+#include "Broadphase.h"
+
+namespace TB8
+{
+
+const u32 BROADPHASE_BUCKET_COUNT_MIN = 64;
+
+void World_Broadphase_Metrics::Clear()
+{
+	m_objectCount = 0;
+	m_cellEntryCount = 0;
+	m_occupiedBucketCount = 0;
+	m_maxBucketCount = 0;
+	m_testedPairCount = 0;
+	m_candidatePairCount = 0;
+}
+
+World_Broadphase::World_Broadphase()
+	: m_cellSize(1.f)
+	, m_bucketMask(0)
+{
+}
+
+void World_Broadphase::Build(const Vector2* pMin, const Vector2* pMax, u32 count)
+{
+	m_metrics.Clear();
+	m_metrics.m_objectCount = count;
+
+	m_min.assign(pMin, pMin + count);
+	m_max.assign(pMax, pMax + count);
+
+	// size the table to a power of two, at least twice the object count.
+	u32 bucketCount = BROADPHASE_BUCKET_COUNT_MIN;
+	while (bucketCount < (count * 2))
+		bucketCount <<= 1;
+	m_bucketMask = bucketCount - 1;
+
+	// insert each object into the buckets of the cells it overlaps.
+	m_entryBuckets.clear();
+	m_entryObjects.clear();
+	for (u32 i = 0; i < count; ++i)
+	{
+		const s32 left = __GetCell(m_min[i].x);
+		const s32 top = __GetCell(m_min[i].y);
+		const s32 right = __GetCell(m_max[i].x);
+		const s32 bottom = __GetCell(m_max[i].y);
+		const size_t firstEntry = m_entryBuckets.size();
+
+		for (s32 y = top; y <= bottom; ++y)
+		{
+			for (s32 x = left; x <= right; ++x)
+			{
+				// cells that hash to the same bucket only need one entry.
+				const u32 bucket = __GetBucket(x, y);
+				if (std::find(m_entryBuckets.begin() + firstEntry, m_entryBuckets.end(), bucket) != m_entryBuckets.end())
+					continue;
+				m_entryBuckets.push_back(bucket);
+				m_entryObjects.push_back(i);
+			}
+		}
+	}
+	m_metrics.m_cellEntryCount = static_cast<u32>(m_entryBuckets.size());
+
+	// counting sort the entries by bucket, objects stay in index order within a bucket.
+	m_bucketStart.assign(bucketCount + 1, 0);
+	for (size_t e = 0; e < m_entryBuckets.size(); ++e)
+	{
+		++m_bucketStart[m_entryBuckets[e] + 1];
+	}
+	for (u32 b = 0; b < bucketCount; ++b)
+	{
+		m_bucketStart[b + 1] += m_bucketStart[b];
+	}
+
+	m_bucketCursor.assign(m_bucketStart.begin(), m_bucketStart.end() - 1);
+	m_bucketObjects.resize(m_entryBuckets.size());
+	for (size_t e = 0; e < m_entryBuckets.size(); ++e)
+	{
+		m_bucketObjects[m_bucketCursor[m_entryBuckets[e]]++] = m_entryObjects[e];
+	}
+}
+
+void World_Broadphase::ComputePairs()
+{
+	m_pairs.clear();
+
+	const u32 bucketCount = m_bucketMask + 1;
+	for (u32 b = 0; b < bucketCount; ++b)
+	{
+		const u32 start = m_bucketStart[b];
+		const u32 end = m_bucketStart[b + 1];
+		if (start == end)
+			continue;
+
+		++m_metrics.m_occupiedBucketCount;
+		m_metrics.m_maxBucketCount = std::max<u32>(m_metrics.m_maxBucketCount, end - start);
+
+		for (u32 i = start; i < end; ++i)
+		{
+			const u32 indexA = m_bucketObjects[i];
+			for (u32 j = i + 1; j < end; ++j)
+			{
+				const u32 indexB = m_bucketObjects[j];
+
+				++m_metrics.m_testedPairCount;
+				if (!__IsOverlap(indexA, indexB))
+					continue;
+
+				// a pair shares several cells, only report it from the cell holding the max of the two mins.
+				const s32 refX = __GetCell(std::max<f32>(m_min[indexA].x, m_min[indexB].x));
+				const s32 refY = __GetCell(std::max<f32>(m_min[indexA].y, m_min[indexB].y));
+				if (__GetBucket(refX, refY) != b)
+					continue;
+
+				World_Broadphase_Pair pair;
+				pair.m_indexA = indexA;
+				pair.m_indexB = indexB;
+				m_pairs.push_back(pair);
+			}
+		}
+	}
+
+	m_metrics.m_candidatePairCount = static_cast<u32>(m_pairs.size());
+}
+
+u32 World_Broadphase::__GetBucket(s32 cellX, s32 cellY) const
+{
+	const u32 hash = (static_cast<u32>(cellX) * 73856093u) ^ (static_cast<u32>(cellY) * 19349663u);
+	return hash & m_bucketMask;
+}
+
+bool World_Broadphase::__IsOverlap(u32 indexA, u32 indexB) const
+{
+	return (m_min[indexA].x <= m_max[indexB].x)
+		&& (m_min[indexB].x <= m_max[indexA].x)
+		&& (m_min[indexA].y <= m_max[indexB].y)
+		&& (m_min[indexB].y <= m_max[indexA].y);
+}
+
+}
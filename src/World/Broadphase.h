@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+
+#include "Common/basic_types.h"
+
+namespace TB8
+{
+
+struct World_Broadphase_Pair
+{
+	u32						m_indexA;
+	u32						m_indexB;
+};
+
+struct World_Broadphase_Metrics
+{
+	World_Broadphase_Metrics() { Clear(); }
+	void Clear();
+
+	u32						m_objectCount;			// objects inserted.
+	u32						m_cellEntryCount;		// object / cell entries.
+	u32						m_occupiedBucketCount;	// buckets with at least one object.
+	u32						m_maxBucketCount;		// most objects in a single bucket.
+	u32						m_testedPairCount;		// pairs given an AABB test.
+	u32						m_candidatePairCount;	// pairs output for the narrow phase.
+};
+
+// uniform grid broadphase, rebuilt every tick.
+//  objects are hashed into grid cells and counting sorted into buckets, candidate pairs are output
+//  once each (from the cell holding the max corner of the two mins) into a flat array.
+class World_Broadphase
+{
+public:
+	World_Broadphase();
+
+	void SetCellSize(f32 cellSize) { assert(cellSize > 0.f); m_cellSize = cellSize; }
+	f32 GetCellSize() const { return m_cellSize; }
+
+	void Build(const Vector2* pMin, const Vector2* pMax, u32 count);
+	void ComputePairs();
+
+	const std::vector<World_Broadphase_Pair>& GetPairs() const { return m_pairs; }
+	const World_Broadphase_Metrics& GetMetrics() const { return m_metrics; }
+
+private:
+	s32 __GetCell(f32 v) const { return static_cast<s32>(std::floor(v / m_cellSize)); }
+	u32 __GetBucket(s32 cellX, s32 cellY) const;
+	bool __IsOverlap(u32 indexA, u32 indexB) const;
+
+	f32								m_cellSize;
+	u32								m_bucketMask;
+
+	std::vector<Vector2>			m_min;
+	std::vector<Vector2>			m_max;
+
+	std::vector<u32>				m_entryBuckets;		// bucket for each object / cell entry.
+	std::vector<u32>				m_entryObjects;		// object for each object / cell entry.
+	std::vector<u32>				m_bucketStart;		// prefix sums, objects for bucket b are [m_bucketStart[b], m_bucketStart[b + 1]).
+	std::vector<u32>				m_bucketObjects;	// object indicies sorted by bucket.
+	std::vector<u32>				m_bucketCursor;
+
+	std::vector<World_Broadphase_Pair>	m_pairs;
+	World_Broadphase_Metrics		m_metrics;
+};
+
+}
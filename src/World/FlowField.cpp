@@ -0,0 +1,458 @@
+#include "pch.h"
+
+#include <cfloat>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TB8_FLOWFIELD_SSE2
+#endif
+
+#include "Pathfinder.h"
+#include "FlowField.h"
+
+namespace TB8
+{
+
+const u8 FLOWFIELD_DIR_NONE = 0xff;
+const f32 FLOWFIELD_COST_UNREACHABLE = FLT_MAX;
+const f32 FLOWFIELD_COST_DIAGONAL = 1.41421356f;
+const f32 FLOWFIELD_DIAGONAL_NORMAL = 0.70710678f;
+
+// same order as the pathfinder, so the step masks line up with its directions.
+static const IVector2 s_flowDirs[] =
+{
+	IVector2(+1, 0), IVector2(-1, 0), IVector2(0, +1), IVector2(0, -1),
+	IVector2(+1, +1), IVector2(+1, -1), IVector2(-1, +1), IVector2(-1, -1),
+};
+
+static const f32 s_flowDirCosts[] =
+{
+	1.f, 1.f, 1.f, 1.f,
+	FLOWFIELD_COST_DIAGONAL, FLOWFIELD_COST_DIAGONAL, FLOWFIELD_COST_DIAGONAL, FLOWFIELD_COST_DIAGONAL,
+};
+
+static const Vector2 s_flowDirNormals[] =
+{
+	Vector2(+1.f, 0.f), Vector2(-1.f, 0.f), Vector2(0.f, +1.f), Vector2(0.f, -1.f),
+	Vector2(+FLOWFIELD_DIAGONAL_NORMAL, +FLOWFIELD_DIAGONAL_NORMAL), Vector2(+FLOWFIELD_DIAGONAL_NORMAL, -FLOWFIELD_DIAGONAL_NORMAL),
+	Vector2(-FLOWFIELD_DIAGONAL_NORMAL, +FLOWFIELD_DIAGONAL_NORMAL), Vector2(-FLOWFIELD_DIAGONAL_NORMAL, -FLOWFIELD_DIAGONAL_NORMAL),
+};
+
+World_FlowField::World_FlowField()
+	: m_isUsed(false)
+	, m_lastUsed(0)
+	, m_stride(0)
+{
+}
+
+bool World_FlowField::IsReachable(const IVector2& cell) const
+{
+	return GetCost(cell) < FLOWFIELD_COST_UNREACHABLE;
+}
+
+f32 World_FlowField::GetCost(const IVector2& cell) const
+{
+	if (!__IsValidCell(cell))
+		return FLOWFIELD_COST_UNREACHABLE;
+	return m_costs[__GetIndex(cell)];
+}
+
+bool World_FlowField::GetDirection(const IVector2& cell, Vector2* pDir) const
+{
+	if (!__IsValidCell(cell))
+		return false;
+
+	const u8 dir = m_dirs[__GetIndex(cell)];
+	if (dir == FLOWFIELD_DIR_NONE)
+		return false;
+
+	*pDir = s_flowDirNormals[dir];
+	return true;
+}
+
+void World_FlowFieldCache_Metrics::Clear()
+{
+	m_buildCount = 0;
+	m_updateCount = 0;
+	m_cacheHitCount = 0;
+	m_nodeCount = 0;
+}
+
+World_FlowFieldCache::World_FlowFieldCache(const World_Pathfinder& pathfinder, u32 fieldCount)
+	: m_pathfinder(pathfinder)
+	, m_stride(0)
+	, m_clock(0)
+	, m_isStepsDirty(false)
+	, m_stamp(0)
+{
+	m_fields.resize(std::max<u32>(fieldCount, 1));
+	for (u32 i = 0; i < ARRAYSIZE(m_offsets); ++i)
+	{
+		m_offsets[i] = 0;
+	}
+}
+
+void World_FlowFieldCache::Resize()
+{
+	m_size = m_pathfinder.GetSize();
+	m_stride = static_cast<u32>(m_size.x + 2);
+	for (u32 i = 0; i < ARRAYSIZE(s_flowDirs); ++i)
+	{
+		m_offsets[i] = s_flowDirs[i].x + (s_flowDirs[i].y * static_cast<s32>(m_stride));
+	}
+
+	const u32 paddedCount = m_stride * static_cast<u32>(m_size.y + 2);
+	m_stepMasks.assign(paddedCount, 0);
+	m_cellCosts.assign(paddedCount, 0.f);
+	m_isStepsDirty = true;
+
+	m_heap.Resize(paddedCount);
+	m_stamps.assign(paddedCount, 0);
+	m_stamp = 0;
+
+	for (std::vector<World_FlowField>::iterator it = m_fields.begin(); it != m_fields.end(); ++it)
+	{
+		it->m_isUsed = false;
+		it->m_costs.clear();
+		it->m_dirs.clear();
+	}
+	m_invalidCells.clear();
+}
+
+void World_FlowFieldCache::InvalidateCell(const IVector2& cell)
+{
+	if (!__IsValidCell(cell))
+		return;
+
+	m_invalidCells.push_back(cell);
+}
+
+void World_FlowFieldCache::Update()
+{
+	// the map is filled in after Resize(), so every cell's steps are read on first use.
+	if (m_isStepsDirty)
+	{
+		IVector2 cell;
+		for (cell.y = 0; cell.y < m_size.y; ++cell.y)
+		{
+			for (cell.x = 0; cell.x < m_size.x; ++cell.x)
+			{
+				__UpdateCellSteps(cell);
+			}
+		}
+		m_isStepsDirty = false;
+		m_invalidCells.clear();
+	}
+
+	if (m_invalidCells.empty())
+		return;
+
+	// a cell's steps depend on the cells around it, so its neighbours' steps change too.
+	m_rootCells.clear();
+	for (std::vector<IVector2>::const_iterator it = m_invalidCells.begin(); it != m_invalidCells.end(); ++it)
+	{
+		IVector2 cell;
+		for (cell.y = it->y - 1; cell.y <= it->y + 1; ++cell.y)
+		{
+			for (cell.x = it->x - 1; cell.x <= it->x + 1; ++cell.x)
+			{
+				if (!__IsValidCell(cell))
+					continue;
+				__UpdateCellSteps(cell);
+				m_rootCells.push_back(__GetIndex(cell));
+			}
+		}
+	}
+	m_invalidCells.clear();
+
+	std::sort(m_rootCells.begin(), m_rootCells.end());
+	m_rootCells.erase(std::unique(m_rootCells.begin(), m_rootCells.end()), m_rootCells.end());
+
+	for (std::vector<World_FlowField>::iterator it = m_fields.begin(); it != m_fields.end(); ++it)
+	{
+		if (it->m_isUsed)
+		{
+			__UpdateField(*it);
+		}
+	}
+}
+
+const World_FlowField* World_FlowFieldCache::GetField(const IVector2& goal)
+{
+	if (!__IsValidCell(goal))
+		return nullptr;
+
+	Update();
+
+	World_FlowField* pOldest = &m_fields.front();
+	for (std::vector<World_FlowField>::iterator it = m_fields.begin(); it != m_fields.end(); ++it)
+	{
+		if (it->m_isUsed && (it->m_goal.x == goal.x) && (it->m_goal.y == goal.y))
+		{
+			it->m_lastUsed = ++m_clock;
+			++m_metrics.m_cacheHitCount;
+			return &*it;
+		}
+
+		if (!pOldest->m_isUsed)
+			continue;
+		if (!it->m_isUsed || (it->m_lastUsed < pOldest->m_lastUsed))
+		{
+			pOldest = &*it;
+		}
+	}
+
+	// replace the least recently used field, reusing its storage.
+	World_FlowField& field = *pOldest;
+	field.m_goal = goal;
+	field.m_isUsed = true;
+	field.m_lastUsed = ++m_clock;
+	__Build(field);
+	return &field;
+}
+
+void World_FlowFieldCache::Reserve(u32 fieldCount)
+{
+	if (fieldCount > m_fields.size())
+	{
+		m_fields.resize(fieldCount);
+	}
+}
+
+void World_FlowFieldCache::__UpdateCellSteps(const IVector2& cell)
+{
+	const u32 index = __GetIndex(cell);
+
+	u8 mask = 0;
+	if (m_pathfinder.IsPassable(cell))
+	{
+		for (u32 i = 0; i < ARRAYSIZE(s_flowDirs); ++i)
+		{
+			if (m_pathfinder.CanStep(cell, s_flowDirs[i]))
+			{
+				mask |= static_cast<u8>(1 << i);
+			}
+		}
+	}
+
+	m_stepMasks[index] = mask;
+	m_cellCosts[index] = static_cast<f32>(m_pathfinder.GetCellCost(cell));
+}
+
+void World_FlowFieldCache::__Build(World_FlowField& field)
+{
+	++m_metrics.m_buildCount;
+
+	field.m_size = m_size;
+	field.m_stride = m_stride;
+	field.m_costs.assign(m_stepMasks.size(), FLOWFIELD_COST_UNREACHABLE);
+	field.m_dirs.assign(m_stepMasks.size(), FLOWFIELD_DIR_NONE);
+
+	if (!m_pathfinder.IsPassable(field.m_goal))
+		return;
+
+	const u32 goalIndex = __GetIndex(field.m_goal);
+	field.m_costs[goalIndex] = 0.f;
+	m_heap.Clear();
+	m_heap.Push(goalIndex, 0.f);
+
+	IRect changed;
+	__Integrate(field, &changed);
+
+	IRect all;
+	all.right = m_size.x;
+	all.bottom = m_size.y;
+	__ComputeDirections(field, all);
+}
+
+void World_FlowFieldCache::__UpdateField(World_FlowField& field)
+{
+	// a change at the goal changes everything.
+	const u32 goalIndex = __GetIndex(field.m_goal);
+	if (std::binary_search(m_rootCells.begin(), m_rootCells.end(), goalIndex))
+	{
+		__Build(field);
+		return;
+	}
+
+	++m_metrics.m_updateCount;
+
+	++m_stamp;
+	if (m_stamp == 0)
+	{
+		std::fill(m_stamps.begin(), m_stamps.end(), 0);
+		m_stamp = 1;
+	}
+
+	// every cell whose route to the goal ran thru a changed step.
+	m_affected.clear();
+	for (std::vector<u32>::const_iterator it = m_rootCells.begin(); it != m_rootCells.end(); ++it)
+	{
+		m_stamps[*it] = m_stamp;
+		m_affected.push_back(*it);
+	}
+	for (u32 i = 0; i < m_affected.size(); ++i)
+	{
+		const u32 index = m_affected[i];
+		for (u32 dir = 0; dir < ARRAYSIZE(s_flowDirs); ++dir)
+		{
+			const u32 indexFrom = static_cast<u32>(static_cast<s32>(index) - m_offsets[dir]);
+			if ((field.m_dirs[indexFrom] != dir) || (m_stamps[indexFrom] == m_stamp))
+				continue;
+			m_stamps[indexFrom] = m_stamp;
+			m_affected.push_back(indexFrom);
+		}
+	}
+
+	IRect changed;
+	changed.left = m_size.x;
+	changed.top = m_size.y;
+	for (std::vector<u32>::const_iterator it = m_affected.begin(); it != m_affected.end(); ++it)
+	{
+		field.m_costs[*it] = FLOWFIELD_COST_UNREACHABLE;
+		field.m_dirs[*it] = FLOWFIELD_DIR_NONE;
+
+		const s32 x = static_cast<s32>(*it % m_stride) - 1;
+		const s32 y = static_cast<s32>(*it / m_stride) - 1;
+		changed.left = std::min<s32>(changed.left, x);
+		changed.top = std::min<s32>(changed.top, y);
+		changed.right = std::max<s32>(changed.right, x + 1);
+		changed.bottom = std::max<s32>(changed.bottom, y + 1);
+	}
+
+	// search again from the cells around them.  their costs may be beaten thru the changed steps, so cells can be
+	//  reopened.
+	m_heap.Clear();
+	for (std::vector<u32>::const_iterator it = m_affected.begin(); it != m_affected.end(); ++it)
+	{
+		for (u32 dir = 0; dir < ARRAYSIZE(s_flowDirs); ++dir)
+		{
+			const u32 indexNext = static_cast<u32>(static_cast<s32>(*it) + m_offsets[dir]);
+			if ((m_stamps[indexNext] == m_stamp) || !(field.m_costs[indexNext] < FLOWFIELD_COST_UNREACHABLE) || m_heap.Contains(indexNext))
+				continue;
+			m_heap.Push(indexNext, field.m_costs[indexNext]);
+		}
+	}
+	__Integrate(field, &changed);
+
+	// directions change for the cells whose cost changed and the cells next to them.
+	changed.left = std::max<s32>(changed.left - 1, 0);
+	changed.top = std::max<s32>(changed.top - 1, 0);
+	changed.right = std::min<s32>(changed.right + 1, m_size.x);
+	changed.bottom = std::min<s32>(changed.bottom + 1, m_size.y);
+	__ComputeDirections(field, changed);
+}
+
+void World_FlowFieldCache::__Integrate(World_FlowField& field, IRect* pChanged)
+{
+	// dijkstra outward from the goal.  a cell steps into the cell it was reached from, so its cost is the cost of that
+	//  step plus the cost from there.
+	std::vector<f32>& costs = field.m_costs;
+	while (!m_heap.IsEmpty())
+	{
+		const u32 index = m_heap.Pop();
+		const f32 cellCost = m_cellCosts[index];
+		const f32 cost = costs[index];
+		++m_metrics.m_nodeCount;
+
+		for (u32 dir = 0; dir < ARRAYSIZE(s_flowDirs); ++dir)
+		{
+			const u32 indexFrom = static_cast<u32>(static_cast<s32>(index) - m_offsets[dir]);
+			if (!(m_stepMasks[indexFrom] & (1 << dir)))
+				continue;
+
+			const f32 costFrom = cost + (s_flowDirCosts[dir] * cellCost);
+			if (!(costFrom < costs[indexFrom]))
+				continue;
+
+			costs[indexFrom] = costFrom;
+			if (m_heap.Contains(indexFrom))
+			{
+				m_heap.DecreaseCost(indexFrom, costFrom);
+			}
+			else
+			{
+				m_heap.Push(indexFrom, costFrom);
+			}
+
+			const s32 x = static_cast<s32>(indexFrom % m_stride) - 1;
+			const s32 y = static_cast<s32>(indexFrom / m_stride) - 1;
+			pChanged->left = std::min<s32>(pChanged->left, x);
+			pChanged->top = std::min<s32>(pChanged->top, y);
+			pChanged->right = std::max<s32>(pChanged->right, x + 1);
+			pChanged->bottom = std::max<s32>(pChanged->bottom, y + 1);
+		}
+	}
+}
+
+void World_FlowFieldCache::__ComputeDirections(World_FlowField& field, const IRect& rect) const
+{
+	const f32* pCosts = field.m_costs.data();
+	const f32* pCellCosts = m_cellCosts.data();
+	const u8* pStepMasks = m_stepMasks.data();
+	u8* pDirs = field.m_dirs.data();
+
+	for (s32 y = rect.top; y < rect.bottom; ++y)
+	{
+		s32 x = rect.left;
+		u32 index = __GetIndex(IVector2(x, y));
+
+#if defined(TB8_FLOWFIELD_SSE2)
+		// 4 cells at a time, the padding keeps every neighbour load in bounds.
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 unreachable = _mm_set1_ps(FLOWFIELD_COST_UNREACHABLE);
+		for (; (x + 4) <= rect.right; x += 4, index += 4)
+		{
+			u32 masks4;
+			memcpy(&masks4, pStepMasks + index, sizeof(masks4));
+			const __m128i masks = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<s32>(masks4)), zero), zero);
+
+			__m128 best = unreachable;
+			__m128i bestDir = _mm_set1_epi32(FLOWFIELD_DIR_NONE);
+			for (u32 dir = 0; dir < ARRAYSIZE(s_flowDirs); ++dir)
+			{
+				const u32 indexNext = static_cast<u32>(static_cast<s32>(index) + m_offsets[dir]);
+				const __m128 total = _mm_add_ps(_mm_loadu_ps(pCosts + indexNext), _mm_mul_ps(_mm_set1_ps(s_flowDirCosts[dir]), _mm_loadu_ps(pCellCosts + indexNext)));
+
+				const __m128i bit = _mm_set1_epi32(1 << dir);
+				const __m128 canStep = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(masks, bit), bit));
+				const __m128 isBetter = _mm_and_ps(canStep, _mm_cmplt_ps(total, best));
+				best = _mm_or_ps(_mm_and_ps(isBetter, total), _mm_andnot_ps(isBetter, best));
+				const __m128i isBetterI = _mm_castps_si128(isBetter);
+				bestDir = _mm_or_si128(_mm_and_si128(isBetterI, _mm_set1_epi32(dir)), _mm_andnot_si128(isBetterI, bestDir));
+			}
+
+			// none at the goal, or where nothing leads to it.
+			const __m128 isValid = _mm_and_ps(_mm_cmplt_ps(best, unreachable), _mm_cmpgt_ps(_mm_loadu_ps(pCosts + index), _mm_setzero_ps()));
+			const __m128i isValidI = _mm_castps_si128(isValid);
+			bestDir = _mm_or_si128(_mm_and_si128(isValidI, bestDir), _mm_andnot_si128(isValidI, _mm_set1_epi32(FLOWFIELD_DIR_NONE)));
+
+			const s32 dirs4 = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(bestDir, zero), zero));
+			memcpy(pDirs + index, &dirs4, sizeof(dirs4));
+		}
+#endif
+
+		for (; x < rect.right; ++x, ++index)
+		{
+			f32 best = FLOWFIELD_COST_UNREACHABLE;
+			u8 bestDir = FLOWFIELD_DIR_NONE;
+			for (u32 dir = 0; dir < ARRAYSIZE(s_flowDirs); ++dir)
+			{
+				if (!(pStepMasks[index] & (1 << dir)))
+					continue;
+
+				const u32 indexNext = static_cast<u32>(static_cast<s32>(index) + m_offsets[dir]);
+				const f32 total = pCosts[indexNext] + (s_flowDirCosts[dir] * pCellCosts[indexNext]);
+				if (total < best)
+				{
+					best = total;
+					bestDir = static_cast<u8>(dir);
+				}
+			}
+
+			pDirs[index] = (pCosts[index] > 0.f) ? bestDir : FLOWFIELD_DIR_NONE;
+		}
+	}
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+
+#include "Common/basic_types.h"
+
+#include "PathHeap.h"
+
+namespace TB8
+{
+
+class World_Pathfinder;
+
+const u32 FLOWFIELD_CACHE_SIZE_DEFAULT = 8;
+
+// distance to one goal cell from every cell of the map, and the step to take from each.
+//  units heading to the same goal share a field and look up their direction in O(1).  fields are built and kept up to
+//  date by World_FlowFieldCache.
+class World_FlowField
+{
+public:
+	World_FlowField();
+
+	const IVector2& GetGoal() const { return m_goal; }
+	bool IsReachable(const IVector2& cell) const;
+	f32 GetCost(const IVector2& cell) const;
+
+	// unit direction of the step toward the goal, false at the goal or when it can't be reached.
+	bool GetDirection(const IVector2& cell, Vector2* pDir) const;
+
+private:
+	friend class World_FlowFieldCache;
+
+	u32 __GetIndex(const IVector2& cell) const { return static_cast<u32>(((cell.y + 1) * m_stride) + (cell.x + 1)); }
+	bool __IsValidCell(const IVector2& cell) const { return (cell.x >= 0) && (cell.y >= 0) && (cell.x < m_size.x) && (cell.y < m_size.y); }
+
+	IVector2						m_goal;
+	bool							m_isUsed;
+	u32								m_lastUsed;
+	IVector2						m_size;
+	u32								m_stride;
+
+	// padded by a cell on every side, like the cache's step masks.
+	std::vector<f32>				m_costs;
+	std::vector<u8>					m_dirs;				// index of the step toward the goal, or FLOWFIELD_DIR_NONE.
+};
+
+struct World_FlowFieldCache_Metrics
+{
+	World_FlowFieldCache_Metrics() { Clear(); }
+	void Clear();
+
+	u32						m_buildCount;
+	u32						m_updateCount;			// incremental updates after cells changed.
+	u32						m_cacheHitCount;
+	u32						m_nodeCount;			// cells expanded building and updating fields.
+};
+
+// least recently used set of flow fields, keyed by goal cell.
+//  integration is a dijkstra search out from the goal over the pathfinder's movement rules.  the step masks and cell
+//  costs it reads are shared by every field and refreshed only around invalidated cells.  an invalidated cell resets
+//  just the cells whose route ran thru it, which are then searched again from their neighbours.  the direction field
+//  is a min over the 8 neighbours of each cell, 4 cells at a time with sse2.
+class World_FlowFieldCache
+{
+public:
+	World_FlowFieldCache(const World_Pathfinder& pathfinder, u32 fieldCount = FLOWFIELD_CACHE_SIZE_DEFAULT);
+
+	// takes the size from the pathfinder and drops every field.
+	void Resize();
+
+	void InvalidateCell(const IVector2& cell);
+	void Update();
+
+	// the field for <goal>, built if it isn't cached.  it stays valid until the next call that builds or evicts.
+	const World_FlowField* GetField(const IVector2& goal);
+
+	// grows the cache to hold at least <fieldCount> fields, so that many goals can be looked up without evicting each
+	//  other.  it never shrinks.
+	void Reserve(u32 fieldCount);
+	u32 GetCapacity() const { return static_cast<u32>(m_fields.size()); }
+
+	const World_FlowFieldCache_Metrics& GetMetrics() const { return m_metrics; }
+
+private:
+	u32 __GetIndex(const IVector2& cell) const { return static_cast<u32>(((cell.y + 1) * m_stride) + (cell.x + 1)); }
+	bool __IsValidCell(const IVector2& cell) const { return (cell.x >= 0) && (cell.y >= 0) && (cell.x < m_size.x) && (cell.y < m_size.y); }
+
+	void __UpdateCellSteps(const IVector2& cell);
+	void __Build(World_FlowField& field);
+	void __UpdateField(World_FlowField& field);
+	void __Integrate(World_FlowField& field, IRect* pChanged);
+	void __ComputeDirections(World_FlowField& field, const IRect& rect) const;
+
+	const World_Pathfinder&			m_pathfinder;
+	IVector2						m_size;
+	u32								m_stride;
+	s32								m_offsets[8];		// index offset of each step direction.
+
+	std::vector<World_FlowField>	m_fields;
+	u32								m_clock;
+
+	// shared by every field, padded by a cell on every side.
+	std::vector<u8>					m_stepMasks;		// per cell, a bit for each direction the pathfinder can step.
+	std::vector<f32>				m_cellCosts;		// cost of entering each cell.
+	bool							m_isStepsDirty;
+
+	std::vector<IVector2>			m_invalidCells;		// changed since the last Update().
+	std::vector<u32>				m_rootCells;		// indicies whose steps changed, for the incremental updates.
+
+	// search state.
+	World_PathHeap					m_heap;
+	std::vector<u32>				m_stamps;
+	u32								m_stamp;
+	std::vector<u32>				m_affected;
+
+	World_FlowFieldCache_Metrics	m_metrics;
+};
+
+}
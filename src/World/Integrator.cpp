@@ -0,0 +1,360 @@
+#include "pch.h"
+
+#include <cmath>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+
+#include "Unit.h"
+#include "Integrator.h"
+
+// msvc allows avx intrinsics without /arch:AVX, so the avx path is always built there and picked at runtime.
+#if defined(_MSC_VER) || defined(__AVX__)
+#define TB8_INTEGRATOR_AVX
+#endif
+
+namespace TB8
+{
+
+const u32 INTEGRATOR_LANE_COUNT = 8;
+
+#if defined(TB8_INTEGRATOR_AVX)
+
+static bool __IsAVXSupported()
+{
+#if defined(_MSC_VER)
+	s32 info[4];
+	__cpuid(info, 1);
+	const bool isOSXSave = (info[2] & (1 << 27)) != 0;
+	const bool isAVX = (info[2] & (1 << 28)) != 0;
+	if (!isOSXSave || !isAVX)
+		return false;
+
+	// the os must save the ymm registers.
+	return (_xgetbv(0) & 0x6) == 0x6;
+#else
+	return true;
+#endif
+}
+
+// is_approx_zero() compares in double precision, these are the float bounds giving the same answer.
+static f32 __ComputeApproxZeroMin()
+{
+	f32 v = static_cast<f32>(-0.000001);
+	while (!(-0.000001 < v))
+		v = std::nextafter(v, 0.f);
+	while (-0.000001 < std::nextafter(v, -1.f))
+		v = std::nextafter(v, -1.f);
+	return v;
+}
+
+static f32 __ComputeApproxZeroMax()
+{
+	f32 v = static_cast<f32>(0.00001);
+	while (!(v < 0.00001))
+		v = std::nextafter(v, 0.f);
+	while (std::nextafter(v, 1.f) < 0.00001)
+		v = std::nextafter(v, 1.f);
+	return v;
+}
+
+static const f32 s_approxZeroMin = __ComputeApproxZeroMin();
+static const f32 s_approxZeroMax = __ComputeApproxZeroMax();
+
+static inline __m256 __IsApproxZero(__m256 v)
+{
+	return _mm256_and_ps(_mm256_cmp_ps(v, _mm256_set1_ps(s_approxZeroMin), _CMP_GE_OQ), _mm256_cmp_ps(v, _mm256_set1_ps(s_approxZeroMax), _CMP_LE_OQ));
+}
+
+static inline __m256 __GetSign(__m256 v)
+{
+	return _mm256_blendv_ps(_mm256_set1_ps(1.f), _mm256_set1_ps(-1.f), _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_LT_OQ));
+}
+
+#else
+
+static bool __IsAVXSupported()
+{
+	return false;
+}
+
+#endif
+
+World_Integrator::World_Integrator()
+	: m_isAVX(__IsAVXSupported())
+{
+}
+
+void World_Integrator::SetAVX(bool isAVX)
+{
+	m_isAVX = isAVX && __IsAVXSupported();
+}
+
+void World_Integrator::Integrate(const s32* pFrameCounts, World_Unit* const* ppUnits, u32 count, World_UnitMove* pMoves)
+{
+	if (!count)
+		return;
+
+	__Gather(pFrameCounts, ppUnits, count);
+
+	if (m_isAVX)
+	{
+		__IntegrateAVX(static_cast<u32>(m_mass.size()));
+	}
+	else
+	{
+		__IntegrateScalar(0, count);
+	}
+
+	__Scatter(ppUnits, count, pMoves);
+}
+
+void World_Integrator::__Gather(const s32* pFrameCounts, World_Unit* const* ppUnits, u32 count)
+{
+	// pad to a whole number of lanes, padding units are at rest with a unit mass.
+	const u32 countPadded = (count + INTEGRATOR_LANE_COUNT - 1) & ~(INTEGRATOR_LANE_COUNT - 1);
+
+	std::vector<f32>* inputs[] = { &m_posX, &m_posY, &m_posZ, &m_velX, &m_velY, &m_velZ, &m_forceX, &m_forceY, &m_forceZ };
+	for (u32 i = 0; i < ARRAYSIZE(inputs); ++i)
+	{
+		inputs[i]->assign(countPadded, 0.f);
+	}
+	m_mass.assign(countPadded, 1.f);
+	m_maxVelocity.assign(countPadded, 1.f);
+	m_elapsedTime.assign(countPadded, 0.f);
+
+	std::vector<f32>* outputs[] = { &m_nextPosX, &m_nextPosY, &m_nextPosZ, &m_nextVelX, &m_nextVelY, &m_nextVelZ };
+	for (u32 i = 0; i < ARRAYSIZE(outputs); ++i)
+	{
+		outputs[i]->resize(countPadded);
+	}
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		const World_Unit& unit = *ppUnits[i];
+		m_posX[i] = unit.m_pos.x;
+		m_posY[i] = unit.m_pos.y;
+		m_posZ[i] = unit.m_pos.z;
+		m_velX[i] = unit.m_velocity.x;
+		m_velY[i] = unit.m_velocity.y;
+		m_velZ[i] = unit.m_velocity.z;
+		m_forceX[i] = unit.m_force.x;
+		m_forceY[i] = unit.m_force.y;
+		m_forceZ[i] = unit.m_force.z;
+		m_mass[i] = unit.m_mass;
+		m_maxVelocity[i] = unit.m_maxVelocity;
+		m_elapsedTime[i] = static_cast<f32>(pFrameCounts[i]) / UNIT_FRAMES_PER_SECOND;
+	}
+}
+
+void World_Integrator::__Scatter(World_Unit* const* ppUnits, u32 count, World_UnitMove* pMoves) const
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		World_Unit& unit = *ppUnits[i];
+		unit.m_velocity.z = m_velZ[i];
+		unit.m_force.z = m_forceZ[i];
+
+		World_UnitMove& move = pMoves[i];
+		move.m_pos = Vector3(m_nextPosX[i], m_nextPosY[i], m_nextPosZ[i]);
+		move.m_vel = Vector3(m_nextVelX[i], m_nextVelY[i], m_nextVelZ[i]);
+	}
+}
+
+void World_Integrator::__IntegrateScalar(u32 begin, u32 end)
+{
+	// same operations, in the same order, as World_Unit::ComputeNextPosition.
+	for (u32 i = begin; i < end; ++i)
+	{
+		const f32 elapsedTime = m_elapsedTime[i];
+
+		// process jumping.
+		if (!is_approx_zero(m_forceZ[i]))
+		{
+			if (is_approx_zero(m_posZ[i]))
+			{
+				m_velZ[i] = UNIT_JUMP_VELOCITY;
+			}
+			m_forceZ[i] = 0.f;
+		}
+
+		const f32 vel0X = m_velX[i];
+		const f32 vel0Y = m_velY[i];
+		const f32 vel0Z = m_velZ[i];
+		const f32 mass = m_mass[i];
+		const f32 maxVelocity = m_maxVelocity[i];
+
+		const f32 forceCharX = m_forceX[i] * UNIT_FORCE_FACTOR;
+		const f32 forceCharY = m_forceY[i] * UNIT_FORCE_FACTOR;
+		const f32 forceCharZ = m_forceZ[i] * UNIT_FORCE_FACTOR;
+
+		const f32 velTotalSq = vel0X * vel0X + vel0Y * vel0Y + vel0Z * vel0Z;
+		const f32 forceResist = UNIT_FORCE_DAMPEN + (velTotalSq * UNIT_WIND_RESIST_FACTOR);
+		const f32 forceEnvX = forceResist * get_sign(vel0X) * -1.f;
+		const f32 forceEnvY = forceResist * get_sign(vel0Y) * -1.f;
+		const f32 forceEnvZ = (mass * UNIT_GRAVITY_FACTOR) * -1.f;
+
+		const f32 accelX = (forceCharX + forceEnvX) / mass;
+		const f32 accelY = (forceCharY + forceEnvY) / mass;
+		const f32 accelZ = (forceCharZ + forceEnvZ) / mass;
+
+		f32 vel1X = vel0X + (accelX * elapsedTime);
+		f32 vel1Y = vel0Y + (accelY * elapsedTime);
+		f32 vel1Z = vel0Z + (accelZ * elapsedTime);
+
+		// don't exceed max velocity, unless it's gravity.
+		const f32 vel1Sq = vel1X * vel1X + vel1Y * vel1Y + vel1Z * vel1Z;
+		if (vel1Sq > (maxVelocity * maxVelocity))
+		{
+			const f32 vel1Mag = static_cast<f32>(sqrt(vel1Sq));
+			vel1X = (vel1X / vel1Mag) * maxVelocity;
+			vel1Y = (vel1Y / vel1Mag) * maxVelocity;
+			if (!(vel1Z < 0.f))
+			{
+				vel1Z = (vel1Z / vel1Mag) * maxVelocity;
+			}
+		}
+
+		// stop rather than reverse once the driving force is gone.
+		if (is_approx_zero(forceCharX))
+		{
+			if (is_approx_zero(vel0X) || ((vel1X < 0.f) && (vel0X > 0.f)) || ((vel1X > 0.f) && (vel0X < 0.f)))
+				vel1X = 0.f;
+		}
+		if (is_approx_zero(forceCharY))
+		{
+			if (is_approx_zero(vel0Y) || ((vel1Y < 0.f) && (vel0Y > 0.f)) || ((vel1Y > 0.f) && (vel0Y < 0.f)))
+				vel1Y = 0.f;
+		}
+
+		f32 posX = m_posX[i] + (vel0X + ((vel1X - vel0X) * 0.5f)) * elapsedTime;
+		f32 posY = m_posY[i] + (vel0Y + ((vel1Y - vel0Y) * 0.5f)) * elapsedTime;
+		f32 posZ = m_posZ[i] + (vel0Z + ((vel1Z - vel0Z) * 0.5f)) * elapsedTime;
+
+		// can't go lower than 0.
+		if (posZ < 0.f)
+		{
+			posZ = 0.f;
+			vel1Z = 0.f;
+		}
+
+		m_nextPosX[i] = posX;
+		m_nextPosY[i] = posY;
+		m_nextPosZ[i] = posZ;
+		m_nextVelX[i] = vel1X;
+		m_nextVelY[i] = vel1Y;
+		m_nextVelZ[i] = vel1Z;
+	}
+}
+
+#if defined(TB8_INTEGRATOR_AVX)
+
+void World_Integrator::__IntegrateAVX(u32 count)
+{
+	// each step mirrors __IntegrateScalar, with branches turned into masks.  no fma, so rounding is identical.
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 negOne = _mm256_set1_ps(-1.f);
+	const __m256 forceFactor = _mm256_set1_ps(UNIT_FORCE_FACTOR);
+	const __m256 forceDampen = _mm256_set1_ps(UNIT_FORCE_DAMPEN);
+	const __m256 windResistFactor = _mm256_set1_ps(UNIT_WIND_RESIST_FACTOR);
+	const __m256 gravityFactor = _mm256_set1_ps(UNIT_GRAVITY_FACTOR);
+	const __m256 jumpVelocity = _mm256_set1_ps(UNIT_JUMP_VELOCITY);
+
+	for (u32 i = 0; i < count; i += INTEGRATOR_LANE_COUNT)
+	{
+		const __m256 posX = _mm256_loadu_ps(&m_posX[i]);
+		const __m256 posY = _mm256_loadu_ps(&m_posY[i]);
+		const __m256 posZ = _mm256_loadu_ps(&m_posZ[i]);
+		const __m256 forceX = _mm256_loadu_ps(&m_forceX[i]);
+		const __m256 forceY = _mm256_loadu_ps(&m_forceY[i]);
+		__m256 forceZ = _mm256_loadu_ps(&m_forceZ[i]);
+		const __m256 mass = _mm256_loadu_ps(&m_mass[i]);
+		const __m256 maxVelocity = _mm256_loadu_ps(&m_maxVelocity[i]);
+		const __m256 elapsed = _mm256_loadu_ps(&m_elapsedTime[i]);
+		const __m256 vel0X = _mm256_loadu_ps(&m_velX[i]);
+		const __m256 vel0Y = _mm256_loadu_ps(&m_velY[i]);
+		__m256 vel0Z = _mm256_loadu_ps(&m_velZ[i]);
+
+		// process jumping.
+		const __m256 isJumpForce = _mm256_andnot_ps(__IsApproxZero(forceZ), _mm256_castsi256_ps(_mm256_set1_epi32(-1)));
+		const __m256 isJump = _mm256_and_ps(isJumpForce, __IsApproxZero(posZ));
+		vel0Z = _mm256_blendv_ps(vel0Z, jumpVelocity, isJump);
+		forceZ = _mm256_blendv_ps(forceZ, zero, isJumpForce);
+		_mm256_storeu_ps(&m_velZ[i], vel0Z);
+		_mm256_storeu_ps(&m_forceZ[i], forceZ);
+
+		const __m256 forceCharX = _mm256_mul_ps(forceX, forceFactor);
+		const __m256 forceCharY = _mm256_mul_ps(forceY, forceFactor);
+		const __m256 forceCharZ = _mm256_mul_ps(forceZ, forceFactor);
+
+		const __m256 velTotalSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vel0X, vel0X), _mm256_mul_ps(vel0Y, vel0Y)), _mm256_mul_ps(vel0Z, vel0Z));
+		const __m256 forceResist = _mm256_add_ps(forceDampen, _mm256_mul_ps(velTotalSq, windResistFactor));
+		const __m256 forceEnvX = _mm256_mul_ps(_mm256_mul_ps(forceResist, __GetSign(vel0X)), negOne);
+		const __m256 forceEnvY = _mm256_mul_ps(_mm256_mul_ps(forceResist, __GetSign(vel0Y)), negOne);
+		const __m256 forceEnvZ = _mm256_mul_ps(_mm256_mul_ps(mass, gravityFactor), negOne);
+
+		const __m256 accelX = _mm256_div_ps(_mm256_add_ps(forceCharX, forceEnvX), mass);
+		const __m256 accelY = _mm256_div_ps(_mm256_add_ps(forceCharY, forceEnvY), mass);
+		const __m256 accelZ = _mm256_div_ps(_mm256_add_ps(forceCharZ, forceEnvZ), mass);
+
+		__m256 vel1X = _mm256_add_ps(vel0X, _mm256_mul_ps(accelX, elapsed));
+		__m256 vel1Y = _mm256_add_ps(vel0Y, _mm256_mul_ps(accelY, elapsed));
+		__m256 vel1Z = _mm256_add_ps(vel0Z, _mm256_mul_ps(accelZ, elapsed));
+
+		// don't exceed max velocity, unless it's gravity.
+		{
+			const __m256 vel1Sq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vel1X, vel1X), _mm256_mul_ps(vel1Y, vel1Y)), _mm256_mul_ps(vel1Z, vel1Z));
+			const __m256 isClamp = _mm256_cmp_ps(vel1Sq, _mm256_mul_ps(maxVelocity, maxVelocity), _CMP_GT_OQ);
+			const __m256 isClampZ = _mm256_andnot_ps(_mm256_cmp_ps(vel1Z, zero, _CMP_LT_OQ), isClamp);
+			const __m256 vel1Mag = _mm256_sqrt_ps(vel1Sq);
+			vel1X = _mm256_blendv_ps(vel1X, _mm256_mul_ps(_mm256_div_ps(vel1X, vel1Mag), maxVelocity), isClamp);
+			vel1Y = _mm256_blendv_ps(vel1Y, _mm256_mul_ps(_mm256_div_ps(vel1Y, vel1Mag), maxVelocity), isClamp);
+			vel1Z = _mm256_blendv_ps(vel1Z, _mm256_mul_ps(_mm256_div_ps(vel1Z, vel1Mag), maxVelocity), isClampZ);
+		}
+
+		// stop rather than reverse once the driving force is gone.
+		{
+			const __m256 isReverseX = _mm256_or_ps(
+				_mm256_and_ps(_mm256_cmp_ps(vel1X, zero, _CMP_LT_OQ), _mm256_cmp_ps(vel0X, zero, _CMP_GT_OQ)),
+				_mm256_and_ps(_mm256_cmp_ps(vel1X, zero, _CMP_GT_OQ), _mm256_cmp_ps(vel0X, zero, _CMP_LT_OQ)));
+			const __m256 isStopX = _mm256_and_ps(__IsApproxZero(forceCharX), _mm256_or_ps(__IsApproxZero(vel0X), isReverseX));
+			vel1X = _mm256_blendv_ps(vel1X, zero, isStopX);
+
+			const __m256 isReverseY = _mm256_or_ps(
+				_mm256_and_ps(_mm256_cmp_ps(vel1Y, zero, _CMP_LT_OQ), _mm256_cmp_ps(vel0Y, zero, _CMP_GT_OQ)),
+				_mm256_and_ps(_mm256_cmp_ps(vel1Y, zero, _CMP_GT_OQ), _mm256_cmp_ps(vel0Y, zero, _CMP_LT_OQ)));
+			const __m256 isStopY = _mm256_and_ps(__IsApproxZero(forceCharY), _mm256_or_ps(__IsApproxZero(vel0Y), isReverseY));
+			vel1Y = _mm256_blendv_ps(vel1Y, zero, isStopY);
+		}
+
+		const __m256 nextPosX = _mm256_add_ps(posX, _mm256_mul_ps(_mm256_add_ps(vel0X, _mm256_mul_ps(_mm256_sub_ps(vel1X, vel0X), half)), elapsed));
+		const __m256 nextPosY = _mm256_add_ps(posY, _mm256_mul_ps(_mm256_add_ps(vel0Y, _mm256_mul_ps(_mm256_sub_ps(vel1Y, vel0Y), half)), elapsed));
+		__m256 nextPosZ = _mm256_add_ps(posZ, _mm256_mul_ps(_mm256_add_ps(vel0Z, _mm256_mul_ps(_mm256_sub_ps(vel1Z, vel0Z), half)), elapsed));
+
+		// can't go lower than 0.
+		const __m256 isBelowFloor = _mm256_cmp_ps(nextPosZ, zero, _CMP_LT_OQ);
+		nextPosZ = _mm256_blendv_ps(nextPosZ, zero, isBelowFloor);
+		vel1Z = _mm256_blendv_ps(vel1Z, zero, isBelowFloor);
+
+		_mm256_storeu_ps(&m_nextPosX[i], nextPosX);
+		_mm256_storeu_ps(&m_nextPosY[i], nextPosY);
+		_mm256_storeu_ps(&m_nextPosZ[i], nextPosZ);
+		_mm256_storeu_ps(&m_nextVelX[i], vel1X);
+		_mm256_storeu_ps(&m_nextVelY[i], vel1Y);
+		_mm256_storeu_ps(&m_nextVelZ[i], vel1Z);
+	}
+}
+
+#else
+
+void World_Integrator::__IntegrateAVX(u32 count)
+{
+	__IntegrateScalar(0, count);
+}
+
+#endif
+
+}
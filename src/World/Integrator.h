@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+
+#include "Common/basic_types.h"
+
+namespace TB8
+{
+
+struct World_Unit;
+
+// proposed move for a unit this tick, before collisions are resolved.
+struct World_UnitMove
+{
+	Vector3							m_pos;
+	Vector3							m_vel;
+};
+
+// batched unit physics.
+//  unit state is gathered into SoA arrays (padded to the lane count), integrated 8 units at a time with AVX when the
+//  cpu supports it, and scattered back.  results match World_Unit::ComputeNextPosition bit for bit.
+class World_Integrator
+{
+public:
+	World_Integrator();
+
+	// <pFrameCounts> is the frames each unit advances.
+	void Integrate(const s32* pFrameCounts, World_Unit* const* ppUnits, u32 count, World_UnitMove* pMoves);
+
+	bool IsAVX() const { return m_isAVX; }
+	void SetAVX(bool isAVX);
+
+private:
+	void __Gather(const s32* pFrameCounts, World_Unit* const* ppUnits, u32 count);
+	void __Scatter(World_Unit* const* ppUnits, u32 count, World_UnitMove* pMoves) const;
+	void __IntegrateScalar(u32 begin, u32 end);
+	void __IntegrateAVX(u32 count);
+
+	bool							m_isAVX;
+
+	// input.
+	std::vector<f32>				m_posX;
+	std::vector<f32>				m_posY;
+	std::vector<f32>				m_posZ;
+	std::vector<f32>				m_velX;
+	std::vector<f32>				m_velY;
+	std::vector<f32>				m_velZ;		// written back, jumping sets it.
+	std::vector<f32>				m_forceX;
+	std::vector<f32>				m_forceY;
+	std::vector<f32>				m_forceZ;	// written back, jumping clears it.
+	std::vector<f32>				m_mass;
+	std::vector<f32>				m_maxVelocity;
+	std::vector<f32>				m_elapsedTime;
+
+	// output.
+	std::vector<f32>				m_nextPosX;
+	std::vector<f32>				m_nextPosY;
+	std::vector<f32>				m_nextPosZ;
+	std::vector<f32>				m_nextVelX;
+	std::vector<f32>				m_nextVelY;
+	std::vector<f32>				m_nextVelZ;
+};
+
+}
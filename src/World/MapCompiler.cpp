@@ -0,0 +1,412 @@
+#include "pch.h"
+
+#include "Common/file_io.h"
+#include "Common/string.h"
+
+#include "WallGrid.h"
+#include "MapStreamer.h"
+#include "MapFile.h"
+#include "MapCompiler.h"
+
+namespace TB8
+{
+
+World_MapCompiler::World_MapCompiler()
+	: m_size(0, 0)
+	, m_startPos(0.f, 0.f)
+{
+}
+
+bool World_MapCompiler::Compile(const char* pszSrcPath, const char* pszDstPath)
+{
+	TB8::File* f = TB8::File::AllocOpen(pszSrcPath, true);
+	if (!f)
+		return false;
+
+	World_MapCompiler compiler;
+	XML_Parser parser;
+	parser.SetHandlers(std::bind(&World_MapCompiler::__ParseMapStartElement, &compiler, std::placeholders::_1, std::placeholders::_2),
+						std::bind(&World_MapCompiler::__ParseMapCharacters, &compiler, std::placeholders::_1, std::placeholders::_2),
+						std::bind(&World_MapCompiler::__ParseMapEndElement, &compiler, std::placeholders::_1));
+	parser.SetReader(std::bind(__ParseMapRead, f, std::placeholders::_1, std::placeholders::_2));
+	const XML_Parser_Result result = parser.Parse();
+	f->Free();
+	if ((result == XML_Parser_Result_Error) || (compiler.m_size.x <= 0) || (compiler.m_size.y <= 0))
+		return false;
+
+	std::vector<u8> data;
+	compiler.Write(&data);
+
+	// written beside the destination and renamed over it, so a failed write doesn't leave a truncated map to load.
+	std::string tempPath = pszDstPath;
+	tempPath += ".tmp";
+	TB8::File* fDst = TB8::File::AllocCreate(tempPath.c_str());
+	if (!fDst)
+		return false;
+	const u32 written = fDst->Write(data.data(), static_cast<u32>(data.size()));
+	fDst->Free();
+	if ((written != data.size()) || !TB8::File::Rename(tempPath.c_str(), pszDstPath))
+	{
+		TB8::File::Delete(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+void World_MapCompiler::Write(std::vector<u8>* pData) const
+{
+	std::vector<u8>& data = *pData;
+	const IVector2 chunkCount((m_size.x + MAPSTREAM_CHUNK_SIZE - 1) / MAPSTREAM_CHUNK_SIZE, (m_size.y + MAPSTREAM_CHUNK_SIZE - 1) / MAPSTREAM_CHUNK_SIZE);
+	const u32 cellCount = MAPSTREAM_CHUNK_SIZE * MAPSTREAM_CHUNK_SIZE;
+
+	// models and their strings.
+	std::vector<char> strings;
+	std::vector<World_MapFile_Model> models(m_models.size());
+	for (u32 i = 0; i < m_models.size(); ++i)
+	{
+		models[i].m_id = m_models[i].m_id;
+		models[i].m_type = static_cast<World_MapFile_ModelType>(m_models[i].m_type);
+		models[i].m_path = __AddString(strings, m_models[i].m_path);
+		models[i].m_name = __AddString(strings, m_models[i].m_name);
+	}
+	if (strings.empty())
+	{
+		strings.push_back(0);
+	}
+
+	std::vector<World_MapFile_Spawn> spawns;
+	for (std::vector<Spawn>::const_iterator it = m_spawns.begin(); it != m_spawns.end(); ++it)
+	{
+		const u32 model = __GetModelIndex(it->m_modelID);
+		if (model == MAPFILE_MODEL_NONE)
+			continue;
+
+		World_MapFile_Spawn spawn;
+		spawn.m_model = model;
+		spawn.m_posX = it->m_pos.x;
+		spawn.m_posY = it->m_pos.y;
+		spawns.push_back(spawn);
+	}
+
+	// the tables go first, so their offsets are known before the chunks are laid out.
+	World_MapFile_Header header;
+	header.m_magic = MAPFILE_MAGIC;
+	header.m_version = MAPFILE_VERSION;
+	header.m_sizeX = m_size.x;
+	header.m_sizeY = m_size.y;
+	header.m_startX = m_startPos.x;
+	header.m_startY = m_startPos.y;
+	header.m_chunkSize = MAPSTREAM_CHUNK_SIZE;
+	header.m_modelCount = static_cast<u32>(models.size());
+	header.m_modelOffset = sizeof(World_MapFile_Header);
+	header.m_chunkCount = static_cast<u32>(chunkCount.x * chunkCount.y);
+	header.m_chunkOffset = header.m_modelOffset + (header.m_modelCount * sizeof(World_MapFile_Model));
+	header.m_spawnCount = static_cast<u32>(spawns.size());
+	header.m_spawnOffset = header.m_chunkOffset + (header.m_chunkCount * sizeof(World_MapFile_Chunk));
+	header.m_stringSize = static_cast<u32>(strings.size());
+	header.m_stringOffset = header.m_spawnOffset + (header.m_spawnCount * sizeof(World_MapFile_Spawn));
+	const u32 chunkDataOffset = (header.m_stringOffset + header.m_stringSize + 3) & ~3;
+
+	data.assign(chunkDataOffset, 0);
+	memcpy(data.data(), &header, sizeof(header));
+	if (!models.empty())
+	{
+		memcpy(data.data() + header.m_modelOffset, models.data(), models.size() * sizeof(World_MapFile_Model));
+	}
+	if (!spawns.empty())
+	{
+		memcpy(data.data() + header.m_spawnOffset, spawns.data(), spawns.size() * sizeof(World_MapFile_Spawn));
+	}
+	memcpy(data.data() + header.m_stringOffset, strings.data(), strings.size());
+
+	// each chunk's tiles, edges and walls together.
+	std::vector<u16> tiles(cellCount);
+	std::vector<u8> edges(cellCount);
+	std::vector<u16> walls;
+	IVector2 chunkPos;
+	for (chunkPos.y = 0; chunkPos.y < chunkCount.y; ++chunkPos.y)
+	{
+		for (chunkPos.x = 0; chunkPos.x < chunkCount.x; ++chunkPos.x)
+		{
+			walls.clear();
+			for (u32 i = 0; i < cellCount; ++i)
+			{
+				const IVector2 cell((chunkPos.x * MAPSTREAM_CHUNK_SIZE) + static_cast<s32>(i % MAPSTREAM_CHUNK_SIZE), (chunkPos.y * MAPSTREAM_CHUNK_SIZE) + static_cast<s32>(i / MAPSTREAM_CHUNK_SIZE));
+				tiles[i] = MAPFILE_MODEL_NONE;
+				edges[i] = World_WallGrid_Edge_None;
+				if ((cell.x >= m_size.x) || (cell.y >= m_size.y))
+					continue;
+
+				const u32 index = (cell.y * m_size.x) + cell.x;
+				tiles[i] = static_cast<u16>(__GetModelIndex(m_tiles[index]));
+				for (u32 bit = 0; bit < 4; ++bit)
+				{
+					if (!(m_edges[index] & (1 << bit)))
+						continue;
+					const u32 model = __GetModelIndex(m_walls[(index * 4) + bit]);
+					if (model == MAPFILE_MODEL_NONE)
+						continue;
+					edges[i] |= static_cast<u8>(1 << bit);
+					walls.push_back(static_cast<u16>(model));
+				}
+			}
+
+			World_MapFile_Chunk chunk;
+			chunk.m_tileOffset = static_cast<u32>(data.size());
+			chunk.m_edgeOffset = chunk.m_tileOffset + (cellCount * sizeof(u16));
+			chunk.m_wallOffset = chunk.m_edgeOffset + cellCount;
+			chunk.m_wallCount = static_cast<u32>(walls.size());
+			const u32 chunkEnd = (chunk.m_wallOffset + (chunk.m_wallCount * sizeof(u16)) + 3) & ~3;
+
+			data.resize(chunkEnd, 0);
+			memcpy(data.data() + chunk.m_tileOffset, tiles.data(), cellCount * sizeof(u16));
+			memcpy(data.data() + chunk.m_edgeOffset, edges.data(), cellCount);
+			if (!walls.empty())
+			{
+				memcpy(data.data() + chunk.m_wallOffset, walls.data(), walls.size() * sizeof(u16));
+			}
+
+			const u32 chunkIndex = (chunkPos.y * chunkCount.x) + chunkPos.x;
+			memcpy(data.data() + header.m_chunkOffset + (chunkIndex * sizeof(World_MapFile_Chunk)), &chunk, sizeof(chunk));
+		}
+	}
+}
+
+u32 World_MapCompiler::__GetModelIndex(u32 modelID) const
+{
+	if (modelID == 0)
+		return MAPFILE_MODEL_NONE;
+
+	for (u32 i = 0; i < m_models.size(); ++i)
+	{
+		if (m_models[i].m_id == modelID)
+			return i;
+	}
+	return MAPFILE_MODEL_NONE;
+}
+
+u32 World_MapCompiler::__AddString(std::vector<char>& strings, const std::string& str)
+{
+	const u32 offset = static_cast<u32>(strings.size());
+	strings.insert(strings.end(), str.begin(), str.end());
+	strings.push_back(0);
+	return offset;
+}
+
+void World_MapCompiler::__ParseMapStartElement(const char* pszName, const char** ppAttribs)
+{
+	if (_strcmpi(reinterpret_cast<const char*>(pszName), "model") == 0)
+	{
+		// models.
+		u32 id = 0;
+		const char* pszType = nullptr;
+		const char* pszPath = nullptr;
+		const char* pszModel = nullptr;
+
+		for (const char** ppAttrib = ppAttribs; ppAttrib && *ppAttrib; ppAttrib += 2)
+		{
+			const char* pszAttribName = *(ppAttrib + 0);
+			const char* pszValue = *(ppAttrib + 1);
+
+			if (_strcmpi(pszAttribName, "id") == 0)
+			{
+				id = atol(pszValue);
+			}
+			else if (_strcmpi(pszAttribName, "type") == 0)
+			{
+				pszType = pszValue;
+			}
+			else if (_strcmpi(pszAttribName, "path") == 0)
+			{
+				pszPath = pszValue;
+			}
+			else if (_strcmpi(pszAttribName, "model") == 0)
+			{
+				pszModel = pszValue;
+			}
+		}
+
+		// the model table is indexed by u16, MAPFILE_MODEL_NONE excluded.
+		if (id != 0 && pszType && pszPath && (m_models.size() < MAPFILE_MODEL_NONE) && (__GetModelIndex(id) == MAPFILE_MODEL_NONE))
+		{
+			Model model;
+			model.m_id = id;
+			model.m_path = pszPath;
+			model.m_name = pszModel ? pszModel : "";
+			if (_strcmpi(pszType, "texture") == 0)
+			{
+				model.m_type = World_MapFile_ModelType_Texture;
+				m_models.push_back(model);
+			}
+			else if ((_strcmpi(pszType, "dae") == 0) && pszModel)
+			{
+				model.m_type = World_MapFile_ModelType_DAE;
+				m_models.push_back(model);
+			}
+		}
+	}
+	if (_strcmpi(reinterpret_cast<const char*>(pszName), "size") == 0)
+	{
+		u32 defaultTile = 0;
+
+		for (const char** ppAttrib = ppAttribs; ppAttrib && *ppAttrib; ppAttrib += 2)
+		{
+			const char* pszAttribName = *(ppAttrib + 0);
+			const char* pszValue = *(ppAttrib + 1);
+
+			if (_strcmpi(pszAttribName, "x") == 0)
+			{
+				m_size.x = atol(pszValue);
+			}
+			else if (_strcmpi(pszAttribName, "y") == 0)
+			{
+				m_size.y = atol(pszValue);
+			}
+			else if (_strcmpi(pszAttribName, "default_tile") == 0)
+			{
+				defaultTile = atol(pszValue);
+			}
+		}
+
+		const u32 cellCount = static_cast<u32>(std::max(m_size.x, 0) * std::max(m_size.y, 0));
+		m_tiles.assign(cellCount, defaultTile);
+		m_edges.assign(cellCount, World_WallGrid_Edge_None);
+		m_walls.assign(cellCount * 4, 0);
+	}
+	if (_strcmpi(reinterpret_cast<const char*>(pszName), "start") == 0)
+	{
+		for (const char** ppAttrib = ppAttribs; ppAttrib && *ppAttrib; ppAttrib += 2)
+		{
+			const char* pszAttribName = *(ppAttrib + 0);
+			const char* pszValue = *(ppAttrib + 1);
+
+			if (_strcmpi(pszAttribName, "x") == 0)
+			{
+				m_startPos.x = static_cast<float>(atol(pszValue));
+			}
+			else if (_strcmpi(pszAttribName, "y") == 0)
+			{
+				m_startPos.y = static_cast<float>(atol(pszValue));
+			}
+		}
+	}
+	if (_strcmpi(reinterpret_cast<const char*>(pszName), "unit") == 0)
+	{
+		Spawn spawn;
+		spawn.m_modelID = 0;
+		spawn.m_pos = Vector2(0.f, 0.f);
+		for (const char** ppAttrib = ppAttribs; ppAttrib && *ppAttrib; ppAttrib += 2)
+		{
+			const char* pszAttribName = *(ppAttrib + 0);
+			const char* pszValue = *(ppAttrib + 1);
+
+			if (_strcmpi(pszAttribName, "model") == 0)
+			{
+				spawn.m_modelID = atol(pszValue);
+			}
+			else if (_strcmpi(pszAttribName, "pos") == 0)
+			{
+				std::vector<std::string> values;
+				StrTok(pszValue, " ,", &values);
+				if (values.size() == 2)
+				{
+					spawn.m_pos.x = static_cast<f32>(atof(values[0].c_str()));
+					spawn.m_pos.y = static_cast<f32>(atof(values[1].c_str()));
+				}
+			}
+		}
+
+		m_spawns.push_back(spawn);
+	}
+	if (_strcmpi(reinterpret_cast<const char*>(pszName), "cell") == 0)
+	{
+		// pos may come after the other attributes.
+		IVector2 pos;
+		u32 tile = 0;
+		bool isTile = false;
+		u32 walls[4] = { 0, 0, 0, 0 };
+		for (const char** ppAttrib = ppAttribs; ppAttrib && *ppAttrib; ppAttrib += 2)
+		{
+			const char* pszAttribName = *(ppAttrib + 0);
+			const char* pszValue = *(ppAttrib + 1);
+
+			if (_strcmpi(pszAttribName, "pos") == 0)
+			{
+				std::vector<std::string> values;
+				StrTok(pszValue, " ,", &values);
+				if (values.size() == 2)
+				{
+					pos.x = atol(values[0].c_str());
+					pos.y = atol(values[1].c_str());
+				}
+			}
+			else if (_strcmpi(pszAttribName, "tile") == 0)
+			{
+				tile = atol(pszValue);
+				isTile = true;
+			}
+			else if (_strcmpi(pszAttribName, "wall") == 0)
+			{
+				std::vector<std::string> values;
+				StrTok(pszValue, " ,", &values);
+				if (values.size() == 2)
+				{
+					u32 bit = 4;
+					if (_strcmpi(values[0].c_str(), "top") == 0)
+					{
+						bit = 0;
+					}
+					else if (_strcmpi(values[0].c_str(), "left") == 0)
+					{
+						bit = 1;
+					}
+					else if (_strcmpi(values[0].c_str(), "right") == 0)
+					{
+						bit = 2;
+					}
+					else if (_strcmpi(values[0].c_str(), "bottom") == 0)
+					{
+						bit = 3;
+					}
+
+					if (bit < 4)
+					{
+						walls[bit] = atol(values[1].c_str());
+					}
+				}
+			}
+		}
+
+		if ((pos.x < 0) || (pos.y < 0) || (pos.x >= m_size.x) || (pos.y >= m_size.y))
+			return;
+
+		const u32 index = (pos.y * m_size.x) + pos.x;
+		if (isTile)
+		{
+			m_tiles[index] = tile;
+		}
+		for (u32 bit = 0; bit < 4; ++bit)
+		{
+			if (walls[bit] == 0)
+				continue;
+			m_edges[index] |= static_cast<u8>(1 << bit);
+			m_walls[(index * 4) + bit] = walls[bit];
+		}
+	}
+}
+
+void World_MapCompiler::__ParseMapCharacters(const char* value, int len)
+{
+}
+
+void World_MapCompiler::__ParseMapEndElement(const char* name)
+{
+}
+
+XML_Parser_Result World_MapCompiler::__ParseMapRead(TB8::File* f, u8* pBuf, u32* pSize)
+{
+	*pSize = f->Read(pBuf, *pSize);
+	return (*pSize > 0) ? XML_Parser_Result_Success : XML_Parser_Result_EOF;
+}
+
+}
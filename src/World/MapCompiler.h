@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/basic_types.h"
+#include "Common/parse_xml.h"
+
+namespace TB8
+{
+
+class File;
+
+// compiles an xml map, the authoring format, to the binary format World::LoadMap() maps in.
+//  <model id= type= path= model=/>			texture or dae model.
+//  <size x= y= default_tile=/>				before any cell.
+//  <start x= y=/>
+//  <unit model= pos="x,y"/>
+//  <cell pos="x,y" tile= wall="side,model" .../>	side is top, left, right or bottom.
+class World_MapCompiler
+{
+public:
+	World_MapCompiler();
+
+	static bool Compile(const char* pszSrcPath, const char* pszDstPath);
+
+	// the compiled map, after parsing.
+	void Write(std::vector<u8>* pData) const;
+
+protected:
+	void __ParseMapStartElement(const char* pszName, const char** ppAttribs);
+	void __ParseMapCharacters(const char* value, int len);
+	void __ParseMapEndElement(const char* name);
+	static XML_Parser_Result __ParseMapRead(TB8::File* f, u8* pBuf, u32* pSize);
+
+	struct Model
+	{
+		u32							m_id;
+		u32							m_type;
+		std::string					m_path;
+		std::string					m_name;
+	};
+
+	struct Spawn
+	{
+		u32							m_modelID;
+		Vector2						m_pos;
+	};
+
+	u32 __GetModelIndex(u32 modelID) const;
+	static u32 __AddString(std::vector<char>& strings, const std::string& str);
+
+	std::vector<Model>				m_models;
+	IVector2						m_size;
+	Vector2							m_startPos;
+	std::vector<Spawn>				m_spawns;
+
+	// per cell, once the size is known.
+	std::vector<u32>				m_tiles;			// model id, 0 for none.
+	std::vector<u8>					m_edges;
+	std::vector<u32>				m_walls;			// model id per edge, 4 per cell in edge bit order.
+};
+
+}
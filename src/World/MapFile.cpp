@@ -0,0 +1,113 @@
+#include "pch.h"
+
+#include "WallGrid.h"
+#include "MapStreamer.h"
+#include "MapFile.h"
+
+namespace TB8
+{
+
+World_MapFile::World_MapFile()
+{
+	Close();
+}
+
+bool World_MapFile::Open(const u8* pData, u32 size)
+{
+	Close();
+	m_pData = pData;
+	m_size = size;
+
+	if (!__IsRange(0, sizeof(World_MapFile_Header)))
+		return false;
+	const World_MapFile_Header* pHeader = reinterpret_cast<const World_MapFile_Header*>(pData);
+	if ((pHeader->m_magic != MAPFILE_MAGIC) || (pHeader->m_version != MAPFILE_VERSION) || (pHeader->m_chunkSize != MAPSTREAM_CHUNK_SIZE))
+		return false;
+	if ((pHeader->m_sizeX <= 0) || (pHeader->m_sizeY <= 0))
+		return false;
+
+	// in 64 bits, any positive size's chunk count fits.
+	const u64 chunkCountX = (static_cast<u64>(pHeader->m_sizeX) + MAPSTREAM_CHUNK_SIZE - 1) / MAPSTREAM_CHUNK_SIZE;
+	const u64 chunkCountY = (static_cast<u64>(pHeader->m_sizeY) + MAPSTREAM_CHUNK_SIZE - 1) / MAPSTREAM_CHUNK_SIZE;
+	if (static_cast<u64>(pHeader->m_chunkCount) != (chunkCountX * chunkCountY))
+		return false;
+
+	// each count is checked against how many fit in the file before it's multiplied, so the sizes can't wrap.
+	if ((pHeader->m_modelCount > (size / sizeof(World_MapFile_Model))) || !__IsRange(pHeader->m_modelOffset, pHeader->m_modelCount * sizeof(World_MapFile_Model)))
+		return false;
+	if ((pHeader->m_chunkCount > (size / sizeof(World_MapFile_Chunk))) || !__IsRange(pHeader->m_chunkOffset, pHeader->m_chunkCount * sizeof(World_MapFile_Chunk)))
+		return false;
+	if ((pHeader->m_spawnCount > (size / sizeof(World_MapFile_Spawn))) || !__IsRange(pHeader->m_spawnOffset, pHeader->m_spawnCount * sizeof(World_MapFile_Spawn)))
+		return false;
+	if (!__IsRange(pHeader->m_stringOffset, pHeader->m_stringSize) || (pHeader->m_stringSize == 0) || (pData[pHeader->m_stringOffset + pHeader->m_stringSize - 1] != 0))
+		return false;
+
+	const World_MapFile_Model* pModels = reinterpret_cast<const World_MapFile_Model*>(pData + pHeader->m_modelOffset);
+	for (u32 i = 0; i < pHeader->m_modelCount; ++i)
+	{
+		if ((pModels[i].m_path >= pHeader->m_stringSize) || (pModels[i].m_name >= pHeader->m_stringSize))
+			return false;
+	}
+
+	const u32 cellCount = MAPSTREAM_CHUNK_SIZE * MAPSTREAM_CHUNK_SIZE;
+	const World_MapFile_Chunk* pChunks = reinterpret_cast<const World_MapFile_Chunk*>(pData + pHeader->m_chunkOffset);
+	for (u32 i = 0; i < pHeader->m_chunkCount; ++i)
+	{
+		const World_MapFile_Chunk& chunk = pChunks[i];
+		if (!__IsRange(chunk.m_tileOffset, cellCount * sizeof(u16)) || !__IsRange(chunk.m_edgeOffset, cellCount))
+			return false;
+		if ((chunk.m_wallCount > (cellCount * 4)) || !__IsRange(chunk.m_wallOffset, chunk.m_wallCount * sizeof(u16)))
+			return false;
+
+		// every edge bit has its wall.
+		u32 wallCount = 0;
+		const u8* pEdges = pData + chunk.m_edgeOffset;
+		for (u32 cell = 0; cell < cellCount; ++cell)
+		{
+			const u8 edges = pEdges[cell] & World_WallGrid_Edge_All;
+			wallCount += (edges & 1) + ((edges >> 1) & 1) + ((edges >> 2) & 1) + ((edges >> 3) & 1);
+		}
+		if (wallCount != chunk.m_wallCount)
+			return false;
+
+		const u16* pTiles = reinterpret_cast<const u16*>(pData + chunk.m_tileOffset);
+		for (u32 cell = 0; cell < cellCount; ++cell)
+		{
+			if ((pTiles[cell] != MAPFILE_MODEL_NONE) && (pTiles[cell] >= pHeader->m_modelCount))
+				return false;
+		}
+		const u16* pWalls = reinterpret_cast<const u16*>(pData + chunk.m_wallOffset);
+		for (u32 wall = 0; wall < chunk.m_wallCount; ++wall)
+		{
+			if (pWalls[wall] >= pHeader->m_modelCount)
+				return false;
+		}
+	}
+
+	const World_MapFile_Spawn* pSpawns = reinterpret_cast<const World_MapFile_Spawn*>(pData + pHeader->m_spawnOffset);
+	for (u32 i = 0; i < pHeader->m_spawnCount; ++i)
+	{
+		if (pSpawns[i].m_model >= pHeader->m_modelCount)
+			return false;
+	}
+
+	m_pHeader = pHeader;
+	m_pModels = pModels;
+	m_pChunks = pChunks;
+	m_pSpawns = pSpawns;
+	m_chunkCount = IVector2(static_cast<s32>(chunkCountX), static_cast<s32>(chunkCountY));
+	return true;
+}
+
+void World_MapFile::Close()
+{
+	m_pData = nullptr;
+	m_size = 0;
+	m_pHeader = nullptr;
+	m_pModels = nullptr;
+	m_pChunks = nullptr;
+	m_pSpawns = nullptr;
+	m_chunkCount = IVector2(0, 0);
+}
+
+}
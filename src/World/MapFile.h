@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Common/basic_types.h"
+
+namespace TB8
+{
+
+// compiled map, the runtime format.  maps are authored as xml and compiled by World_MapCompiler.
+//  the file is read in place, so everything is little endian and 4 byte aligned, and offsets are from the start of the
+//  file.  the map is cut into square chunks of MAPSTREAM_CHUNK_SIZE cells, each chunk's layers sit together so
+//  streaming a chunk in touches one run of the file.
+
+const u32 MAPFILE_MAGIC = 0x4d384254;		// "TB8M".
+const u32 MAPFILE_VERSION = 1;
+const u16 MAPFILE_MODEL_NONE = 0xffff;
+const char* const MAPFILE_EXTENSION = ".tb8map";
+
+enum World_MapFile_ModelType : u32
+{
+	World_MapFile_ModelType_Texture,
+	World_MapFile_ModelType_DAE,
+};
+
+struct World_MapFile_Header
+{
+	u32							m_magic;
+	u32							m_version;
+	s32							m_sizeX;			// cells.
+	s32							m_sizeY;
+	f32							m_startX;
+	f32							m_startY;
+	u32							m_chunkSize;		// cells along a side.
+	u32							m_modelCount;
+	u32							m_modelOffset;		// World_MapFile_Model[m_modelCount].
+	u32							m_chunkCount;
+	u32							m_chunkOffset;		// World_MapFile_Chunk[m_chunkCount], rows of chunks.
+	u32							m_spawnCount;
+	u32							m_spawnOffset;		// World_MapFile_Spawn[m_spawnCount].
+	u32							m_stringSize;
+	u32							m_stringOffset;		// nul terminated strings.
+};
+
+struct World_MapFile_Model
+{
+	u32							m_id;				// id in the xml.
+	World_MapFile_ModelType		m_type;
+	u32							m_path;				// offsets in the string table.
+	u32							m_name;
+};
+
+// layers of one chunk, each a full chunk even where it hangs off the map.  cells are in rows.
+struct World_MapFile_Chunk
+{
+	u32							m_tileOffset;		// u16 model index per cell, or MAPFILE_MODEL_NONE.
+	u32							m_edgeOffset;		// u8 World_WallGrid_Edge mask per cell.
+	u32							m_wallOffset;		// u16 model index per wall, by cell then edge bit.
+	u32							m_wallCount;
+};
+
+struct World_MapFile_Spawn
+{
+	u32							m_model;			// model index.
+	f32							m_posX;
+	f32							m_posY;
+};
+
+// checked view of a compiled map in memory.
+class World_MapFile
+{
+public:
+	World_MapFile();
+
+	// false if the data isn't a compiled map of this version, or any table runs past its end.
+	bool Open(const u8* pData, u32 size);
+	void Close();
+
+	IVector2 GetSize() const { return IVector2(m_pHeader->m_sizeX, m_pHeader->m_sizeY); }
+	Vector2 GetStartPos() const { return Vector2(m_pHeader->m_startX, m_pHeader->m_startY); }
+	IVector2 GetChunkCount() const { return m_chunkCount; }
+
+	u32 GetModelCount() const { return m_pHeader->m_modelCount; }
+	const World_MapFile_Model& GetModel(u32 model) const { return m_pModels[model]; }
+	const char* GetString(u32 offset) const { return reinterpret_cast<const char*>(m_pData + m_pHeader->m_stringOffset + offset); }
+
+	const u16* GetChunkTiles(const IVector2& chunkPos) const { return reinterpret_cast<const u16*>(m_pData + __GetChunk(chunkPos).m_tileOffset); }
+	const u8* GetChunkEdges(const IVector2& chunkPos) const { return m_pData + __GetChunk(chunkPos).m_edgeOffset; }
+	const u16* GetChunkWalls(const IVector2& chunkPos) const { return reinterpret_cast<const u16*>(m_pData + __GetChunk(chunkPos).m_wallOffset); }
+
+	u32 GetSpawnCount() const { return m_pHeader->m_spawnCount; }
+	const World_MapFile_Spawn& GetSpawn(u32 spawn) const { return m_pSpawns[spawn]; }
+
+private:
+	const World_MapFile_Chunk& __GetChunk(const IVector2& chunkPos) const { return m_pChunks[(chunkPos.y * m_chunkCount.x) + chunkPos.x]; }
+	bool __IsRange(u32 offset, u32 size) const { return (offset <= m_size) && (size <= (m_size - offset)) && ((offset & 3) == 0); }
+
+	const u8*						m_pData;
+	u32								m_size;
+	const World_MapFile_Header*		m_pHeader;
+	const World_MapFile_Model*		m_pModels;
+	const World_MapFile_Chunk*		m_pChunks;
+	const World_MapFile_Spawn*		m_pSpawns;
+	IVector2						m_chunkCount;
+};
+
+}
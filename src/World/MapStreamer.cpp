@@ -0,0 +1,325 @@
+#include "pch.h"
+
+#include "Object.h"
+#include "MapStreamer.h"
+
+namespace TB8
+{
+
+const f32 MAPSTREAM_LOAD_DIST = 48.f;				// meters from the focus to the nearest point of a chunk.
+const f32 MAPSTREAM_UNLOAD_DIST = 80.f;
+const u32 MAPSTREAM_MEMORY_BUDGET = 16 * 1024 * 1024;
+
+void World_MapStreamer_Metrics::Clear()
+{
+	m_residentCount = 0;
+	m_loadingCount = 0;
+	m_memorySize = 0;
+	m_loadCount = 0;
+	m_evictCount = 0;
+}
+
+World_MapStreamer::World_MapStreamer()
+	: m_isShutdown(false)
+{
+}
+
+World_MapStreamer::~World_MapStreamer()
+{
+	// the world stops the streamer before it frees its objects, this only covers a streamer that never started.
+	assert(!m_thread.joinable());
+}
+
+void World_MapStreamer::Start(const IVector2& mapSize, const World_MapStreamer_BuildFn& build, const World_MapStreamer_AttachFn& attach)
+{
+	assert(!m_thread.joinable());
+
+	m_mapSize = mapSize;
+	m_chunkCount = IVector2((mapSize.x + MAPSTREAM_CHUNK_SIZE - 1) / MAPSTREAM_CHUNK_SIZE, (mapSize.y + MAPSTREAM_CHUNK_SIZE - 1) / MAPSTREAM_CHUNK_SIZE);
+	m_chunks.clear();
+	m_chunks.resize(m_chunkCount.x * m_chunkCount.y);
+	for (std::vector<Chunk>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+	{
+		it->m_state = World_MapChunk_State_Unloaded;
+		it->m_memorySize = 0;
+	}
+	m_resident.clear();
+	m_build = build;
+	m_attach = attach;
+
+	m_requests.clear();
+	m_results.clear();
+	m_isShutdown = false;
+	m_metrics.Clear();
+
+	m_thread = std::thread(&World_MapStreamer::__ThreadMain, this);
+}
+
+void World_MapStreamer::Stop(World_ObjectMap& objects)
+{
+	if (!m_thread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isShutdown = true;
+		m_requests.clear();
+	}
+	m_wake.notify_all();
+	m_thread.join();
+
+	// built but never linked.
+	for (std::vector<std::pair<u32, std::vector<World_Object*>>>::iterator it = m_results.begin(); it != m_results.end(); ++it)
+	{
+		for (std::vector<World_Object*>::iterator itObj = it->second.begin(); itObj != it->second.end(); ++itObj)
+		{
+			OBJFREE(*itObj);
+		}
+	}
+	m_results.clear();
+
+	while (!m_resident.empty())
+	{
+		__Evict(m_resident.back(), objects);
+	}
+	m_chunks.clear();
+	m_build = nullptr;
+}
+
+void World_MapStreamer::Update(const Vector2& focus, World_ObjectMap& objects, bool isWait)
+{
+	if (m_chunks.empty())
+		return;
+
+	// chunks in the load distance that aren't resident or on their way.
+	const s32 reach = static_cast<s32>(std::ceil(MAPSTREAM_LOAD_DIST / static_cast<f32>(MAPSTREAM_CHUNK_SIZE)));
+	const IVector2 focusChunk(static_cast<s32>(std::floor(focus.x / static_cast<f32>(MAPSTREAM_CHUNK_SIZE))), static_cast<s32>(std::floor(focus.y / static_cast<f32>(MAPSTREAM_CHUNK_SIZE))));
+	const IVector2 chunkMin(std::max(focusChunk.x - reach, 0), std::max(focusChunk.y - reach, 0));
+	const IVector2 chunkMax(std::min(focusChunk.x + reach, m_chunkCount.x - 1), std::min(focusChunk.y + reach, m_chunkCount.y - 1));
+	std::vector<u32> requests;
+	IVector2 chunkPos;
+	for (chunkPos.y = chunkMin.y; chunkPos.y <= chunkMax.y; ++chunkPos.y)
+	{
+		for (chunkPos.x = chunkMin.x; chunkPos.x <= chunkMax.x; ++chunkPos.x)
+		{
+			const u32 chunk = __GetChunkIndex(chunkPos);
+			if (m_chunks[chunk].m_state != World_MapChunk_State_Unloaded)
+				continue;
+			if (__GetChunkDistSq(chunk, focus) > (MAPSTREAM_LOAD_DIST * MAPSTREAM_LOAD_DIST))
+				continue;
+			m_chunks[chunk].m_state = World_MapChunk_State_Loading;
+			requests.push_back(chunk);
+		}
+	}
+
+	std::vector<std::pair<u32, std::vector<World_Object*>>> results;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_focus = focus;
+
+		// drop queued chunks the focus has left behind.
+		for (u32 i = 0; i < m_requests.size(); )
+		{
+			if (__GetChunkDistSq(m_requests[i], focus) > (MAPSTREAM_UNLOAD_DIST * MAPSTREAM_UNLOAD_DIST))
+			{
+				m_chunks[m_requests[i]].m_state = World_MapChunk_State_Unloaded;
+				m_requests[i] = m_requests.back();
+				m_requests.pop_back();
+				continue;
+			}
+			++i;
+		}
+
+		m_requests.insert(m_requests.end(), requests.begin(), requests.end());
+		results.swap(m_results);
+	}
+	if (!requests.empty())
+	{
+		m_wake.notify_one();
+	}
+
+	for (;;)
+	{
+		for (std::vector<std::pair<u32, std::vector<World_Object*>>>::iterator it = results.begin(); it != results.end(); ++it)
+		{
+			__Link(it->first, it->second, objects);
+		}
+		results.clear();
+
+		if (!isWait)
+			break;
+
+		// keep going until everything in the load distance is in.
+		bool isPending = false;
+		for (chunkPos.y = chunkMin.y; !isPending && (chunkPos.y <= chunkMax.y); ++chunkPos.y)
+		{
+			for (chunkPos.x = chunkMin.x; !isPending && (chunkPos.x <= chunkMax.x); ++chunkPos.x)
+			{
+				isPending = m_chunks[__GetChunkIndex(chunkPos)].m_state == World_MapChunk_State_Loading;
+			}
+		}
+		if (!isPending)
+			break;
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this]() { return !m_results.empty(); });
+		results.swap(m_results);
+	}
+
+	// evict past the unload distance, then furthest first while over budget.
+	for (u32 i = 0; i < m_resident.size(); )
+	{
+		const u32 chunk = m_resident[i];
+		if (__GetChunkDistSq(chunk, focus) > (MAPSTREAM_UNLOAD_DIST * MAPSTREAM_UNLOAD_DIST))
+		{
+			__Evict(chunk, objects);
+			continue;
+		}
+		++i;
+	}
+
+	while (m_metrics.m_memorySize > MAPSTREAM_MEMORY_BUDGET)
+	{
+		u32 chunkFar = UINT_MAX;
+		f32 distSqFar = MAPSTREAM_LOAD_DIST * MAPSTREAM_LOAD_DIST;
+		for (std::vector<u32>::const_iterator it = m_resident.begin(); it != m_resident.end(); ++it)
+		{
+			const f32 distSq = __GetChunkDistSq(*it, focus);
+			if (distSq > distSqFar)
+			{
+				distSqFar = distSq;
+				chunkFar = *it;
+			}
+		}
+
+		// what's in the load distance stays, the budget has to cover it.
+		if (chunkFar == UINT_MAX)
+			break;
+		__Evict(chunkFar, objects);
+	}
+
+	m_metrics.m_residentCount = static_cast<u32>(m_resident.size());
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_metrics.m_loadingCount = static_cast<u32>(m_requests.size());
+	}
+}
+
+bool World_MapStreamer::IsCellResident(const IVector2& cell) const
+{
+	if (m_chunks.empty())
+		return false;
+
+	// nothing streams off the map.
+	if ((cell.x < 0) || (cell.y < 0) || (cell.x >= m_mapSize.x) || (cell.y >= m_mapSize.y))
+		return true;
+
+	const IVector2 chunkPos(cell.x / MAPSTREAM_CHUNK_SIZE, cell.y / MAPSTREAM_CHUNK_SIZE);
+	return m_chunks[__GetChunkIndex(chunkPos)].m_state == World_MapChunk_State_Resident;
+}
+
+f32 World_MapStreamer::__GetChunkDistSq(u32 chunk, const Vector2& pos) const
+{
+	// cells are a meter.
+	const IVector2 chunkPos(static_cast<s32>(chunk) % m_chunkCount.x, static_cast<s32>(chunk) / m_chunkCount.x);
+	const Vector2 min(static_cast<f32>(chunkPos.x * MAPSTREAM_CHUNK_SIZE), static_cast<f32>(chunkPos.y * MAPSTREAM_CHUNK_SIZE));
+	const Vector2 max(min.x + static_cast<f32>(MAPSTREAM_CHUNK_SIZE), min.y + static_cast<f32>(MAPSTREAM_CHUNK_SIZE));
+	const Vector2 nearest(std::min(std::max(pos.x, min.x), max.x), std::min(std::max(pos.y, min.y), max.y));
+	return (nearest - pos).MagSq();
+}
+
+void World_MapStreamer::__Link(u32 chunk, std::vector<World_Object*>& objects, World_ObjectMap& objectMap)
+{
+	Chunk& c = m_chunks[chunk];
+	assert(c.m_state == World_MapChunk_State_Loading);
+
+	m_attach(objects);
+	c.m_objects.swap(objects);
+	c.m_links.clear();
+	c.m_links.reserve(c.m_objects.size());
+	for (std::vector<World_Object*>::const_iterator it = c.m_objects.begin(); it != c.m_objects.end(); ++it)
+	{
+		const World_Object* pObj = *it;
+		const IVector2 cell(static_cast<s32>(pObj->m_pos.x), static_cast<s32>(pObj->m_pos.y));
+		c.m_links.push_back(objectMap.insert(std::make_pair(cell, *it)));
+	}
+
+	// the object, its map node, and its link.
+	c.m_memorySize = static_cast<u32>(c.m_objects.size() * (sizeof(World_Object) + sizeof(World_ObjectMap::value_type) + (4 * sizeof(void*)) + sizeof(World_ObjectMap::iterator) + sizeof(World_Object*)));
+	c.m_state = World_MapChunk_State_Resident;
+
+	m_resident.push_back(chunk);
+	m_metrics.m_memorySize += c.m_memorySize;
+	++m_metrics.m_loadCount;
+}
+
+void World_MapStreamer::__Evict(u32 chunk, World_ObjectMap& objects)
+{
+	Chunk& c = m_chunks[chunk];
+	assert(c.m_state == World_MapChunk_State_Resident);
+
+	for (std::vector<World_ObjectMap::iterator>::const_iterator it = c.m_links.begin(); it != c.m_links.end(); ++it)
+	{
+		objects.erase(*it);
+	}
+	for (std::vector<World_Object*>::iterator it = c.m_objects.begin(); it != c.m_objects.end(); ++it)
+	{
+		OBJFREE(*it);
+	}
+
+	// release the memory, not just the contents.
+	std::vector<World_Object*>().swap(c.m_objects);
+	std::vector<World_ObjectMap::iterator>().swap(c.m_links);
+
+	m_metrics.m_memorySize -= c.m_memorySize;
+	c.m_memorySize = 0;
+	c.m_state = World_MapChunk_State_Unloaded;
+
+	m_resident.erase(std::find(m_resident.begin(), m_resident.end(), chunk));
+	++m_metrics.m_evictCount;
+}
+
+void World_MapStreamer::__ThreadMain()
+{
+	for (;;)
+	{
+		u32 chunk = 0;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this]() { return m_isShutdown || !m_requests.empty(); });
+			if (m_isShutdown)
+				return;
+
+			// nearest the focus first.
+			u32 best = 0;
+			f32 bestDistSq = FLT_MAX;
+			for (u32 i = 0; i < m_requests.size(); ++i)
+			{
+				const f32 distSq = __GetChunkDistSq(m_requests[i], m_focus);
+				if (distSq < bestDistSq)
+				{
+					bestDistSq = distSq;
+					best = i;
+				}
+			}
+			chunk = m_requests[best];
+			m_requests[best] = m_requests.back();
+			m_requests.pop_back();
+		}
+
+		const IVector2 chunkPos(static_cast<s32>(chunk) % m_chunkCount.x, static_cast<s32>(chunk) / m_chunkCount.x);
+		const IVector2 cellMin(chunkPos.x * MAPSTREAM_CHUNK_SIZE, chunkPos.y * MAPSTREAM_CHUNK_SIZE);
+		const IVector2 cellMax(std::min(cellMin.x + MAPSTREAM_CHUNK_SIZE, m_mapSize.x), std::min(cellMin.y + MAPSTREAM_CHUNK_SIZE, m_mapSize.y));
+		std::vector<World_Object*> objects;
+		m_build(cellMin, cellMax, &objects);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_results.push_back(std::make_pair(chunk, std::vector<World_Object*>()));
+			m_results.back().second.swap(objects);
+		}
+		m_done.notify_all();
+	}
+}
+
+}
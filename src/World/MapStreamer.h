@@ -0,0 +1,107 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Common/basic_types.h"
+
+namespace TB8
+{
+
+struct World_Object;
+
+typedef std::multimap<IVector2, World_Object*> World_ObjectMap;
+
+const s32 MAPSTREAM_CHUNK_SIZE = 16;				// cells.
+
+// builds the objects of the chunk covering [cellMin, cellMax).  runs on the streaming thread, so it may only read data
+//  that doesn't change while the map is loaded.
+typedef std::function<void(const IVector2& cellMin, const IVector2& cellMax, std::vector<World_Object*>* pObjects)> World_MapStreamer_BuildFn;
+// finishes a built chunk's objects on the main thread, just before they're linked.  anything that reads the renderer
+//  goes here.
+typedef std::function<void(std::vector<World_Object*>& objects)> World_MapStreamer_AttachFn;
+
+enum World_MapChunk_State : u8
+{
+	World_MapChunk_State_Unloaded,
+	World_MapChunk_State_Loading,		// queued for, or on, the streaming thread.
+	World_MapChunk_State_Resident,
+};
+
+struct World_MapStreamer_Metrics
+{
+	World_MapStreamer_Metrics() { Clear(); }
+	void Clear();
+
+	u32						m_residentCount;		// chunks.
+	u32						m_loadingCount;
+	u32						m_memorySize;			// bytes held by resident chunks.
+	u32						m_loadCount;			// chunks made resident since the last Clear().
+	u32						m_evictCount;
+};
+
+// streams the map's objects in square chunks around a focus point.
+//  chunks within the load distance are queued nearest first and built on a streaming thread, then linked into the
+//  world's object map on the main thread.  chunks are only evicted past the larger unload distance, so a focus moving
+//  back and forth over a border doesn't thrash, or when resident chunks outgrow the memory budget, furthest first.
+//  walls stay in the resident wall grid, only their models and collision boxes stream.
+class World_MapStreamer
+{
+public:
+	World_MapStreamer();
+	~World_MapStreamer();
+
+	void Start(const IVector2& mapSize, const World_MapStreamer_BuildFn& build, const World_MapStreamer_AttachFn& attach);
+
+	// stops the thread and unlinks and frees every chunk's objects.
+	void Stop(World_ObjectMap& objects);
+
+	// queues chunks near <focus>, links built chunks and evicts.  <isWait> blocks until every chunk in the load
+	//  distance is resident.
+	void Update(const Vector2& focus, World_ObjectMap& objects, bool isWait);
+
+	// cells off the map count as resident, there's nothing to wait for.
+	bool IsCellResident(const IVector2& cell) const;
+
+	const World_MapStreamer_Metrics& GetMetrics() const { return m_metrics; }
+
+private:
+	struct Chunk
+	{
+		World_MapChunk_State				m_state;
+		std::vector<World_Object*>			m_objects;
+		std::vector<World_ObjectMap::iterator>	m_links;		// each object's entry in the world's object map.
+		u32									m_memorySize;
+	};
+
+	u32 __GetChunkIndex(const IVector2& chunkPos) const { return static_cast<u32>((chunkPos.y * m_chunkCount.x) + chunkPos.x); }
+	f32 __GetChunkDistSq(u32 chunk, const Vector2& pos) const;
+	void __Link(u32 chunk, std::vector<World_Object*>& objects, World_ObjectMap& objectMap);
+	void __Evict(u32 chunk, World_ObjectMap& objects);
+	void __ThreadMain();
+
+	IVector2							m_mapSize;
+	IVector2							m_chunkCount;
+	std::vector<Chunk>					m_chunks;
+	std::vector<u32>					m_resident;
+	World_MapStreamer_BuildFn			m_build;
+	World_MapStreamer_AttachFn			m_attach;
+
+	// shared with the streaming thread.
+	std::thread							m_thread;
+	std::mutex							m_mutex;
+	std::condition_variable				m_wake;				// the thread waits for requests.
+	std::condition_variable				m_done;				// a blocking Update() waits for results.
+	std::vector<u32>					m_requests;
+	std::vector<std::pair<u32, std::vector<World_Object*>>>	m_results;
+	Vector2								m_focus;
+	bool								m_isShutdown;
+
+	World_MapStreamer_Metrics			m_metrics;
+};
+
+}
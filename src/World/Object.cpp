@@ -1,9 +1,6 @@
 #include "pch.h"
 
-#include "common/memory.h"
-
-#include "render/RenderModel.h"
-#include "render/RenderMain.h"
+#include "Common/memory.h"
 
 #include "Bounds.h"
 #include "Object.h"
@@ -27,6 +24,28 @@ void World_Object::Init()
 	__ComputeModelBaseCenterAndSize();
 	__ComputeModelWorldLocalTransform();
 	ComputeBounds();
+
+	StorePrevState();
+	ComputeRenderState(1.f);
+}
+
+void World_Object::StorePrevState()
+{
+	m_posPrev = m_pos;
+	m_rotationPrev = m_rotation;
+}
+
+void World_Object::ComputeRenderState(f32 alpha)
+{
+	m_renderPos = m_posPrev + ((m_pos - m_posPrev) * alpha);
+
+	// turn the short way round.
+	f32 rotationDelta = m_rotation - m_rotationPrev;
+	while (rotationDelta > 180.f)
+		rotationDelta -= 360.f;
+	while (rotationDelta < -180.f)
+		rotationDelta += 360.f;
+	m_renderRotation = m_rotationPrev + (rotationDelta * alpha);
 }
 
 void World_Object::Render2D(const Vector3& screenWorldPos)
@@ -37,10 +56,10 @@ void World_Object::Render3D(const Vector3& screenWorldPos)
 {
 	// rotate it.
 	Matrix4 matrixRotate;
-	matrixRotate.SetRotate(Vector3(0.f, 0.f, DirectX::XM_PI * (m_rotation) / 180.f));
+	matrixRotate.SetRotate(Vector3(0.f, 0.f, PI * (m_renderRotation) / 180.f));
 
 	// position it.
-	Vector3 renderPos = m_pos - screenWorldPos;
+	Vector3 renderPos = m_renderPos - screenWorldPos;
 
 	Matrix4 matrixPosition;
 	matrixPosition.SetTranslation(renderPos);
@@ -50,40 +69,39 @@ void World_Object::Render3D(const Vector3& screenWorldPos)
 	worldTransform = Matrix4::MultiplyAB(worldTransform, matrixRotate);
 	worldTransform = Matrix4::MultiplyAB(worldTransform, m_worldLocalTransform);
 
-	m_pModel->SetWorldTransform(worldTransform);
-	m_pModel->Render(__GetRenderer());
+	m_pModel->Render(worldTransform, m_pose);
 }
 
 void World_Object::__ComputeModelBaseCenterAndSize()
 {
-	const std::vector<RenderModel_Mesh>& meshes = m_pModel->GetMeshes();
-	assert(!meshes.empty());
-	const RenderModel_Mesh& mesh = meshes.front();
+	const World_RenderModel_Bounds& bounds = m_pModel->GetBounds();
 
-	m_size = m_pModel->GetSize();
-	m_center = m_pModel->GetCenter();
+	m_size = bounds.m_size;
+	m_center = bounds.m_center;
 	m_offset.y = (m_size.y / 2.f);
 }
 
 void World_Object::__ComputeModelAnimCenterAndSize(s32 animID)
 {
-	const RenderModel_Anim* pAnim = m_pModel->GetAnim(animID);
+	const World_RenderModel_Bounds* pAnimBounds = m_pModel->GetAnimBounds(animID);
+	const World_RenderModel_Bounds& bounds = pAnimBounds ? *pAnimBounds : m_pModel->GetBounds();
 
-	m_size = pAnim->m_bounds.m_size;
-	m_center.y = pAnim->m_bounds.m_center.y;
-	m_offset.y = (pAnim->m_bounds.m_size.y / 2);
+	m_size = bounds.m_size;
+	m_center.y = bounds.m_center.y;
+	m_offset.y = (bounds.m_size.y / 2);
 }
 
 void World_Object::__InterpolateCenterAndSize(s32 animID0, s32 animID1, f32 t)
 {
-	const RenderModel_Anim* pAnimA = m_pModel->GetAnim(animID0);
-	const RenderModel_Anim* pAnimB = m_pModel->GetAnim(animID1);
+	const World_RenderModel_Bounds* pAnimA = m_pModel->GetAnimBounds(animID0);
+	const World_RenderModel_Bounds* pAnimB = m_pModel->GetAnimBounds(animID1);
+	const World_RenderModel_Bounds& bounds = m_pModel->GetBounds();
 
-	const Vector3& centerA = pAnimA ? pAnimA->m_bounds.m_center : m_pModel->GetCenter();
-	const Vector3& centerB = pAnimB ? pAnimB->m_bounds.m_center : m_pModel->GetCenter();
+	const Vector3& centerA = pAnimA ? pAnimA->m_center : bounds.m_center;
+	const Vector3& centerB = pAnimB ? pAnimB->m_center : bounds.m_center;
 
-	const Vector3& sizeA = pAnimA ? pAnimA->m_bounds.m_size : m_pModel->GetSize();
-	const Vector3& sizeB = pAnimB ? pAnimB->m_bounds.m_size : m_pModel->GetSize();
+	const Vector3& sizeA = pAnimA ? pAnimA->m_size : bounds.m_size;
+	const Vector3& sizeB = pAnimB ? pAnimB->m_size : bounds.m_size;
 
 	const Vector3 center = (centerA * (1.f - t)) + (centerB * t);
 	const Vector3 size = (sizeA * (1.f - t)) + (sizeB * t);
@@ -95,17 +113,13 @@ void World_Object::__InterpolateCenterAndSize(s32 animID0, s32 animID1, f32 t)
 
 void World_Object::__ComputeModelWorldLocalTransform()
 {
-	const std::vector<RenderModel_Mesh>& meshes = m_pModel->GetMeshes();
-	assert(!meshes.empty());
-	const RenderModel_Mesh& mesh = meshes.front();
-
 	// center it and apply offset, still in directX coords.
 	Matrix4 matrixCenter;
 	matrixCenter.SetTranslation(Vector3(-m_center.x, -m_center.y, -m_center.z));
 
 	// align size of the model.
 	Vector3 sizeAligned = m_size * m_scale;
-	__GetRenderer()->AlignWorldSize(sizeAligned);
+	__GetWorldRender()->AlignWorldSize(sizeAligned);
 
 	// scale it.
 	const Vector3 scale(is_approx_zero(m_size.x) ? 1.f : (sizeAligned.x / m_size.x),
@@ -135,48 +149,16 @@ void World_Object::__ComputeModelWorldLocalTransform()
 
 void World_Object::__SetAnim(s32 animID)
 {
-	for (u32 iJoint = 0; iJoint < m_pModel->GetJointCount(); ++iJoint)
-	{
-		const RenderModel_Anim_Joint* pJointAnimA = m_pModel->GetAnimJoint(animID, iJoint);
-		const RenderModel_Joint* pJoint = m_pModel->GetJoint(iJoint);
-		m_pModel->SetJointTransformMatrix(iJoint, pJointAnimA ? pJointAnimA->m_transform : pJoint->m_baseMatrix);
-	}
+	m_pose.m_animID0 = animID;
+	m_pose.m_animID1 = animID;
+	m_pose.m_t = 0.f;
 }
 
 void World_Object::__InterpolateAnims(s32 animID0, s32 animID1, f32 t)
 {
-	for (u32 iJoint = 0; iJoint < m_pModel->GetJointCount(); ++iJoint)
-	{
-		const RenderModel_Anim_Joint* pJointAnimA = m_pModel->GetAnimJoint(animID0, iJoint);
-		const RenderModel_Anim_Joint* pJointAnimB = m_pModel->GetAnimJoint(animID1, iJoint);
-		const RenderModel_Joint* pJoint = m_pModel->GetJoint(iJoint);
-		if (!pJointAnimA && !pJointAnimB)
-		{
-			m_pModel->SetJointTransformMatrix(iJoint, pJoint->m_baseMatrix);
-		}
-		else
-		{
-			const Matrix4& matrixA = pJointAnimA ? pJointAnimA->m_transform : pJoint->m_baseMatrix;
-			const Matrix4& matrixB = pJointAnimB ? pJointAnimB->m_transform : pJoint->m_baseMatrix;
-
-			const Vector4 qA = Matrix4::ToQuaternion(matrixA);
-			const Vector4 qB = Matrix4::ToQuaternion(matrixB);
-
-			const Vector4 qR = Vector4::SLERP(qA, qB, t);
-
-			Matrix4 matrixC = Matrix4::FromQuaternion(qR);
-
-			Vector3 posA;
-			Vector3 posB;
-			matrixA.GetTranslation(posA);
-			matrixB.GetTranslation(posB);
-
-			Vector3 posC = (posA + posB) / 2.f;
-			matrixC.AddTranslation(posC);
-
-			m_pModel->SetJointTransformMatrix(iJoint, matrixC);
-		}
-	}
+	m_pose.m_animID0 = animID0;
+	m_pose.m_animID1 = animID1;
+	m_pose.m_t = t;
 }
 
 void World_Object::ComputeBounds()
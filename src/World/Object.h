@@ -1,16 +1,15 @@
 #pragma once
 
-#include "common/basic_types.h"
+#include "Common/basic_types.h"
 
-#include "client/Client_Globals.h"
+#include "Client/Client_Globals.h"
 
 #include "Bounds.h"
+#include "Render.h"
 
 namespace TB8
 {
 
-class RenderModel;
-
 enum World_Object_Type
 {
 	World_Object_Type_Tile = 0,
@@ -25,12 +24,17 @@ struct World_Object : public Client_Globals_Accessor
 		: Client_Globals_Accessor(pGlobalState)
 		, m_modelID(0)
 		, m_pModel(nullptr)
+		, m_pose()
 		, m_center()
 		, m_offset()
 		, m_size()
 		, m_pos()
 		, m_rotation(0.f)
 		, m_scale(0.f)
+		, m_posPrev()
+		, m_rotationPrev(0.f)
+		, m_renderPos()
+		, m_renderRotation(0.f)
 		, m_worldLocalTransform()
 		, m_bounds()
 	{
@@ -43,6 +47,10 @@ struct World_Object : public Client_Globals_Accessor
 	void ComputeBounds();
 	bool IsCollision(World_Object_Bounds& bounds) const;
 
+	// render state is interpolated between the previous and current simulation states.
+	void StorePrevState();
+	void ComputeRenderState(f32 alpha);
+
 	virtual void Render2D(const Vector3& screenWorldPos);
 	virtual void Render3D(const Vector3& screenWorldPos);
 
@@ -50,18 +58,24 @@ struct World_Object : public Client_Globals_Accessor
 	void __ComputeModelAnimCenterAndSize(s32 animID);
 	void __ComputeModelWorldLocalTransform();
 	void __InterpolateCenterAndSize(s32 animID0, s32 animID1, f32 t);
+	// sets the pose the model's drawn in.
 	void __SetAnim(s32 animID0);
 	void __InterpolateAnims(s32 animID0, s32 animID1, f32 t);
 
 	u32								m_modelID;
 	World_Object_Type				m_type;
-	RenderModel*					m_pModel;
+	World_RenderModel*				m_pModel;
+	World_RenderModel_Pose			m_pose;
 	Vector3							m_center;
 	Vector3							m_offset;
 	Vector3							m_size;
 	Vector3							m_pos;
 	f32								m_rotation;
 	f32								m_scale;
+	Vector3							m_posPrev;
+	f32								m_rotationPrev;
+	Vector3							m_renderPos;
+	f32								m_renderRotation;
 	Matrix4							m_worldLocalTransform;
 	World_Object_Bounds				m_bounds;
 };
@@ -0,0 +1,112 @@
+#include "pch.h"
+
+#include "PathHeap.h"
+
+namespace TB8
+{
+
+const u32 World_PathHeap::INVALID_POSITION;
+
+World_PathHeap::World_PathHeap()
+{
+}
+
+void World_PathHeap::Resize(u32 nodeCount)
+{
+	m_heap.clear();
+	m_heap.reserve(nodeCount);
+	m_positions.assign(nodeCount, INVALID_POSITION);
+}
+
+void World_PathHeap::Clear()
+{
+	// only the nodes still in the heap have a position to reset.
+	for (std::vector<Entry>::const_iterator it = m_heap.begin(); it != m_heap.end(); ++it)
+	{
+		m_positions[it->m_node] = INVALID_POSITION;
+	}
+	m_heap.clear();
+}
+
+void World_PathHeap::Push(u32 node, f32 cost)
+{
+	assert(!Contains(node));
+
+	Entry entry;
+	entry.m_cost = cost;
+	entry.m_node = node;
+	m_heap.push_back(entry);
+	m_positions[node] = static_cast<u32>(m_heap.size() - 1);
+	__SiftUp(static_cast<u32>(m_heap.size() - 1));
+}
+
+void World_PathHeap::DecreaseCost(u32 node, f32 cost)
+{
+	const u32 pos = m_positions[node];
+	assert(pos != INVALID_POSITION);
+	assert(cost <= m_heap[pos].m_cost);
+
+	m_heap[pos].m_cost = cost;
+	__SiftUp(pos);
+}
+
+u32 World_PathHeap::Pop()
+{
+	assert(!m_heap.empty());
+
+	const u32 node = m_heap.front().m_node;
+	m_positions[node] = INVALID_POSITION;
+
+	const Entry last = m_heap.back();
+	m_heap.pop_back();
+	if (!m_heap.empty())
+	{
+		__Set(0, last);
+		__SiftDown(0);
+	}
+
+	return node;
+}
+
+void World_PathHeap::__SiftUp(u32 pos)
+{
+	const Entry entry = m_heap[pos];
+	while (pos > 0)
+	{
+		const u32 parent = (pos - 1) / 2;
+		if (!(entry.m_cost < m_heap[parent].m_cost))
+			break;
+		__Set(pos, m_heap[parent]);
+		pos = parent;
+	}
+	__Set(pos, entry);
+}
+
+void World_PathHeap::__SiftDown(u32 pos)
+{
+	const Entry entry = m_heap[pos];
+	const u32 count = static_cast<u32>(m_heap.size());
+	for (;;)
+	{
+		u32 child = (pos * 2) + 1;
+		if (child >= count)
+			break;
+		if (((child + 1) < count) && (m_heap[child + 1].m_cost < m_heap[child].m_cost))
+		{
+			++child;
+		}
+		if (!(m_heap[child].m_cost < entry.m_cost))
+			break;
+		__Set(pos, m_heap[child]);
+		pos = child;
+	}
+	__Set(pos, entry);
+}
+
+void World_PathHeap::__Set(u32 pos, const Entry& entry)
+{
+	m_heap[pos] = entry;
+	m_positions[entry.m_node] = pos;
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+#include "Common/basic_types.h"
+
+namespace TB8
+{
+
+// binary min heap of node indicies keyed on cost, with decrease-key.
+//  storage is sized once by Resize() and reused, so searches don't allocate.
+class World_PathHeap
+{
+public:
+	World_PathHeap();
+
+	void Resize(u32 nodeCount);
+	void Clear();
+
+	bool IsEmpty() const { return m_heap.empty(); }
+	u32 GetSize() const { return static_cast<u32>(m_heap.size()); }
+	bool Contains(u32 node) const { return m_positions[node] != INVALID_POSITION; }
+
+	void Push(u32 node, f32 cost);
+	void DecreaseCost(u32 node, f32 cost);
+	u32 Pop();
+
+private:
+	struct Entry
+	{
+		f32					m_cost;
+		u32					m_node;
+	};
+
+	static const u32 INVALID_POSITION = 0xffffffff;
+
+	void __SiftUp(u32 pos);
+	void __SiftDown(u32 pos);
+	void __Set(u32 pos, const Entry& entry);
+
+	std::vector<Entry>		m_heap;
+	std::vector<u32>		m_positions;		// heap position of each node, or INVALID_POSITION.
+};
+
+}
@@ -0,0 +1,632 @@
+#include "pch.h"
+
+#include "PathHierarchy.h"
+
+namespace TB8
+{
+
+const s32 PATH_CHUNK_SIZE = 16;
+const s32 PATH_ENTRANCE_SPLIT_LENGTH = 6;		// runs this long get an entrance at each end instead of the middle.
+const f32 PATH_HIERARCHY_COST_DIAGONAL = 1.41421356f;
+const f32 PATH_HIERARCHY_HEURISTIC_WEIGHT = 1.25f;	// trades a few percent of path length for far fewer nodes expanded.
+const u32 PATH_NODE_NONE = 0xffffffff;
+
+static const IVector2 s_hierarchyDirs[] =
+{
+	IVector2(+1, 0), IVector2(-1, 0), IVector2(0, +1), IVector2(0, -1),
+	IVector2(+1, +1), IVector2(+1, -1), IVector2(-1, +1), IVector2(-1, -1),
+};
+
+static const f32 s_hierarchyDirCosts[] =
+{
+	1.f, 1.f, 1.f, 1.f,
+	PATH_HIERARCHY_COST_DIAGONAL, PATH_HIERARCHY_COST_DIAGONAL, PATH_HIERARCHY_COST_DIAGONAL, PATH_HIERARCHY_COST_DIAGONAL,
+};
+
+static f32 __GetOctileDistance(const IVector2& a, const IVector2& b)
+{
+	const s32 dx = std::abs(a.x - b.x);
+	const s32 dy = std::abs(a.y - b.y);
+	const s32 diagonal = std::min<s32>(dx, dy);
+	const s32 straight = std::max<s32>(dx, dy) - diagonal;
+	return static_cast<f32>(straight) + (static_cast<f32>(diagonal) * PATH_HIERARCHY_COST_DIAGONAL);
+}
+
+static u32 __NextStamp(u32 stamp, std::vector<u32>& stamps)
+{
+	++stamp;
+	if (stamp == 0)
+	{
+		std::fill(stamps.begin(), stamps.end(), 0);
+		stamp = 1;
+	}
+	return stamp;
+}
+
+void World_PathHierarchy_Metrics::Clear()
+{
+	m_chunkRebuildCount = 0;
+	m_searchCount = 0;
+	m_nodeCount = 0;
+}
+
+World_PathHierarchy::World_PathHierarchy(World_Pathfinder& pathfinder)
+	: m_pathfinder(pathfinder)
+	, m_chunkStamp(0)
+	, m_abstractStamp(0)
+{
+	const u32 chunkCellCount = static_cast<u32>(PATH_CHUNK_SIZE * PATH_CHUNK_SIZE);
+	m_chunkHeap.Resize(chunkCellCount);
+	m_chunkStamps.assign(chunkCellCount, 0);
+	m_chunkCosts.resize(chunkCellCount);
+	m_chunkParents.resize(chunkCellCount);
+}
+
+void World_PathHierarchy::Resize()
+{
+	m_size = m_pathfinder.GetSize();
+	m_chunkCount = IVector2((m_size.x + PATH_CHUNK_SIZE - 1) / PATH_CHUNK_SIZE, (m_size.y + PATH_CHUNK_SIZE - 1) / PATH_CHUNK_SIZE);
+
+	const u32 chunkCount = static_cast<u32>(m_chunkCount.x * m_chunkCount.y);
+	m_chunks.clear();
+	m_chunks.resize(chunkCount);
+	m_borders.clear();
+	m_borders.resize(chunkCount * 2);
+	m_isBorderDirty.assign(chunkCount * 2, false);
+	m_dirtyChunks.clear();
+	m_dirtyBorders.clear();
+	m_nodes.clear();
+	m_freeNodes.clear();
+
+	for (u32 chunk = 0; chunk < chunkCount; ++chunk)
+	{
+		Chunk& c = m_chunks[chunk];
+		const IVector2 chunkPos(static_cast<s32>(chunk % m_chunkCount.x), static_cast<s32>(chunk / m_chunkCount.x));
+		c.m_cellMin = chunkPos * PATH_CHUNK_SIZE;
+		c.m_cellMax = IVector2(std::min<s32>(c.m_cellMin.x + PATH_CHUNK_SIZE, m_size.x), std::min<s32>(c.m_cellMin.y + PATH_CHUNK_SIZE, m_size.y));
+		c.m_isDirty = false;
+		__MarkChunkDirty(chunk);
+		__MarkBorderDirty(__GetBorderIndex(chunk, false));
+		__MarkBorderDirty(__GetBorderIndex(chunk, true));
+	}
+}
+
+void World_PathHierarchy::InvalidateCell(const IVector2& cell)
+{
+	if ((cell.x < 0) || (cell.y < 0) || (cell.x >= m_size.x) || (cell.y >= m_size.y))
+		return;
+
+	// entrances only depend on the cells either side of a border.
+	const u32 chunk = __GetChunkIndex(cell);
+	const Chunk& c = m_chunks[chunk];
+	if ((cell.x == c.m_cellMin.x) && (cell.x > 0))
+	{
+		__MarkBorderDirty(__GetBorderIndex(chunk - 1, false));
+	}
+	if (cell.x == (c.m_cellMax.x - 1))
+	{
+		__MarkBorderDirty(__GetBorderIndex(chunk, false));
+	}
+	if ((cell.y == c.m_cellMin.y) && (cell.y > 0))
+	{
+		__MarkBorderDirty(__GetBorderIndex(chunk - m_chunkCount.x, true));
+	}
+	if (cell.y == (c.m_cellMax.y - 1))
+	{
+		__MarkBorderDirty(__GetBorderIndex(chunk, true));
+	}
+	__MarkChunkDirty(chunk);
+}
+
+void World_PathHierarchy::Update()
+{
+	// new entrances change the nodes of the chunks on both sides.
+	for (std::vector<u32>::const_iterator it = m_dirtyBorders.begin(); it != m_dirtyBorders.end(); ++it)
+	{
+		const u32 border = *it;
+		const u32 chunk = border / 2;
+		const bool isSouth = (border % 2) != 0;
+
+		__FreeBorder(border);
+		__BuildBorder(chunk, isSouth);
+		m_isBorderDirty[border] = false;
+
+		__MarkChunkDirty(chunk);
+		const IVector2 chunkPos(static_cast<s32>(chunk % m_chunkCount.x), static_cast<s32>(chunk / m_chunkCount.x));
+		if (isSouth ? (chunkPos.y < (m_chunkCount.y - 1)) : (chunkPos.x < (m_chunkCount.x - 1)))
+		{
+			__MarkChunkDirty(isSouth ? (chunk + m_chunkCount.x) : (chunk + 1));
+		}
+	}
+	m_dirtyBorders.clear();
+
+	for (std::vector<u32>::const_iterator it = m_dirtyChunks.begin(); it != m_dirtyChunks.end(); ++it)
+	{
+		__BuildChunkSteps(*it);
+		__GatherChunkNodes(*it);
+		__BuildChunkEdges(*it);
+		m_chunks[*it].m_isDirty = false;
+		++m_metrics.m_chunkRebuildCount;
+	}
+	m_dirtyChunks.clear();
+}
+
+World_Path_Status World_PathHierarchy::FindPath(const IVector2& start, const IVector2& goal, std::vector<IVector2>* pPath, bool isRefined)
+{
+	pPath->clear();
+
+	Update();
+
+	if (!m_pathfinder.IsPassable(start) || !m_pathfinder.IsPassable(goal))
+		return World_Path_Status_NotFound;
+
+	// nearby queries aren't worth the abstraction, and would detour thru entrances.
+	const u32 startChunk = __GetChunkIndex(start);
+	const u32 goalChunk = __GetChunkIndex(goal);
+	if ((startChunk == goalChunk) || (__GetOctileDistance(start, goal) <= static_cast<f32>(PATH_CHUNK_SIZE)))
+		return m_pathfinder.FindPath(start, goal, pPath);
+
+	++m_metrics.m_searchCount;
+
+	std::vector<u32> nodes;
+	if (!__SearchAbstract(start, goal, &nodes))
+		return World_Path_Status_NotFound;
+
+	const u32 startNode = static_cast<u32>(m_nodes.size());
+	const u32 goalNode = startNode + 1;
+
+	pPath->push_back(start);
+	for (u32 i = 1; i < nodes.size(); ++i)
+	{
+		const u32 node = nodes[i];
+		const IVector2& cell = (node == goalNode) ? goal : m_nodes[node].m_cell;
+		if (!isRefined)
+		{
+			if ((cell.x != pPath->back().x) || (cell.y != pPath->back().y))
+			{
+				pPath->push_back(cell);
+			}
+			continue;
+		}
+
+		// hops are a step across a border, or inside the chunk of <cell>.
+		const IVector2 from = pPath->back();
+		const u32 chunk = (node == goalNode) ? goalChunk : m_nodes[node].m_chunk;
+		if (__GetChunkIndex(from) != chunk)
+		{
+			pPath->push_back(cell);
+		}
+		else if (!__GetChunkPath(chunk, from, cell, pPath))
+		{
+			assert(false);
+			pPath->clear();
+			return World_Path_Status_NotFound;
+		}
+	}
+
+	return World_Path_Status_Found;
+}
+
+u32 World_PathHierarchy::__GetChunkIndex(const IVector2& cell) const
+{
+	return static_cast<u32>(((cell.y / PATH_CHUNK_SIZE) * m_chunkCount.x) + (cell.x / PATH_CHUNK_SIZE));
+}
+
+void World_PathHierarchy::__MarkChunkDirty(u32 chunk)
+{
+	Chunk& c = m_chunks[chunk];
+	if (c.m_isDirty)
+		return;
+
+	c.m_isDirty = true;
+	m_dirtyChunks.push_back(chunk);
+}
+
+void World_PathHierarchy::__MarkBorderDirty(u32 border)
+{
+	if (m_isBorderDirty[border])
+		return;
+
+	m_isBorderDirty[border] = true;
+	m_dirtyBorders.push_back(border);
+}
+
+u32 World_PathHierarchy::__AllocNode(const IVector2& cell, u32 chunk)
+{
+	u32 node;
+	if (!m_freeNodes.empty())
+	{
+		node = m_freeNodes.back();
+		m_freeNodes.pop_back();
+	}
+	else
+	{
+		node = static_cast<u32>(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+
+	Node& n = m_nodes[node];
+	n.m_cell = cell;
+	n.m_chunk = chunk;
+	n.m_twin = PATH_NODE_NONE;
+	n.m_twinCost = 0.f;
+	n.m_edges.clear();
+	n.m_isUsed = true;
+	return node;
+}
+
+void World_PathHierarchy::__FreeBorder(u32 border)
+{
+	std::vector<u32>& nodes = m_borders[border];
+	for (std::vector<u32>::const_iterator it = nodes.begin(); it != nodes.end(); ++it)
+	{
+		Node& n = m_nodes[*it];
+		n.m_isUsed = false;
+		n.m_edges.clear();
+		m_freeNodes.push_back(*it);
+	}
+	nodes.clear();
+}
+
+void World_PathHierarchy::__BuildBorder(u32 chunk, bool isSouth)
+{
+	const Chunk& c = m_chunks[chunk];
+	const IVector2 chunkPos(static_cast<s32>(chunk % m_chunkCount.x), static_cast<s32>(chunk / m_chunkCount.x));
+	if (isSouth ? (chunkPos.y >= (m_chunkCount.y - 1)) : (chunkPos.x >= (m_chunkCount.x - 1)))
+		return;
+
+	// walk the last row or column of the chunk, stepping across into the next chunk.
+	const IVector2 dir = isSouth ? IVector2(0, 1) : IVector2(1, 0);
+	const IVector2 along = isSouth ? IVector2(1, 0) : IVector2(0, 1);
+	const IVector2 first = isSouth ? IVector2(c.m_cellMin.x, c.m_cellMax.y - 1) : IVector2(c.m_cellMax.x - 1, c.m_cellMin.y);
+	const s32 length = isSouth ? (c.m_cellMax.x - c.m_cellMin.x) : (c.m_cellMax.y - c.m_cellMin.y);
+	const u32 border = __GetBorderIndex(chunk, isSouth);
+
+	s32 runStart = -1;
+	for (s32 i = 0; i <= length; ++i)
+	{
+		// a run also ends where the cells can't step along the border on either side, so every cell of a run reaches
+		//  its entrances.
+		const IVector2 cell = first + (along * i);
+		const bool isOpen = (i < length) && m_pathfinder.IsPassable(cell) && m_pathfinder.CanStep(cell, dir);
+		if (isOpen && (runStart >= 0))
+		{
+			const IVector2 cellPrev = cell - along;
+			if (m_pathfinder.CanStep(cellPrev, along) && m_pathfinder.CanStep(cellPrev + dir, along))
+				continue;
+		}
+		else if (isOpen)
+		{
+			runStart = i;
+			continue;
+		}
+		if (runStart < 0)
+			continue;
+
+		const s32 runLength = i - runStart;
+		if (runLength < PATH_ENTRANCE_SPLIT_LENGTH)
+		{
+			__AddEntrance(border, first + (along * (runStart + (runLength / 2))), dir);
+		}
+		else
+		{
+			__AddEntrance(border, first + (along * runStart), dir);
+			__AddEntrance(border, first + (along * (i - 1)), dir);
+		}
+		runStart = isOpen ? i : -1;
+	}
+}
+
+void World_PathHierarchy::__AddEntrance(u32 border, const IVector2& cell, const IVector2& dir)
+{
+	const IVector2 cellNext = cell + dir;
+	const u32 node = __AllocNode(cell, __GetChunkIndex(cell));
+	const u32 nodeNext = __AllocNode(cellNext, __GetChunkIndex(cellNext));
+
+	Node& n = m_nodes[node];
+	n.m_twin = nodeNext;
+	n.m_twinCost = m_pathfinder.GetStepCost(cell, dir);
+
+	Node& nNext = m_nodes[nodeNext];
+	nNext.m_twin = node;
+	nNext.m_twinCost = m_pathfinder.GetStepCost(cellNext, IVector2(0, 0) - dir);
+
+	m_borders[border].push_back(node);
+	m_borders[border].push_back(nodeNext);
+}
+
+void World_PathHierarchy::__GatherChunkNodes(u32 chunk)
+{
+	const IVector2 chunkPos(static_cast<s32>(chunk % m_chunkCount.x), static_cast<s32>(chunk / m_chunkCount.x));
+
+	u32 borders[4];
+	u32 borderCount = 0;
+	borders[borderCount++] = __GetBorderIndex(chunk, false);
+	borders[borderCount++] = __GetBorderIndex(chunk, true);
+	if (chunkPos.x > 0)
+	{
+		borders[borderCount++] = __GetBorderIndex(chunk - 1, false);
+	}
+	if (chunkPos.y > 0)
+	{
+		borders[borderCount++] = __GetBorderIndex(chunk - m_chunkCount.x, true);
+	}
+
+	std::vector<u32>& nodes = m_chunks[chunk].m_nodes;
+	nodes.clear();
+	for (u32 i = 0; i < borderCount; ++i)
+	{
+		const std::vector<u32>& borderNodes = m_borders[borders[i]];
+		for (std::vector<u32>::const_iterator it = borderNodes.begin(); it != borderNodes.end(); ++it)
+		{
+			if (m_nodes[*it].m_chunk == chunk)
+			{
+				nodes.push_back(*it);
+			}
+		}
+	}
+}
+
+void World_PathHierarchy::__BuildChunkEdges(u32 chunk)
+{
+	const std::vector<u32>& nodes = m_chunks[chunk].m_nodes;
+	for (std::vector<u32>::const_iterator it = nodes.begin(); it != nodes.end(); ++it)
+	{
+		Node& n = m_nodes[*it];
+		n.m_edges.clear();
+
+		__SearchChunk(chunk, n.m_cell, false, nullptr);
+		for (std::vector<u32>::const_iterator itOther = nodes.begin(); itOther != nodes.end(); ++itOther)
+		{
+			if (*itOther == *it)
+				continue;
+
+			Edge edge;
+			edge.m_node = *itOther;
+			edge.m_cost = __GetChunkCost(chunk, m_nodes[*itOther].m_cell);
+			if (edge.m_cost >= 0.f)
+			{
+				n.m_edges.push_back(edge);
+			}
+		}
+	}
+}
+
+void World_PathHierarchy::__BuildChunkSteps(u32 chunk)
+{
+	// the steps out of each cell that stay in the chunk, so searches don't go back to the pathfinder and wall grid.
+	//  they only depend on cells inside the chunk.
+	Chunk& c = m_chunks[chunk];
+	const u32 cellCount = static_cast<u32>((c.m_cellMax.x - c.m_cellMin.x) * (c.m_cellMax.y - c.m_cellMin.y));
+	c.m_stepMasks.resize(cellCount);
+	c.m_cellCosts.resize(cellCount);
+
+	IVector2 cell;
+	u32 index = 0;
+	for (cell.y = c.m_cellMin.y; cell.y < c.m_cellMax.y; ++cell.y)
+	{
+		for (cell.x = c.m_cellMin.x; cell.x < c.m_cellMax.x; ++cell.x, ++index)
+		{
+			u8 mask = 0;
+			for (u32 i = 0; i < ARRAYSIZE(s_hierarchyDirs); ++i)
+			{
+				const IVector2 cellNext = cell + s_hierarchyDirs[i];
+				if ((cellNext.x < c.m_cellMin.x) || (cellNext.y < c.m_cellMin.y) || (cellNext.x >= c.m_cellMax.x) || (cellNext.y >= c.m_cellMax.y))
+					continue;
+				if (m_pathfinder.CanStep(cell, s_hierarchyDirs[i]))
+				{
+					mask |= static_cast<u8>(1 << i);
+				}
+			}
+			c.m_stepMasks[index] = mask;
+			c.m_cellCosts[index] = m_pathfinder.GetCellCost(cell);
+		}
+	}
+}
+
+f32 World_PathHierarchy::__SearchChunk(u32 chunk, const IVector2& from, bool isReverse, const IVector2* pTarget)
+{
+	const Chunk& c = m_chunks[chunk];
+	const s32 width = c.m_cellMax.x - c.m_cellMin.x;
+
+	m_chunkStamp = __NextStamp(m_chunkStamp, m_chunkStamps);
+	m_chunkHeap.Clear();
+
+	const IVector2 fromLocal = from - c.m_cellMin;
+	const u32 fromIndex = static_cast<u32>((fromLocal.y * width) + fromLocal.x);
+	const IVector2 targetLocal = pTarget ? (*pTarget - c.m_cellMin) : IVector2();
+	const u32 targetIndex = pTarget ? static_cast<u32>((targetLocal.y * width) + targetLocal.x) : PATH_NODE_NONE;
+	m_chunkStamps[fromIndex] = m_chunkStamp;
+	m_chunkCosts[fromIndex] = 0.f;
+	m_chunkParents[fromIndex] = fromIndex;
+	m_chunkHeap.Push(fromIndex, pTarget ? __GetOctileDistance(fromLocal, targetLocal) : 0.f);
+
+	while (!m_chunkHeap.IsEmpty())
+	{
+		const u32 index = m_chunkHeap.Pop();
+		const f32 cost = m_chunkCosts[index];
+		if (index == targetIndex)
+			return cost;
+
+		const IVector2 local(static_cast<s32>(index % width), static_cast<s32>(index / width));
+		for (u32 mask = c.m_stepMasks[index], i = 0; mask; mask >>= 1, ++i)
+		{
+			if (!(mask & 1))
+				continue;
+
+			// stepping is symmetric, only the cell whose cost is paid differs.
+			const IVector2& dir = s_hierarchyDirs[i];
+			const IVector2 localNext = local + dir;
+			const u32 indexNext = static_cast<u32>((localNext.y * width) + localNext.x);
+			const f32 costNext = cost + (s_hierarchyDirCosts[i] * static_cast<f32>(c.m_cellCosts[isReverse ? index : indexNext]));
+			const f32 heuristic = pTarget ? __GetOctileDistance(localNext, targetLocal) : 0.f;
+			if (m_chunkStamps[indexNext] != m_chunkStamp)
+			{
+				m_chunkStamps[indexNext] = m_chunkStamp;
+				m_chunkCosts[indexNext] = costNext;
+				m_chunkParents[indexNext] = index;
+				m_chunkHeap.Push(indexNext, costNext + heuristic);
+			}
+			else if (m_chunkHeap.Contains(indexNext) && (costNext < m_chunkCosts[indexNext]))
+			{
+				m_chunkCosts[indexNext] = costNext;
+				m_chunkParents[indexNext] = index;
+				m_chunkHeap.DecreaseCost(indexNext, costNext + heuristic);
+			}
+		}
+	}
+
+	return pTarget ? -1.f : 0.f;
+}
+
+f32 World_PathHierarchy::__GetChunkCost(u32 chunk, const IVector2& cell) const
+{
+	const Chunk& c = m_chunks[chunk];
+	const IVector2 local = cell - c.m_cellMin;
+	const u32 index = static_cast<u32>((local.y * (c.m_cellMax.x - c.m_cellMin.x)) + local.x);
+	return (m_chunkStamps[index] == m_chunkStamp) ? m_chunkCosts[index] : -1.f;
+}
+
+bool World_PathHierarchy::__GetChunkPath(u32 chunk, const IVector2& from, const IVector2& to, std::vector<IVector2>* pPath)
+{
+	if ((from.x == to.x) && (from.y == to.y))
+		return true;
+	if (__SearchChunk(chunk, from, false, &to) < 0.f)
+		return false;
+
+	// appends the cells after <from>.
+	const Chunk& c = m_chunks[chunk];
+	const s32 width = c.m_cellMax.x - c.m_cellMin.x;
+	const size_t pathStart = pPath->size();
+	const IVector2 toLocal = to - c.m_cellMin;
+	for (u32 index = static_cast<u32>((toLocal.y * width) + toLocal.x); m_chunkParents[index] != index; index = m_chunkParents[index])
+	{
+		pPath->push_back(c.m_cellMin + IVector2(static_cast<s32>(index % width), static_cast<s32>(index / width)));
+	}
+	std::reverse(pPath->begin() + pathStart, pPath->end());
+	return true;
+}
+
+bool World_PathHierarchy::__SearchAbstract(const IVector2& start, const IVector2& goal, std::vector<u32>* pNodes)
+{
+	const u32 startNode = static_cast<u32>(m_nodes.size());
+	const u32 goalNode = startNode + 1;
+	if (m_abstractStamps.size() < (startNode + 2))
+	{
+		m_abstractHeap.Resize(startNode + 2);
+		m_abstractStamps.assign(startNode + 2, 0);
+		m_abstractCosts.resize(startNode + 2);
+		m_abstractParents.resize(startNode + 2);
+		m_abstractStamp = 0;
+	}
+
+	// connect the start and goal to the nodes of their chunks.
+	const u32 startChunk = __GetChunkIndex(start);
+	const u32 goalChunk = __GetChunkIndex(goal);
+
+	m_startEdges.clear();
+	__SearchChunk(startChunk, start, false, nullptr);
+	const std::vector<u32>& startNodes = m_chunks[startChunk].m_nodes;
+	for (std::vector<u32>::const_iterator it = startNodes.begin(); it != startNodes.end(); ++it)
+	{
+		Edge edge;
+		edge.m_node = *it;
+		edge.m_cost = __GetChunkCost(startChunk, m_nodes[*it].m_cell);
+		if (edge.m_cost >= 0.f)
+		{
+			m_startEdges.push_back(edge);
+		}
+	}
+
+	m_goalEdges.clear();
+	__SearchChunk(goalChunk, goal, true, nullptr);
+	const std::vector<u32>& goalNodes = m_chunks[goalChunk].m_nodes;
+	for (std::vector<u32>::const_iterator it = goalNodes.begin(); it != goalNodes.end(); ++it)
+	{
+		Edge edge;
+		edge.m_node = *it;
+		edge.m_cost = __GetChunkCost(goalChunk, m_nodes[*it].m_cell);
+		if (edge.m_cost >= 0.f)
+		{
+			m_goalEdges.push_back(edge);
+		}
+	}
+
+	if (m_startEdges.empty() || m_goalEdges.empty())
+		return false;
+
+	m_abstractStamp = __NextStamp(m_abstractStamp, m_abstractStamps);
+	m_abstractHeap.Clear();
+	__AddAbstractNode(startNode, startNode, 0.f, goal);
+
+	while (!m_abstractHeap.IsEmpty())
+	{
+		const u32 node = m_abstractHeap.Pop();
+		++m_metrics.m_nodeCount;
+
+		if (node == goalNode)
+		{
+			for (u32 n = goalNode; ; n = m_abstractParents[n])
+			{
+				pNodes->push_back(n);
+				if (m_abstractParents[n] == n)
+					break;
+			}
+			std::reverse(pNodes->begin(), pNodes->end());
+			return true;
+		}
+
+		const f32 cost = m_abstractCosts[node];
+		if (node == startNode)
+		{
+			for (std::vector<Edge>::const_iterator it = m_startEdges.begin(); it != m_startEdges.end(); ++it)
+			{
+				__AddAbstractNode(it->m_node, node, cost + it->m_cost, goal);
+			}
+			continue;
+		}
+
+		const Node& n = m_nodes[node];
+		__AddAbstractNode(n.m_twin, node, cost + n.m_twinCost, goal);
+		for (std::vector<Edge>::const_iterator it = n.m_edges.begin(); it != n.m_edges.end(); ++it)
+		{
+			__AddAbstractNode(it->m_node, node, cost + it->m_cost, goal);
+		}
+		if (n.m_chunk == goalChunk)
+		{
+			for (std::vector<Edge>::const_iterator it = m_goalEdges.begin(); it != m_goalEdges.end(); ++it)
+			{
+				if (it->m_node == node)
+				{
+					__AddAbstractNode(goalNode, node, cost + it->m_cost, goal);
+					break;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+void World_PathHierarchy::__AddAbstractNode(u32 node, u32 parent, f32 cost, const IVector2& goal)
+{
+	// the start node is only ever added first, alone.
+	const f32 heuristic = (node < m_nodes.size()) ? __GetOctileDistance(m_nodes[node].m_cell, goal) * PATH_HIERARCHY_HEURISTIC_WEIGHT : 0.f;
+	if (m_abstractStamps[node] != m_abstractStamp)
+	{
+		m_abstractStamps[node] = m_abstractStamp;
+		m_abstractCosts[node] = cost;
+		m_abstractParents[node] = parent;
+		m_abstractHeap.Push(node, cost + heuristic);
+		return;
+	}
+
+	if (!m_abstractHeap.Contains(node) || !(cost < m_abstractCosts[node]))
+		return;
+
+	m_abstractCosts[node] = cost;
+	m_abstractParents[node] = parent;
+	m_abstractHeap.DecreaseCost(node, cost + heuristic);
+}
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <vector>
+
+#include "Common/basic_types.h"
+
+#include "PathHeap.h"
+#include "Pathfinder.h"
+
+namespace TB8
+{
+
+struct World_PathHierarchy_Metrics
+{
+	World_PathHierarchy_Metrics() { Clear(); }
+	void Clear();
+
+	u32						m_chunkRebuildCount;	// chunks whose entrances and costs were rebuilt.
+	u32						m_searchCount;
+	u32						m_nodeCount;			// abstract nodes expanded.
+};
+
+// hierarchical pathfinding (hpa*) for long paths across large maps.
+//  the map is split into square chunks.  each run of open cells along a chunk border becomes one or two entrances,
+//  a node on either side, and the cost between every pair of nodes within a chunk is precomputed.  a query connects
+//  start and goal to the nodes of their chunks, searches the small abstract graph, and refines each hop with a search
+//  bounded to one chunk.  movement rules and cell costs come from the flat pathfinder.
+//
+//  InvalidateCell() marks the chunk holding a changed cell, and Update() rebuilds just the costs inside it.  a cell
+//  next to a border also rebuilds that border's entrances, and so the costs of the chunk across it.
+class World_PathHierarchy
+{
+public:
+	World_PathHierarchy(World_Pathfinder& pathfinder);
+
+	// takes the size from the pathfinder, everything is rebuilt by the next Update().
+	void Resize();
+
+	void InvalidateCell(const IVector2& cell);
+	void Update();
+
+	// <pPath> is every cell from start to goal, or with <isRefined> false just start, the entrances crossed, and goal.
+	//  hops between those waypoints are short and can be refined later with the flat pathfinder.
+	World_Path_Status FindPath(const IVector2& start, const IVector2& goal, std::vector<IVector2>* pPath, bool isRefined = true);
+
+	u32 GetNodeCount() const { return static_cast<u32>(m_nodes.size() - m_freeNodes.size()); }
+	const World_PathHierarchy_Metrics& GetMetrics() const { return m_metrics; }
+
+private:
+	struct Edge
+	{
+		u32							m_node;
+		f32							m_cost;
+	};
+
+	struct Node
+	{
+		IVector2					m_cell;
+		u32							m_chunk;
+		u32							m_twin;				// node across the border.
+		f32							m_twinCost;
+		std::vector<Edge>			m_edges;			// to the other nodes of the chunk.
+		bool						m_isUsed;
+	};
+
+	struct Chunk
+	{
+		IVector2					m_cellMin;
+		IVector2					m_cellMax;			// exclusive.
+		std::vector<u32>			m_nodes;
+		std::vector<u8>				m_stepMasks;		// per cell, a bit for each direction that stays in the chunk.
+		std::vector<u8>				m_cellCosts;
+		bool						m_isDirty;
+	};
+
+	u32 __GetChunkIndex(const IVector2& cell) const;
+	u32 __GetBorderIndex(u32 chunk, bool isSouth) const { return (chunk * 2) + (isSouth ? 1 : 0); }
+	void __MarkChunkDirty(u32 chunk);
+	void __MarkBorderDirty(u32 border);
+
+	u32 __AllocNode(const IVector2& cell, u32 chunk);
+	void __FreeBorder(u32 border);
+	void __BuildBorder(u32 chunk, bool isSouth);
+	void __AddEntrance(u32 border, const IVector2& cell, const IVector2& dir);
+	void __BuildChunkSteps(u32 chunk);
+	void __GatherChunkNodes(u32 chunk);
+	void __BuildChunkEdges(u32 chunk);
+
+	// dijkstra, or a* with <pTarget>, over the cells of one chunk.  <isReverse> finds the cost from each cell to <from>.
+	f32 __SearchChunk(u32 chunk, const IVector2& from, bool isReverse, const IVector2* pTarget);
+	f32 __GetChunkCost(u32 chunk, const IVector2& cell) const;
+	bool __GetChunkPath(u32 chunk, const IVector2& from, const IVector2& to, std::vector<IVector2>* pPath);
+
+	bool __SearchAbstract(const IVector2& start, const IVector2& goal, std::vector<u32>* pNodes);
+	void __AddAbstractNode(u32 node, u32 parent, f32 cost, const IVector2& goal);
+
+	World_Pathfinder&				m_pathfinder;
+	IVector2						m_size;
+	IVector2						m_chunkCount;
+	std::vector<Chunk>				m_chunks;
+	std::vector<std::vector<u32>>	m_borders;			// nodes on the east and south border of each chunk.
+	std::vector<u32>				m_dirtyChunks;		// chunks whose node costs need rebuilding.
+	std::vector<u32>				m_dirtyBorders;		// borders whose entrances need rebuilding.
+	std::vector<bool>				m_isBorderDirty;
+
+	std::vector<Node>				m_nodes;
+	std::vector<u32>				m_freeNodes;
+
+	// chunk search state.
+	World_PathHeap					m_chunkHeap;
+	std::vector<u32>				m_chunkStamps;
+	std::vector<f32>				m_chunkCosts;
+	std::vector<u32>				m_chunkParents;
+	u32								m_chunkStamp;
+
+	// abstract search state, the last two nodes are the start and goal of the query.
+	World_PathHeap					m_abstractHeap;
+	std::vector<u32>				m_abstractStamps;
+	std::vector<f32>				m_abstractCosts;
+	std::vector<u32>				m_abstractParents;
+	u32								m_abstractStamp;
+	std::vector<Edge>				m_startEdges;
+	std::vector<Edge>				m_goalEdges;		// cost from a node to the goal.
+
+	World_PathHierarchy_Metrics		m_metrics;
+};
+
+}
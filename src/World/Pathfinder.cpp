@@ -0,0 +1,640 @@
+#include "pch.h"
+
+#include <climits>
+
+#include "WallGrid.h"
+#include "Pathfinder.h"
+
+namespace TB8
+{
+
+const u32 PATH_CACHE_SIZE = 64;
+const f32 PATH_COST_DIAGONAL = 1.41421356f;
+const u64 PATH_CACHE_KEY_NONE = 0xffffffffffffffffULL;
+const u32 PATH_NODE_NONE = UINT_MAX;
+
+static const IVector2 s_pathDirs[] =
+{
+	IVector2(+1, 0), IVector2(-1, 0), IVector2(0, +1), IVector2(0, -1),
+	IVector2(+1, +1), IVector2(+1, -1), IVector2(-1, +1), IVector2(-1, -1),
+};
+
+static s32 __GetSign(s32 v)
+{
+	return (v > 0) ? 1 : ((v < 0) ? -1 : 0);
+}
+
+void World_Pathfinder_Metrics::Clear()
+{
+	m_searchCount = 0;
+	m_cacheHitCount = 0;
+	m_nodeCount = 0;
+}
+
+World_Pathfinder::World_Pathfinder(const World_WallGrid& wallGrid)
+	: m_wallGrid(wallGrid)
+	, m_weightedCellCount(0)
+	, m_costRevision(0)
+	, m_stamp(0)
+	, m_isSearching(false)
+	, m_searchRequestID(0)
+	, m_searchMode(World_Path_Mode_Auto)
+	, m_jumpNode(PATH_NODE_NONE)
+	, m_jumpDirCount(0)
+	, m_jumpDirIndex(0)
+	, m_jumpStraightIndex(0)
+	, m_requestSerial(0)
+	, m_cacheClock(0)
+	, m_cacheWallRevision(0)
+	, m_cacheCostRevision(0)
+{
+	m_cache.resize(PATH_CACHE_SIZE);
+	for (std::vector<CacheEntry>::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+	{
+		it->m_key = PATH_CACHE_KEY_NONE;
+		it->m_lastUsed = 0;
+		it->m_status = World_Path_Status_None;
+	}
+}
+
+void World_Pathfinder::Resize(const IVector2& size)
+{
+	m_size = IVector2(std::max<s32>(size.x, 0), std::max<s32>(size.y, 0));
+	const u32 cellCount = static_cast<u32>(m_size.x * m_size.y);
+
+	m_cellCosts.assign(cellCount, 1);
+	m_weightedCellCount = 0;
+	++m_costRevision;
+
+	m_heap.Resize(cellCount);
+	m_nodeStamps.assign(cellCount, 0);
+	m_nodeCosts.resize(cellCount);
+	m_nodeParents.resize(cellCount);
+	m_stamp = 0;
+	m_isSearching = false;
+}
+
+void World_Pathfinder::SetCellCost(const IVector2& cell, u8 cost)
+{
+	if ((cell.x < 0) || (cell.y < 0) || (cell.x >= m_size.x) || (cell.y >= m_size.y))
+		return;
+
+	u8& cellCost = m_cellCosts[__GetIndex(cell)];
+	if (cellCost == cost)
+		return;
+
+	m_weightedCellCount -= (cellCost > 1) ? 1 : 0;
+	m_weightedCellCount += (cost > 1) ? 1 : 0;
+	cellCost = cost;
+	++m_costRevision;
+}
+
+u8 World_Pathfinder::GetCellCost(const IVector2& cell) const
+{
+	if ((cell.x < 0) || (cell.y < 0) || (cell.x >= m_size.x) || (cell.y >= m_size.y))
+		return 0;
+	return m_cellCosts[__GetIndex(cell)];
+}
+
+World_Path_Status World_Pathfinder::FindPath(const IVector2& start, const IVector2& goal, std::vector<IVector2>* pPath, World_Path_Mode mode)
+{
+	pPath->clear();
+
+	__ValidateCache();
+
+	World_Path_Status status;
+	if (__FindCache(start, goal, &status, pPath))
+		return status;
+
+	if (!IsPassable(start) || !IsPassable(goal))
+		return World_Path_Status_NotFound;
+
+	// takes over the search state, a time-sliced request in progress starts again next Update().
+	__SearchBegin(start, goal, mode);
+	s32 budget = INT_MAX;
+	status = __SearchStep(budget);
+	__SearchEnd(status, pPath);
+	__AddCache(start, goal, status, *pPath);
+	return status;
+}
+
+u32 World_Pathfinder::RequestPath(const IVector2& start, const IVector2& goal, World_Path_Mode mode)
+{
+	u32 slot = 0;
+	while ((slot < m_requests.size()) && m_requests[slot].m_id)
+	{
+		++slot;
+	}
+	if (slot == m_requests.size())
+	{
+		m_requests.emplace_back();
+	}
+
+	++m_requestSerial;
+
+	Request& request = m_requests[slot];
+	request.m_id = ((m_requestSerial & 0xffff) << 16) | (slot + 1);
+	request.m_serial = m_requestSerial;
+	request.m_status = World_Path_Status_Pending;
+	request.m_mode = mode;
+	request.m_start = start;
+	request.m_goal = goal;
+	request.m_path.clear();
+
+	// recent paths don't need a search.
+	__ValidateCache();
+	World_Path_Status status;
+	if (__FindCache(start, goal, &status, &request.m_path))
+	{
+		request.m_status = status;
+	}
+	else if (!IsPassable(start) || !IsPassable(goal))
+	{
+		request.m_status = World_Path_Status_NotFound;
+	}
+
+	return request.m_id;
+}
+
+World_Path_Status World_Pathfinder::GetRequestStatus(u32 requestID) const
+{
+	const Request* pRequest = __FindRequest(requestID);
+	return pRequest ? pRequest->m_status : World_Path_Status_None;
+}
+
+bool World_Pathfinder::GetRequestPath(u32 requestID, std::vector<IVector2>* pPath) const
+{
+	const Request* pRequest = __FindRequest(requestID);
+	if (!pRequest || (pRequest->m_status != World_Path_Status_Found))
+		return false;
+
+	*pPath = pRequest->m_path;
+	return true;
+}
+
+void World_Pathfinder::ReleaseRequest(u32 requestID)
+{
+	Request* pRequest = __FindRequest(requestID);
+	if (!pRequest)
+		return;
+
+	if (m_isSearching && (m_searchRequestID == requestID))
+	{
+		m_isSearching = false;
+		m_searchRequestID = 0;
+	}
+
+	pRequest->m_id = 0;
+	pRequest->m_status = World_Path_Status_None;
+}
+
+void World_Pathfinder::Update(u32 nodeBudget)
+{
+	__ValidateCache();
+
+	s32 budget = static_cast<s32>(std::min<u32>(nodeBudget, INT_MAX));
+	while (budget > 0)
+	{
+		if (!m_isSearching || !m_searchRequestID)
+		{
+			// start the oldest pending request.
+			Request* pNext = nullptr;
+			for (std::vector<Request>::iterator it = m_requests.begin(); it != m_requests.end(); ++it)
+			{
+				if (!it->m_id || (it->m_status != World_Path_Status_Pending))
+					continue;
+				if (!pNext || (it->m_serial < pNext->m_serial))
+				{
+					pNext = &*it;
+				}
+			}
+			if (!pNext)
+				break;
+
+			World_Path_Status status;
+			if (__FindCache(pNext->m_start, pNext->m_goal, &status, &pNext->m_path))
+			{
+				pNext->m_status = status;
+				--budget;
+				continue;
+			}
+
+			__SearchBegin(pNext->m_start, pNext->m_goal, pNext->m_mode);
+			m_searchRequestID = pNext->m_id;
+		}
+
+		const World_Path_Status status = __SearchStep(budget);
+		if (status == World_Path_Status_Pending)
+			break;
+
+		Request* pRequest = __FindRequest(m_searchRequestID);
+		assert(pRequest);
+		pRequest->m_status = status;
+		__SearchEnd(status, &pRequest->m_path);
+		__AddCache(pRequest->m_start, pRequest->m_goal, status, pRequest->m_path);
+	}
+}
+
+bool World_Pathfinder::IsPassable(const IVector2& cell) const
+{
+	if ((cell.x < 0) || (cell.y < 0) || (cell.x >= m_size.x) || (cell.y >= m_size.y))
+		return false;
+	return m_cellCosts[__GetIndex(cell)] != 0;
+}
+
+bool World_Pathfinder::CanStep(const IVector2& cell, const IVector2& dir) const
+{
+	if (!IsPassable(cell + dir))
+		return false;
+
+	// diagonal steps need both corner cells too, which makes an impassable cell act like one walled on every side.
+	if ((dir.x != 0) && (dir.y != 0))
+	{
+		if (!IsPassable(IVector2(cell.x + dir.x, cell.y)) || !IsPassable(IVector2(cell.x, cell.y + dir.y)))
+			return false;
+	}
+
+	return m_wallGrid.CanStep(cell, dir);
+}
+
+bool World_Pathfinder::__IsForced(const IVector2& cell, const IVector2& dir, const IVector2& side) const
+{
+	// arriving straight along <dir>, the cell to <side> is only reached best thru <cell> if the previous cell can't
+	// step diagonally to it.
+	if (!CanStep(cell, side))
+		return false;
+
+	const IVector2 cellPrev = cell - dir;
+	return !CanStep(cellPrev, dir + side);
+}
+
+f32 World_Pathfinder::GetStepCost(const IVector2& cell, const IVector2& dir) const
+{
+	const f32 base = ((dir.x != 0) && (dir.y != 0)) ? PATH_COST_DIAGONAL : 1.f;
+	return base * static_cast<f32>(m_cellCosts[__GetIndex(cell + dir)]);
+}
+
+f32 World_Pathfinder::__GetHeuristic(const IVector2& cell) const
+{
+	// octile distance, admissible since no cell costs less than 1.
+	const s32 dx = std::abs(m_searchGoal.x - cell.x);
+	const s32 dy = std::abs(m_searchGoal.y - cell.y);
+	const s32 diagonal = std::min<s32>(dx, dy);
+	const s32 straight = std::max<s32>(dx, dy) - diagonal;
+	return static_cast<f32>(straight) + (static_cast<f32>(diagonal) * PATH_COST_DIAGONAL);
+}
+
+World_Pathfinder::Request* World_Pathfinder::__FindRequest(u32 requestID)
+{
+	const u32 slot = (requestID & 0xffff) - 1;
+	if (!requestID || (slot >= m_requests.size()) || (m_requests[slot].m_id != requestID))
+		return nullptr;
+	return &m_requests[slot];
+}
+
+const World_Pathfinder::Request* World_Pathfinder::__FindRequest(u32 requestID) const
+{
+	const u32 slot = (requestID & 0xffff) - 1;
+	if (!requestID || (slot >= m_requests.size()) || (m_requests[slot].m_id != requestID))
+		return nullptr;
+	return &m_requests[slot];
+}
+
+bool World_Pathfinder::__FindCache(const IVector2& start, const IVector2& goal, World_Path_Status* pStatus, std::vector<IVector2>* pPath)
+{
+	if (!IsPassable(start) || !IsPassable(goal))
+		return false;
+
+	const u64 key = (static_cast<u64>(__GetIndex(start)) << 32) | __GetIndex(goal);
+	for (std::vector<CacheEntry>::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+	{
+		if (it->m_key != key)
+			continue;
+
+		it->m_lastUsed = ++m_cacheClock;
+		*pStatus = it->m_status;
+		*pPath = it->m_path;
+		++m_metrics.m_cacheHitCount;
+		return true;
+	}
+
+	return false;
+}
+
+void World_Pathfinder::__AddCache(const IVector2& start, const IVector2& goal, World_Path_Status status, const std::vector<IVector2>& path)
+{
+	if (!IsPassable(start) || !IsPassable(goal))
+		return;
+
+	// replace the least recently used entry.
+	std::vector<CacheEntry>::iterator itOldest = m_cache.begin();
+	for (std::vector<CacheEntry>::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+	{
+		if (it->m_key == PATH_CACHE_KEY_NONE)
+		{
+			itOldest = it;
+			break;
+		}
+		if (it->m_lastUsed < itOldest->m_lastUsed)
+		{
+			itOldest = it;
+		}
+	}
+
+	itOldest->m_key = (static_cast<u64>(__GetIndex(start)) << 32) | __GetIndex(goal);
+	itOldest->m_lastUsed = ++m_cacheClock;
+	itOldest->m_status = status;
+	itOldest->m_path = path;
+}
+
+void World_Pathfinder::__ValidateCache()
+{
+	if ((m_cacheWallRevision == m_wallGrid.GetRevision()) && (m_cacheCostRevision == m_costRevision))
+		return;
+
+	m_cacheWallRevision = m_wallGrid.GetRevision();
+	m_cacheCostRevision = m_costRevision;
+
+	for (std::vector<CacheEntry>::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+	{
+		it->m_key = PATH_CACHE_KEY_NONE;
+		it->m_status = World_Path_Status_None;
+	}
+
+	// a search in progress was using the old map.
+	m_isSearching = false;
+}
+
+void World_Pathfinder::__SearchBegin(const IVector2& start, const IVector2& goal, World_Path_Mode mode)
+{
+	if (mode == World_Path_Mode_Auto)
+	{
+		mode = IsUniformCost() ? World_Path_Mode_JPS : World_Path_Mode_AStar;
+	}
+	else if ((mode == World_Path_Mode_JPS) && !IsUniformCost())
+	{
+		// jps's pruning assumes every step of a kind costs the same.
+		mode = World_Path_Mode_AStar;
+	}
+
+	++m_stamp;
+	if (m_stamp == 0)
+	{
+		std::fill(m_nodeStamps.begin(), m_nodeStamps.end(), 0);
+		m_stamp = 1;
+	}
+
+	m_heap.Clear();
+	m_isSearching = true;
+	m_searchRequestID = 0;
+	m_searchMode = mode;
+	m_searchStart = start;
+	m_searchGoal = goal;
+	m_jumpNode = PATH_NODE_NONE;
+
+	const u32 node = __GetIndex(start);
+	__AddNode(node, node, 0.f);
+}
+
+World_Path_Status World_Pathfinder::__SearchStep(s32& budget)
+{
+	const s32 budgetStart = budget;
+	const u32 goal = __GetIndex(m_searchGoal);
+
+	World_Path_Status status = World_Path_Status_Pending;
+	while (budget > 0)
+	{
+		// finish the jumps the budget ran out in.
+		if (m_jumpNode != PATH_NODE_NONE)
+		{
+			if (!__ContinueJPS(budget) || (budget <= 0))
+				break;
+		}
+
+		if (m_heap.IsEmpty())
+		{
+			status = World_Path_Status_NotFound;
+			break;
+		}
+
+		const u32 node = m_heap.Pop();
+		--budget;
+		if (node == goal)
+		{
+			status = World_Path_Status_Found;
+			break;
+		}
+
+		if (m_searchMode == World_Path_Mode_JPS)
+		{
+			__ExpandJPS(node);
+		}
+		else
+		{
+			__ExpandAStar(node);
+		}
+	}
+
+	m_metrics.m_nodeCount += static_cast<u32>(budgetStart - budget);
+	return status;
+}
+
+void World_Pathfinder::__SearchEnd(World_Path_Status status, std::vector<IVector2>* pPath)
+{
+	m_isSearching = false;
+	m_searchRequestID = 0;
+	++m_metrics.m_searchCount;
+
+	pPath->clear();
+	if (status != World_Path_Status_Found)
+		return;
+
+	// walk back to the start, then fill in the cells between jump points.
+	u32 node = __GetIndex(m_searchGoal);
+	for (;;)
+	{
+		pPath->push_back(__GetCell(node));
+		const u32 parent = m_nodeParents[node];
+		if (parent == node)
+			break;
+
+		const IVector2 cell = __GetCell(node);
+		const IVector2 cellParent = __GetCell(parent);
+		const IVector2 dir(__GetSign(cellParent.x - cell.x), __GetSign(cellParent.y - cell.y));
+		for (IVector2 step = cell + dir; !((step.x == cellParent.x) && (step.y == cellParent.y)); step = step + dir)
+		{
+			pPath->push_back(step);
+		}
+		node = parent;
+	}
+	std::reverse(pPath->begin(), pPath->end());
+}
+
+void World_Pathfinder::__AddNode(u32 node, u32 parent, f32 cost)
+{
+	if (m_nodeStamps[node] != m_stamp)
+	{
+		m_nodeStamps[node] = m_stamp;
+		m_nodeCosts[node] = cost;
+		m_nodeParents[node] = parent;
+		m_heap.Push(node, cost + __GetHeuristic(__GetCell(node)));
+		return;
+	}
+
+	// the heuristic is consistent, so closed nodes never improve.
+	if (!m_heap.Contains(node) || !(cost < m_nodeCosts[node]))
+		return;
+
+	m_nodeCosts[node] = cost;
+	m_nodeParents[node] = parent;
+	m_heap.DecreaseCost(node, cost + __GetHeuristic(__GetCell(node)));
+}
+
+void World_Pathfinder::__ExpandAStar(u32 node)
+{
+	const IVector2 cell = __GetCell(node);
+	const f32 cost = m_nodeCosts[node];
+	for (u32 i = 0; i < ARRAYSIZE(s_pathDirs); ++i)
+	{
+		const IVector2& dir = s_pathDirs[i];
+		if (!CanStep(cell, dir))
+			continue;
+		__AddNode(__GetIndex(cell + dir), node, cost + GetStepCost(cell, dir));
+	}
+}
+
+void World_Pathfinder::__ExpandJPS(u32 node)
+{
+	// the jumps are made by __ContinueJPS().
+	m_jumpNode = node;
+	m_jumpDirCount = 0;
+	m_jumpDirIndex = 0;
+	m_jumpCell = __GetCell(node);
+	m_jumpStraightIndex = 0;
+
+	const IVector2 cell = __GetCell(node);
+	const u32 parent = m_nodeParents[node];
+
+	// the start has no direction, so look every way.
+	if (parent == node)
+	{
+		for (u32 i = 0; i < ARRAYSIZE(s_pathDirs); ++i)
+		{
+			m_jumpDirs[m_jumpDirCount++] = s_pathDirs[i];
+		}
+		return;
+	}
+
+	const IVector2 cellParent = __GetCell(parent);
+	const IVector2 dir(__GetSign(cell.x - cellParent.x), __GetSign(cell.y - cellParent.y));
+
+	if ((dir.x != 0) && (dir.y != 0))
+	{
+		// diagonal, natural neighbors only.
+		m_jumpDirs[m_jumpDirCount++] = IVector2(dir.x, 0);
+		m_jumpDirs[m_jumpDirCount++] = IVector2(0, dir.y);
+		m_jumpDirs[m_jumpDirCount++] = dir;
+		return;
+	}
+
+	// straight, natural neighbor plus any forced ones to the sides.
+	m_jumpDirs[m_jumpDirCount++] = dir;
+
+	const IVector2 sides[] = { IVector2(dir.y, dir.x), IVector2(-dir.y, -dir.x) };
+	for (u32 i = 0; i < ARRAYSIZE(sides); ++i)
+	{
+		const IVector2& side = sides[i];
+		if (!__IsForced(cell, dir, side))
+			continue;
+		m_jumpDirs[m_jumpDirCount++] = side;
+		m_jumpDirs[m_jumpDirCount++] = dir + side;
+	}
+}
+
+bool World_Pathfinder::__ContinueJPS(s32& budget)
+{
+	const IVector2 cell = __GetCell(m_jumpNode);
+	while (m_jumpDirIndex < m_jumpDirCount)
+	{
+		const IVector2& dir = m_jumpDirs[m_jumpDirIndex];
+		const bool isDiagonal = (dir.x != 0) && (dir.y != 0);
+		const JumpResult result = isDiagonal ? __JumpDiagonal(dir, budget) : __JumpStraight(m_jumpCell, dir, budget);
+		if (result == JumpResult_Paused)
+			return false;
+
+		if (result == JumpResult_Found)
+		{
+			const s32 steps = std::max<s32>(std::abs(m_jumpCell.x - cell.x), std::abs(m_jumpCell.y - cell.y));
+			const f32 cost = static_cast<f32>(steps) * (isDiagonal ? PATH_COST_DIAGONAL : 1.f);
+			__AddNode(__GetIndex(m_jumpCell), m_jumpNode, m_nodeCosts[m_jumpNode] + cost);
+		}
+
+		++m_jumpDirIndex;
+		m_jumpCell = cell;
+		m_jumpStraightIndex = 0;
+	}
+
+	m_jumpNode = PATH_NODE_NONE;
+	return true;
+}
+
+World_Pathfinder::JumpResult World_Pathfinder::__JumpStraight(IVector2& cell, const IVector2& dir, s32& budget) const
+{
+	// stops on the jump point, or where it ran out of budget.
+	const IVector2 sideA(dir.y, dir.x);
+	const IVector2 sideB(-dir.y, -dir.x);
+
+	for (;;)
+	{
+		if (budget <= 0)
+			return JumpResult_Paused;
+		if (!CanStep(cell, dir))
+			return JumpResult_None;
+		cell = cell + dir;
+		--budget;
+
+		if (((cell.x == m_searchGoal.x) && (cell.y == m_searchGoal.y)) || __IsForced(cell, dir, sideA) || __IsForced(cell, dir, sideB))
+			return JumpResult_Found;
+	}
+}
+
+World_Pathfinder::JumpResult World_Pathfinder::__JumpDiagonal(const IVector2& dir, s32& budget)
+{
+	const IVector2 dirX(dir.x, 0);
+	const IVector2 dirY(0, dir.y);
+
+	for (;;)
+	{
+		if (m_jumpStraightIndex == 0)
+		{
+			if (budget <= 0)
+				return JumpResult_Paused;
+			if (!CanStep(m_jumpCell, dir))
+				return JumpResult_None;
+			m_jumpCell = m_jumpCell + dir;
+			--budget;
+
+			if ((m_jumpCell.x == m_searchGoal.x) && (m_jumpCell.y == m_searchGoal.y))
+				return JumpResult_Found;
+			m_jumpStraightIndex = 1;
+			m_jumpStraightCell = m_jumpCell;
+		}
+
+		// a diagonal stops where either straight component would find something.
+		const JumpResult result = __JumpStraight(m_jumpStraightCell, (m_jumpStraightIndex == 1) ? dirX : dirY, budget);
+		if (result != JumpResult_None)
+			return result;
+
+		if (m_jumpStraightIndex == 1)
+		{
+			m_jumpStraightIndex = 2;
+			m_jumpStraightCell = m_jumpCell;
+		}
+		else
+		{
+			m_jumpStraightIndex = 0;
+		}
+	}
+}
+
+}
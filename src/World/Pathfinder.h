@@ -0,0 +1,159 @@
+#pragma once
+
+#include <vector>
+
+#include "Common/basic_types.h"
+
+#include "PathHeap.h"
+
+namespace TB8
+{
+
+class World_WallGrid;
+
+enum World_Path_Mode : u32
+{
+	World_Path_Mode_Auto,			// jps when every cell costs the same, otherwise a*.
+	World_Path_Mode_JPS,
+	World_Path_Mode_AStar,
+};
+
+enum World_Path_Status : u32
+{
+	World_Path_Status_None,
+	World_Path_Status_Pending,
+	World_Path_Status_Found,
+	World_Path_Status_NotFound,
+};
+
+struct World_Pathfinder_Metrics
+{
+	World_Pathfinder_Metrics() { Clear(); }
+	void Clear();
+
+	u32						m_searchCount;			// searches run to completion.
+	u32						m_cacheHitCount;
+	u32						m_nodeCount;			// nodes expanded and cells scanned by jumps.
+};
+
+// 8-way pathfinding over the map cells and the wall grid.
+//  node state is generation stamped and the open list is a reusable heap, so a search doesn't allocate.  results
+//  are cached by (start, goal) until the walls or cell costs change.  paths are every cell from start to goal.
+class World_Pathfinder
+{
+public:
+	World_Pathfinder(const World_WallGrid& wallGrid);
+
+	void Resize(const IVector2& size);
+
+	// 0 is impassable, 1 is the base cost.
+	void SetCellCost(const IVector2& cell, u8 cost);
+	u8 GetCellCost(const IVector2& cell) const;
+	bool IsUniformCost() const { return m_weightedCellCount == 0; }
+	const IVector2& GetSize() const { return m_size; }
+
+	// movement rules shared with the other navigation structures.
+	bool IsPassable(const IVector2& cell) const;
+	bool CanStep(const IVector2& cell, const IVector2& dir) const;
+	f32 GetStepCost(const IVector2& cell, const IVector2& dir) const;
+
+	// runs the whole search now.
+	World_Path_Status FindPath(const IVector2& start, const IVector2& goal, std::vector<IVector2>* pPath, World_Path_Mode mode = World_Path_Mode_Auto);
+
+	// time-sliced, requests are searched in order by Update() within its node budget.
+	u32 RequestPath(const IVector2& start, const IVector2& goal, World_Path_Mode mode = World_Path_Mode_Auto);
+	World_Path_Status GetRequestStatus(u32 requestID) const;
+	bool GetRequestPath(u32 requestID, std::vector<IVector2>* pPath) const;
+	void ReleaseRequest(u32 requestID);
+	void Update(u32 nodeBudget);
+
+	const World_Pathfinder_Metrics& GetMetrics() const { return m_metrics; }
+
+private:
+	struct Request
+	{
+		u32							m_id;				// 0 when the slot is free.
+		u32							m_serial;			// request order.
+		World_Path_Status			m_status;
+		World_Path_Mode				m_mode;
+		IVector2					m_start;
+		IVector2					m_goal;
+		std::vector<IVector2>		m_path;
+	};
+
+	enum JumpResult : u32
+	{
+		JumpResult_None,
+		JumpResult_Found,
+		JumpResult_Paused,			// out of budget, resumed by the next __SearchStep().
+	};
+
+	struct CacheEntry
+	{
+		u64							m_key;
+		u32							m_lastUsed;
+		World_Path_Status			m_status;
+		std::vector<IVector2>		m_path;
+	};
+
+	u32 __GetIndex(const IVector2& cell) const { return static_cast<u32>((cell.y * m_size.x) + cell.x); }
+	IVector2 __GetCell(u32 index) const { return IVector2(static_cast<s32>(index % m_size.x), static_cast<s32>(index / m_size.x)); }
+	bool __IsForced(const IVector2& cell, const IVector2& dir, const IVector2& side) const;
+	f32 __GetHeuristic(const IVector2& cell) const;
+
+	Request* __FindRequest(u32 requestID);
+	const Request* __FindRequest(u32 requestID) const;
+
+	bool __FindCache(const IVector2& start, const IVector2& goal, World_Path_Status* pStatus, std::vector<IVector2>* pPath);
+	void __AddCache(const IVector2& start, const IVector2& goal, World_Path_Status status, const std::vector<IVector2>& path);
+	void __ValidateCache();
+
+	void __SearchBegin(const IVector2& start, const IVector2& goal, World_Path_Mode mode);
+	World_Path_Status __SearchStep(s32& budget);
+	void __SearchEnd(World_Path_Status status, std::vector<IVector2>* pPath);
+	void __AddNode(u32 node, u32 parent, f32 cost);
+	void __ExpandAStar(u32 node);
+	void __ExpandJPS(u32 node);
+	bool __ContinueJPS(s32& budget);
+	JumpResult __JumpStraight(IVector2& cell, const IVector2& dir, s32& budget) const;
+	JumpResult __JumpDiagonal(const IVector2& dir, s32& budget);
+
+	const World_WallGrid&			m_wallGrid;
+	IVector2						m_size;
+	std::vector<u8>					m_cellCosts;
+	u32								m_weightedCellCount;
+	u32								m_costRevision;
+
+	// search state, one search at a time.
+	World_PathHeap					m_heap;
+	std::vector<u32>				m_nodeStamps;
+	std::vector<f32>				m_nodeCosts;
+	std::vector<u32>				m_nodeParents;
+	u32								m_stamp;
+	bool							m_isSearching;
+	u32								m_searchRequestID;	// time-sliced request being searched, 0 for none.
+	World_Path_Mode					m_searchMode;
+	IVector2						m_searchStart;
+	IVector2						m_searchGoal;
+
+	// the jps node being expanded, its jumps are resumed where they stopped when the budget runs out.
+	u32								m_jumpNode;			// PATH_NODE_NONE when there's none.
+	IVector2						m_jumpDirs[8];
+	u32								m_jumpDirCount;
+	u32								m_jumpDirIndex;
+	IVector2						m_jumpCell;			// where the current jump has reached.
+	IVector2						m_jumpStraightCell;	// where a diagonal jump's straight scan has reached.
+	u32								m_jumpStraightIndex;	// 0 before the diagonal step, then 1 or 2 scanning x or y.
+
+	std::vector<Request>			m_requests;
+	u32								m_requestSerial;
+
+	std::vector<CacheEntry>			m_cache;
+	u32								m_cacheClock;
+	u32								m_cacheWallRevision;
+	u32								m_cacheCostRevision;
+
+	World_Pathfinder_Metrics		m_metrics;
+};
+
+}
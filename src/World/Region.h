@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include "Common/basic_types.h"
+
+#include "Integrator.h"
+#include "Broadphase.h"
+
+namespace TB8
+{
+
+struct World_Unit;
+
+const u32 WORLD_REGION_NONE = 0xffffffff;
+
+// square block of map cells, updated as one job.
+//  units are assigned to a region by their position at the start of the tick.  a region integrates its units, resolves
+//  their wall collisions, and resolves unit collisions between units whose bounds lie inside it.  everything else is
+//  left to the serial phase that follows.
+struct World_Region
+{
+	IVector2						m_cellMin;
+	IVector2						m_cellMax;			// exclusive.
+
+	std::vector<u32>				m_unitIndicies;		// index into World::m_tickUnits.
+	std::vector<World_Unit*>		m_units;
+	std::vector<s32>				m_frameCounts;		// frames each unit advances.
+	std::vector<World_UnitMove>		m_moves;
+	std::vector<u8>					m_isInterior;		// bounds lie strictly inside the region.
+
+	World_Integrator				m_integrator;
+	World_Broadphase				m_broadphase;
+	std::vector<Vector2>			m_boundsMin;
+	std::vector<Vector2>			m_boundsMax;
+};
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Common/basic_types.h"
+#include "Common/ref_count.h"
+
+namespace TB8
+{
+
+// what the world draws with.  the world only sees these, so it simulates the same with a window and gpu behind them
+//  or, with World_RenderNull, with nothing.
+
+struct World_RenderModel_Bounds
+{
+	Vector3							m_min;
+	Vector3							m_max;
+	Vector3							m_center;
+	Vector3							m_size;
+};
+
+// blend of two animations, -1 for the model's base pose.  each object keeps its own, models are shared.
+struct World_RenderModel_Pose
+{
+	World_RenderModel_Pose()
+		: m_animID0(-1)
+		, m_animID1(-1)
+		, m_t(0.f)
+	{
+	}
+
+	s32								m_animID0;
+	s32								m_animID1;
+	f32								m_t;
+};
+
+class World_RenderModel : public ref_count
+{
+public:
+	// of the first mesh.
+	virtual const World_RenderModel_Bounds& GetBounds() const = 0;
+	virtual u32 GetAnimCount() const = 0;
+	// nullptr if the model doesn't have <animID>.
+	virtual const World_RenderModel_Bounds* GetAnimBounds(s32 animID) const = 0;
+
+	virtual void Render(const Matrix4& worldTransform, const World_RenderModel_Pose& pose) = 0;
+};
+
+enum World_RenderThought_Type : u32
+{
+	World_RenderThought_Type_Imagine,
+	World_RenderThought_Type_Speech,
+};
+
+// a unit's thought bubble.
+class World_RenderThought : public ref_count
+{
+public:
+	virtual void Render(const Vector2& screenPos) = 0;
+};
+
+// the avatar's status bars.  the avatar keeps the values, the bars only show them.
+class World_RenderStatusBars : public ref_count
+{
+public:
+	// <uv0> to <uv1> is the bar's icon in the texture the bars were allocated with.
+	virtual u32 AddBar(const char* pszName, const Vector2& uv0, const Vector2& uv1, s32 value, s32 maxValue, s32 incrementSize) = 0;
+	virtual void SetBarValue(u32 barID, s32 value) = 0;
+
+	virtual void Render2D() = 0;
+	virtual void Render3D() = 0;
+};
+
+class World_Render
+{
+public:
+	virtual ~World_Render() {}
+
+	// nullptr if the model doesn't load, or has no mesh.
+	virtual World_RenderModel* AllocModelFromDAE(const char* pszPath, const char* pszFile, const char* pszModelName) = 0;
+	// one meter square tile, facing up.
+	virtual World_RenderModel* AllocModelFromTexture(const char* pszTexturePath) = 0;
+	virtual World_RenderThought* AllocThought(World_RenderThought_Type type, const char* pszText) = 0;
+	virtual World_RenderStatusBars* AllocStatusBars(const char* pszTexturePath) = 0;
+
+	// snap world sizes and positions to whole pixels.  reads the current views, so only call it on the main thread.
+	virtual void AlignWorldSize(Vector3& worldSize) const = 0;
+	virtual void AlignWorldPosition(Vector3& worldPos) const = 0;
+	virtual Vector2 WorldToScreenCoords(const Vector3& worldPos) const = 0;
+	virtual Vector2 GetScreenSizeWorld() const = 0;
+};
+
+}
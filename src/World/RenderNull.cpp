@@ -0,0 +1,111 @@
+#include "pch.h"
+
+#include "Common/memory.h"
+
+#include "RenderNull.h"
+
+namespace TB8
+{
+
+const f32 NULL_MODEL_SIZE = 1.f;
+const Vector2 NULL_SCREEN_SIZE_WORLD(16.f, 9.f);
+
+class World_RenderNull_Model : public World_RenderModel
+{
+public:
+	World_RenderNull_Model()
+	{
+		m_bounds.m_min = Vector3(-NULL_MODEL_SIZE / 2.f, -NULL_MODEL_SIZE / 2.f, -NULL_MODEL_SIZE / 2.f);
+		m_bounds.m_max = Vector3(NULL_MODEL_SIZE / 2.f, NULL_MODEL_SIZE / 2.f, NULL_MODEL_SIZE / 2.f);
+		m_bounds.m_center = Vector3(0.f, 0.f, 0.f);
+		m_bounds.m_size = Vector3(NULL_MODEL_SIZE, NULL_MODEL_SIZE, NULL_MODEL_SIZE);
+	}
+
+	virtual const World_RenderModel_Bounds& GetBounds() const override { return m_bounds; }
+	virtual u32 GetAnimCount() const override { return 0; }
+	virtual const World_RenderModel_Bounds* GetAnimBounds(s32 /*animID*/) const override { return nullptr; }
+	virtual void Render(const Matrix4& /*worldTransform*/, const World_RenderModel_Pose& /*pose*/) override {}
+
+private:
+	virtual void __Free() override { TB8_DEL(this); }
+
+	World_RenderModel_Bounds		m_bounds;
+};
+
+class World_RenderNull_Thought : public World_RenderThought
+{
+public:
+	virtual void Render(const Vector2& /*screenPos*/) override {}
+
+private:
+	virtual void __Free() override { TB8_DEL(this); }
+};
+
+class World_RenderNull_StatusBars : public World_RenderStatusBars
+{
+public:
+	World_RenderNull_StatusBars()
+		: m_barCount(0)
+	{
+	}
+
+	virtual u32 AddBar(const char* /*pszName*/, const Vector2& /*uv0*/, const Vector2& /*uv1*/, s32 /*value*/, s32 /*maxValue*/, s32 /*incrementSize*/) override { return ++m_barCount; }
+	virtual void SetBarValue(u32 /*barID*/, s32 /*value*/) override {}
+	virtual void Render2D() override {}
+	virtual void Render3D() override {}
+
+private:
+	virtual void __Free() override { TB8_DEL(this); }
+
+	u32								m_barCount;
+};
+
+World_RenderNull* World_RenderNull::Alloc()
+{
+	return TB8_NEW(World_RenderNull)();
+}
+
+void World_RenderNull::Free()
+{
+	TB8_DEL(this);
+}
+
+World_RenderModel* World_RenderNull::AllocModelFromDAE(const char* /*pszPath*/, const char* /*pszFile*/, const char* /*pszModelName*/)
+{
+	return TB8_NEW(World_RenderNull_Model)();
+}
+
+World_RenderModel* World_RenderNull::AllocModelFromTexture(const char* /*pszTexturePath*/)
+{
+	return TB8_NEW(World_RenderNull_Model)();
+}
+
+World_RenderThought* World_RenderNull::AllocThought(World_RenderThought_Type /*type*/, const char* /*pszText*/)
+{
+	return TB8_NEW(World_RenderNull_Thought)();
+}
+
+World_RenderStatusBars* World_RenderNull::AllocStatusBars(const char* /*pszTexturePath*/)
+{
+	return TB8_NEW(World_RenderNull_StatusBars)();
+}
+
+void World_RenderNull::AlignWorldSize(Vector3& /*worldSize*/) const
+{
+}
+
+void World_RenderNull::AlignWorldPosition(Vector3& /*worldPos*/) const
+{
+}
+
+Vector2 World_RenderNull::WorldToScreenCoords(const Vector3& worldPos) const
+{
+	return Vector2(worldPos.x, worldPos.y);
+}
+
+Vector2 World_RenderNull::GetScreenSizeWorld() const
+{
+	return NULL_SCREEN_SIZE_WORLD;
+}
+
+}
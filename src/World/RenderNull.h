@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Common/basic_types.h"
+
+#include "Render.h"
+
+namespace TB8
+{
+
+// renders nothing, for running the world with no window or gpu: servers, benchmarks and tests.
+//  models are one meter cubes with no animations, since their meshes are never loaded.
+class World_RenderNull : public World_Render
+{
+public:
+	static World_RenderNull* Alloc();
+	void Free();
+
+	virtual World_RenderModel* AllocModelFromDAE(const char* pszPath, const char* pszFile, const char* pszModelName) override;
+	virtual World_RenderModel* AllocModelFromTexture(const char* pszTexturePath) override;
+	virtual World_RenderThought* AllocThought(World_RenderThought_Type type, const char* pszText) override;
+	virtual World_RenderStatusBars* AllocStatusBars(const char* pszTexturePath) override;
+
+	virtual void AlignWorldSize(Vector3& worldSize) const override;
+	virtual void AlignWorldPosition(Vector3& worldPos) const override;
+	virtual Vector2 WorldToScreenCoords(const Vector3& worldPos) const override;
+	virtual Vector2 GetScreenSizeWorld() const override;
+};
+
+}
@@ -0,0 +1,244 @@
+#include "pch.h"
+
+#include "SimLod.h"
+
+#include "Unit.h"
+
+namespace TB8
+{
+
+const f32 SIMLOD_NEAR_DIST = 24.f;			// meters from a focus point that units tick every frame.
+const f32 SIMLOD_MID_DIST = 64.f;
+const s32 SIMLOD_INTERVAL_MID = 4;
+const s32 SIMLOD_INTERVAL_FAR = 16;			// a power of two, the others divide it.
+const f32 SIMLOD_WAKE_MARGIN = 2.f;			// added to a moving unit's reach when waking its neighbours.
+const f32 SIMLOD_BUCKET_SIZE = 8.f;
+const u32 SIMLOD_BUCKET_COUNT = 1024;
+
+void World_SimLod_Metrics::Clear()
+{
+	m_awakeCount = 0;
+	m_asleepCount = 0;
+	m_tickCount = 0;
+	m_wakeCount = 0;
+	m_sleepCount = 0;
+}
+
+World_SimLod::World_SimLod()
+	: m_clock(0)
+{
+	m_sleepBuckets.resize(SIMLOD_BUCKET_COUNT);
+}
+
+void World_SimLod::Reset(u32 unitCount)
+{
+	m_awake.resize(unitCount);
+	m_awakeSlots.resize(unitCount);
+	for (u32 i = 0; i < unitCount; ++i)
+	{
+		m_awake[i] = i;
+		m_awakeSlots[i] = i;
+	}
+	m_isAsleep.assign(unitCount, 0);
+	m_isWakeDue.assign(unitCount, 0);
+	m_frames.assign(unitCount, 0);
+
+	for (std::vector<std::vector<u32>>::iterator it = m_sleepBuckets.begin(); it != m_sleepBuckets.end(); ++it)
+	{
+		it->clear();
+	}
+	m_sleepSlots.assign(unitCount, 0);
+	m_sleepBucketIndicies.assign(unitCount, 0);
+	m_sleepPos.resize(unitCount);
+
+	m_tickUnits.clear();
+	m_tickFrames.clear();
+}
+
+void World_SimLod::SetFocus(const Vector2* pFocus, u32 focusCount)
+{
+	m_focus.assign(pFocus, pFocus + focusCount);
+}
+
+void World_SimLod::Schedule(s32 frameCount, World_Unit* const* ppUnits)
+{
+	const u32 wakeCount = m_metrics.m_wakeCount;
+	m_metrics.Clear();
+	m_metrics.m_wakeCount = wakeCount;
+
+	const u32 clockPrev = m_clock;
+	m_clock += static_cast<u32>(frameCount);
+
+	// everything near a focus point is awake.
+	for (std::vector<Vector2>::const_iterator it = m_focus.begin(); it != m_focus.end(); ++it)
+	{
+		WakeRect(Vector2(it->x - SIMLOD_NEAR_DIST, it->y - SIMLOD_NEAR_DIST), Vector2(it->x + SIMLOD_NEAR_DIST, it->y + SIMLOD_NEAR_DIST));
+	}
+
+	// units woken by a moving unit are appended to m_awake, and picked up later in this loop.
+	m_tickUnits.clear();
+	for (u32 i = 0; i < m_awake.size(); ++i)
+	{
+		const u32 unit = m_awake[i];
+		const World_Unit& unitObj = *ppUnits[unit];
+		const Vector2 pos(unitObj.m_pos.x, unitObj.m_pos.y);
+		m_frames[unit] += frameCount;
+
+		// a unit ticks when the clock crosses a multiple of its interval, offset by its phase.
+		const u32 interval = static_cast<u32>(GetTickInterval(pos));
+		const u32 phase = unit & (SIMLOD_INTERVAL_FAR - 1);
+		const bool isDue = m_isWakeDue[unit] || (((m_clock + phase) / interval) != ((clockPrev + phase) / interval));
+		if (!isDue)
+			continue;
+		m_isWakeDue[unit] = 0;
+
+		// wake anything it could reach this tick.
+		const bool isMoving = !is_approx_zero(unitObj.m_velocity.x) || !is_approx_zero(unitObj.m_velocity.y)
+			|| !is_approx_zero(unitObj.GetForce().x) || !is_approx_zero(unitObj.GetForce().y);
+		if (isMoving)
+		{
+			const f32 reach = (unitObj.m_maxVelocity * static_cast<f32>(m_frames[unit]) / UNIT_FRAMES_PER_SECOND) + SIMLOD_WAKE_MARGIN;
+			WakeRect(Vector2(pos.x - reach, pos.y - reach), Vector2(pos.x + reach, pos.y + reach));
+		}
+
+		m_tickUnits.push_back(unit);
+	}
+
+	// tick in unit order, so results don't depend on the order units woke.
+	std::sort(m_tickUnits.begin(), m_tickUnits.end());
+	m_tickFrames.resize(m_tickUnits.size());
+	for (u32 i = 0; i < m_tickUnits.size(); ++i)
+	{
+		const u32 unit = m_tickUnits[i];
+		m_tickFrames[i] = m_frames[unit];
+		m_frames[unit] = 0;
+	}
+
+	m_metrics.m_awakeCount = static_cast<u32>(m_awake.size());
+	m_metrics.m_asleepCount = GetUnitCount() - m_metrics.m_awakeCount;
+	m_metrics.m_tickCount = static_cast<u32>(m_tickUnits.size());
+}
+
+void World_SimLod::Sleep(u32 unit, const Vector2& pos)
+{
+	if (m_isAsleep[unit])
+		return;
+
+	// swap the last awake unit into its slot.
+	const u32 slot = m_awakeSlots[unit];
+	const u32 unitLast = m_awake.back();
+	m_awake[slot] = unitLast;
+	m_awakeSlots[unitLast] = slot;
+	m_awake.pop_back();
+
+	const u32 bucket = __GetBucket(static_cast<s32>(std::floor(pos.x / SIMLOD_BUCKET_SIZE)), static_cast<s32>(std::floor(pos.y / SIMLOD_BUCKET_SIZE)));
+	m_sleepBucketIndicies[unit] = bucket;
+	m_sleepSlots[unit] = static_cast<u32>(m_sleepBuckets[bucket].size());
+	m_sleepBuckets[bucket].push_back(unit);
+	m_sleepPos[unit] = pos;
+
+	m_isAsleep[unit] = 1;
+	m_isWakeDue[unit] = 0;
+	m_frames[unit] = 0;
+	++m_metrics.m_sleepCount;
+}
+
+void World_SimLod::Wake(u32 unit)
+{
+	if (!m_isAsleep[unit])
+		return;
+
+	__RemoveSleeper(unit);
+
+	m_awakeSlots[unit] = static_cast<u32>(m_awake.size());
+	m_awake.push_back(unit);
+
+	m_isAsleep[unit] = 0;
+	m_isWakeDue[unit] = 1;
+	++m_metrics.m_wakeCount;
+}
+
+void World_SimLod::WakeRect(const Vector2& min, const Vector2& max)
+{
+	const s32 left = static_cast<s32>(std::floor(min.x / SIMLOD_BUCKET_SIZE));
+	const s32 top = static_cast<s32>(std::floor(min.y / SIMLOD_BUCKET_SIZE));
+	const s32 right = static_cast<s32>(std::floor(max.x / SIMLOD_BUCKET_SIZE));
+	const s32 bottom = static_cast<s32>(std::floor(max.y / SIMLOD_BUCKET_SIZE));
+
+	// the buckets the rect covers, or all of them when it covers more cells than there are buckets.
+	m_wakeBuckets.clear();
+	if ((static_cast<s64>(right - left + 1) * static_cast<s64>(bottom - top + 1)) > static_cast<s64>(SIMLOD_BUCKET_COUNT))
+	{
+		for (u32 bucket = 0; bucket < SIMLOD_BUCKET_COUNT; ++bucket)
+		{
+			m_wakeBuckets.push_back(bucket);
+		}
+	}
+	else
+	{
+		for (s32 y = top; y <= bottom; ++y)
+		{
+			for (s32 x = left; x <= right; ++x)
+			{
+				m_wakeBuckets.push_back(__GetBucket(x, y));
+			}
+		}
+	}
+
+	// collect first, waking changes the buckets.
+	m_wakeList.clear();
+	for (std::vector<u32>::const_iterator itBucket = m_wakeBuckets.begin(); itBucket != m_wakeBuckets.end(); ++itBucket)
+	{
+		const std::vector<u32>& bucket = m_sleepBuckets[*itBucket];
+		for (std::vector<u32>::const_iterator it = bucket.begin(); it != bucket.end(); ++it)
+		{
+			const Vector2& pos = m_sleepPos[*it];
+			if ((pos.x >= min.x) && (pos.y >= min.y) && (pos.x <= max.x) && (pos.y <= max.y))
+			{
+				m_wakeList.push_back(*it);
+			}
+		}
+	}
+
+	for (std::vector<u32>::const_iterator it = m_wakeList.begin(); it != m_wakeList.end(); ++it)
+	{
+		Wake(*it);
+	}
+}
+
+s32 World_SimLod::GetTickInterval(const Vector2& pos) const
+{
+	if (m_focus.empty())
+		return 1;
+
+	f32 distSq = FLT_MAX;
+	for (std::vector<Vector2>::const_iterator it = m_focus.begin(); it != m_focus.end(); ++it)
+	{
+		distSq = std::min(distSq, (pos - *it).MagSq());
+	}
+
+	if (distSq < (SIMLOD_NEAR_DIST * SIMLOD_NEAR_DIST))
+		return 1;
+	if (distSq < (SIMLOD_MID_DIST * SIMLOD_MID_DIST))
+		return SIMLOD_INTERVAL_MID;
+	return SIMLOD_INTERVAL_FAR;
+}
+
+u32 World_SimLod::__GetBucket(s32 cellX, s32 cellY) const
+{
+	const u32 hash = (static_cast<u32>(cellX) * 73856093u) ^ (static_cast<u32>(cellY) * 19349663u);
+	return hash & (SIMLOD_BUCKET_COUNT - 1);
+}
+
+void World_SimLod::__RemoveSleeper(u32 unit)
+{
+	// swap the last unit in the bucket into its slot.
+	std::vector<u32>& bucket = m_sleepBuckets[m_sleepBucketIndicies[unit]];
+	const u32 slot = m_sleepSlots[unit];
+	const u32 unitLast = bucket.back();
+	bucket[slot] = unitLast;
+	m_sleepSlots[unitLast] = slot;
+	bucket.pop_back();
+}
+
+}
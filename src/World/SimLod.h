@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+
+#include "Common/basic_types.h"
+
+namespace TB8
+{
+
+struct World_Unit;
+
+struct World_SimLod_Metrics
+{
+	World_SimLod_Metrics() { Clear(); }
+	void Clear();
+
+	u32						m_awakeCount;
+	u32						m_asleepCount;
+	u32						m_tickCount;			// units ticked this frame.
+	u32						m_wakeCount;			// units woken this frame.
+	u32						m_sleepCount;			// units put to sleep this frame.
+};
+
+// simulation level of detail for units.
+//  awake units tick at a rate set by their distance to the nearest focus point, every frame up close and every few
+//  frames further out, with the frames in between accumulated into the next tick.  ticks are staggered by unit so a
+//  rate doesn't tick all its units on the same frame.  asleep units aren't visited at all, they sit in a spatial hash
+//  until a focus point or a moving unit comes near, or the world wakes them.  units are indicies into World::m_units.
+class World_SimLod
+{
+public:
+	World_SimLod();
+
+	// every unit awake.
+	void Reset(u32 unitCount);
+	u32 GetUnitCount() const { return static_cast<u32>(m_isAsleep.size()); }
+
+	void SetFocus(const Vector2* pFocus, u32 focusCount);
+
+	// advances the clock, and lists the units due a tick with the frames each has accumulated.
+	void Schedule(s32 frameCount, World_Unit* const* ppUnits);
+
+	void Sleep(u32 unit, const Vector2& pos);
+	void Wake(u32 unit);
+	void WakeRect(const Vector2& min, const Vector2& max);
+	bool IsAsleep(u32 unit) const { return m_isAsleep[unit] != 0; }
+
+	// frames between ticks at <pos>, 1 near a focus point.
+	s32 GetTickInterval(const Vector2& pos) const;
+
+	const std::vector<u32>& GetAwakeUnits() const { return m_awake; }
+	const std::vector<u32>& GetTickUnits() const { return m_tickUnits; }
+	const std::vector<s32>& GetTickFrames() const { return m_tickFrames; }
+	const World_SimLod_Metrics& GetMetrics() const { return m_metrics; }
+
+private:
+	u32 __GetBucket(s32 cellX, s32 cellY) const;
+	void __RemoveSleeper(u32 unit);
+
+	std::vector<Vector2>			m_focus;
+	u32								m_clock;
+
+	std::vector<u32>				m_awake;
+	std::vector<u32>				m_awakeSlots;		// per unit, index into m_awake.
+	std::vector<u8>					m_isAsleep;
+	std::vector<u8>					m_isWakeDue;		// woken since the last Schedule(), ticks on the next regardless of rate.
+	std::vector<s32>				m_frames;			// per unit, frames since its last tick.
+
+	// asleep units, hashed by cell.
+	std::vector<std::vector<u32>>	m_sleepBuckets;
+	std::vector<u32>				m_sleepSlots;		// per unit, index into its bucket.
+	std::vector<u32>				m_sleepBucketIndicies;
+	std::vector<Vector2>			m_sleepPos;
+	std::vector<u32>				m_wakeBuckets;
+	std::vector<u32>				m_wakeList;
+
+	std::vector<u32>				m_tickUnits;
+	std::vector<s32>				m_tickFrames;
+
+	World_SimLod_Metrics			m_metrics;
+};
+
+}
@@ -1,8 +1,7 @@
 #include "pch.h"
 
-#include "render/RenderMain.h"
-#include "render/RenderModel.h"
-#include "render/RenderImagine.h"
+#include "Event/EventQueue.h"
+#include "Event/EventQueueMessages.h"
 
 #include "Unit.h"
 
@@ -45,6 +44,8 @@ void World_Unit::Free()
 
 World_Unit::~World_Unit()
 {
+	__GetEventQueue()->CancelMessage(m_thoughtTimerID);
+	__GetEventQueue()->Unregister<EventMessage_UnitThought>(EventModuleID_World, m_eventID, m_eventID);
 	RELEASEI(m_pImagine);
 }
 
@@ -52,39 +53,57 @@ void World_Unit::__Initialize()
 {
 	m_sittingFrame = SITTING_FRAME_MAX;
 
-	m_thoughtFrame = 0;
-	m_thoughtFrameNext = (THOUGHT_FRAME_HIDE_MIN + (rand() % (THOUGHT_FRAME_HIDE_MAX - THOUGHT_FRAME_HIDE_MIN)));
+	m_eventID = __GetGlobals()->GetNewID();
+	__GetEventQueue()->Register<EventMessage_UnitThought>(EventModuleID_World, m_eventID, m_eventID, this, &World_Unit::__OnThought);
+
 	m_thoughtFrequency.resize(ARRAYSIZE(s_mooeyThoughts));
+	__ScheduleThought(THOUGHT_FRAME_HIDE_MIN, THOUGHT_FRAME_HIDE_MAX);
+}
+
+void World_Unit::SeedRandom(u64 seed, u64 stream)
+{
+	m_random.Seed(seed, stream);
+	if (IsSitting() && !m_pImagine)
+	{
+		__ScheduleThought(THOUGHT_FRAME_HIDE_MIN, THOUGHT_FRAME_HIDE_MAX);
+	}
+}
+
+void World_Unit::__ScheduleThought(s32 frameMin, s32 frameMax)
+{
+	__GetEventQueue()->CancelMessage(m_thoughtTimerID);
+
+	EventMessage* pEvent = EventMessage_UnitThought::Alloc(m_eventID);
+	m_thoughtTimerID = __GetEventQueue()->QueueMessageAfter(&pEvent, static_cast<u32>(m_random.Next(frameMin, frameMax)));
 }
 
 void World_Unit::Render2D(const Vector3& screenWorldPos)
 {
 	if (m_pImagine)
 	{
-		const Vector3 renderWorldPos = m_pos - screenWorldPos;
+		const Vector3 renderWorldPos = m_renderPos - screenWorldPos;
 		const Vector3 renderWorldPosUL(renderWorldPos.x, renderWorldPos.y, renderWorldPos.z + (m_size.y * m_scale));
-		const Vector2 screenPos = __GetRenderer()->WorldToScreenCoords(renderWorldPosUL);
+		const Vector2 screenPos = __GetWorldRender()->WorldToScreenCoords(renderWorldPosUL);
 
-		m_pImagine->SetPosition(screenPos);
-		m_pImagine->Render();
+		m_pImagine->Render(screenPos);
 	}
 }
 
 void World_Unit::ComputeNextPosition(s32 frameCount, Vector3& pos, Vector3& vel)
 {
 	// compute environmental forces.
-	const f32 forceFactor = 20.f;
-	const f32 forceDampen = 10.0f;
-	const f32 windResistFactor = 0.25f;
-	const f32 gravityFactor = 10.0f;
-	const f32 elapsedTime = static_cast<f32>(frameCount) / 60.f;
+	const f32 forceFactor = UNIT_FORCE_FACTOR;
+	const f32 forceDampen = UNIT_FORCE_DAMPEN;
+	const f32 windResistFactor = UNIT_WIND_RESIST_FACTOR;
+	const f32 gravityFactor = UNIT_GRAVITY_FACTOR;
+	const f32 elapsedTime = static_cast<f32>(frameCount) / UNIT_FRAMES_PER_SECOND;
 
 	// process jumping.
 	if (!is_approx_zero(m_force.z))
 	{
 		if (is_approx_zero(m_pos.z))
 		{
-			m_velocity.z = +4.f;
+			m_velocity.z = +UNIT_JUMP_VELOCITY;
 		}
 		m_force.z = 0.f;
 	}
@@ -156,6 +175,31 @@ void World_Unit::ComputeNextPosition(s32 frameCount, Vector3& pos, Vector3& vel)
 	}
 }
 
+void World_Unit::SteerToVelocity(s32 frameCount, const Vector2& vel)
+{
+	// invert ComputeNextPosition() on each axis, the force that cancels the drag and makes up the difference.
+	const f32 elapsedTime = static_cast<f32>(frameCount) / UNIT_FRAMES_PER_SECOND;
+	const f32 drag = UNIT_FORCE_DAMPEN + (m_velocity.MagSq() * UNIT_WIND_RESIST_FACTOR);
+	const f32 velCur[2] = { m_velocity.x, m_velocity.y };
+	const f32 velNew[2] = { vel.x, vel.y };
+	f32 force[2];
+	for (u32 axis = 0; axis < 2; ++axis)
+	{
+		if (is_approx_zero(velNew[axis]) && is_approx_zero(velCur[axis]))
+		{
+			force[axis] = 0.f;
+			continue;
+		}
+
+		const f32 accel = (velNew[axis] - velCur[axis]) / elapsedTime;
+		force[axis] = ((accel * m_mass) + (drag * get_sign(velCur[axis]))) / UNIT_FORCE_FACTOR;
+		force[axis] = std::min(std::max(force[axis], -1.f), 1.f);
+	}
+
+	m_force.x = force[0];
+	m_force.y = force[1];
+}
+
 void World_Unit::UpdatePosition(s32 frameCount, const Vector3& pos, const Vector3& vel)
 {
 	// compute new facing.
@@ -165,7 +209,7 @@ void World_Unit::UpdatePosition(s32 frameCount, const Vector3& pos, const Vector
 		Vector2 facingVector(vel.x, vel.y);
 		facingVector.Normalize();
 		const f32 angle = std::atan2(facingVector.y, facingVector.x);
-		facing = (angle / DirectX::XM_PI) * 180.f;
+		facing = (angle / PI) * 180.f;
 	}
 
 	// compute distance traveled.
@@ -177,13 +221,17 @@ void World_Unit::UpdatePosition(s32 frameCount, const Vector3& pos, const Vector
 	{
 		if (m_sittingFrame > 0)
 		{
+			if (m_sittingFrame == SITTING_FRAME_MAX)
+			{
+				__OnStandUp();
+			}
 			RELEASEI(m_pImagine);
 
 			m_sittingFrame -= (frameCount * 2);
 
 			if (m_sittingFrame > 0)
 			{
-				u32 animCount = m_pModel->GetAnimCount();
+				const u32 animCount = __GetAnimCount();
 				const f32 animRange = static_cast<f32>(animCount);
 				const u32 animIndex0 = static_cast<u32>(m_animIndex * animRange) % animCount;
 				const f32 t = static_cast<f32>(SITTING_FRAME_MAX - m_sittingFrame) / static_cast<f32>(SITTING_FRAME_MAX);
@@ -207,7 +255,7 @@ void World_Unit::UpdatePosition(s32 frameCount, const Vector3& pos, const Vector
 			m_animIndex -= 1.f;
 
 		// decide which two animations we'll interpolate between.
-		u32 animCount = m_pModel->GetAnimCount();
+		const u32 animCount = __GetAnimCount();
 		const f32 animRange = static_cast<f32>(animCount);
 		const u32 animIndex0 = static_cast<u32>(m_animIndex * animRange) % animCount;
 		const u32 animIndex1 = (animIndex0 + 1) % animCount;
@@ -230,7 +278,7 @@ void World_Unit::UpdatePosition(s32 frameCount, const Vector3& pos, const Vector
 
 		if (m_sittingFrame < SITTING_FRAME_MAX)
 		{
-			u32 animCount = m_pModel->GetAnimCount();
+			const u32 animCount = __GetAnimCount();
 			const f32 animRange = static_cast<f32>(animCount);
 			const u32 animIndex0 = static_cast<u32>(m_animIndex * animRange) % animCount;
 			const f32 t = static_cast<f32>(m_sittingFrame) / static_cast<f32>(SITTING_FRAME_MAX);
@@ -248,59 +296,71 @@ void World_Unit::UpdatePosition(s32 frameCount, const Vector3& pos, const Vector
 		__ComputeModelAnimCenterAndSize(-1);
 		__ComputeModelWorldLocalTransform();
 
-		m_thoughtFrame = 0;
-		m_thoughtFrameNext = (THOUGHT_FRAME_HIDE_MIN + (rand() % (THOUGHT_FRAME_HIDE_MAX - THOUGHT_FRAME_HIDE_MIN)));
+		__OnSitDown();
 	}
 
 	// compute updated bounds.
 	ComputeBounds();
 }
 
-void World_Unit::Update(s32 frameCount)
+void World_Unit::__OnSitDown()
+{
+	__ScheduleThought(THOUGHT_FRAME_HIDE_MIN, THOUGHT_FRAME_HIDE_MAX);
+}
+
+void World_Unit::__OnStandUp()
 {
+	__GetEventQueue()->CancelMessage(m_thoughtTimerID);
+	m_thoughtTimerID = EVENTQUEUE_TIMER_NONE;
+}
+
+void World_Unit::__OnThought(EventMessage_UnitThought* /*pEvent*/)
+{
+	m_thoughtTimerID = EVENTQUEUE_TIMER_NONE;
+	// it may have come due just before the unit stood up.
 	if (IsSitting())
 	{
-		m_thoughtFrame += frameCount;
-		const bool change = m_thoughtFrame > m_thoughtFrameNext;
-		if (change)
-		{
-			if (m_pImagine)
-			{
-				RELEASEI(m_pImagine);
+		__ChangeThought();
+	}
+}
 
-				m_thoughtFrame = 0;
-				m_thoughtFrameNext = (THOUGHT_FRAME_HIDE_MIN + (rand() % (THOUGHT_FRAME_HIDE_MAX - THOUGHT_FRAME_HIDE_MIN)));
-			}
-			else
-			{
-				u32 thoughtFreqMax = UINT_MAX;
-				for (u32 i = 0; i < m_thoughtFrequency.size(); ++i)
-				{
-					thoughtFreqMax = std::min<u32>(thoughtFreqMax, m_thoughtFrequency[i]);
-				}
-
-				std::vector<u32> thoughtIndicies;
-				for (u32 i = 0; i < m_thoughtFrequency.size(); ++i)
-				{
-					if (m_thoughtFrequency[i] <= (thoughtFreqMax + 1))
-					{
-						thoughtIndicies.push_back(i);
-					}
-				}
-
-				const u32 iiThought = rand() % thoughtIndicies.size();
-				const u32 iThought = thoughtIndicies[iiThought];
-				const RenderImagine_Type t = (rand() & 1) ? RenderImagine_Type_Imagine : RenderImagine_Type_Speech;
-				m_pImagine = RenderImagine::Alloc(__GetRenderer());
-				m_pImagine->SetType(t);
-				m_pImagine->SetText(s_mooeyThoughts[iThought]);
-				m_thoughtFrequency[iThought]++;
-
-				m_thoughtFrame = 0;
-				m_thoughtFrameNext = (THOUGHT_FRAME_SHOW_MIN + (rand() % (THOUGHT_FRAME_SHOW_MAX - THOUGHT_FRAME_SHOW_MIN)));
-			}
+void World_Unit::__ChangeThought()
+{
+	if (m_pImagine)
+	{
+		RELEASEI(m_pImagine);
+		__ScheduleThought(THOUGHT_FRAME_HIDE_MIN, THOUGHT_FRAME_HIDE_MAX);
+		return;
+	}
+
+	u32 thoughtFreqMax = UINT_MAX;
+	for (u32 i = 0; i < m_thoughtFrequency.size(); ++i)
+	{
+		thoughtFreqMax = std::min<u32>(thoughtFreqMax, m_thoughtFrequency[i]);
+	}
+
+	std::vector<u32> thoughtIndicies;
+	for (u32 i = 0; i < m_thoughtFrequency.size(); ++i)
+	{
+		if (m_thoughtFrequency[i] <= (thoughtFreqMax + 1))
+		{
+			thoughtIndicies.push_back(i);
 		}
 	}
+
+	const u32 iiThought = m_random.Next(static_cast<u32>(thoughtIndicies.size()));
+	const u32 iThought = thoughtIndicies[iiThought];
+	const World_RenderThought_Type t = m_random.NextBool() ? World_RenderThought_Type_Imagine : World_RenderThought_Type_Speech;
+	m_pImagine = __GetWorldRender()->AllocThought(t, s_mooeyThoughts[iThought]);
+	m_thoughtFrequency[iThought]++;
+
+	__ScheduleThought(THOUGHT_FRAME_SHOW_MIN, THOUGHT_FRAME_SHOW_MAX);
+}
+
+u32 World_Unit::__GetAnimCount() const
+{
+	// a model without animations, as under World_RenderNull, walks in its base pose.
+	return std::max<u32>(m_pModel->GetAnimCount(), 1);
 }
 
 bool World_Unit::IsSitting() const
@@ -1,13 +1,24 @@
 #pragma once
 
-#include "common/basic_types.h"
+#include "Common/basic_types.h"
+#include "Common/random.h"
+
+#include "Event/EventQueueTimers.h"
 
 #include "Object.h"
 
 namespace TB8
 {
 
-class RenderImagine;
+class EventMessage_UnitThought;
+
+// unit physics, shared by World_Unit::ComputeNextPosition and World_Integrator.
+const f32 UNIT_FORCE_FACTOR = 20.f;
+const f32 UNIT_FORCE_DAMPEN = 10.f;
+const f32 UNIT_WIND_RESIST_FACTOR = 0.25f;
+const f32 UNIT_GRAVITY_FACTOR = 10.f;
+const f32 UNIT_JUMP_VELOCITY = 4.f;
+const f32 UNIT_FRAMES_PER_SECOND = 60.f;
 
 struct World_Unit : public World_Object
 {
@@ -15,10 +26,13 @@ struct World_Unit : public World_Object
 		: World_Object(pGlobalState)
 		, m_mass(0.f)
 		, m_maxVelocity(0.f)
+		, m_worldIndex(UINT_MAX)
+		, m_isGoalSet(false)
 		, m_distanceTravelled(0.f)
 		, m_animIndex(0.f)
 		, m_sittingFrame(0)
-		, m_thoughtFrame(0)
+		, m_eventID(0)
+		, m_thoughtTimerID(EVENTQUEUE_TIMER_NONE)
 		, m_pImagine(nullptr)
 	{
 	}
@@ -29,29 +43,48 @@ struct World_Unit : public World_Object
 
 	void ComputeNextPosition(s32 frameCount, Vector3& pos, Vector3& vel);
 	void UpdatePosition(s32 frameCount, const Vector3& pos, const Vector3& vel);
-	virtual void Update(s32 frameCount);
+	// sets the force that brings the velocity closest to <vel> on the next ComputeNextPosition().
+	void SteerToVelocity(s32 frameCount, const Vector2& vel);
 	const Vector3& GetForce() const { return m_force; }
 	void SetForce(const Vector3& force) { m_force = force; }
 	bool IsSitting() const;
+	// a unit's draws come from its own stream of the world's seed, so they don't depend on the order units update in.
+	void SeedRandom(u64 seed, u64 stream);
 
 	virtual void Render2D(const Vector3& screenWorldPos) override;
 
 	void __Initialize();
+	u32 __GetAnimCount() const;
+	virtual void __OnSitDown();
+	virtual void __OnStandUp();
+	void __OnThought(EventMessage_UnitThought* pEvent);
+	void __ScheduleThought(s32 frameMin, s32 frameMax);
+	void __ChangeThought();
 
 	f32								m_mass;
 	f32								m_maxVelocity;
 	Vector3							m_force;
 	Vector3							m_velocity;
 
+	u32								m_worldIndex;		// index in World::m_units, for its simulation lod.
+
+	// steered toward by the world's flow fields.
+	bool							m_isGoalSet;
+	IVector2						m_goalCell;
+
 	f32								m_distanceTravelled;
 
+	Random							m_random;
+
 	f32								m_animIndex;
 	s32								m_sittingFrame;
-	s32								m_thoughtFrame;
-	s32								m_thoughtFrameNext;
+
+	// thoughts come and go on timers while sitting, rather than being counted down each update.
+	u32								m_eventID;			// object id of the unit's events.
+	EventQueueTimerID				m_thoughtTimerID;
 	std::vector<u32>				m_thoughtFrequency;
 
-	RenderImagine*					m_pImagine;
+	World_RenderThought*			m_pImagine;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "pch.h"
+
+#include "UnitGrid.h"
+
+namespace TB8
+{
+
+const f32 UNITGRID_CELL_SIZE = 2.f;			// meters.
+
+void World_UnitGrid_Metrics::Clear()
+{
+	m_unitCount = 0;
+	m_cellChangeCount = 0;
+}
+
+World_UnitGrid::World_UnitGrid()
+	: m_cellCount(1, 1)
+	, m_maxRadius(0.f)
+{
+	m_cellHeads.assign(1, UNITGRID_NONE);
+}
+
+void World_UnitGrid::Resize(const Vector2& worldSize)
+{
+	m_cellCount.x = std::max<s32>(static_cast<s32>(std::ceil(worldSize.x / UNITGRID_CELL_SIZE)), 1);
+	m_cellCount.y = std::max<s32>(static_cast<s32>(std::ceil(worldSize.y / UNITGRID_CELL_SIZE)), 1);
+	m_maxRadius = 0.f;
+	m_cellHeads.assign(m_cellCount.x * m_cellCount.y, UNITGRID_NONE);
+
+	m_units.clear();
+	m_pos.clear();
+	m_radius.clear();
+	m_cells.clear();
+	m_next.clear();
+	m_prev.clear();
+
+	m_metrics.Clear();
+}
+
+void World_UnitGrid::Insert(u32 unit, World_Unit* pUnit, const Vector2& pos, f32 radius)
+{
+	if (unit >= m_units.size())
+	{
+		m_units.resize(unit + 1, nullptr);
+		m_pos.resize(unit + 1);
+		m_radius.resize(unit + 1, 0.f);
+		m_cells.resize(unit + 1, UNITGRID_NONE);
+		m_next.resize(unit + 1, UNITGRID_NONE);
+		m_prev.resize(unit + 1, UNITGRID_NONE);
+	}
+
+	m_units[unit] = pUnit;
+	m_pos[unit] = pos;
+	m_radius[unit] = radius;
+	m_maxRadius = std::max(m_maxRadius, radius);
+
+	const u32 cell = __GetCellIndex(__GetCellX(pos.x), __GetCellY(pos.y));
+	if (cell == m_cells[unit])
+		return;
+
+	if (m_cells[unit] == UNITGRID_NONE)
+	{
+		++m_metrics.m_unitCount;
+	}
+	else
+	{
+		__Unlink(unit);
+		++m_metrics.m_cellChangeCount;
+	}
+	__Link(unit, cell);
+}
+
+void World_UnitGrid::Remove(u32 unit)
+{
+	if ((unit >= m_cells.size()) || (m_cells[unit] == UNITGRID_NONE))
+		return;
+
+	__Unlink(unit);
+	m_units[unit] = nullptr;
+	--m_metrics.m_unitCount;
+}
+
+u32 World_UnitGrid::QueryRadius(const Vector2& center, f32 radius, World_Unit** ppUnits, u32 capacity) const
+{
+	const s32 left = __GetCellX(center.x - radius - m_maxRadius);
+	const s32 top = __GetCellY(center.y - radius - m_maxRadius);
+	const s32 right = __GetCellX(center.x + radius + m_maxRadius);
+	const s32 bottom = __GetCellY(center.y + radius + m_maxRadius);
+
+	u32 count = 0;
+	for (s32 y = top; y <= bottom; ++y)
+	{
+		for (s32 x = left; x <= right; ++x)
+		{
+			for (u32 unit = m_cellHeads[__GetCellIndex(x, y)]; unit != UNITGRID_NONE; unit = m_next[unit])
+			{
+				const f32 dist = radius + m_radius[unit];
+				if ((m_pos[unit] - center).MagSq() > (dist * dist))
+					continue;
+				if (count < capacity)
+				{
+					ppUnits[count] = m_units[unit];
+				}
+				++count;
+			}
+		}
+	}
+	return count;
+}
+
+u32 World_UnitGrid::QueryAABB(const Vector2& min, const Vector2& max, World_Unit** ppUnits, u32 capacity) const
+{
+	const s32 left = __GetCellX(min.x - m_maxRadius);
+	const s32 top = __GetCellY(min.y - m_maxRadius);
+	const s32 right = __GetCellX(max.x + m_maxRadius);
+	const s32 bottom = __GetCellY(max.y + m_maxRadius);
+
+	u32 count = 0;
+	for (s32 y = top; y <= bottom; ++y)
+	{
+		for (s32 x = left; x <= right; ++x)
+		{
+			for (u32 unit = m_cellHeads[__GetCellIndex(x, y)]; unit != UNITGRID_NONE; unit = m_next[unit])
+			{
+				// distance from the centre to the nearest point of the box.
+				const Vector2& pos = m_pos[unit];
+				const Vector2 nearest(std::min(std::max(pos.x, min.x), max.x), std::min(std::max(pos.y, min.y), max.y));
+				if ((nearest - pos).MagSq() > (m_radius[unit] * m_radius[unit]))
+					continue;
+				if (count < capacity)
+				{
+					ppUnits[count] = m_units[unit];
+				}
+				++count;
+			}
+		}
+	}
+	return count;
+}
+
+bool World_UnitGrid::Raycast(const Vector2& from, const Vector2& to, const World_Unit* pIgnore, World_Unit** ppUnit, f32* pFraction) const
+{
+	// walk the cells along the segment, testing the units in reach of each.  a unit more than <reach> cells from every
+	//  cell walked so far can only be hit further along, so the walk stops once a hit is before the current cell's exit.
+	const s32 reach = std::max<s32>(static_cast<s32>(std::ceil(m_maxRadius / UNITGRID_CELL_SIZE)), 1);
+	const Vector2 delta = to - from;
+	const f32 deltaMagSq = delta.MagSq();
+
+	const Vector2 fromCell(from.x / UNITGRID_CELL_SIZE, from.y / UNITGRID_CELL_SIZE);
+	const Vector2 deltaCell(delta.x / UNITGRID_CELL_SIZE, delta.y / UNITGRID_CELL_SIZE);
+	IVector2 cell(static_cast<s32>(std::floor(fromCell.x)), static_cast<s32>(std::floor(fromCell.y)));
+	const IVector2 cellEnd(static_cast<s32>(std::floor(fromCell.x + deltaCell.x)), static_cast<s32>(std::floor(fromCell.y + deltaCell.y)));
+	const IVector2 step((delta.x > 0.f) ? 1 : ((delta.x < 0.f) ? -1 : 0), (delta.y > 0.f) ? 1 : ((delta.y < 0.f) ? -1 : 0));
+
+	// parametric distance along the segment to the next vertical / horizontal cell boundary.
+	f32 tMaxX = FLT_MAX;
+	f32 tMaxY = FLT_MAX;
+	f32 tDeltaX = FLT_MAX;
+	f32 tDeltaY = FLT_MAX;
+	if (step.x != 0)
+	{
+		tMaxX = (static_cast<f32>(cell.x + ((step.x > 0) ? 1 : 0)) - fromCell.x) / deltaCell.x;
+		tDeltaX = static_cast<f32>(step.x) / deltaCell.x;
+	}
+	if (step.y != 0)
+	{
+		tMaxY = (static_cast<f32>(cell.y + ((step.y > 0) ? 1 : 0)) - fromCell.y) / deltaCell.y;
+		tDeltaY = static_cast<f32>(step.y) / deltaCell.y;
+	}
+
+	World_Unit* pHit = nullptr;
+	f32 tHit = FLT_MAX;
+	s32 remaining = std::abs(cellEnd.x - cell.x) + std::abs(cellEnd.y - cell.y);
+	for (;;)
+	{
+		const s32 left = std::min(std::max(cell.x - reach, 0), m_cellCount.x - 1);
+		const s32 top = std::min(std::max(cell.y - reach, 0), m_cellCount.y - 1);
+		const s32 right = std::min(std::max(cell.x + reach, 0), m_cellCount.x - 1);
+		const s32 bottom = std::min(std::max(cell.y + reach, 0), m_cellCount.y - 1);
+		for (s32 y = top; y <= bottom; ++y)
+		{
+			for (s32 x = left; x <= right; ++x)
+			{
+				for (u32 unit = m_cellHeads[__GetCellIndex(x, y)]; unit != UNITGRID_NONE; unit = m_next[unit])
+				{
+					if (m_units[unit] == pIgnore)
+						continue;
+
+					// first root of |from + delta t - pos| = radius.
+					const Vector2 offset = from - m_pos[unit];
+					const f32 c = offset.MagSq() - (m_radius[unit] * m_radius[unit]);
+					f32 t = 0.f;
+					if (c > 0.f)
+					{
+						if (deltaMagSq <= 0.f)
+							continue;
+						const f32 b = Vector2::Dot(offset, delta);
+						const f32 discriminant = (b * b) - (deltaMagSq * c);
+						if ((b >= 0.f) || (discriminant < 0.f))
+							continue;
+						t = (-b - std::sqrt(discriminant)) / deltaMagSq;
+						if (t > 1.f)
+							continue;
+					}
+
+					if (t < tHit)
+					{
+						tHit = t;
+						pHit = m_units[unit];
+					}
+				}
+			}
+		}
+
+		if (remaining <= 0)
+			break;
+
+		// exit of this cell.
+		const f32 tExit = std::min(tMaxX, tMaxY);
+		if (tHit <= tExit)
+			break;
+
+		if (tMaxX < tMaxY)
+		{
+			cell.x += step.x;
+			tMaxX += tDeltaX;
+		}
+		else
+		{
+			cell.y += step.y;
+			tMaxY += tDeltaY;
+		}
+		--remaining;
+	}
+
+	if (!pHit)
+		return false;
+
+	if (ppUnit)
+	{
+		*ppUnit = pHit;
+	}
+	if (pFraction)
+	{
+		*pFraction = tHit;
+	}
+	return true;
+}
+
+s32 World_UnitGrid::__GetCellX(f32 x) const
+{
+	return std::min(std::max(static_cast<s32>(std::floor(x / UNITGRID_CELL_SIZE)), 0), m_cellCount.x - 1);
+}
+
+s32 World_UnitGrid::__GetCellY(f32 y) const
+{
+	return std::min(std::max(static_cast<s32>(std::floor(y / UNITGRID_CELL_SIZE)), 0), m_cellCount.y - 1);
+}
+
+void World_UnitGrid::__Link(u32 unit, u32 cell)
+{
+	const u32 head = m_cellHeads[cell];
+	m_next[unit] = head;
+	m_prev[unit] = UNITGRID_NONE;
+	if (head != UNITGRID_NONE)
+	{
+		m_prev[head] = unit;
+	}
+	m_cellHeads[cell] = unit;
+	m_cells[unit] = cell;
+}
+
+void World_UnitGrid::__Unlink(u32 unit)
+{
+	const u32 next = m_next[unit];
+	const u32 prev = m_prev[unit];
+	if (prev != UNITGRID_NONE)
+	{
+		m_next[prev] = next;
+	}
+	else
+	{
+		m_cellHeads[m_cells[unit]] = next;
+	}
+	if (next != UNITGRID_NONE)
+	{
+		m_prev[next] = prev;
+	}
+	m_cells[unit] = UNITGRID_NONE;
+}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+
+#include "Common/basic_types.h"
+
+namespace TB8
+{
+
+struct World_Unit;
+
+const u32 UNITGRID_NONE = 0xffffffff;
+
+struct World_UnitGrid_Metrics
+{
+	World_UnitGrid_Metrics() { Clear(); }
+	void Clear();
+
+	u32						m_unitCount;
+	u32						m_cellChangeCount;		// units moved to another cell since the last Resize().
+};
+
+// persistent uniform grid of units, for spatial queries.
+//  each cell heads an intrusive list of the units whose centre is in it, so moving a unit within its cell is a store
+//  and moving it across cells is an unlink and a link.  positions off the map are clamped into the edge cells.  queries
+//  only read, so any number can run at once between updates.
+class World_UnitGrid
+{
+public:
+	World_UnitGrid();
+
+	// drops every unit.
+	void Resize(const Vector2& worldSize);
+
+	// adds <unit>, or moves it if it's already in the grid.
+	void Insert(u32 unit, World_Unit* pUnit, const Vector2& pos, f32 radius);
+	void Remove(u32 unit);
+
+	// units whose circle touches the query shape, written to <ppUnits> up to <capacity>.  returns the number found,
+	//  which is more than <capacity> when the buffer was too small.
+	u32 QueryRadius(const Vector2& center, f32 radius, World_Unit** ppUnits, u32 capacity) const;
+	u32 QueryAABB(const Vector2& min, const Vector2& max, World_Unit** ppUnits, u32 capacity) const;
+
+	// first unit the segment hits, skipping <pIgnore>.  <pFraction> is how far along the segment, 0 to 1.
+	bool Raycast(const Vector2& from, const Vector2& to, const World_Unit* pIgnore, World_Unit** ppUnit, f32* pFraction) const;
+
+	const World_UnitGrid_Metrics& GetMetrics() const { return m_metrics; }
+
+private:
+	u32 __GetCellIndex(s32 cellX, s32 cellY) const { return static_cast<u32>((cellY * m_cellCount.x) + cellX); }
+	s32 __GetCellX(f32 x) const;
+	s32 __GetCellY(f32 y) const;
+	void __Link(u32 unit, u32 cell);
+	void __Unlink(u32 unit);
+
+	IVector2						m_cellCount;
+	f32								m_maxRadius;		// largest radius inserted, how far queries look past their shape.
+
+	std::vector<u32>				m_cellHeads;		// first unit in each cell, or UNITGRID_NONE.
+
+	// per unit.
+	std::vector<World_Unit*>		m_units;
+	std::vector<Vector2>			m_pos;
+	std::vector<f32>				m_radius;
+	std::vector<u32>				m_cells;			// cell holding the unit, or UNITGRID_NONE when it isn't in the grid.
+	std::vector<u32>				m_next;
+	std::vector<u32>				m_prev;
+
+	World_UnitGrid_Metrics			m_metrics;
+};
+
+}
@@ -0,0 +1,382 @@
+#include "pch.h"
+
+#include <cmath>
+#include <cfloat>
+
+#include "WallGrid.h"
+
+namespace TB8
+{
+
+World_WallGrid::World_WallGrid()
+	: m_revision(0)
+{
+}
+
+void World_WallGrid::Resize(const IVector2& size)
+{
+	m_size = size;
+	m_edges.clear();
+	m_edges.resize(static_cast<size_t>(std::max<s32>(size.x, 0)) * static_cast<size_t>(std::max<s32>(size.y, 0)), World_WallGrid_Edge_None);
+	++m_revision;
+}
+
+void World_WallGrid::Clear()
+{
+	std::fill(m_edges.begin(), m_edges.end(), static_cast<u8>(World_WallGrid_Edge_None));
+	++m_revision;
+}
+
+void World_WallGrid::SetWall(const IVector2& cell, World_WallGrid_Edge edge, bool isWall)
+{
+	// record the edge on both cells that share it.
+	const IVector2 cellOther = cell + GetEdgeDirection(edge);
+	const World_WallGrid_Edge edgeOther = GetOppositeEdge(edge);
+
+	if (IsValidCell(cell))
+	{
+		u8& edges = m_edges[__GetIndex(cell)];
+		edges = isWall ? (edges | edge) : (edges & ~edge);
+	}
+	if (IsValidCell(cellOther))
+	{
+		u8& edges = m_edges[__GetIndex(cellOther)];
+		edges = isWall ? (edges | edgeOther) : (edges & ~edgeOther);
+	}
+
+	++m_revision;
+}
+
+bool World_WallGrid::CanStep(const IVector2& cell, const IVector2& dir) const
+{
+	if (!IsValidCell(cell) || !IsValidCell(cell + dir))
+		return false;
+
+	if ((dir.x == 0) || (dir.y == 0))
+		return __CanCross(cell, dir);
+
+	// diagonal, don't allow cutting a corner that has a wall touching it.
+	const IVector2 dirX(dir.x, 0);
+	const IVector2 dirY(0, dir.y);
+	return __CanCross(cell, dirX)
+		&& __CanCross(cell, dirY)
+		&& __CanCross(cell + dirX, dirY)
+		&& __CanCross(cell + dirY, dirX);
+}
+
+bool World_WallGrid::IsWallInRect(const Vector2& min, const Vector2& max) const
+{
+	const s32 left = std::max<s32>(static_cast<s32>(std::floor(min.x)), 0);
+	const s32 top = std::max<s32>(static_cast<s32>(std::floor(min.y)), 0);
+	const s32 right = std::min<s32>(static_cast<s32>(std::floor(max.x)), m_size.x - 1);
+	const s32 bottom = std::min<s32>(static_cast<s32>(std::floor(max.y)), m_size.y - 1);
+
+	IVector2 cell;
+	for (cell.y = top; cell.y <= bottom; ++cell.y)
+	{
+		const f32 edgeTop = static_cast<f32>(cell.y);
+		const f32 edgeBottom = static_cast<f32>(cell.y + 1);
+		for (cell.x = left; cell.x <= right; ++cell.x)
+		{
+			const u8 edges = m_edges[__GetIndex(cell)];
+			if (!edges)
+				continue;
+
+			const f32 edgeLeft = static_cast<f32>(cell.x);
+			const f32 edgeRight = static_cast<f32>(cell.x + 1);
+
+			// the cell overlaps the rect, so each edge only needs testing along its own axis.
+			if ((edges & World_WallGrid_Edge_Top) && (min.y <= edgeTop) && (edgeTop <= max.y))
+				return true;
+			if ((edges & World_WallGrid_Edge_Bottom) && (min.y <= edgeBottom) && (edgeBottom <= max.y))
+				return true;
+			if ((edges & World_WallGrid_Edge_Left) && (min.x <= edgeLeft) && (edgeLeft <= max.x))
+				return true;
+			if ((edges & World_WallGrid_Edge_Right) && (min.x <= edgeRight) && (edgeRight <= max.x))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+bool World_WallGrid::IsWallInCircle(const Vector2& center, f32 radius) const
+{
+	const Vector2 min(center.x - radius, center.y - radius);
+	const Vector2 max(center.x + radius, center.y + radius);
+	const s32 left = std::max<s32>(static_cast<s32>(std::floor(min.x)), 0);
+	const s32 top = std::max<s32>(static_cast<s32>(std::floor(min.y)), 0);
+	const s32 right = std::min<s32>(static_cast<s32>(std::floor(max.x)), m_size.x - 1);
+	const s32 bottom = std::min<s32>(static_cast<s32>(std::floor(max.y)), m_size.y - 1);
+	const f32 radiusSq = radius * radius;
+
+	IVector2 cell;
+	for (cell.y = top; cell.y <= bottom; ++cell.y)
+	{
+		for (cell.x = left; cell.x <= right; ++cell.x)
+		{
+			const u8 edges = m_edges[__GetIndex(cell)];
+			if (!edges)
+				continue;
+
+			const Vector2 ul(static_cast<f32>(cell.x), static_cast<f32>(cell.y));
+			const Vector2 ur(ul.x + 1.f, ul.y);
+			const Vector2 ll(ul.x, ul.y + 1.f);
+			const Vector2 lr(ul.x + 1.f, ul.y + 1.f);
+
+			if ((edges & World_WallGrid_Edge_Top) && (__DistSqPointToSegment(center, ul, ur) <= radiusSq))
+				return true;
+			if ((edges & World_WallGrid_Edge_Bottom) && (__DistSqPointToSegment(center, ll, lr) <= radiusSq))
+				return true;
+			if ((edges & World_WallGrid_Edge_Left) && (__DistSqPointToSegment(center, ul, ll) <= radiusSq))
+				return true;
+			if ((edges & World_WallGrid_Edge_Right) && (__DistSqPointToSegment(center, ur, lr) <= radiusSq))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+bool World_WallGrid::IsWallInHull(const Vector2* pPoints, u32 pointCount, f32 halfThickness) const
+{
+	if (!pointCount)
+		return false;
+
+	Vector2 min = pPoints[0];
+	Vector2 max = pPoints[0];
+	for (u32 i = 1; i < pointCount; ++i)
+	{
+		min = Vector2(std::min<f32>(min.x, pPoints[i].x), std::min<f32>(min.y, pPoints[i].y));
+		max = Vector2(std::max<f32>(max.x, pPoints[i].x), std::max<f32>(max.y, pPoints[i].y));
+	}
+
+	const s32 left = std::max<s32>(static_cast<s32>(std::floor(min.x - halfThickness)), 0);
+	const s32 top = std::max<s32>(static_cast<s32>(std::floor(min.y - halfThickness)), 0);
+	const s32 right = std::min<s32>(static_cast<s32>(std::floor(max.x + halfThickness)), m_size.x - 1);
+	const s32 bottom = std::min<s32>(static_cast<s32>(std::floor(max.y + halfThickness)), m_size.y - 1);
+
+	IVector2 cell;
+	for (cell.y = top; cell.y <= bottom; ++cell.y)
+	{
+		for (cell.x = left; cell.x <= right; ++cell.x)
+		{
+			const u8 edges = m_edges[__GetIndex(cell)];
+			if (!edges)
+				continue;
+
+			const f32 x0 = static_cast<f32>(cell.x);
+			const f32 y0 = static_cast<f32>(cell.y);
+			const f32 x1 = x0 + 1.f;
+			const f32 y1 = y0 + 1.f;
+			const f32 h = halfThickness;
+
+			if ((edges & World_WallGrid_Edge_Top) && __IsRectInHull(Vector2(x0 - h, y0 - h), Vector2(x1 + h, y0 + h), pPoints, pointCount))
+				return true;
+			if ((edges & World_WallGrid_Edge_Bottom) && __IsRectInHull(Vector2(x0 - h, y1 - h), Vector2(x1 + h, y1 + h), pPoints, pointCount))
+				return true;
+			if ((edges & World_WallGrid_Edge_Left) && __IsRectInHull(Vector2(x0 - h, y0 - h), Vector2(x0 + h, y1 + h), pPoints, pointCount))
+				return true;
+			if ((edges & World_WallGrid_Edge_Right) && __IsRectInHull(Vector2(x1 - h, y0 - h), Vector2(x1 + h, y1 + h), pPoints, pointCount))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+bool World_WallGrid::HasLineOfSight(const Vector2& from, const Vector2& to) const
+{
+	return !Raycast(from, to, nullptr);
+}
+
+bool World_WallGrid::Raycast(const Vector2& from, const Vector2& to, Vector2* pHit) const
+{
+	IVector2 cell(static_cast<s32>(std::floor(from.x)), static_cast<s32>(std::floor(from.y)));
+	const IVector2 cellEnd(static_cast<s32>(std::floor(to.x)), static_cast<s32>(std::floor(to.y)));
+	const Vector2 delta = to - from;
+	const IVector2 step((delta.x > 0.f) ? 1 : ((delta.x < 0.f) ? -1 : 0), (delta.y > 0.f) ? 1 : ((delta.y < 0.f) ? -1 : 0));
+
+	// parametric distance along the ray to the next vertical / horizontal cell boundary.
+	f32 tMaxX = FLT_MAX;
+	f32 tMaxY = FLT_MAX;
+	f32 tDeltaX = FLT_MAX;
+	f32 tDeltaY = FLT_MAX;
+	if (step.x != 0)
+	{
+		tMaxX = (static_cast<f32>(cell.x + ((step.x > 0) ? 1 : 0)) - from.x) / delta.x;
+		tDeltaX = static_cast<f32>(step.x) / delta.x;
+	}
+	if (step.y != 0)
+	{
+		tMaxY = (static_cast<f32>(cell.y + ((step.y > 0) ? 1 : 0)) - from.y) / delta.y;
+		tDeltaY = static_cast<f32>(step.y) / delta.y;
+	}
+
+	const IVector2 dirX(step.x, 0);
+	const IVector2 dirY(0, step.y);
+
+	s32 remaining = std::abs(cellEnd.x - cell.x) + std::abs(cellEnd.y - cell.y);
+	while (remaining > 0)
+	{
+		f32 t = 0.f;
+		bool isBlocked = false;
+
+		if ((tMaxX == tMaxY) && (remaining >= 2))
+		{
+			// passing exactly thru a corner, blocked if a wall touches the corner.
+			t = tMaxX;
+			isBlocked = !__CanCross(cell, dirX) || !__CanCross(cell, dirY) || !__CanCross(cell + dirX, dirY) || !__CanCross(cell + dirY, dirX);
+			cell = cell + step;
+			tMaxX += tDeltaX;
+			tMaxY += tDeltaY;
+			remaining -= 2;
+		}
+		else if (tMaxX < tMaxY)
+		{
+			t = tMaxX;
+			isBlocked = !__CanCross(cell, dirX);
+			cell.x += step.x;
+			tMaxX += tDeltaX;
+			--remaining;
+		}
+		else
+		{
+			t = tMaxY;
+			isBlocked = !__CanCross(cell, dirY);
+			cell.y += step.y;
+			tMaxY += tDeltaY;
+			--remaining;
+		}
+
+		if (isBlocked)
+		{
+			if (pHit)
+			{
+				*pHit = from + (delta * t);
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+World_WallGrid_Edge World_WallGrid::GetOppositeEdge(World_WallGrid_Edge edge)
+{
+	switch (edge)
+	{
+	case World_WallGrid_Edge_Top:
+		return World_WallGrid_Edge_Bottom;
+	case World_WallGrid_Edge_Left:
+		return World_WallGrid_Edge_Right;
+	case World_WallGrid_Edge_Right:
+		return World_WallGrid_Edge_Left;
+	case World_WallGrid_Edge_Bottom:
+		return World_WallGrid_Edge_Top;
+	default:
+		return World_WallGrid_Edge_None;
+	}
+}
+
+IVector2 World_WallGrid::GetEdgeDirection(World_WallGrid_Edge edge)
+{
+	switch (edge)
+	{
+	case World_WallGrid_Edge_Top:
+		return IVector2(0, -1);
+	case World_WallGrid_Edge_Left:
+		return IVector2(-1, 0);
+	case World_WallGrid_Edge_Right:
+		return IVector2(+1, 0);
+	case World_WallGrid_Edge_Bottom:
+		return IVector2(0, +1);
+	default:
+		return IVector2(0, 0);
+	}
+}
+
+bool World_WallGrid::__CanCross(const IVector2& cell, const IVector2& dir) const
+{
+	// cells off the map have no walls of their own, so only the edges of <cell> matter.
+	u8 edge = World_WallGrid_Edge_None;
+	if (dir.x > 0)
+		edge = World_WallGrid_Edge_Right;
+	else if (dir.x < 0)
+		edge = World_WallGrid_Edge_Left;
+	else if (dir.y > 0)
+		edge = World_WallGrid_Edge_Bottom;
+	else if (dir.y < 0)
+		edge = World_WallGrid_Edge_Top;
+
+	if (IsValidCell(cell))
+		return (m_edges[__GetIndex(cell)] & edge) == 0;
+
+	// walls on the map border are only recorded on the inside cell.
+	const IVector2 cellOther = cell + dir;
+	if (IsValidCell(cellOther))
+		return (m_edges[__GetIndex(cellOther)] & GetOppositeEdge(static_cast<World_WallGrid_Edge>(edge))) == 0;
+
+	return true;
+}
+
+bool World_WallGrid::__IsRectInHull(const Vector2& min, const Vector2& max, const Vector2* pPoints, u32 pointCount)
+{
+	// separating axes.  the rect's are x and y, and the hull's edges are among the lines between its points, so
+	//  testing every pair finds them without building the hull.
+	Vector2 pointsMin = pPoints[0];
+	Vector2 pointsMax = pPoints[0];
+	for (u32 i = 1; i < pointCount; ++i)
+	{
+		pointsMin = Vector2(std::min<f32>(pointsMin.x, pPoints[i].x), std::min<f32>(pointsMin.y, pPoints[i].y));
+		pointsMax = Vector2(std::max<f32>(pointsMax.x, pPoints[i].x), std::max<f32>(pointsMax.y, pPoints[i].y));
+	}
+	if ((pointsMax.x < min.x) || (max.x < pointsMin.x) || (pointsMax.y < min.y) || (max.y < pointsMin.y))
+		return false;
+
+	const Vector2 corners[4] = { min, Vector2(max.x, min.y), max, Vector2(min.x, max.y) };
+	for (u32 i = 0; i < pointCount; ++i)
+	{
+		for (u32 j = i + 1; j < pointCount; ++j)
+		{
+			const Vector2 edge = pPoints[j] - pPoints[i];
+			if (is_approx_zero(edge.MagSq()))
+				continue;
+			const Vector2 axis(-edge.y, edge.x);
+
+			f32 hullMin = FLT_MAX;
+			f32 hullMax = -FLT_MAX;
+			for (u32 k = 0; k < pointCount; ++k)
+			{
+				const f32 proj = Vector2::Dot(pPoints[k], axis);
+				hullMin = std::min<f32>(hullMin, proj);
+				hullMax = std::max<f32>(hullMax, proj);
+			}
+			f32 rectMin = FLT_MAX;
+			f32 rectMax = -FLT_MAX;
+			for (u32 k = 0; k < ARRAYSIZE(corners); ++k)
+			{
+				const f32 proj = Vector2::Dot(corners[k], axis);
+				rectMin = std::min<f32>(rectMin, proj);
+				rectMax = std::max<f32>(rectMax, proj);
+			}
+			if ((hullMax < rectMin) || (rectMax < hullMin))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+f32 World_WallGrid::__DistSqPointToSegment(const Vector2& p, const Vector2& a, const Vector2& b)
+{
+	const Vector2 ab = b - a;
+	const Vector2 ap = p - a;
+	const f32 lenSq = ab.MagSq();
+	f32 t = is_approx_zero(lenSq) ? 0.f : (Vector2::Dot(ap, ab) / lenSq);
+	t = std::min<f32>(std::max<f32>(t, 0.f), 1.f);
+	const Vector2 closest = a + (ab * t);
+	return (p - closest).MagSq();
+}
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include "Common/basic_types.h"
+
+namespace TB8
+{
+
+// edges of a map cell that may hold a wall.
+enum World_WallGrid_Edge : u8
+{
+	World_WallGrid_Edge_None = 0x0,
+	World_WallGrid_Edge_Top = 0x1,
+	World_WallGrid_Edge_Left = 0x2,
+	World_WallGrid_Edge_Right = 0x4,
+	World_WallGrid_Edge_Bottom = 0x8,
+	World_WallGrid_Edge_All = 0xf,
+};
+
+// per-cell wall edge bitmask, compiled from the map at load.
+//  cell (x,y) covers world [x, x+1) x [y, y+1).  each wall is recorded on both cells sharing the edge.
+class World_WallGrid
+{
+public:
+	World_WallGrid();
+
+	void Resize(const IVector2& size);
+	void Clear();
+	void SetWall(const IVector2& cell, World_WallGrid_Edge edge, bool isWall);
+
+	const IVector2& GetSize() const { return m_size; }
+	u32 GetRevision() const { return m_revision; }
+	bool IsValidCell(const IVector2& cell) const { return (cell.x >= 0) && (cell.y >= 0) && (cell.x < m_size.x) && (cell.y < m_size.y); }
+	u8 GetEdges(const IVector2& cell) const { return IsValidCell(cell) ? m_edges[__GetIndex(cell)] : static_cast<u8>(World_WallGrid_Edge_None); }
+	bool IsWall(const IVector2& cell, World_WallGrid_Edge edge) const { return (GetEdges(cell) & edge) != 0; }
+
+	// pathfinding adjacency. dir components are -1, 0 or +1; diagonal steps need all four edges around the corner open.
+	bool CanStep(const IVector2& cell, const IVector2& dir) const;
+
+	// broad phase: true if any wall edge touches the world space rect [min, max].
+	bool IsWallInRect(const Vector2& min, const Vector2& max) const;
+	bool IsWallInCircle(const Vector2& center, f32 radius) const;
+	// exact: true if any wall edge, as a rect <halfThickness> either side of it, overlaps the convex hull of the points.
+	bool IsWallInHull(const Vector2* pPoints, u32 pointCount, f32 halfThickness) const;
+
+	// DDA walk thru the cells between two world points.
+	bool HasLineOfSight(const Vector2& from, const Vector2& to) const;
+	bool Raycast(const Vector2& from, const Vector2& to, Vector2* pHit) const;
+
+	static World_WallGrid_Edge GetOppositeEdge(World_WallGrid_Edge edge);
+	static IVector2 GetEdgeDirection(World_WallGrid_Edge edge);
+
+private:
+	s32 __GetIndex(const IVector2& cell) const { return (cell.y * m_size.x) + cell.x; }
+	bool __CanCross(const IVector2& cell, const IVector2& dir) const;
+	static f32 __DistSqPointToSegment(const Vector2& p, const Vector2& a, const Vector2& b);
+	static bool __IsRectInHull(const Vector2& min, const Vector2& max, const Vector2* pPoints, u32 pointCount);
+
+	IVector2				m_size;
+	std::vector<u8>			m_edges;
+	u32						m_revision;
+};
+
+}
@@ -1,17 +1,11 @@
 #include "pch.h"
 
-#include "common/memory.h"
-#include "common/parse_xml.h"
-#include "common/string.h"
+#include "Common/memory.h"
+#include "Common/file_io.h"
+#include "Common/job_system.h"
 
-#include "event/EventQueue.h"
-#include "event/EventQueueMessages.h"
-
-#include "render/RenderMain.h"
-#include "render/RenderModel.h"
-#include "render/RenderImagine.h"
-#include "render/RenderTexture.h"
-#include "render/RenderStatusBars.h"
+#include "Event/EventQueue.h"
+#include "Event/EventQueueMessages.h"
 
 #include "Object.h"
 #include "Unit.h"
@@ -22,10 +16,41 @@ namespace TB8
 {
 
 const f32 TILES_PER_METER = 1.0f;
+const f32 WALL_GRID_MARGIN = 0.125f;		// covers the half thickness of a wall model about its edge.
+const f32 UNIT_HEIGHT = 0.75f;
+const f32 UNIT_MASS = 2.f;
+const f32 UNIT_MAX_VELOCITY = 2.5f;
+const s32 REGION_SIZE_CELLS = 8;
+const u32 PATHFINDER_NODE_BUDGET = 2048;		// per frame, for time-sliced path requests.
+const u32 QUERY_BATCH_SIZE = 64;				// queries per job in the batch queries.
+const u32 QUERY_COLLISION_OBJECT_MAX = 128;		// objects near one unit, 4x4 cells of tiles and walls.  more go to the heap.
+const u64 WORLD_SEED_DEFAULT = 0x8B17E5EEDull;
+
+// where a wall model sits on each edge of its cell, in edge bit order.
+struct World_MapWallPlacement
+{
+	f32											m_rotation;
+	Vector2										m_offset;
+};
+
+const World_MapWallPlacement MAP_WALL_PLACEMENTS[4] =
+{
+	{ 0.f, Vector2(0.5f, 0.f) },			// top.
+	{ -90.f, Vector2(0.0f, 0.5f) },			// left.
+	{ +90.f, Vector2(1.0f, 0.5f) },			// right.
+	{ +180.f, Vector2(0.5f, 1.0f) },		// bottom.
+};
 
 World::World(Client_Globals* pGlobalState)
 	: Client_Globals_Accessor(pGlobalState)
+	, m_pMapFileMapping(nullptr)
+	, m_pathfinder(m_wallGrid)
+	, m_pathHierarchy(m_pathfinder)
+	, m_flowFields(m_pathfinder)
 	, m_pCharacterObj(nullptr)
+	, m_seed(WORLD_SEED_DEFAULT)
+	, m_threadCount(0)
+	, m_pJobSystem(nullptr)
 {
 }
 
@@ -46,7 +71,7 @@ void World::Free()
 	TB8_DEL(this);
 }
 
-void World::LoadMap(const char* pszMapPath)
+bool World::LoadMap(const char* pszMapPath)
 {
 	std::string mapPathFile = __GetPathAssets();
 	TB8::File::AppendToPath(mapPathFile, pszMapPath);
@@ -54,27 +79,44 @@ void World::LoadMap(const char* pszMapPath)
 	m_mapPath = mapPathFile;
 	File::StripFileNameFromPath(m_mapPath);
 
-	// open the xml file.
-	TB8::File* f = TB8::File::AllocOpen(mapPathFile.c_str(), true);
-	assert(f);
+	// the xml is compiled the first time it's loaded after a change, and it's the compiled map that's loaded.  a
+	//  compiled map without its xml loads as it is.
+	std::string compiledPathFile = mapPathFile;
+	File::SetExtension(compiledPathFile, MAPFILE_EXTENSION);
+	u64 srcTime = 0;
+	u64 dstTime = 0;
+	if (File::GetModifiedTime(mapPathFile.c_str(), &srcTime) && (!File::GetModifiedTime(compiledPathFile.c_str(), &dstTime) || (dstTime < srcTime)))
+	{
+		if (!World_MapCompiler::Compile(mapPathFile.c_str(), compiledPathFile.c_str()))
+			return false;
+	}
 
-	XML_Parser parser;
-	parser.SetHandlers(std::bind(&World::__ParseMapStartElement, this, std::placeholders::_1, std::placeholders::_2),
-						std::bind(&World::__ParseMapCharacters, this, std::placeholders::_1, std::placeholders::_2),
-						std::bind(&World::__ParseMapEndElement, this, std::placeholders::_1));
-	parser.SetReader(std::bind(__ParseMapRead, f, std::placeholders::_1, std::placeholders::_2));
-	parser.Parse();
+	// map it, it stays mapped while the map is loaded for the streaming thread to build chunks from.
+	m_pMapFileMapping = FileMapping::AllocOpen(compiledPathFile.c_str());
+	if (!m_pMapFileMapping)
+		return false;
+	if (!m_mapFile.Open(m_pMapFileMapping->GetData(), m_pMapFileMapping->GetSize()))
+	{
+		OBJFREE(m_pMapFileMapping);
+		return false;
+	}
+
+	__LoadMapFile();
+
+	// tiles and walls stream in around the avatar, starting with everything in reach of where it starts.
+	m_mapStreamer.Start(m_mapSize, std::bind(&World::__BuildMapChunk, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
+		std::bind(&World::__AttachMapChunk, this, std::placeholders::_1));
+	m_mapStreamer.Update(Vector2(m_startPos.x, m_startPos.y), m_objects, true);
+	return true;
 }
 
 void World::LoadCharacter(const char* pszCharacterModelPath, const char* pszModelName)
 {
-	RenderModel* pModel = RenderModel::AllocFromDAE(__GetRenderer(), __GetPathAssets().c_str(), pszCharacterModelPath, pszModelName);
+	World_RenderModel* pModel = __GetWorldRender()->AllocModelFromDAE(__GetPathAssets().c_str(), pszCharacterModelPath, pszModelName);
+	assert(pModel);
 	m_mapModels.insert(std::make_pair(0, pModel));
 
-	const std::vector<RenderModel_Mesh>& meshes = pModel->GetMeshes();
-	assert(!meshes.empty());
-	const RenderModel_Mesh& mesh = meshes.front();
-	const RenderModel_Bounds& meshBounds = mesh.m_bounds;
+	const World_RenderModel_Bounds& meshBounds = pModel->GetBounds();
 
 	m_pCharacterObj = World_Avatar::Alloc(__GetGlobals(), pszCharacterModelPath);
 
@@ -83,42 +125,309 @@ void World::LoadCharacter(const char* pszCharacterModelPath, const char* pszMode
 	m_pCharacterObj->m_pModel = pModel;
 	// scale the model so <y> is 0.75 meters.
 	m_pCharacterObj->m_pos = m_startPos;
-	m_pCharacterObj->m_scale = .75f / meshBounds.m_size.y;
-	m_pCharacterObj->m_mass = 2.f;
+	m_pCharacterObj->m_scale = UNIT_HEIGHT / meshBounds.m_size.y;
+	m_pCharacterObj->m_mass = UNIT_MASS;
 	m_pCharacterObj->m_bounds.m_type = World_Object_Bounds_Type_Sphere;
 
 	m_pCharacterObj->Init();
+	m_pCharacterObj->SeedRandom(m_seed, m_units.size());
+
+	m_units.push_back(m_pCharacterObj);
+}
+
+void World::SetWall(const IVector2& cell, World_WallGrid_Edge edge, bool isWall)
+{
+	m_wallGrid.SetWall(cell, edge, isWall);
+	m_pathHierarchy.InvalidateCell(cell);
+	m_pathHierarchy.InvalidateCell(cell + World_WallGrid::GetEdgeDirection(edge));
+	m_flowFields.InvalidateCell(cell);
+	m_flowFields.InvalidateCell(cell + World_WallGrid::GetEdgeDirection(edge));
+}
+
+void World::SetCellCost(const IVector2& cell, u8 cost)
+{
+	m_pathfinder.SetCellCost(cell, cost);
+	m_pathHierarchy.InvalidateCell(cell);
+	m_flowFields.InvalidateCell(cell);
+}
+
+void World::SetUnitGoal(World_Unit* pUnit, const IVector2& cell)
+{
+	pUnit->m_isGoalSet = true;
+	pUnit->m_goalCell = cell;
+	WakeUnit(pUnit);
+}
+
+void World::ClearUnitGoal(World_Unit* pUnit)
+{
+	pUnit->m_isGoalSet = false;
+	const Vector3 force(0.f, 0.f, pUnit->GetForce().z);
+	pUnit->SetForce(force);
+	WakeUnit(pUnit);
 }
 
 void World::Update(s32 frameCount)
 {
-	Vector3 pos;
-	Vector3 vel;
-	m_pCharacterObj->ComputeNextPosition(frameCount, pos, vel);
+	// pick the units that tick this frame, near the avatar every frame and less often further out.
+	if (m_simLod.GetUnitCount() != m_units.size())
+	{
+		m_simLod.Reset(static_cast<u32>(m_units.size()));
+		m_unitGrid.Resize(Vector2(static_cast<f32>(m_mapSize.x) * TILES_PER_METER, static_cast<f32>(m_mapSize.y) * TILES_PER_METER));
+		for (u32 i = 0; i < m_units.size(); ++i)
+		{
+			World_Unit* pUnit = m_units[i];
+			pUnit->m_worldIndex = i;
+			m_unitGrid.Insert(i, pUnit, Vector2(pUnit->m_pos.x, pUnit->m_pos.y), __GetUnitRadius(*pUnit));
+		}
+	}
+	if (m_pCharacterObj)
+	{
+		const Vector2 focus(m_pCharacterObj->m_pos.x, m_pCharacterObj->m_pos.y);
+		m_simLod.SetFocus(&focus, 1);
+	}
+	m_simLod.Schedule(frameCount, m_units.data());
+
+	if (m_pCharacterObj)
+	{
+		m_mapStreamer.Update(Vector2(m_pCharacterObj->m_pos.x, m_pCharacterObj->m_pos.y), m_objects, false);
+	}
+
+	const std::vector<u32>& awakeUnits = m_simLod.GetAwakeUnits();
+	for (std::vector<u32>::const_iterator it = awakeUnits.begin(); it != awakeUnits.end(); ++it)
+	{
+		m_units[*it]->StorePrevState();
+	}
+
+	const std::vector<u32>& tickUnits = m_simLod.GetTickUnits();
+	m_tickUnits.resize(tickUnits.size());
+	for (u32 i = 0; i < tickUnits.size(); ++i)
+	{
+		m_tickUnits[i] = m_units[tickUnits[i]];
+	}
+	m_tickFrames = m_simLod.GetTickFrames();
+
+	// rebuild navigation changed since the last tick, then advance time-sliced path requests.
+	m_pathHierarchy.Update();
+	m_flowFields.Update();
+	m_pathfinder.Update(PATHFINDER_NODE_BUDGET * static_cast<u32>(frameCount));
+
+	if (!m_pJobSystem)
+	{
+		m_pJobSystem = JobSystem::Alloc(m_threadCount);
+	}
+
+	__SteerUnitsToGoals();
+	__AvoidUnits(frameCount);
+
+	// move units within each region in parallel.
+	__AssignUnitsToRegions();
+	m_pJobSystem->ParallelFor(static_cast<u32>(m_regions.size()), [this](u32 regionIndex) { __UpdateRegion(m_regions[regionIndex]); });
+
+	m_unitMoves.resize(m_tickUnits.size());
+	m_unitRegions.resize(m_tickUnits.size());
+	for (u32 regionIndex = 0; regionIndex < m_regions.size(); ++regionIndex)
+	{
+		const World_Region& region = m_regions[regionIndex];
+		for (u32 i = 0; i < region.m_unitIndicies.size(); ++i)
+		{
+			const u32 tickIndex = region.m_unitIndicies[i];
+			m_unitMoves[tickIndex] = region.m_moves[i];
+			m_unitRegions[tickIndex] = region.m_isInterior[i] ? regionIndex : WORLD_REGION_NONE;
+		}
+	}
+
+	// resolve unit collisions across region borders, serially in unit order.
+	__AdjustUnitPositionsForUnitCollisions();
+
+	// move.  sitting down and standing up schedule and cancel event queue timers, which are only used from this thread.
+	for (u32 i = 0; i < m_tickUnits.size(); ++i)
+	{
+		World_Unit* pUnit = m_tickUnits[i];
+		const World_UnitMove& move = m_unitMoves[i];
+		pUnit->UpdatePosition(m_tickFrames[i], move.m_pos, move.m_vel);
+		m_unitGrid.Insert(pUnit->m_worldIndex, pUnit, Vector2(pUnit->m_pos.x, pUnit->m_pos.y), __GetUnitRadius(*pUnit));
+	}
+	if (m_pCharacterObj)
+	{
+		m_pCharacterObj->UpdateStats();
+	}
+
+	__SleepSettledUnits();
+}
+
+void World::WakeUnit(World_Unit* pUnit)
+{
+	if (pUnit->m_worldIndex < m_simLod.GetUnitCount())
+	{
+		m_simLod.Wake(pUnit->m_worldIndex);
+	}
+}
 
-	// adjust position & velocity for collisions.
-	__AdjustCharacterModelPositionForCollisions(pos, vel);
+u32 World::QueryRadius(const Vector2& center, f32 radius, World_Unit** ppUnits, u32 capacity) const
+{
+	return m_unitGrid.QueryRadius(center, radius, ppUnits, capacity);
+}
 
-	// update.
-	m_pCharacterObj->UpdatePosition(frameCount, pos, vel);
+u32 World::QueryAABB(const Vector2& min, const Vector2& max, World_Unit** ppUnits, u32 capacity) const
+{
+	return m_unitGrid.QueryAABB(min, max, ppUnits, capacity);
+}
 
-	m_pCharacterObj->Update(frameCount);
+u32 World::QueryObjectsAABB(const Vector2& min, const Vector2& max, World_Object** ppObjects, u32 capacity) const
+{
+	// objects are keyed by cell, walk each row of cells the box touches.
+	const s32 left = static_cast<s32>(std::floor(min.x / TILES_PER_METER));
+	const s32 top = static_cast<s32>(std::floor(min.y / TILES_PER_METER));
+	const s32 right = static_cast<s32>(std::floor(max.x / TILES_PER_METER));
+	const s32 bottom = static_cast<s32>(std::floor(max.y / TILES_PER_METER));
+
+	u32 count = 0;
+	for (s32 y = top; y <= bottom; ++y)
+	{
+		for (std::multimap<IVector2, World_Object*>::const_iterator it = m_objects.lower_bound(IVector2(left, y));
+			(it != m_objects.end()) && (it->first.y == y) && (it->first.x <= right); ++it)
+		{
+			if (count < capacity)
+			{
+				ppObjects[count] = it->second;
+			}
+			++count;
+		}
+	}
+	return count;
 }
 
-void World::Render3D(RenderMain* pRenderer)
+bool World::Raycast(const Vector2& from, const Vector2& to, const World_Unit* pIgnore, World_RaycastHit* pHit) const
 {
-	// draw all the tiles that might be on-screen.
-	const Vector2& screenSizeWorld = pRenderer->GetRenderScreenSizeWorld();
+	// walls first, then only the units before the wall.
+	Vector2 end = to;
+	f32 fraction = 1.f;
+	const bool isWall = m_wallGrid.Raycast(from, to, &end);
+	if (isWall)
+	{
+		const Vector2 delta = to - from;
+		const f32 deltaMagSq = delta.MagSq();
+		fraction = (deltaMagSq > 0.f) ? (Vector2::Dot(end - from, delta) / deltaMagSq) : 0.f;
+	}
+
+	World_Unit* pUnit = nullptr;
+	f32 unitFraction = 0.f;
+	if (m_unitGrid.Raycast(from, end, pIgnore, &pUnit, &unitFraction))
+	{
+		if (pHit)
+		{
+			pHit->m_fraction = unitFraction * fraction;
+			pHit->m_pos = from + ((end - from) * unitFraction);
+			pHit->m_pUnit = pUnit;
+		}
+		return true;
+	}
+
+	if (!isWall)
+		return false;
+
+	if (pHit)
+	{
+		pHit->m_fraction = fraction;
+		pHit->m_pos = end;
+		pHit->m_pUnit = nullptr;
+	}
+	return true;
+}
 
-	// compute which tiles we'll draw.
+bool World::HasLineOfSight(const Vector2& from, const Vector2& to) const
+{
+	// units don't block sight.
+	return m_wallGrid.HasLineOfSight(from, to);
+}
+
+void World::QueryRadiusBatch(const Vector2* pCenters, const f32* pRadii, u32 queryCount, World_Unit** ppUnits, u32 capacity, u32* pCounts)
+{
+	__RunQueryBatch(queryCount, [this, pCenters, pRadii, ppUnits, capacity, pCounts](u32 query) { pCounts[query] = QueryRadius(pCenters[query], pRadii[query], ppUnits + (query * capacity), capacity); });
+}
+
+void World::QueryAABBBatch(const Vector2* pMins, const Vector2* pMaxs, u32 queryCount, World_Unit** ppUnits, u32 capacity, u32* pCounts)
+{
+	__RunQueryBatch(queryCount, [this, pMins, pMaxs, ppUnits, capacity, pCounts](u32 query) { pCounts[query] = QueryAABB(pMins[query], pMaxs[query], ppUnits + (query * capacity), capacity); });
+}
+
+void World::RaycastBatch(const Vector2* pFrom, const Vector2* pTo, u32 queryCount, World_RaycastHit* pHits, u8* pIsHit)
+{
+	__RunQueryBatch(queryCount, [this, pFrom, pTo, pHits, pIsHit](u32 query) { pIsHit[query] = Raycast(pFrom[query], pTo[query], nullptr, pHits + query) ? 1 : 0; });
+}
+
+void World::HasLineOfSightBatch(const Vector2* pFrom, const Vector2* pTo, u32 queryCount, u8* pResults)
+{
+	__RunQueryBatch(queryCount, [this, pFrom, pTo, pResults](u32 query) { pResults[query] = HasLineOfSight(pFrom[query], pTo[query]) ? 1 : 0; });
+}
+
+void World::__RunQueryBatch(u32 queryCount, const std::function<void(u32)>& query)
+{
+	if (!m_pJobSystem)
+	{
+		m_pJobSystem = JobSystem::Alloc(m_threadCount);
+	}
+
+	// queries only read the world, split them into jobs of a few at a time.
+	const u32 jobCount = (queryCount + QUERY_BATCH_SIZE - 1) / QUERY_BATCH_SIZE;
+	m_pJobSystem->ParallelFor(jobCount, [queryCount, &query](u32 job)
+	{
+		const u32 end = std::min((job + 1) * QUERY_BATCH_SIZE, queryCount);
+		for (u32 i = job * QUERY_BATCH_SIZE; i < end; ++i)
+		{
+			query(i);
+		}
+	});
+}
+
+void World::SetThreadCount(u32 threadCount)
+{
+	m_threadCount = threadCount;
+	OBJFREE(m_pJobSystem);
+}
+
+u32 World::GetThreadCount() const
+{
+	return m_pJobSystem ? m_pJobSystem->GetThreadCount() : JobSystem::ResolveThreadCount(m_threadCount);
+}
+
+void World::SetSeed(u64 seed)
+{
+	// each unit's stream is its spawn order.
+	m_seed = seed;
+	for (u32 i = 0; i < m_units.size(); ++i)
+	{
+		m_units[i]->SeedRandom(m_seed, i);
+	}
+}
+
+void World::UpdateRender(f32 alpha)
+{
+	// asleep units haven't moved since they sat down, their render state is already where they are.
+	if (m_simLod.GetUnitCount() != m_units.size())
+	{
+		for (std::vector<World_Unit*>::iterator it = m_units.begin(); it != m_units.end(); ++it)
+		{
+			(*it)->ComputeRenderState(alpha);
+		}
+		return;
+	}
+
+	const std::vector<u32>& awakeUnits = m_simLod.GetAwakeUnits();
+	for (std::vector<u32>::const_iterator it = awakeUnits.begin(); it != awakeUnits.end(); ++it)
+	{
+		m_units[*it]->ComputeRenderState(alpha);
+	}
+}
+
+void World::Render3D()
+{
+	// draw all the tiles that might be on-screen.
 	IRect tiles;
-	tiles.left = static_cast<u32>((m_pCharacterObj->m_pos.x - ((screenSizeWorld.x / 2.f) * 3.f) / TILES_PER_METER));
-	tiles.right = static_cast<u32>((m_pCharacterObj->m_pos.x + ((screenSizeWorld.x / 2.f) * 3.f) / TILES_PER_METER)) + 1;
-	tiles.top = static_cast<u32>((m_pCharacterObj->m_pos.y - ((screenSizeWorld.y / 2.f) * 4.f) / TILES_PER_METER));
-	tiles.bottom = static_cast<u32>((m_pCharacterObj->m_pos.y + ((screenSizeWorld.y / 2.f) * 4.f) / TILES_PER_METER)) + 1;
+	__GetViewTiles(tiles);
 
-	Vector3 screenWorldPos = m_pCharacterObj->m_pos;
-	__GetRenderer()->AlignWorldPosition(screenWorldPos);
+	Vector3 screenWorldPos = m_pCharacterObj->m_renderPos;
+	__GetWorldRender()->AlignWorldPosition(screenWorldPos);
 
 	// draw the tiles & walls.
 	IVector2 cellPos;
@@ -133,108 +442,341 @@ void World::Render3D(RenderMain* pRenderer)
 		}
 	}
 
-	// draw the character.
+	// draw the units, relative to the character.
+	const u32 count = __QueryViewUnits(tiles);
+	for (u32 i = 0; i < count; ++i)
+	{
+		m_queryUnits[i]->Render3D(m_pCharacterObj->m_renderPos);
+	}
+}
+
+void World::Render2D()
+{
+	// the same units Render3D() draws.
+	IRect tiles;
+	__GetViewTiles(tiles);
+	const u32 count = __QueryViewUnits(tiles);
+	for (u32 i = 0; i < count; ++i)
 	{
-		m_pCharacterObj->Render3D(m_pCharacterObj->m_pos);
+		m_queryUnits[i]->Render2D(m_pCharacterObj->m_renderPos);
 	}
 }
 
-void World::Render2D(RenderMain* pRenderer)
+void World::__GetViewTiles(IRect& tiles) const
 {
-	m_pCharacterObj->Render2D(m_pCharacterObj->m_pos);
+	// the tiles that might be on-screen, with a wide margin.
+	const Vector2 screenSizeWorld = __GetWorldRender()->GetScreenSizeWorld();
+	tiles.left = static_cast<u32>((m_pCharacterObj->m_renderPos.x - ((screenSizeWorld.x / 2.f) * 3.f) / TILES_PER_METER));
+	tiles.right = static_cast<u32>((m_pCharacterObj->m_renderPos.x + ((screenSizeWorld.x / 2.f) * 3.f) / TILES_PER_METER)) + 1;
+	tiles.top = static_cast<u32>((m_pCharacterObj->m_renderPos.y - ((screenSizeWorld.y / 2.f) * 4.f) / TILES_PER_METER));
+	tiles.bottom = static_cast<u32>((m_pCharacterObj->m_renderPos.y + ((screenSizeWorld.y / 2.f) * 4.f) / TILES_PER_METER)) + 1;
+}
+
+u32 World::__QueryViewUnits(const IRect& tiles)
+{
+	// into m_queryUnits, which has room for them all.
+	const Vector2 viewMin(static_cast<f32>(tiles.left) * TILES_PER_METER, static_cast<f32>(tiles.top) * TILES_PER_METER);
+	const Vector2 viewMax(static_cast<f32>(tiles.right) * TILES_PER_METER, static_cast<f32>(tiles.bottom) * TILES_PER_METER);
+	m_queryUnits.resize(m_units.size());
+	return QueryAABB(viewMin, viewMax, m_queryUnits.data(), static_cast<u32>(m_queryUnits.size()));
 }
 
 void World::__Initialize()
 {
+	m_broadphase.SetCellSize(TILES_PER_METER);
+
 	// register for events.
-	__GetEventQueue()->RegisterForMessage(EventModuleID_World, EventMessageID_MoveStart, std::bind(&World::__EventHandler, this, std::placeholders::_1));
-	__GetEventQueue()->RegisterForMessage(EventModuleID_World, EventMessageID_MoveEnd, std::bind(&World::__EventHandler, this, std::placeholders::_1));
+	__GetEventQueue()->Register<EventMessage_MoveStart>(EventModuleID_World, this, &World::__OnMoveStart);
+	__GetEventQueue()->Register<EventMessage_MoveEnd>(EventModuleID_World, this, &World::__OnMoveEnd);
 }
 
 void World::__Uninitialize()
 {
 	__GetEventQueue()->UnregisterForMessagesByRegistree(EventModuleID_World);
 
+	m_mapStreamer.Stop(m_objects);
 	for (std::multimap<IVector2, World_Object*>::iterator it = m_objects.begin(); it != m_objects.end(); ++it)
 	{
 		OBJFREE(it->second);
 	}
+	m_objects.clear();
+	m_mapFile.Close();
+	OBJFREE(m_pMapFileMapping);
+	m_mapFileModels.clear();
+
+	for (std::vector<World_Unit*>::iterator it = m_units.begin(); it != m_units.end(); ++it)
+	{
+		if (*it != m_pCharacterObj)
+		{
+			OBJFREE(*it);
+		}
+	}
+	m_units.clear();
 
 	OBJFREE(m_pCharacterObj);
 
-	for (std::map<u32, RenderModel*>::iterator it = m_mapModels.begin(); it != m_mapModels.end(); ++it)
+	OBJFREE(m_pJobSystem);
+
+	for (std::map<u32, World_RenderModel*>::iterator it = m_mapModels.begin(); it != m_mapModels.end(); ++it)
 	{
 		RELEASEI(it->second);
 	}
 }
 
-void World::__EventHandler(EventMessage* pEvent)
+void World::__OnMoveStart(EventMessage_MoveStart* pEvent)
 {
-	switch (pEvent->GetID())
+	if (pEvent->m_dx != 0)
 	{
-	case EventMessageID_MoveStart:
+		const Vector3 force(static_cast<f32>(pEvent->m_dx), m_pCharacterObj->GetForce().y, m_pCharacterObj->GetForce().z);
+		m_pCharacterObj->SetForce(force);
+	}
+	if (pEvent->m_dy != 0)
 	{
-		EventMessage_MoveStart* pEventMoveStart = static_cast<EventMessage_MoveStart*>(pEvent);
-		if (pEventMoveStart->m_dx != 0)
-		{
-			const Vector3 force(static_cast<f32>(pEventMoveStart->m_dx), m_pCharacterObj->GetForce().y, m_pCharacterObj->GetForce().z);
-			m_pCharacterObj->SetForce(force);
-		}
-		if (pEventMoveStart->m_dy != 0)
-		{
-			const Vector3 force(m_pCharacterObj->GetForce().x, static_cast<f32>(pEventMoveStart->m_dy), m_pCharacterObj->GetForce().z);
-			m_pCharacterObj->SetForce(force);
-		}
-		if (pEventMoveStart->m_dz != 0)
+		const Vector3 force(m_pCharacterObj->GetForce().x, static_cast<f32>(pEvent->m_dy), m_pCharacterObj->GetForce().z);
+		m_pCharacterObj->SetForce(force);
+	}
+	if (pEvent->m_dz != 0)
+	{
+		const Vector3 force(m_pCharacterObj->GetForce().x, m_pCharacterObj->GetForce().y, static_cast<f32>(pEvent->m_dz));
+		m_pCharacterObj->SetForce(force);
+	}
+}
+
+void World::__OnMoveEnd(EventMessage_MoveEnd* pEvent)
+{
+	if (pEvent->m_dx != 0)
+	{
+		const Vector3 force(0.f, m_pCharacterObj->GetForce().y, m_pCharacterObj->GetForce().z);
+		m_pCharacterObj->SetForce(force);
+	}
+	if (pEvent->m_dy != 0)
+	{
+		const Vector3 force(m_pCharacterObj->GetForce().x, 0.f, m_pCharacterObj->GetForce().z);
+		m_pCharacterObj->SetForce(force);
+	}
+	if (pEvent->m_dz != 0)
+	{
+		const Vector3 force(m_pCharacterObj->GetForce().x, m_pCharacterObj->GetForce().y, 0.f);
+		m_pCharacterObj->SetForce(force);
+	}
+}
+
+void World::__SteerUnitsToGoals()
+{
+	// group the units by goal, so each goal's field is looked up once, and make room for every goal so they don't
+	//  evict each other's fields.
+	m_steerGoals.clear();
+	for (u32 i = 0; i < m_tickUnits.size(); ++i)
+	{
+		const World_Unit* pUnit = m_tickUnits[i];
+		if (!pUnit->m_isGoalSet)
+			continue;
+		const u64 goal = (static_cast<u64>(static_cast<u32>(pUnit->m_goalCell.y)) << 32) | static_cast<u32>(pUnit->m_goalCell.x);
+		m_steerGoals.push_back(std::make_pair(goal, i));
+	}
+	std::sort(m_steerGoals.begin(), m_steerGoals.end());
+
+	u32 goalCount = 0;
+	for (u32 i = 0; i < m_steerGoals.size(); ++i)
+	{
+		if ((i == 0) || (m_steerGoals[i].first != m_steerGoals[i - 1].first))
 		{
-			const Vector3 force(m_pCharacterObj->GetForce().x, m_pCharacterObj->GetForce().y, static_cast<f32>(pEventMoveStart->m_dz));
-			m_pCharacterObj->SetForce(force);
+			++goalCount;
 		}
-		break;
 	}
-	case EventMessageID_MoveEnd:
+	m_flowFields.Reserve(goalCount);
+
+	const World_FlowField* pField = nullptr;
+	for (u32 i = 0; i < m_steerGoals.size(); ++i)
 	{
-		EventMessage_MoveStart* pEventMoveEnd = static_cast<EventMessage_MoveStart*>(pEvent);
-		if (pEventMoveEnd->m_dx != 0)
+		World_Unit* pUnit = m_tickUnits[m_steerGoals[i].second];
+		if ((i == 0) || (m_steerGoals[i].first != m_steerGoals[i - 1].first))
 		{
-			const Vector3 force(0.f, m_pCharacterObj->GetForce().y, m_pCharacterObj->GetForce().z);
-			m_pCharacterObj->SetForce(force);
+			pField = m_flowFields.GetField(pUnit->m_goalCell);
 		}
-		if (pEventMoveEnd->m_dy != 0)
+
+		// stop at the goal, or when it can't be reached.
+		const IVector2 cell(static_cast<s32>(pUnit->m_pos.x / TILES_PER_METER), static_cast<s32>(pUnit->m_pos.y / TILES_PER_METER));
+		Vector2 dir;
+		if (!pField || !pField->GetDirection(cell, &dir))
 		{
-			const Vector3 force(m_pCharacterObj->GetForce().x, 0.f, m_pCharacterObj->GetForce().z);
-			m_pCharacterObj->SetForce(force);
+			dir = Vector2(0.f, 0.f);
 		}
-		if (pEventMoveEnd->m_dz != 0)
+
+		const Vector3 force(dir.x, dir.y, pUnit->GetForce().z);
+		pUnit->SetForce(force);
+	}
+}
+
+void World::__AvoidUnits(s32 frameCount)
+{
+	// units following a goal avoid each other, everything else is an obstacle moving at its current velocity.  only
+	//  units ticking this frame take part.
+	const u32 count = static_cast<u32>(m_tickUnits.size());
+	m_avoidanceAgents.resize(count);
+	m_avoidanceVelocities.resize(count);
+	for (u32 i = 0; i < count; ++i)
+	{
+		const World_Unit* pUnit = m_tickUnits[i];
+		World_Avoidance_Agent& agent = m_avoidanceAgents[i];
+
+		agent.m_pos = Vector2(pUnit->m_pos.x, pUnit->m_pos.y);
+		agent.m_vel = Vector2(pUnit->m_velocity.x, pUnit->m_velocity.y);
+		agent.m_radius = __GetUnitRadius(*pUnit);
+		agent.m_maxSpeed = pUnit->m_maxVelocity;
+		agent.m_isAvoiding = pUnit->m_isGoalSet ? 1 : 0;
+
+		// flow field directions are unit length, so a goal is approached at full speed.
+		const Vector3& force = pUnit->GetForce();
+		agent.m_velPref = pUnit->m_isGoalSet ? (Vector2(force.x, force.y) * pUnit->m_maxVelocity) : agent.m_vel;
+	}
+
+	const f32 timeStep = static_cast<f32>(frameCount) / UNIT_FRAMES_PER_SECOND;
+	m_avoidance.Compute(m_avoidanceAgents.data(), count, timeStep, m_pJobSystem, m_avoidanceVelocities.data());
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		World_Unit* pUnit = m_tickUnits[i];
+		if (!pUnit->m_isGoalSet)
+			continue;
+		pUnit->SteerToVelocity(m_tickFrames[i], m_avoidanceVelocities[i]);
+	}
+}
+
+f32 World::__GetUnitRadius(const World_Unit& unit)
+{
+	// circle around the bounds in the ground plane.
+	Vector3 min, max;
+	unit.m_bounds.ComputeAABB(min, max);
+	return std::max(max.x - min.x, max.y - min.y) * 0.5f;
+}
+
+void World::__SleepSettledUnits()
+{
+	// units sat still with nothing to do sleep until something comes near, unless they're close enough to be watched.
+	for (std::vector<World_Unit*>::const_iterator it = m_tickUnits.begin(); it != m_tickUnits.end(); ++it)
+	{
+		const World_Unit* pUnit = *it;
+		if ((pUnit == m_pCharacterObj) || pUnit->m_isGoalSet || !pUnit->IsSitting() || pUnit->m_pImagine)
+			continue;
+		if (!is_approx_zero(pUnit->GetForce().x) || !is_approx_zero(pUnit->GetForce().y) || !is_approx_zero(pUnit->GetForce().z))
+			continue;
+		if (!is_approx_zero(pUnit->m_velocity.x) || !is_approx_zero(pUnit->m_velocity.y) || !is_approx_zero(pUnit->m_velocity.z))
+			continue;
+
+		const Vector2 pos(pUnit->m_pos.x, pUnit->m_pos.y);
+		if (m_simLod.GetTickInterval(pos) <= 1)
+			continue;
+		m_simLod.Sleep(pUnit->m_worldIndex, pos);
+	}
+}
+
+void World::__AssignUnitsToRegions()
+{
+	// regions tile the map.
+	const IVector2 regionCount(std::max<s32>((m_mapSize.x + REGION_SIZE_CELLS - 1) / REGION_SIZE_CELLS, 1), std::max<s32>((m_mapSize.y + REGION_SIZE_CELLS - 1) / REGION_SIZE_CELLS, 1));
+	if ((regionCount.x != m_regionCount.x) || (regionCount.y != m_regionCount.y))
+	{
+		m_regionCount = regionCount;
+		m_regions.clear();
+		m_regions.resize(regionCount.x * regionCount.y);
+
+		IVector2 regionPos;
+		for (regionPos.y = 0; regionPos.y < regionCount.y; ++regionPos.y)
 		{
-			const Vector3 force(m_pCharacterObj->GetForce().x, m_pCharacterObj->GetForce().y, 0.f);
-			m_pCharacterObj->SetForce(force);
+			for (regionPos.x = 0; regionPos.x < regionCount.x; ++regionPos.x)
+			{
+				World_Region& region = m_regions[(regionPos.y * regionCount.x) + regionPos.x];
+				region.m_cellMin = IVector2(regionPos.x * REGION_SIZE_CELLS, regionPos.y * REGION_SIZE_CELLS);
+				region.m_cellMax = IVector2(region.m_cellMin.x + REGION_SIZE_CELLS, region.m_cellMin.y + REGION_SIZE_CELLS);
+				region.m_broadphase.SetCellSize(TILES_PER_METER);
+			}
 		}
-		break;
 	}
-	default:
-		break;
+
+	for (std::vector<World_Region>::iterator it = m_regions.begin(); it != m_regions.end(); ++it)
+	{
+		it->m_unitIndicies.clear();
+		it->m_units.clear();
+		it->m_frameCounts.clear();
+	}
+
+	// units go in by index, so each region's list is in unit order.
+	for (u32 i = 0; i < m_tickUnits.size(); ++i)
+	{
+		World_Unit* pUnit = m_tickUnits[i];
+		const s32 cellX = static_cast<s32>(std::floor(pUnit->m_pos.x / TILES_PER_METER));
+		const s32 cellY = static_cast<s32>(std::floor(pUnit->m_pos.y / TILES_PER_METER));
+		const s32 regionX = std::min<s32>(std::max<s32>(cellX, 0) / REGION_SIZE_CELLS, m_regionCount.x - 1);
+		const s32 regionY = std::min<s32>(std::max<s32>(cellY, 0) / REGION_SIZE_CELLS, m_regionCount.y - 1);
+
+		World_Region& region = m_regions[(regionY * m_regionCount.x) + regionX];
+		region.m_unitIndicies.push_back(i);
+		region.m_units.push_back(pUnit);
+		region.m_frameCounts.push_back(m_tickFrames[i]);
 	}
 }
 
-void World::__AdjustCharacterModelPositionForCollisions(Vector3& pos, Vector3& vel)
+void World::__UpdateRegion(World_Region& region) const
 {
-	if (!__IsCharacterModelCollideWithWall(pos))
+	// runs on a worker. only touches the region's own units, and reads the map.
+	const u32 count = static_cast<u32>(region.m_units.size());
+	region.m_moves.resize(count);
+	region.m_isInterior.resize(count);
+	if (!count)
 		return;
 
-	__AdjustCharacterModelPositionForCollisionsAxis(pos, vel, Vector3(1.f, 0.f, 0.f));
-	__AdjustCharacterModelPositionForCollisionsAxis(pos, vel, Vector3(0.f, 1.f, 0.f));
-	__AdjustCharacterModelPositionForCollisionsAxis(pos, vel, Vector3(0.f, 0.f, 1.f));
+	// compute where each unit wants to go.
+	region.m_integrator.Integrate(region.m_frameCounts.data(), region.m_units.data(), count, region.m_moves.data());
+
+	// adjust for collisions with walls.
+	const Vector2 regionMin(static_cast<f32>(region.m_cellMin.x) * TILES_PER_METER, static_cast<f32>(region.m_cellMin.y) * TILES_PER_METER);
+	const Vector2 regionMax(static_cast<f32>(region.m_cellMax.x) * TILES_PER_METER, static_cast<f32>(region.m_cellMax.y) * TILES_PER_METER);
+	region.m_boundsMin.resize(count);
+	region.m_boundsMax.resize(count);
+	for (u32 i = 0; i < count; ++i)
+	{
+		const World_Unit& unit = *region.m_units[i];
+		World_UnitMove& move = region.m_moves[i];
+		__AdjustUnitPositionForCollisions(unit, move.m_pos, move.m_vel);
+
+		Vector2& min = region.m_boundsMin[i];
+		Vector2& max = region.m_boundsMax[i];
+		__ComputeUnitMoveBounds(unit, move, min, max);
+		region.m_isInterior[i] = (min.x > regionMin.x) && (min.y > regionMin.y) && (max.x < regionMax.x) && (max.y < regionMax.y);
+	}
+
+	// interior units can only touch units in this region, resolve those pairs here.
+	region.m_broadphase.Build(region.m_boundsMin.data(), region.m_boundsMax.data(), count);
+	region.m_broadphase.ComputePairs();
+
+	const std::vector<World_Broadphase_Pair>& pairs = region.m_broadphase.GetPairs();
+	for (std::vector<World_Broadphase_Pair>::const_iterator it = pairs.begin(); it != pairs.end(); ++it)
+	{
+		if (!region.m_isInterior[it->m_indexA] || !region.m_isInterior[it->m_indexB])
+			continue;
+		__ResolveUnitCollision(*region.m_units[it->m_indexA], region.m_moves[it->m_indexA], *region.m_units[it->m_indexB], region.m_moves[it->m_indexB]);
+	}
+}
+
+void World::__AdjustUnitPositionForCollisions(const World_Unit& unit, Vector3& pos, Vector3& vel) const
+{
+	if (!__IsUnitCollideWithWall(unit, pos))
+		return;
+
+	__AdjustUnitPositionForCollisionsAxis(unit, pos, vel, Vector3(1.f, 0.f, 0.f));
+	__AdjustUnitPositionForCollisionsAxis(unit, pos, vel, Vector3(0.f, 1.f, 0.f));
+	__AdjustUnitPositionForCollisionsAxis(unit, pos, vel, Vector3(0.f, 0.f, 1.f));
 }
 
-void World::__AdjustCharacterModelPositionForCollisionsAxis(Vector3& pos, Vector3& vel, const Vector3& axis)
+void World::__AdjustUnitPositionForCollisionsAxis(const World_Unit& unit, Vector3& pos, Vector3& vel, const Vector3& axis) const
 {
-	const World_Object& object = *m_pCharacterObj;
+	const World_Object& object = unit;
 	const Vector3 posDelta = pos - object.m_pos;
 	const f32 posDeltaAxisMag = Vector3::Dot(posDelta, axis);
 	if (is_approx_zero(posDeltaAxisMag))
 		return;
-	if (!__IsCharacterModelCollideWithWall(object.m_pos + (axis * posDeltaAxisMag)))
+	if (!__IsUnitCollideWithWall(unit, object.m_pos + (axis * posDeltaAxisMag)))
 		return;
 
 	// this axis collides. interpolate position.
@@ -244,7 +786,7 @@ void World::__AdjustCharacterModelPositionForCollisionsAxis(Vector3& pos, Vector
 	for (u32 i = 0; i < 8; ++i)
 	{
 		const f32 mid = (max + min) / 2.f;
-		if (__IsCharacterModelCollideWithWall(object.m_pos + (axis * mid)))
+		if (__IsUnitCollideWithWall(unit, object.m_pos + (axis * mid)))
 		{
 			max = mid;
 		}
@@ -272,256 +814,311 @@ void World::__AdjustCharacterModelPositionForCollisionsAxis(Vector3& pos, Vector
 	}
 }
 
-bool World::__IsCharacterModelCollideWithWall(const Vector3& posNew) const
+bool World::__IsBoundsInWallGrid(const World_Object_Bounds& bounds) const
 {
-	const World_Object& object = *m_pCharacterObj;
+	// walls stand the full height of the map, so only the footprint of the bounds matters.
+	switch (bounds.m_type)
+	{
+	case World_Object_Bounds_Type_Box:
+	{
+		Vector2 points[ARRAYSIZE(bounds.m_coords)];
+		for (u32 i = 0; i < ARRAYSIZE(bounds.m_coords); ++i)
+		{
+			points[i] = Vector2(bounds.m_coords[i].x, bounds.m_coords[i].y);
+		}
+		return m_wallGrid.IsWallInHull(points, ARRAYSIZE(points), WALL_GRID_MARGIN);
+	}
+	case World_Object_Bounds_Type_Sphere:
+		return m_wallGrid.IsWallInCircle(Vector2(bounds.m_center.x, bounds.m_center.y), bounds.m_radius + WALL_GRID_MARGIN);
+	default:
+		return false;
+	}
+}
+
+bool World::__IsUnitCollideWithWall(const World_Unit& unit, const Vector3& posNew) const
+{
+	const World_Object& object = unit;
 	const Vector3 posDelta = posNew - object.m_pos;
 
 	World_Object_Bounds boundsNew = object.m_bounds;
 	boundsNew.m_center = boundsNew.m_center + posDelta;
 
-	// compute which tiles to examine for collisions.
-	IRect tiles;
-	tiles.left = static_cast<u32>(posNew.x / TILES_PER_METER) - 1;
-	tiles.right = static_cast<u32>(posNew.x / TILES_PER_METER) + 1;
-	tiles.top = static_cast<u32>(posNew.y / TILES_PER_METER) - 1;
-	tiles.bottom = static_cast<u32>(posNew.y / TILES_PER_METER) + 1;
-
-	// look at walls for each tile.
-	IVector2 cellPos;
-	for (cellPos.y = tiles.top; cellPos.y <= tiles.bottom; ++cellPos.y)
+	// broad phase, only run the detailed test if a wall edge is near the bounds.
+	Vector3 boundsMin;
+	Vector3 boundsMax;
+	boundsNew.ComputeAABB(boundsMin, boundsMax);
+	if (!m_wallGrid.IsWallInRect(Vector2(boundsMin.x - WALL_GRID_MARGIN, boundsMin.y - WALL_GRID_MARGIN), Vector2(boundsMax.x + WALL_GRID_MARGIN, boundsMax.y + WALL_GRID_MARGIN)))
+		return false;
+
+	// wall objects only exist in resident chunks.  past them, test the bounds against the wall edges themselves.
+	const IVector2 cellMin(static_cast<s32>(std::floor((boundsMin.x / TILES_PER_METER) - 1.f)), static_cast<s32>(std::floor((boundsMin.y / TILES_PER_METER) - 1.f)));
+	const IVector2 cellMax(static_cast<s32>(std::floor((boundsMax.x / TILES_PER_METER) + 1.f)), static_cast<s32>(std::floor((boundsMax.y / TILES_PER_METER) + 1.f)));
+	if (!m_mapStreamer.IsCellResident(cellMin) || !m_mapStreamer.IsCellResident(cellMax) ||
+		!m_mapStreamer.IsCellResident(IVector2(cellMax.x, cellMin.y)) || !m_mapStreamer.IsCellResident(IVector2(cellMin.x, cellMax.y)))
+		return __IsBoundsInWallGrid(boundsNew);
+
+	// look at the walls in the tiles around the bounds.
+	World_Object* objects[QUERY_COLLISION_OBJECT_MAX];
+	const Vector2 queryMin(boundsMin.x - TILES_PER_METER, boundsMin.y - TILES_PER_METER);
+	const Vector2 queryMax(boundsMax.x + TILES_PER_METER, boundsMax.y + TILES_PER_METER);
+	World_Object** ppObjects = objects;
+	std::vector<World_Object*> objectsOverflow;
+	const u32 count = QueryObjectsAABB(queryMin, queryMax, objects, QUERY_COLLISION_OBJECT_MAX);
+	if (count > QUERY_COLLISION_OBJECT_MAX)
 	{
-		cellPos.x = tiles.left;
-		for (std::multimap<IVector2, World_Object*>::const_iterator it = m_objects.lower_bound(cellPos);
-			(it != m_objects.end()) && (it->first.y == cellPos.y) && (it->first.x <= tiles.right); ++it)
-		{
-			World_Object* pObj = it->second;
-			if (!pObj->IsCollision(boundsNew))
-				continue;
+		// a dense spot, query again into a buffer big enough for all of them.
+		objectsOverflow.resize(count);
+		ppObjects = objectsOverflow.data();
+		QueryObjectsAABB(queryMin, queryMax, ppObjects, count);
+	}
+	for (u32 i = 0; i < count; ++i)
+	{
+		if (ppObjects[i]->IsCollision(boundsNew))
 			return true;
-		}
 	}
 
 	return false;
 }
 
-void World::__ParseMapStartElement(const char* pszName, const char** ppAttribs)
+void World::__AdjustUnitPositionsForUnitCollisions()
 {
-	if (_strcmpi(reinterpret_cast<const char*>(pszName), "model") == 0)
+	// bounds of each unit at its new position.
+	const u32 count = static_cast<u32>(m_tickUnits.size());
+	m_unitBoundsMin.resize(count);
+	m_unitBoundsMax.resize(count);
+	for (u32 i = 0; i < count; ++i)
 	{
-		// models.
-		u32 id = 0;
-		const char* pszType = nullptr;
-		const char* pszPath = nullptr;
-		const char* pszModel = nullptr;
-		RenderModel* pModel = nullptr;
+		__ComputeUnitMoveBounds(*m_tickUnits[i], m_unitMoves[i], m_unitBoundsMin[i], m_unitBoundsMax[i]);
+	}
 
-		for (const char** ppAttrib = ppAttribs; ppAttrib && *ppAttrib; ppAttrib += 2)
-		{
-			const char* pszAttribName = *(ppAttrib + 0);
-			const char* pszValue = *(ppAttrib + 1);
+	// find candidate pairs.
+	m_broadphase.Build(m_unitBoundsMin.data(), m_unitBoundsMax.data(), count);
+	m_broadphase.ComputePairs();
 
-			if (_strcmpi(pszAttribName, "id") == 0)
-			{
-				id = atol(pszValue);
-			}
-			else if (_strcmpi(pszAttribName, "type") == 0)
-			{
-				pszType = pszValue;
-			}
-			else if (_strcmpi(pszAttribName, "path") == 0)
-			{
-				pszPath = pszValue;
-			}
-			else if (_strcmpi(pszAttribName, "model") == 0)
-			{
-				pszModel = pszValue;
-			}
-		}
+	// narrow phase, push colliding units apart.
+	const std::vector<World_Broadphase_Pair>& pairs = m_broadphase.GetPairs();
+	for (std::vector<World_Broadphase_Pair>::const_iterator it = pairs.begin(); it != pairs.end(); ++it)
+	{
+		// already resolved by the region.
+		const u32 regionA = m_unitRegions[it->m_indexA];
+		if ((regionA != WORLD_REGION_NONE) && (regionA == m_unitRegions[it->m_indexB]))
+			continue;
 
-		if (id != 0 && pszType && pszPath)
-		{
-			if (_strcmpi(pszType, "texture") == 0)
-			{
-				std::string texturePath = m_mapPath;
-				TB8::File::AppendToPath(texturePath, pszPath);
-				RenderTexture* pTexture = RenderTexture::Alloc(__GetRenderer(), texturePath.c_str());
-				pModel = RenderModel::AllocSimpleRectangle(__GetRenderer(), RenderMainViewType_World, Vector3(0.f, 0.f, 1.f), Vector3(1.f, 0.f, 0.f), 
-															pTexture, Vector2(0.f, 0.f), Vector2(1.f, 1.f));
-				RELEASEI(pTexture);
-			}
-			else if ((_strcmpi(pszType, "dae") == 0) && pszModel)
-			{
-				pModel = RenderModel::AllocFromDAE(__GetRenderer(), m_mapPath.c_str(), pszPath, pszModel);
-			}
-		}
+		__ResolveUnitCollision(*m_tickUnits[it->m_indexA], m_unitMoves[it->m_indexA], *m_tickUnits[it->m_indexB], m_unitMoves[it->m_indexB]);
+	}
+}
 
-		if (id != 0 && pModel)
-		{
-			m_mapModels.insert(std::make_pair(id, pModel));
-		}
+void World::__ComputeUnitMoveBounds(const World_Unit& unit, const World_UnitMove& move, Vector2& min, Vector2& max) const
+{
+	World_Object_Bounds bounds = unit.m_bounds;
+	bounds.m_center = bounds.m_center + (move.m_pos - unit.m_pos);
+
+	Vector3 boundsMin;
+	Vector3 boundsMax;
+	bounds.ComputeAABB(boundsMin, boundsMax);
+	min = Vector2(boundsMin.x, boundsMin.y);
+	max = Vector2(boundsMax.x, boundsMax.y);
+}
+
+void World::__ResolveUnitCollision(const World_Unit& unitA, World_UnitMove& moveA, const World_Unit& unitB, World_UnitMove& moveB) const
+{
+	World_Object_Bounds boundsA = unitA.m_bounds;
+	boundsA.m_center = boundsA.m_center + (moveA.m_pos - unitA.m_pos);
+	World_Object_Bounds boundsB = unitB.m_bounds;
+	boundsB.m_center = boundsB.m_center + (moveB.m_pos - unitB.m_pos);
+	if (!World_Object_Bounds::IsCollision(boundsA, boundsB))
+		return;
+
+	// separate along the line between the centers.
+	Vector2 normal(boundsB.m_center.x - boundsA.m_center.x, boundsB.m_center.y - boundsA.m_center.y);
+	const f32 dist = normal.Mag();
+	if (is_approx_zero(dist))
+	{
+		normal = Vector2(1.f, 0.f);
 	}
-	if (_strcmpi(reinterpret_cast<const char*>(pszName), "size") == 0)
+	else
 	{
-		u32 defaultTile = 0;
+		normal = normal / dist;
+	}
 
-		for (const char** ppAttrib = ppAttribs; ppAttrib && *ppAttrib; ppAttrib += 2)
-		{
-			const char* pszAttribName = *(ppAttrib + 0);
-			const char* pszValue = *(ppAttrib + 1);
+	const f32 overlap = std::max<f32>(boundsA.m_radius + boundsB.m_radius - dist, 0.f);
+	const Vector3 push(normal.x * overlap * 0.5f, normal.y * overlap * 0.5f, 0.f);
 
-			if (_strcmpi(pszAttribName, "x") == 0)
-			{
-				m_mapSize.x = atol(pszValue);
-			}
-			else if (_strcmpi(pszAttribName, "y") == 0)
-			{
-				m_mapSize.y = atol(pszValue);
-			}
-			else if (_strcmpi(pszAttribName, "default_tile") == 0)
-			{
-				defaultTile = atol(pszValue);
-			}
-		}
+	// don't push a unit into a wall.
+	const Vector3 posA = moveA.m_pos - push;
+	if (!__IsUnitCollideWithWall(unitA, posA))
+	{
+		moveA.m_pos = posA;
+	}
+	const Vector3 posB = moveB.m_pos + push;
+	if (!__IsUnitCollideWithWall(unitB, posB))
+	{
+		moveB.m_pos = posB;
+	}
 
-		IVector2 pos;
-		for (pos.x = 0; pos.x < m_mapSize.x; ++pos.x)
-		{
-			for (pos.y = 0; pos.y < m_mapSize.y; ++pos.y)
-			{
-				std::map<u32, RenderModel*>::iterator itModel = m_mapModels.find(defaultTile);
-				if (itModel != m_mapModels.end())
-				{
-					World_Object* pObj = World_Object::Alloc(__GetGlobals());
-					pObj->m_modelID = defaultTile;
-					pObj->m_type = World_Object_Type_Tile;
-					pObj->m_pModel = itModel->second;
-					pObj->m_scale = 1.f;
-					pObj->m_rotation = 0.f;
-					pObj->m_pos = Vector3(static_cast<f32>(pos.x), static_cast<f32>(pos.y), 0.f);
-					pObj->Init();
-
-					m_objects.insert(std::make_pair(pos, pObj));
-				}
-			}
-		}
+	// remove the velocity that closes the gap.
+	const f32 closingA = (moveA.m_vel.x * normal.x) + (moveA.m_vel.y * normal.y);
+	if (closingA > 0.f)
+	{
+		moveA.m_vel.x -= normal.x * closingA;
+		moveA.m_vel.y -= normal.y * closingA;
 	}
-	if (_strcmpi(reinterpret_cast<const char*>(pszName), "start") == 0)
+	const f32 closingB = (moveB.m_vel.x * normal.x) + (moveB.m_vel.y * normal.y);
+	if (closingB < 0.f)
 	{
-		Vector3 posStart(0.f, 0.f, 0.f);
-		for (const char** ppAttrib = ppAttribs; ppAttrib && *ppAttrib; ppAttrib += 2)
-		{
-			const char* pszAttribName = *(ppAttrib + 0);
-			const char* pszValue = *(ppAttrib + 1);
+		moveB.m_vel.x -= normal.x * closingB;
+		moveB.m_vel.y -= normal.y * closingB;
+	}
+}
 
-			if (_strcmpi(pszAttribName, "x") == 0)
-			{
-				posStart.x = static_cast<float>(atol(pszValue));
-			}
-			else if (_strcmpi(pszAttribName, "y") == 0)
-			{
-				posStart.y = static_cast<float>(atol(pszValue));
-			}
+void World::__LoadMapFile()
+{
+	// models, in the file's model order.
+	m_mapFileModels.assign(m_mapFile.GetModelCount(), nullptr);
+	for (u32 i = 0; i < m_mapFile.GetModelCount(); ++i)
+	{
+		const World_MapFile_Model& model = m_mapFile.GetModel(i);
+		const char* pszPath = m_mapFile.GetString(model.m_path);
+		World_RenderModel* pModel = nullptr;
+		if (model.m_type == World_MapFile_ModelType_Texture)
+		{
+			std::string texturePath = m_mapPath;
+			TB8::File::AppendToPath(texturePath, pszPath);
+			pModel = __GetWorldRender()->AllocModelFromTexture(texturePath.c_str());
+		}
+		else if (model.m_type == World_MapFile_ModelType_DAE)
+		{
+			pModel = __GetWorldRender()->AllocModelFromDAE(m_mapPath.c_str(), pszPath, m_mapFile.GetString(model.m_name));
 		}
 
-		m_startPos = posStart;
+		if (pModel)
+		{
+			m_mapModels.insert(std::make_pair(model.m_id, pModel));
+			m_mapFileModels[i] = pModel;
+		}
 	}
-	if (_strcmpi(reinterpret_cast<const char*>(pszName), "cell") == 0)
+
+	m_mapSize = m_mapFile.GetSize();
+	const Vector2 startPos = m_mapFile.GetStartPos();
+	m_startPos = Vector3(startPos.x, startPos.y, 0.f);
+
+	m_wallGrid.Resize(m_mapSize);
+	m_pathfinder.Resize(m_mapSize);
+	m_pathHierarchy.Resize();
+	m_flowFields.Resize();
+
+	// the wall grid has every wall from the start, only their objects stream.
+	const IVector2 chunkCount = m_mapFile.GetChunkCount();
+	IVector2 chunkPos;
+	for (chunkPos.y = 0; chunkPos.y < chunkCount.y; ++chunkPos.y)
 	{
-		IVector2 pos;
-		for (const char** ppAttrib = ppAttribs; ppAttrib && *ppAttrib; ppAttrib += 2)
+		for (chunkPos.x = 0; chunkPos.x < chunkCount.x; ++chunkPos.x)
 		{
-			const char* pszAttribName = *(ppAttrib + 0);
-			const char* pszValue = *(ppAttrib + 1);
-
-			if (_strcmpi(pszAttribName, "pos") == 0)
+			const u8* pEdges = m_mapFile.GetChunkEdges(chunkPos);
+			const u16* pWalls = m_mapFile.GetChunkWalls(chunkPos);
+			for (u32 i = 0; i < MAPSTREAM_CHUNK_SIZE * MAPSTREAM_CHUNK_SIZE; ++i)
 			{
-				std::vector<std::string> values;
-				StrTok(pszValue, " ,", &values);
-				if (values.size() == 2)
-				{
-					pos.x = atol(values[0].c_str());
-					pos.y = atol(values[1].c_str());
-				}
-			}
-			else if (_strcmpi(pszAttribName, "wall") == 0)
-			{
-				std::vector<std::string> values;
-				StrTok(pszValue, " ,", &values);
-				if (values.size() == 2)
-				{
-					u32 index = 0;
-					f32 rotation = 0.f;
-					Vector2 offset;
-					if (_strcmpi(values[0].c_str(), "top") == 0)
-					{
-						index = 0;
-						rotation = 0.f;
-						offset = Vector2(0.5f, 0.f);
-					}
-					else if (_strcmpi(values[0].c_str(), "left") == 0)
-					{
-						index = 1;
-						rotation = -90.f;
-						offset = Vector2(0.0f, 0.5f);
-					}
-					else if (_strcmpi(values[0].c_str(), "right") == 0)
-					{
-						index = 2;
-						rotation = +90.f;
-						offset = Vector2(1.0f, 0.5f);
-					}
-					else if (_strcmpi(values[0].c_str(), "bottom") == 0)
-					{
-						index = 3;
-						rotation = +180.f;
-						offset = Vector2(0.5f, 1.0f);
-					}
+				if (!pEdges[i])
+					continue;
 
-					const u32 modelID = atol(values[1].c_str());
-					std::map<u32, RenderModel*>::iterator it = m_mapModels.find(modelID);
-					if (it != m_mapModels.end())
+				const IVector2 cell((chunkPos.x * MAPSTREAM_CHUNK_SIZE) + static_cast<s32>(i % MAPSTREAM_CHUNK_SIZE), (chunkPos.y * MAPSTREAM_CHUNK_SIZE) + static_cast<s32>(i / MAPSTREAM_CHUNK_SIZE));
+				for (u32 bit = 0; bit < 4; ++bit)
+				{
+					if (!(pEdges[i] & (1 << bit)))
+						continue;
+					if (m_mapFileModels[*pWalls++])
 					{
-						RenderModel* pModel = it->second;
-						const std::vector<RenderModel_Mesh>& meshes = it->second->GetMeshes();
-						if (!meshes.empty())
-						{
-							World_Object* pObj = World_Object::Alloc(__GetGlobals());
-
-							const RenderModel_Mesh& mesh = meshes.front();
-							const RenderModel_Bounds& meshBounds = mesh.m_bounds;
-
-							pObj->m_modelID = modelID;
-							pObj->m_type = World_Object_Type_Wall;
-							pObj->m_pos = Vector3(static_cast<f32>(pos.x) + offset.x, static_cast<f32>(pos.y) + offset.y, 0.f);
-							pObj->m_scale = 1.0f / meshBounds.m_size.x;
-							pObj->m_rotation = rotation;
-							pObj->m_pModel = pModel;
-							pObj->m_bounds.m_type = World_Object_Bounds_Type_Box;
-
-							pObj->Init();
-
-							m_objects.insert(std::make_pair(IVector2(static_cast<s32>(pObj->m_pos.x), static_cast<s32>(pObj->m_pos.y)), pObj));
-						}
+						m_wallGrid.SetWall(cell, static_cast<World_WallGrid_Edge>(1 << bit), true);
 					}
 				}
 			}
 		}
 	}
-}
 
-void World::__ParseMapCharacters(const char* value, int len)
-{
+	for (u32 i = 0; i < m_mapFile.GetSpawnCount(); ++i)
+	{
+		const World_MapFile_Spawn& spawn = m_mapFile.GetSpawn(i);
+		World_RenderModel* pModel = m_mapFileModels[spawn.m_model];
+		if (!pModel)
+			continue;
+
+		const World_RenderModel_Bounds& meshBounds = pModel->GetBounds();
+
+		World_Unit* pUnit = World_Unit::Alloc(__GetGlobals());
+		pUnit->m_modelID = m_mapFile.GetModel(spawn.m_model).m_id;
+		pUnit->m_type = World_Object_Type_Unit;
+		pUnit->m_pModel = pModel;
+		pUnit->m_pos = Vector3(spawn.m_posX, spawn.m_posY, 0.f);
+		pUnit->m_scale = UNIT_HEIGHT / meshBounds.m_size.y;
+		pUnit->m_mass = UNIT_MASS;
+		pUnit->m_maxVelocity = UNIT_MAX_VELOCITY;
+		pUnit->m_bounds.m_type = World_Object_Bounds_Type_Sphere;
+		pUnit->Init();
+		pUnit->SeedRandom(m_seed, m_units.size());
+
+		m_units.push_back(pUnit);
+	}
 }
 
-void World::__ParseMapEndElement(const char* name)
+void World::__BuildMapChunk(const IVector2& cellMin, const IVector2& /*cellMax*/, std::vector<World_Object*>* pObjects)
 {
+	// on the streaming thread.  Init() aligns model sizes to the renderer's views, which can change under us, so it
+	//  waits for __AttachMapChunk().
+	// streamer chunks are the file's chunks.
+	const IVector2 chunkPos(cellMin.x / MAPSTREAM_CHUNK_SIZE, cellMin.y / MAPSTREAM_CHUNK_SIZE);
+	const u16* pTiles = m_mapFile.GetChunkTiles(chunkPos);
+	const u8* pEdges = m_mapFile.GetChunkEdges(chunkPos);
+	const u16* pWalls = m_mapFile.GetChunkWalls(chunkPos);
+
+	for (u32 i = 0; i < MAPSTREAM_CHUNK_SIZE * MAPSTREAM_CHUNK_SIZE; ++i)
+	{
+		const IVector2 pos(cellMin.x + static_cast<s32>(i % MAPSTREAM_CHUNK_SIZE), cellMin.y + static_cast<s32>(i / MAPSTREAM_CHUNK_SIZE));
+
+		World_RenderModel* pTileModel = (pTiles[i] != MAPFILE_MODEL_NONE) ? m_mapFileModels[pTiles[i]] : nullptr;
+		if (pTileModel)
+		{
+			World_Object* pObj = World_Object::Alloc(__GetGlobals());
+			pObj->m_modelID = m_mapFile.GetModel(pTiles[i]).m_id;
+			pObj->m_type = World_Object_Type_Tile;
+			pObj->m_pModel = pTileModel;
+			pObj->m_scale = 1.f;
+			pObj->m_rotation = 0.f;
+			pObj->m_pos = Vector3(static_cast<f32>(pos.x), static_cast<f32>(pos.y), 0.f);
+			pObjects->push_back(pObj);
+		}
+
+		for (u32 bit = 0; bit < 4; ++bit)
+		{
+			if (!(pEdges[i] & (1 << bit)))
+				continue;
+
+			const u16 model = *pWalls++;
+			World_RenderModel* pModel = m_mapFileModels[model];
+			if (!pModel)
+				continue;
+
+			const World_RenderModel_Bounds& meshBounds = pModel->GetBounds();
+			const World_MapWallPlacement& placement = MAP_WALL_PLACEMENTS[bit];
+
+			World_Object* pObj = World_Object::Alloc(__GetGlobals());
+			pObj->m_modelID = m_mapFile.GetModel(model).m_id;
+			pObj->m_type = World_Object_Type_Wall;
+			pObj->m_pos = Vector3(static_cast<f32>(pos.x) + placement.m_offset.x, static_cast<f32>(pos.y) + placement.m_offset.y, 0.f);
+			pObj->m_scale = 1.0f / meshBounds.m_size.x;
+			pObj->m_rotation = placement.m_rotation;
+			pObj->m_pModel = pModel;
+			pObj->m_bounds.m_type = World_Object_Bounds_Type_Box;
+			pObjects->push_back(pObj);
+		}
+	}
 }
 
-XML_Parser_Result World::__ParseMapRead(TB8::File* f, u8* pBuf, u32* pSize)
+void World::__AttachMapChunk(std::vector<World_Object*>& objects)
 {
-	*pSize = f->Read(pBuf, *pSize);
-	return (*pSize > 0) ? XML_Parser_Result_Success : XML_Parser_Result_EOF;
+	for (std::vector<World_Object*>::iterator it = objects.begin(); it != objects.end(); ++it)
+	{
+		(*it)->Init();
+	}
 }
 
-}
\ No newline at end of file
+}
@@ -2,20 +2,46 @@
 
 #include <string>
 #include <map>
-
-#include "common/basic_types.h"
-
-#include "client/Client_Globals.h"
+#include <vector>
+#include <functional>
+
+#include "Common/basic_types.h"
+
+#include "Client/Client_Globals.h"
+
+#include "WallGrid.h"
+#include "Broadphase.h"
+#include "Integrator.h"
+#include "Region.h"
+#include "Pathfinder.h"
+#include "PathHierarchy.h"
+#include "FlowField.h"
+#include "Avoidance.h"
+#include "SimLod.h"
+#include "UnitGrid.h"
+#include "MapStreamer.h"
+#include "MapFile.h"
+#include "MapCompiler.h"
+#include "Render.h"
 
 namespace TB8
 {
 
 struct World_Object;
+struct World_Object_Bounds;
 struct World_Unit;
 struct World_Avatar;
-class RenderModel;
-class RenderImagine;
-class RenderStatusBars;
+class JobSystem;
+class FileMapping;
+class EventMessage_MoveStart;
+class EventMessage_MoveEnd;
+
+struct World_RaycastHit
+{
+	Vector2										m_pos;
+	f32											m_fraction;			// along the ray, 0 to 1.
+	World_Unit*									m_pUnit;			// nullptr for a wall.
+};
 
 class World : public Client_Globals_Accessor
 {
@@ -26,36 +52,134 @@ public:
 	static World* Alloc(Client_Globals* pGlobalState);
 	void Free();
 
-	void LoadMap(const char* pszMapPath);
+	// <pszMapPath> is the xml map, or a map compiled from one.  false if the xml doesn't compile, or the compiled map
+	//  can't be opened or isn't valid.
+	bool LoadMap(const char* pszMapPath);
 	void LoadCharacter(const char* pszCharacterModelPath, const char* pszModelName);
 
 	void Update(s32 frameCount);
-	void Render3D(RenderMain* pRenderer);
-	void Render2D(RenderMain* pRenderer);
+	void UpdateRender(f32 alpha);
+	void Render3D();
+	void Render2D();
+
+	const World_WallGrid& GetWallGrid() const { return m_wallGrid; }
+	const World_Broadphase_Metrics& GetBroadphaseMetrics() const { return m_broadphase.GetMetrics(); }
+	World_Pathfinder& GetPathfinder() { return m_pathfinder; }
+	World_PathHierarchy& GetPathHierarchy() { return m_pathHierarchy; }
+	World_FlowFieldCache& GetFlowFields() { return m_flowFields; }
+	const World_Avoidance_Metrics& GetAvoidanceMetrics() const { return m_avoidance.GetMetrics(); }
+	const World_SimLod_Metrics& GetSimLodMetrics() const { return m_simLod.GetMetrics(); }
+	const World_UnitGrid_Metrics& GetUnitGridMetrics() const { return m_unitGrid.GetMetrics(); }
+	const World_MapStreamer_Metrics& GetMapStreamerMetrics() const { return m_mapStreamer.GetMetrics(); }
+
+	// units with a goal follow the flow field to it, sharing the field with every unit headed to the same cell.
+	void SetUnitGoal(World_Unit* pUnit, const IVector2& cell);
+	void ClearUnitGoal(World_Unit* pUnit);
+
+	// far units tick less often, and units sat still with nothing to do sleep.  anything that gives a unit something
+	//  to do wakes it.
+	void WakeUnit(World_Unit* pUnit);
+
+	// changes after the map is loaded, keeping the navigation structures in step.
+	void SetWall(const IVector2& cell, World_WallGrid_Edge edge, bool isWall);
+	void SetCellCost(const IVector2& cell, u8 cost);
+
+	// spatial queries over the units, the map objects and the walls.  results go in the caller's buffer, the return is
+	//  the number found, which is more than <capacity> when the buffer was too small.  units are where the last
+	//  Update() left them.
+	u32 QueryRadius(const Vector2& center, f32 radius, World_Unit** ppUnits, u32 capacity) const;
+	u32 QueryAABB(const Vector2& min, const Vector2& max, World_Unit** ppUnits, u32 capacity) const;
+	u32 QueryObjectsAABB(const Vector2& min, const Vector2& max, World_Object** ppObjects, u32 capacity) const;
+	bool Raycast(const Vector2& from, const Vector2& to, const World_Unit* pIgnore, World_RaycastHit* pHit) const;
+	bool HasLineOfSight(const Vector2& from, const Vector2& to) const;
+
+	// many queries at once, spread over the job system.  query i writes up to <capacity> units from
+	//  ppUnits + (i * capacity), and its count to pCounts[i].
+	void QueryRadiusBatch(const Vector2* pCenters, const f32* pRadii, u32 queryCount, World_Unit** ppUnits, u32 capacity, u32* pCounts);
+	void QueryAABBBatch(const Vector2* pMins, const Vector2* pMaxs, u32 queryCount, World_Unit** ppUnits, u32 capacity, u32* pCounts);
+	void RaycastBatch(const Vector2* pFrom, const Vector2* pTo, u32 queryCount, World_RaycastHit* pHits, u8* pIsHit);
+	void HasLineOfSightBatch(const Vector2* pFrom, const Vector2* pTo, u32 queryCount, u8* pResults);
+
+	// threads used by Update(), 0 for one per core.  results don't depend on it.
+	void SetThreadCount(u32 threadCount);
+	u32 GetThreadCount() const;
+
+	// seeds every unit's random stream, so a run replays from the same seed and inputs.
+	void SetSeed(u64 seed);
+	u64 GetSeed() const { return m_seed; }
 
 protected:
 	void __Initialize();
 	void __Uninitialize();
 
-	void __EventHandler(EventMessage* pEvent);
-
-	void __AdjustCharacterModelPositionForCollisions(Vector3& pos, Vector3& vel);
-	void __AdjustCharacterModelPositionForCollisionsAxis(Vector3& pos, Vector3& vel, const Vector3& axis);
-	bool __IsCharacterModelCollideWithWall(const Vector3& posNew) const;
-
-	void __ParseMapStartElement(const char* name, const char** atts);
-	void __ParseMapCharacters(const char* value, int len);
-	void __ParseMapEndElement(const char* name);
-	static XML_Parser_Result __ParseMapRead(TB8::File* f, u8* pBuf, u32* pSize);
+	void __OnMoveStart(EventMessage_MoveStart* pEvent);
+	void __OnMoveEnd(EventMessage_MoveEnd* pEvent);
+
+	void __SteerUnitsToGoals();
+	void __AvoidUnits(s32 frameCount);
+	static f32 __GetUnitRadius(const World_Unit& unit);
+	void __SleepSettledUnits();
+	void __RunQueryBatch(u32 queryCount, const std::function<void(u32)>& query);
+	void __GetViewTiles(IRect& tiles) const;
+	u32 __QueryViewUnits(const IRect& tiles);
+	void __AssignUnitsToRegions();
+	void __UpdateRegion(World_Region& region) const;
+
+	void __AdjustUnitPositionForCollisions(const World_Unit& unit, Vector3& pos, Vector3& vel) const;
+	void __AdjustUnitPositionForCollisionsAxis(const World_Unit& unit, Vector3& pos, Vector3& vel, const Vector3& axis) const;
+	bool __IsUnitCollideWithWall(const World_Unit& unit, const Vector3& posNew) const;
+	bool __IsBoundsInWallGrid(const World_Object_Bounds& bounds) const;
+	void __AdjustUnitPositionsForUnitCollisions();
+	void __ComputeUnitMoveBounds(const World_Unit& unit, const World_UnitMove& move, Vector2& min, Vector2& max) const;
+	void __ResolveUnitCollision(const World_Unit& unitA, World_UnitMove& moveA, const World_Unit& unitB, World_UnitMove& moveB) const;
+
+	void __LoadMapFile();
+	// runs on the map streaming thread.
+	void __BuildMapChunk(const IVector2& cellMin, const IVector2& cellMax, std::vector<World_Object*>* pObjects);
+	void __AttachMapChunk(std::vector<World_Object*>& objects);
 
 	std::string									m_mapPath;
 	IVector2									m_mapSize;
 	Vector3										m_startPos;
-	std::map<u32, RenderModel*>					m_mapModels;
-
-	std::multimap<IVector2, World_Object*>		m_objects;
+	std::map<u32, World_RenderModel*>			m_mapModels;
+
+	// the compiled map the tile and wall objects are built from.  fixed once the map is loaded, the streaming thread
+	//  reads it.
+	FileMapping*								m_pMapFileMapping;
+	World_MapFile								m_mapFile;
+	std::vector<World_RenderModel*>				m_mapFileModels;	// per model in the file, nullptr if it didn't load.
+
+	World_ObjectMap								m_objects;			// tiles and walls of the resident chunks.
+	World_MapStreamer							m_mapStreamer;
+	World_WallGrid								m_wallGrid;
+	World_Pathfinder							m_pathfinder;
+	World_PathHierarchy							m_pathHierarchy;
+	World_FlowFieldCache						m_flowFields;
+	std::vector<std::pair<u64, u32>>			m_steerGoals;		// (goal cell, index in m_tickUnits), grouped by goal.
+	World_Avoidance								m_avoidance;
+	std::vector<World_Avoidance_Agent>			m_avoidanceAgents;
+	std::vector<Vector2>						m_avoidanceVelocities;
 
 	World_Avatar*								m_pCharacterObj;
+	std::vector<World_Unit*>					m_units;
+	u64											m_seed;
+
+	World_SimLod								m_simLod;
+	std::vector<World_Unit*>					m_tickUnits;		// units ticking this frame, in unit order.
+	std::vector<s32>							m_tickFrames;		// frames each of m_tickUnits advances.
+	World_UnitGrid								m_unitGrid;
+	std::vector<World_Unit*>					m_queryUnits;
+
+	u32											m_threadCount;
+	JobSystem*									m_pJobSystem;
+	IVector2									m_regionCount;
+	std::vector<World_Region>					m_regions;
+	std::vector<u32>							m_unitRegions;		// per tick unit, region that resolved unit collisions, or WORLD_REGION_NONE.
+
+	World_Broadphase							m_broadphase;
+	std::vector<World_UnitMove>					m_unitMoves;		// per tick unit.
+	std::vector<Vector2>						m_unitBoundsMin;
+	std::vector<Vector2>						m_unitBoundsMax;
 };
 
 
@@ -1,32 +1,25 @@
 #pragma once
 
+// the world doesn't render itself, see World_Render, so it builds without windows or directX.
+#if defined(_WIN32)
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
 // Windows Header Files:
 #include <windows.h>
-#include <shellapi.h>
-
-#include <d3d11.h>
-#include <d2d1.h>
-#include <d2d1_1.h>
-#include <dxgi1_3.h>
-#include <DirectXMath.h>
-#include <Dwrite.h>
-
-#include <wrl/client.h>
-#include <Wincodec.h>
-#include <shlwapi.h>
+#else
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <malloc.h>
 #include <memory.h>
-#include <tchar.h>
+#include <string.h>
+#include <limits.h>
+#include <float.h>
 
 #include <vector>
 #include <map>
 #include <algorithm>
 #include <cmath>
 
-#include "common/basic_types.h"
-#include "common/memory.h"
-
+#include "Common/basic_types.h"
+#include "Common/memory.h"